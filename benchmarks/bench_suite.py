@@ -0,0 +1,298 @@
+"""Benchmark suite: L operations across buffer shapes and unicode kinds, against str.
+
+Every shape is built from the same kind of text:
+
+- ``flat``: a single str-backed leaf;
+- ``balanced``: ``L.join`` of short leaves (a balanced JoinBuffer tree);
+- ``fine``: the same with leaves of ``FINE_PIECE`` code points, as many
+  small appends produce;
+- ``chain``: the same leaves appended one by one with ``+`` (the trees
+  ``concat_balanced`` keeps balanced), and ``rchain`` prepended one by one;
+- ``builder``: the same leaves appended to an ``lstring.Builder``;
+- ``slice``: a slice view inside a balanced tree;
+- ``mul_slice``: nested MulBuffer/SliceBuffer combinations;
+- ``utf8``: a UTF-8 leaf over bytes (``L.from_buffer(..., encoding='utf-8')``),
+
+each in 1-, 2- and 4-byte kinds. The operations (find, rfind, count, split,
+iteration, str(), hash, comparisons, startswith and building the shape
+itself) are timed on the L and, as a baseline, on the equal str. The
+``*_absent`` searches look for ``ABSENT``, which does not occur: they
+scan the whole text and time the candidate prefilter of the search.
+
+Usage (from repo root, with extension importable):
+    python benchmarks/bench_suite.py
+    python benchmarks/bench_suite.py --quick --filter 'find|split'
+    python benchmarks/bench_suite.py --compare benchmarks/results/suite_<timestamp>.json
+
+It writes a timestamped JSON report under benchmarks/results/. With
+``--compare``, L timings are checked against a previous report and the
+script exits with status 1 if any of them got slower than ``--threshold``.
+"""
+
+import argparse
+import json
+import os
+import platform
+import random
+import re
+import statistics
+import subprocess
+import timeit
+from datetime import datetime, timezone
+
+import lstring
+from lstring import L, Builder
+
+
+KINDS = {
+    "ucs1": "abcdefghijklmnopqrstuvwxyz ,.",
+    "ucs2": "абвгдежзийклмнопрстуфхцчшщ ,.",
+    "ucs4": "\U0001F600\U0001F601\U0001F602\U0001F603\U0001F604\U0001F605abcdefgh ,.",
+}
+
+NEEDLE = "|needle|"
+ABSENT = "~~~"
+SEPARATOR = ","
+PIECE = 64
+FINE_PIECE = 17
+
+
+def _make_text(kind: str, length: int, seed: int = 28) -> str:
+    """Random text of `length` code points with NEEDLE planted at 90%."""
+    rnd = random.Random(seed)
+    alphabet = KINDS[kind]
+    text = "".join(rnd.choice(alphabet) for _ in range(length - len(NEEDLE)))
+    at = length * 9 // 10
+    return text[:at] + NEEDLE + text[at:]
+
+
+def _pieces(text: str, size: int = PIECE) -> list[str]:
+    return [text[i:i + size] for i in range(0, len(text), size)]
+
+
+def _build_chain(pieces: list[str]) -> L:
+    result = L("")
+    for p in pieces:
+        result = result + L(p)
+    return result
+
+
+def _build_rchain(pieces: list[str]) -> L:
+    result = L("")
+    for p in reversed(pieces):
+        result = L(p) + result
+    return result
+
+
+def _build_with_builder(pieces: list[str]) -> L:
+    b = Builder()
+    for p in pieces:
+        b.append(p)
+    return b.build()
+
+
+def _build_mul_slice(text: str, length: int) -> L:
+    period = L(text[: max(PIECE, length // 64)])
+    inner = (period[3:-3] * 4)[5:-5]
+    outer = (inner * (length // len(inner) + 2))[7:]
+    return outer[: length - len(NEEDLE)] + L(NEEDLE)
+
+
+def build_shapes(kind: str, length: int) -> dict:
+    """Return {shape: (builder, L)}; builder() rebuilds the shape."""
+    text = _make_text(kind, length)
+    pieces = _pieces(text)
+    fine_pieces = _pieces(text, FINE_PIECE)
+    margin = PIECE * 4
+    wide = _make_text(kind, length + 2 * margin, seed=29)
+    wide = wide[:margin] + text + wide[margin + length:]
+    wide_pieces = _pieces(wide)
+    data = text.encode("utf-8")
+
+    builders = {
+        "flat": lambda: L(text),
+        "balanced": lambda: L("").join([L(p) for p in pieces]),
+        "fine": lambda: L("").join([L(p) for p in fine_pieces]),
+        "chain": lambda: _build_chain(pieces),
+        "rchain": lambda: _build_rchain(pieces),
+        "builder": lambda: _build_with_builder(pieces),
+        "slice": lambda: L("").join([L(p) for p in wide_pieces])[margin:margin + length],
+        "mul_slice": lambda: _build_mul_slice(text, length),
+        "utf8": lambda: L.from_buffer(data, encoding="utf-8"),
+    }
+    return {name: (build, build()) for name, build in builders.items()}
+
+
+def _iterate(s) -> int:
+    n = 0
+    for _ in s:
+        n += 1
+    return n
+
+
+def operations(lz: L, py: str, length: int) -> dict:
+    """Return {op: (L callable, str callable)} over equal content."""
+    other_lz = L(py[:-1] + "\x00")
+    other_py = py[:-1] + "\x00"
+    equal_lz = L(py)
+    equal_py = "".join([py[:1], py[1:]])
+    prefix = py[: length // 2]
+    return {
+        "find": (lambda: lz.find(NEEDLE), lambda: py.find(NEEDLE)),
+        "rfind": (lambda: lz.rfind(py[5:12]), lambda: py.rfind(py[5:12])),
+        "find_absent": (lambda: lz.find(ABSENT), lambda: py.find(ABSENT)),
+        "rfind_absent": (lambda: lz.rfind(ABSENT), lambda: py.rfind(ABSENT)),
+        "count": (lambda: lz.count(SEPARATOR), lambda: py.count(SEPARATOR)),
+        "count_absent": (lambda: lz.count(ABSENT), lambda: py.count(ABSENT)),
+        "split": (lambda: lz.split(SEPARATOR), lambda: py.split(SEPARATOR)),
+        "iter": (lambda: _iterate(lz), lambda: _iterate(py)),
+        # str(py) would return py itself; a slice copies like str(lz) does.
+        "str": (lambda: str(lz), lambda: py[:-1]),
+        "hash_slice": (lambda: hash(lz[1:]), lambda: hash(py[1:])),
+        "eq": (lambda: lz == equal_lz, lambda: py == equal_py),
+        "lt": (lambda: lz < other_lz, lambda: py < other_py),
+        "startswith": (lambda: lz.startswith(prefix), lambda: py.startswith(prefix)),
+    }
+
+
+def _time(fn, *, repeats: int, min_time: float) -> dict:
+    timer = timeit.Timer(fn)
+    number = 1
+    while True:
+        if timer.timeit(number) >= min_time or number >= 1_000_000:
+            break
+        number *= 4
+    per_call = [t / number for t in timer.repeat(repeat=repeats, number=number)]
+    return {
+        "repeats": repeats,
+        "number": number,
+        "median_s": statistics.median(per_call),
+        "min_s": min(per_call),
+        "max_s": max(per_call),
+    }
+
+
+def _key(entry: dict) -> str:
+    return f"{entry['kind']}/{entry['shape']}/{entry['op']}/{entry['impl']}"
+
+
+def compare(report: dict, baseline_path: str, threshold: float) -> int:
+    """Print L timings against a baseline report; return the number of regressions."""
+    with open(baseline_path, encoding="utf-8") as f:
+        baseline = {_key(e): e for e in json.load(f)["results"]}
+    regressions = 0
+    print(f"\nCompared with {baseline_path} (threshold {threshold:.2f}x):")
+    for entry in report["results"]:
+        if entry["impl"] != "L":
+            continue
+        old = baseline.get(_key(entry))
+        if old is None:
+            continue
+        ratio = entry["min_s"] / old["min_s"] if old["min_s"] > 0 else 1.0
+        flag = ""
+        if ratio > threshold:
+            regressions += 1
+            flag = "  <-- slower"
+        print(f"  {_key(entry):32s} {old['min_s'] * 1e6:11.1f} -> {entry['min_s'] * 1e6:11.1f} us  {ratio:5.2f}x{flag}")
+    print(f"{regressions} regression(s)")
+    return regressions
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--length", type=int, default=1_000_000, help="string length in code points")
+    parser.add_argument("--quick", action="store_true", help="short strings and fewer repeats")
+    parser.add_argument("--repeats", type=int, default=5, help="timeit repeats")
+    parser.add_argument("--min-time", type=float, default=0.02, help="minimum seconds per timed batch")
+    parser.add_argument("--kinds", type=str, default=",".join(KINDS), help="comma-separated unicode kinds")
+    parser.add_argument("--filter", type=str, default="",
+                        help="regular expression selecting 'kind/shape/op' names")
+    parser.add_argument(
+        "--out",
+        type=str,
+        default="",
+        help="output JSON path (default: benchmarks/results/suite_<timestamp>.json)",
+    )
+    parser.add_argument("--compare", type=str, default="", help="baseline JSON report to compare with")
+    parser.add_argument("--threshold", type=float, default=1.25,
+                        help="slowdown ratio reported as a regression by --compare")
+    args = parser.parse_args()
+
+    length = 50_000 if args.quick else args.length
+    repeats = 3 if args.quick else args.repeats
+    min_time = min(args.min_time, 0.005) if args.quick else args.min_time
+    kinds = [k for k in args.kinds.split(",") if k.strip()]
+    selected = re.compile(args.filter)
+
+    # Keep lazy structures stable.
+    orig_thresh = lstring.get_optimize_threshold()
+    lstring.set_optimize_threshold(0)
+
+    try:
+        ts = datetime.now(timezone.utc).strftime("%Y%m%d_%H%M%S")
+        out_path = args.out or os.path.join("benchmarks", "results", f"suite_{ts}.json")
+
+        try:
+            git_head = (
+                subprocess.check_output(["git", "rev-parse", "HEAD"], stderr=subprocess.DEVNULL)
+                .decode("ascii", errors="replace")
+                .strip()
+            )
+        except Exception:
+            git_head = None
+
+        report = {
+            "meta": {
+                "timestamp_utc": ts,
+                "python": platform.python_version(),
+                "platform": platform.platform(),
+                "processor": platform.processor() or None,
+                "git_head": git_head,
+                "optimize_threshold": 0,
+                "lstring_version": getattr(lstring, "__version__", None),
+                "length": length,
+                "kinds": kinds,
+            },
+            "results": [],
+        }
+
+        def record(kind, shape, op, impl, fn):
+            stats = _time(fn, repeats=repeats, min_time=min_time)
+            report["results"].append({"kind": kind, "shape": shape, "op": op, "impl": impl, **stats})
+            return stats
+
+        for kind in kinds:
+            shapes = build_shapes(kind, length)
+            for shape, (build, lz) in shapes.items():
+                py = str(lz)
+                ops = operations(lz, py, length)
+                ops["build"] = (build, lambda: "".join(_pieces(py)))
+                for op, (l_fn, py_fn) in ops.items():
+                    if not selected.search(f"{kind}/{shape}/{op}"):
+                        continue
+                    l_result, py_result = l_fn(), py_fn()
+                    if op not in ("str", "build", "hash_slice") and l_result != py_result:
+                        raise RuntimeError(f"{kind}/{shape}/{op}: L gives {l_result!r}, str gives {py_result!r}")
+                    l_stats = record(kind, shape, op, "L", l_fn)
+                    py_stats = record(kind, shape, op, "str", py_fn)
+                    ratio = l_stats["median_s"] / py_stats["median_s"] if py_stats["median_s"] > 0 else 0.0
+                    print(
+                        f"{kind:5s} {shape:10s} {op:11s} L={l_stats['median_s'] * 1e6:11.1f} us "
+                        f"str={py_stats['median_s'] * 1e6:11.1f} us  L/str={ratio:7.2f}"
+                    )
+
+        os.makedirs(os.path.dirname(out_path) or ".", exist_ok=True)
+        with open(out_path, "w", encoding="utf-8") as f:
+            json.dump(report, f, ensure_ascii=False, indent=2)
+        print(f"\nWrote: {out_path}")
+
+        if args.compare and compare(report, args.compare, args.threshold):
+            return 1
+        return 0
+
+    finally:
+        lstring.set_optimize_threshold(orig_thresh)
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -5,7 +5,16 @@ This module provides a wrapper around the _lstring C extension,
 exposing the L class for lazy string operations.
 """
 
-from .lstring import L, CharClass, get_optimize_threshold, set_optimize_threshold
+from .lstring import (
+    L, CharClass, Pattern, Builder, get_optimize_threshold, set_optimize_threshold,
+    get_parallel_copy_threshold, set_parallel_copy_threshold,
+    get_parallel_copy_threads, set_parallel_copy_threads,
+    get_class_index_threshold, set_class_index_threshold,
+    get_compact_min_leaf, set_compact_min_leaf,
+    get_compact_max_leaf, set_compact_max_leaf,
+    get_stats_enabled, set_stats_enabled, stats, reset_stats,
+    get_str_cache_limit, set_str_cache_limit, clear_str_cache,
+)
 from ._version import __version__
 
 def get_include():
@@ -13,4 +22,13 @@ def get_include():
 
     return os.path.join(os.path.dirname(__file__), "include")
 
-__all__ = ['__version__', 'L', 'CharClass', 'get_optimize_threshold', 'set_optimize_threshold', 'get_include']
+__all__ = [
+    '__version__', 'L', 'CharClass', 'Pattern', 'Builder', 'get_optimize_threshold', 'set_optimize_threshold',
+    'get_parallel_copy_threshold', 'set_parallel_copy_threshold',
+    'get_parallel_copy_threads', 'set_parallel_copy_threads',
+    'get_class_index_threshold', 'set_class_index_threshold',
+    'get_compact_min_leaf', 'set_compact_min_leaf',
+    'get_compact_max_leaf', 'set_compact_max_leaf',
+    'get_stats_enabled', 'set_stats_enabled', 'stats', 'reset_stats',
+    'get_str_cache_limit', 'set_str_cache_limit', 'clear_str_cache', 'get_include',
+]
@@ -11,6 +11,50 @@ from typing import Union, Optional
 from collections.abc import Mapping
 
 
+# Compiled format templates by (style, format string): a format that is
+# used again is not parsed again. The oldest entry is evicted when full.
+_TEMPLATE_CACHE_SIZE = 512
+_template_cache = {}
+
+# Compiled f-string expressions by source text, bounded the same way.
+_CODE_CACHE_SIZE = 512
+_code_cache = {}
+
+
+def _template(format_str, style: str):
+    """
+    Return the compiled template of a format string (L instance).
+
+    Args:
+        format_str: Format string (L instance)
+        style: 'printf', 'printf_named', 'format' or 'fformat'
+
+    Returns:
+        _lstring._format_template: Template rendering into ropes whose
+        literal parts are slices of format_str
+    """
+    key = (style, type(format_str), format_str)
+    tmpl = _template_cache.get(key)
+    if tmpl is None:
+        tmpl = format_str._format_template(style)
+        if len(_template_cache) >= _TEMPLATE_CACHE_SIZE:
+            del _template_cache[next(iter(_template_cache))]
+        _template_cache[key] = tmpl
+    return tmpl
+
+
+def _compile_expr(expr_str: str):
+    """Return the code object of an f-string expression, compiling it once."""
+    code = _code_cache.get(expr_str)
+    if code is None:
+        # eval() of a str strips surrounding whitespace; compile() does not
+        code = compile(expr_str.strip(), '<string>', 'eval')
+        if len(_code_cache) >= _CODE_CACHE_SIZE:
+            del _code_cache[next(iter(_code_cache))]
+        _code_cache[expr_str] = code
+    return code
+
+
 def _printf_pos(format_str, placeholders: tuple):
     """
     Format a lazy string using positional printf-style placeholders.
@@ -22,58 +66,7 @@ def _printf_pos(format_str, placeholders: tuple):
     Returns:
         L: Formatted lazy string
     """
-    from .lstring import L
-    
-    def format_parts():
-        """Generator that yields formatted parts of the string."""
-        last_pos = 0
-        value_idx = 0
-        length = len(format_str)
-        
-        while last_pos < length:
-            # Find next %
-            percent_pos = format_str.findc('%', last_pos)
-            
-            if percent_pos == -1:
-                # No more placeholders - yield rest of string
-                yield format_str[last_pos:]
-                break
-            
-            # Yield static part before %
-            if percent_pos > last_pos:
-                yield format_str[last_pos:percent_pos]
-            
-            # Parse the placeholder
-            end_pos, is_escape, star_count = format_str._parse_printf_positional(percent_pos)
-            
-            if end_pos == -1:
-                # Invalid placeholder - let str % handle the error
-                # Yield the % and continue
-                yield L('%')
-                last_pos = percent_pos + 1
-                continue
-            
-            if is_escape:
-                # %% escape sequence
-                yield L('%')
-                last_pos = end_pos
-                continue
-            
-            # Valid placeholder - extract it
-            placeholder = str(format_str[percent_pos:end_pos])
-            
-            # Extract values for this placeholder
-            # We need star_count + 1 values: star_count for *, 1 for the actual value
-            values = placeholders[value_idx:value_idx + star_count + 1]
-            value_idx += star_count + 1
-            
-            # Format using str %
-            formatted = placeholder % values
-            yield L(formatted)
-            
-            last_pos = end_pos
-    
-    return L('').join(format_parts())
+    return _template(format_str, 'printf').printf(placeholders)
 
 
 def _printf_dict(format_str, placeholders: Mapping):
@@ -88,62 +81,18 @@ def _printf_dict(format_str, placeholders: Mapping):
         L: Formatted lazy string
     """
     from .lstring import L
-    
+
+    tmpl = _template(format_str, 'printf_named')
+    if tmpl.verbatim:
+        # A spec the template cannot parse: str % gets the mapping as is
+        return tmpl.printf_named(placeholders)
+
     # Convert all keys to L for consistent lookup
     # This handles both str and L keys in the input dict
     normalized_placeholders = {L(k) if isinstance(k, str) else k: v 
                                for k, v in placeholders.items()}
     
-    def format_parts():
-        """Generator that yields formatted parts of the string."""
-        last_pos = 0
-        length = len(format_str)
-        
-        while last_pos < length:
-            # Find next %
-            percent_pos = format_str.findc('%', last_pos)
-            
-            if percent_pos == -1:
-                # No more placeholders - yield rest of string
-                yield format_str[last_pos:]
-                break
-            
-            # Yield static part before %
-            if percent_pos > last_pos:
-                yield format_str[last_pos:percent_pos]
-            
-            # Parse the placeholder
-            end_pos, is_escape, name_end = format_str._parse_printf_named(percent_pos)
-            
-            if end_pos == -1:
-                # Invalid or positional placeholder - let str % handle the error
-                # Yield the % and continue
-                yield L('%')
-                last_pos = percent_pos + 1
-                continue
-            
-            if is_escape:
-                # %% escape sequence
-                yield L('%')
-                last_pos = end_pos
-                continue
-            
-            # Valid named placeholder - extract it and the name
-            placeholder = str(format_str[percent_pos:end_pos])
-            name = format_str[percent_pos + 2:name_end - 1]  # Skip %( and )
-            
-            # Get value from dict
-            value = normalized_placeholders[name]
-            
-            # Format using str %
-            # Create a temporary dict with str key for formatting
-            formatted = placeholder % {str(name): value}
-            yield L(formatted)
-            
-            last_pos = end_pos
-    
-    return L('').join(format_parts())
-
+    return tmpl.printf_named(normalized_placeholders)
 
 
 def printf(format_str, placeholders: Union[dict, tuple]):
@@ -229,94 +178,7 @@ def format(format_str, args=(), kwargs=types.MappingProxyType({})):
     if isinstance(format_str, str):
         format_str = L(format_str)
     
-    # Create formatting function closure to avoid checking condition in loop
-    # Use format_map when there are no positional args - works for both dict and Mapping
-    if len(args) == 0:
-        def do_format(placeholder_str, args_slice=()):
-            return placeholder_str.format_map(kwargs)
-    else:
-        def do_format(placeholder_str, args_slice=args):
-            return placeholder_str.format(*args_slice, **kwargs)
-    
-    def format_parts():
-        """Generator that yields formatted parts of the string."""
-        last_pos = 0
-        auto_arg_index = 0  # For auto-numbered placeholders
-        has_auto = False
-        has_numbered = False
-        
-        # Parse placeholders using _parse_format_placeholder
-        pos = 0
-        length = len(format_str)
-        
-        while pos < length:
-            # Find next { or }
-            next_pos = format_str.findcs('{}', pos)
-            
-            if next_pos == -1:
-                # No more braces - yield rest of string
-                if last_pos < length:
-                    if last_pos > 0:
-                        yield format_str[last_pos:]
-                    else:
-                        yield format_str
-                break
-            
-            # Parse the token at this position
-            end_pos, token_type, content_end = format_str._parse_format_placeholder(next_pos)
-            
-            if end_pos == -1:
-                # Invalid/unclosed - skip this character
-                pos = next_pos + 1
-                continue
-            
-            # Yield static part before this token
-            if next_pos > last_pos:
-                yield format_str[last_pos:next_pos]
-            
-            if token_type == 1:
-                # Literal {{ -> {
-                yield L('{')
-            elif token_type == 2:
-                # Literal }} -> }
-                yield L('}')
-            elif token_type == 3:
-                # Placeholder {content}
-                content = format_str[next_pos + 1:content_end]
-                placeholder_str = '{' + str(content) + '}'
-                
-                # Determine placeholder type by looking at first character
-                # Check if it's auto-numbered, numbered, or named
-                if len(content) == 0 or content[0] in ':.![':
-                    # Auto-numbered: {}, {:.2f}, {!r}
-                    has_auto = True
-                    if has_numbered:
-                        raise ValueError("cannot mix auto and manual numbering")
-                    
-                    # Format with args[auto_arg_index:]
-                    formatted = do_format(placeholder_str, args[auto_arg_index:])
-                    auto_arg_index += 1
-                    
-                elif content[0].isdigit():
-                    # Numbered: {0}, {1:.2f}
-                    has_numbered = True
-                    if has_auto:
-                        raise ValueError("cannot mix auto and manual numbering")
-                    
-                    # Format with all args
-                    formatted = do_format(placeholder_str)
-                    
-                else:
-                    # Named or attribute/index access: {name}, {obj.attr}, {dict[key]}
-                    # Format with all args and kwargs
-                    formatted = do_format(placeholder_str)
-                
-                yield L(formatted)
-            
-            last_pos = end_pos
-            pos = end_pos
-    
-    return L('').join(format_parts())
+    return _template(format_str, 'format').format(args, kwargs)
 
 
 def fformat(format_str, globals_dict=None, locals_dict=None):
@@ -369,59 +231,18 @@ def fformat(format_str, globals_dict=None, locals_dict=None):
             locals_dict = frame.f_locals
         del frame
     
-    def format_parts():
-        """Generator that yields formatted parts of the string."""
-        pos = 0
-        length = len(format_str)
-        last_pos = 0
+    tmpl = _template(format_str, 'fformat')
+    values = []
+    for expr_str, spec in tmpl.fields():
+        # Evaluate the expression
+        try:
+            result = eval(_compile_expr(expr_str), globals_dict, locals_dict)
+        except Exception as e:
+            # Re-raise with context about which expression failed
+            raise type(e)(f"Error evaluating {{!{{expr_str}}!}}: {e}") from e
         
-        while pos < length:
-            # Find next { or }
-            next_pos = format_str.findcs('{}', pos)
-            
-            if next_pos == -1:
-                # No more braces - yield rest of string
-                if last_pos < length:
-                    yield format_str[last_pos:]
-                break
-            
-            # Parse the token at this position
-            end_pos, token_type, content_end, expr_end = format_str._parse_fformat_placeholder(next_pos)
-            
-            if end_pos == -1:
-                # Invalid/unclosed - skip this character
-                pos = next_pos + 1
-                continue
-            
-            # Yield static part before this token
-            if next_pos > last_pos:
-                yield format_str[last_pos:next_pos]
-            
-            if token_type == 1:
-                # Literal {{ -> {
-                yield L('{')
-            elif token_type == 2:
-                # Literal }} -> }
-                yield L('}')
-            elif token_type == 3:
-                # Placeholder {expr[!conv][:spec]}
-                # Extract expression
-                expr_str = str(format_str[next_pos + 1:expr_end])
-                
-                # Evaluate the expression
-                try:
-                    result = eval(expr_str, globals_dict, locals_dict)
-                except Exception as e:
-                    # Re-raise with context about which expression failed
-                    raise type(e)(f"Error evaluating {{!{{expr_str}}!}}: {e}") from e
-                
-                # Apply conversion and/or format spec using str.format()
-                # Extract everything after expression: !r, :spec, !r:spec, or empty
-                format_suffix = str(format_str[expr_end:content_end])
-                yield L(('{' + format_suffix + '}').format(result))
-            
-            last_pos = end_pos
-            pos = end_pos
+        # Apply conversion and/or format spec using str.format():
+        # spec is '{' + (!r, :spec, !r:spec or empty) + '}'
+        values.append(spec.format(result))
     
-    return L('').join(format_parts())
-
+    return tmpl.fill(values)
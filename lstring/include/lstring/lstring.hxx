@@ -7,6 +7,7 @@
 #define LSTRING_HXX
 
 #include <Python.h>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <stdexcept>
@@ -49,7 +50,50 @@ inline bool char_is(uint32_t ch, uint32_t charclass) {
            ((charclass & CHAR_PRINTABLE) && Py_UNICODE_ISPRINTABLE(ch));
 }
 
+/**
+ * @brief All character classes of a code point, as CharClass flags
+ */
+inline uint32_t char_classes(uint32_t ch) {
+    return (Py_UNICODE_ISSPACE(ch) ? CHAR_SPACE : 0) |
+           (Py_UNICODE_ISALPHA(ch) ? CHAR_ALPHA : 0) |
+           (Py_UNICODE_ISDIGIT(ch) ? CHAR_DIGIT : 0) |
+           (Py_UNICODE_ISLOWER(ch) ? CHAR_LOWER : 0) |
+           (Py_UNICODE_ISUPPER(ch) ? CHAR_UPPER : 0) |
+           (Py_UNICODE_ISDECIMAL(ch) ? CHAR_DECIMAL : 0) |
+           (Py_UNICODE_ISNUMERIC(ch) ? CHAR_NUMERIC : 0) |
+           (Py_UNICODE_ISPRINTABLE(ch) ? CHAR_PRINTABLE : 0);
+}
+
 class CharSet;
+class SubstringIndex;
+class StrCache;
+
+/**
+ * @brief Contiguous run of code points stored at a single unicode kind.
+ *
+ * Spans are produced by Buffer::visit_spans() from the underlying storage of
+ * leaf buffers, so `data` points straight into the Python str (or into a
+ * short-lived scratch area for buffers without contiguous storage).
+ */
+struct BufferSpan {
+    int kind;           // PyUnicode_1BYTE_KIND, PyUnicode_2BYTE_KIND or PyUnicode_4BYTE_KIND
+    const void *data;   // first code point of the run
+    Py_ssize_t length;  // number of code points in the run
+};
+
+/**
+ * @brief Receiver of the spans reported by Buffer::visit_spans().
+ */
+class SpanVisitor {
+public:
+    virtual ~SpanVisitor() = default;
+
+    /**
+     * @brief Handle the next span.
+     * @return false to stop the traversal, true to continue.
+     */
+    virtual bool visit(const BufferSpan& span) = 0;
+};
 
 /**
  * @brief Abstract Buffer base class
@@ -69,45 +113,85 @@ protected:
         return reinterpret_cast<const uint32_t*>(PyUnicode_DATA(s));
     }
 
-    bool check_istitle_range(Py_ssize_t check_len) const {
-        if (check_len == 0) return false;
-        bool previous_is_cased = false;
-        bool has_cased = false;
-
-        for (Py_ssize_t i = 0; i < check_len; ++i) {
-            Py_UCS4 ch = value(i);
-
-            if (Py_UNICODE_ISUPPER(ch) || Py_UNICODE_ISTITLE(ch)) {
-                if (previous_is_cased) {
-                    return false;
-                }
-                previous_is_cased = true;
-                has_cased = true;
-            } else if (Py_UNICODE_ISLOWER(ch)) {
-                if (!previous_is_cased) {
-                    return false;
-                }
-                previous_is_cased = true;
-                has_cased = true;
-            } else {
-                previous_is_cased = false;
-            }
-        }
-        return has_cased;
-    }
+    bool check_istitle_range(Py_ssize_t check_len) const;
+
+    /**
+     * Lazily filled caches (here and in derived buffers) are atomics: a
+     * buffer is immutable, so threads racing on first use all compute the
+     * same value and relaxed publication is enough.
+     */
+    mutable std::atomic<Py_uhash_t> cached_hash;
 
-    Py_hash_t cached_hash;
+    /** cached_hash value meaning "not computed yet". */
+    static constexpr Py_uhash_t HASH_UNSET = (Py_uhash_t)-1;
+
+    /**
+     * @brief Index attached by L.build_index(), owned by the buffer.
+     *
+     * Set once by SubstringIndex::attach() and read without locking, so
+     * searches on indexed and unindexed buffers alike take no lock.
+     */
+    mutable std::atomic<const SubstringIndex*> substring_index;
+
+    /**
+     * @brief Whether StrCache holds an entry for this buffer.
+     *
+     * Written by StrCache under its mutex; lookups and ~Buffer() of
+     * buffers without an entry check it and skip the cache's lock.
+     */
+    mutable std::atomic<bool> str_cached;
+
+    friend class SubstringIndex;
+    friend class StrCache;
+
+    /**
+     * @brief Polynomial hash of the whole buffer, see range_hash().
+     *
+     * Composite buffers override this to combine the cached hashes of their
+     * children instead of scanning the content.
+     */
+    virtual Py_uhash_t compute_hash() const;
+
+    /**
+     * @brief Polynomial hash of [start, end) computed from the code points.
+     */
+    Py_uhash_t scan_hash(Py_ssize_t start, Py_ssize_t end) const;
+
+    /**
+     * @brief Minimal unicode kind of [start, end) computed from the code points.
+     */
+    int scan_kind(Py_ssize_t start, Py_ssize_t end) const;
 
 public:
     static constexpr int buffer_class_id = 1;
 
-    Buffer() : cached_hash(-1) {}
+    Buffer() : cached_hash(HASH_UNSET), substring_index(nullptr), str_cached(false) {}
     virtual ~Buffer();
 
+    /**
+     * @brief Buffers come from the Python object allocator.
+     *
+     * Nodes are small and created in large numbers by slicing, joining and
+     * splitting; pymalloc serves them from size-class pools instead of the
+     * system heap. Buffers are created and destroyed with the GIL held.
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr) noexcept;
+
     virtual bool is_a(int class_id) const;
 
     virtual Py_ssize_t length() const = 0;
     virtual int unicode_kind() const = 0;
+
+    /**
+     * @brief Minimal unicode kind of the code points in [start, end).
+     *
+     * Composite buffers answer from the kinds of their children (which
+     * cache them), so only the partially covered leaves are scanned. The
+     * range must be normalized to 0 <= start <= end <= length(); an empty
+     * range has kind PyUnicode_1BYTE_KIND.
+     */
+    virtual int range_kind(Py_ssize_t start, Py_ssize_t end) const;
     virtual uint32_t value(Py_ssize_t index) const = 0;
 
     virtual void copy(uint32_t *target, Py_ssize_t start, Py_ssize_t count) const = 0;
@@ -118,6 +202,38 @@ public:
 
     virtual bool is_str() const;
 
+    /**
+     * @brief Describe [start, end) as a single span over the buffer storage.
+     *
+     * Leaf buffers that keep their code points contiguously (e.g. StrBuffer)
+     * override this. The range must be non-empty and normalized.
+     *
+     * @return false if the buffer has no contiguous storage for the range.
+     */
+    virtual bool get_span(Py_ssize_t start, Py_ssize_t end, BufferSpan& span) const;
+
+    /**
+     * @brief Visit the code points in [start, end) as contiguous spans.
+     *
+     * Spans are reported left to right. Composite buffers forward the call
+     * to their children, so a whole rope is visited with one descent per
+     * leaf instead of one per code point. The range must already be
+     * normalized to 0 <= start <= end <= length().
+     *
+     * The default implementation reports get_span() when available and
+     * otherwise copies chunks of the range into a scratch UCS4 area.
+     *
+     * @return false if the visitor stopped the traversal, true otherwise.
+     */
+    virtual bool visit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const;
+
+    /**
+     * @brief Same as visit_spans() but reports the spans right to left.
+     *
+     * Each span is still laid out in forward order.
+     */
+    virtual bool rvisit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const;
+
     virtual Py_ssize_t findc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const = 0;
     virtual Py_ssize_t rfindc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const = 0;
     virtual Py_ssize_t findcs(Py_ssize_t start, Py_ssize_t end, const CharSet& charset, bool invert = false) const;
@@ -127,12 +243,38 @@ public:
     virtual Py_ssize_t findcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const;
     virtual Py_ssize_t rfindcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const;
 
-    Py_hash_t hash() {
-        if (cached_hash != -1) {
-            return cached_hash;
+    /**
+     * @brief Polynomial hash of the whole content, cached.
+     *
+     * A value that happens to equal HASH_UNSET is simply recomputed.
+     */
+    Py_uhash_t poly_hash() const {
+        Py_uhash_t h = cached_hash.load(std::memory_order_relaxed);
+        if (h != HASH_UNSET) {
+            return h;
         }
-        cached_hash = compute_hash();
-        return cached_hash;
+        h = compute_hash();
+        cached_hash.store(h, std::memory_order_relaxed);
+        return h;
+    }
+
+    /**
+     * @brief Polynomial hash of the code points in [start, end).
+     *
+     * The hash is `sum(ch[i] * 31^(n-1-i))` modulo 2^64, so the hash of a
+     * concatenation follows from the hashes and lengths of its parts (see
+     * src/poly_hash.hxx). Composite buffers override this to reuse cached
+     * child hashes for the parts of the range that cover whole children.
+     * The range must be normalized to 0 <= start <= end <= length().
+     */
+    virtual Py_uhash_t range_hash(Py_ssize_t start, Py_ssize_t end) const;
+
+    /**
+     * @brief Python hash of the content: poly_hash() with -1 mapped to -2.
+     */
+    Py_hash_t hash() const {
+        Py_hash_t h = (Py_hash_t)poly_hash();
+        return h == -1 ? -2 : h;
     }
 
     virtual int cmp(const Buffer* other) const;
@@ -148,20 +290,6 @@ public:
     virtual bool isprintable() const;
     virtual bool istitle() const;
 
-private:
-    Py_hash_t compute_hash() const {
-        Py_ssize_t len = length();
-        Py_hash_t x = 0;
-        Py_hash_t mult = 31;
-        for (Py_ssize_t i = 0; i < len; i++) {
-            uint32_t ch = value(i);
-            x = x * mult + ch;
-        }
-        if (x == -1) {
-            x = -2;
-        }
-        return x;
-    }
 };
 
 struct LStrObject {
@@ -7,6 +7,7 @@ exposing the L class for lazy string operations.
 
 import _lstring
 import inspect
+import os
 from enum import IntFlag
 from functools import partial
 from .format import printf, format as _format, fformat as _fformat
@@ -36,6 +37,48 @@ class L(_lstring.L):
     Inherits from _lstring.L to allow Python-level customization while
     maintaining C++ performance for core operations.
     """
+
+    # Like str, instances carry no attributes; without __dict__ and
+    # __weakref__ slots an instance holds just the buffer pointer.
+    __slots__ = ()
+    
+    # ============================================================================
+    # Construction from memory
+    # ============================================================================
+    
+    @classmethod
+    def from_file(cls, path, width=1, encoding=None):
+        """
+        Map a file read-only and return an L over its content, without reading it.
+        
+        The file is read as code points of `width` bytes (1 for Latin-1/ASCII,
+        2 or 4 in native byte order), or with encoding='utf-8' as UTF-8 that
+        is decoded only where accessed; see from_buffer(). Pages of the file
+        are loaded only where the string is accessed.
+        
+        Args:
+            path: Path of the file
+            width: Bytes per code point: 1, 2 or 4
+            encoding: None, or 'utf-8' for UTF-8 content
+        
+        Returns:
+            L: String backed by the mapped file
+        
+        Raises:
+            UnicodeDecodeError: If encoding is 'utf-8' and the file is not valid UTF-8
+        
+        Examples:
+            >>> log = L.from_file('/var/log/syslog')
+            >>> first_line = log[:log.findc('\\n')]
+            >>> text = L.from_file('notes.md', encoding='utf-8')
+        """
+        import mmap
+        with open(path, 'rb') as f:
+            if os.fstat(f.fileno()).st_size == 0:
+                # Empty files cannot be mapped.
+                return cls.from_buffer(b'', width, encoding)
+            mapping = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        return cls.from_buffer(mapping, width, encoding)
     
     # ============================================================================
     # Comparison operators
@@ -216,163 +259,6 @@ class L(_lstring.L):
     # Searching and Replacing
     # ============================================================================
     
-    def startswith(self, prefix, start=None, end=None):
-        """
-        Check if string starts with the specified prefix.
-        
-        Args:
-            prefix: String or L instance to check for
-            start: Optional start position (default: 0)
-            end: Optional end position (default: len(self))
-        
-        Returns:
-            bool: True if string starts with prefix, False otherwise
-        
-        Examples:
-            >>> L('hello world').startswith('hello')
-            True
-            >>> L('hello world').startswith('world')
-            False
-            >>> L('hello world').startswith('lo', 3)
-            True
-        """
-        # Convert prefix to L if it's a string
-        if isinstance(prefix, str):
-            prefix = L(prefix)
-        elif not isinstance(prefix, _lstring.L):
-            raise TypeError(f"startswith first arg must be str or L, not {type(prefix).__name__}")
-        
-        # Handle start/end parameters
-        length = len(self)
-        if start is None:
-            start = 0
-        elif start < 0:
-            start = max(0, length + start)
-        
-        if end is None:
-            end = length
-        elif end < 0:
-            end = max(0, length + end)
-        
-        # Clamp to valid range
-        start = max(0, min(start, length))
-        end = max(start, min(end, length))
-        
-        # Get the substring to compare
-        prefix_len = len(prefix)
-        if prefix_len == 0:
-            return True
-        if prefix_len > (end - start):
-            return False
-        
-        # Compare substring with prefix
-        return self[start:start + prefix_len] == prefix
-    
-    def endswith(self, suffix, start=None, end=None):
-        """
-        Check if string ends with the specified suffix.
-        
-        Args:
-            suffix: String or L instance to check for
-            start: Optional start position (default: 0)
-            end: Optional end position (default: len(self))
-        
-        Returns:
-            bool: True if string ends with suffix, False otherwise
-        
-        Examples:
-            >>> L('hello world').endswith('world')
-            True
-            >>> L('hello world').endswith('hello')
-            False
-            >>> L('hello world').endswith('lo', 0, 5)
-            True
-        """
-        # Convert suffix to L if it's a string
-        if isinstance(suffix, str):
-            suffix = L(suffix)
-        elif not isinstance(suffix, _lstring.L):
-            raise TypeError(f"endswith first arg must be str or L, not {type(suffix).__name__}")
-        
-        # Handle start/end parameters
-        length = len(self)
-        if start is None:
-            start = 0
-        elif start < 0:
-            start = max(0, length + start)
-        
-        if end is None:
-            end = length
-        elif end < 0:
-            end = max(0, length + end)
-        
-        # Clamp to valid range
-        start = max(0, min(start, length))
-        end = max(start, min(end, length))
-        
-        # Get the substring to compare
-        suffix_len = len(suffix)
-        if suffix_len == 0:
-            return True
-        if suffix_len > (end - start):
-            return False
-        
-        # Compare substring with suffix
-        return self[end - suffix_len:end] == suffix
-    
-    def removeprefix(self, prefix):
-        """
-        Remove prefix from the beginning of the string if present.
-        
-        If the string starts with the prefix, return a lazy slice without it.
-        Otherwise, return the original string unchanged.
-        
-        Args:
-            prefix: String or L instance to remove from the beginning
-        
-        Returns:
-            L: String with prefix removed, or original string if prefix not found
-        
-        Examples:
-            >>> L('TestHook').removeprefix('Test')
-            L('Hook')
-            >>> L('BaseTestCase').removeprefix('Test')
-            L('BaseTestCase')
-            >>> L('hello').removeprefix('')
-            L('hello')
-        """
-        if self.startswith(prefix):
-            return self[len(prefix):]
-        return self
-    
-    def removesuffix(self, suffix):
-        """
-        Remove suffix from the end of the string if present.
-        
-        If the string ends with the suffix, return a lazy slice without it.
-        Otherwise, return the original string unchanged.
-        
-        Args:
-            suffix: String or L instance to remove from the end
-        
-        Returns:
-            L: String with suffix removed, or original string if suffix not found
-        
-        Examples:
-            >>> L('MiscTests').removesuffix('Tests')
-            L('Misc')
-            >>> L('TmpDirMixin').removesuffix('Tests')
-            L('TmpDirMixin')
-            >>> L('hello').removesuffix('')
-            L('hello')
-        """
-        if self.endswith(suffix):
-            suffix_len = len(suffix)
-            if suffix_len == 0:
-                return self
-            return self[:-suffix_len]
-        return self
-    
     def index(self, sub, start=None, end=None):
         """
         Find the lowest index where substring is found, raise ValueError if not found.
@@ -445,66 +331,6 @@ class L(_lstring.L):
             raise ValueError("substring not found")
         return result
     
-    def count(self, sub, start=None, end=None):
-        """
-        Count non-overlapping occurrences of substring.
-        
-        Args:
-            sub: Substring to count (str or L instance)
-            start: Optional start position (default: 0)
-            end: Optional end position (default: len(self))
-        
-        Returns:
-            int: Number of non-overlapping occurrences
-        
-        Examples:
-            >>> L('hello hello').count('hello')
-            2
-            >>> L('hello hello').count('l')
-            4
-            >>> L('aaaa').count('aa')
-            2
-        """
-        # Convert sub to L if it's a string
-        if isinstance(sub, str):
-            sub = L(sub)
-        elif not isinstance(sub, _lstring.L):
-            raise TypeError(f"count first arg must be str or L, not {type(sub).__name__}")
-        
-        # Handle start/end parameters
-        length = len(self)
-        if start is None:
-            start = 0
-        elif start < 0:
-            start = max(0, length + start)
-        
-        if end is None:
-            end = length
-        elif end < 0:
-            end = max(0, length + end)
-        
-        # Clamp to valid range
-        start = max(0, min(start, length))
-        end = max(start, min(end, length))
-        
-        # Special case: empty substring
-        sub_len = len(sub)
-        if sub_len == 0:
-            # Empty substring appears at every position including start and end
-            return end - start + 1
-        
-        # Count non-overlapping occurrences using find
-        count = 0
-        pos = start
-        while pos <= end - sub_len:
-            found = self.find(sub, pos, end)
-            if found == -1:
-                break
-            count += 1
-            pos = found + sub_len
-        
-        return count
-    
     def findcs(self, charset, start=None, end=None, invert=False):
         """
         Find first occurrence of any character from charset.
@@ -532,7 +358,7 @@ class L(_lstring.L):
         """
         # Prefer passing str directly to the C extension.
         # For non-str, non-L inputs, attempt to treat as an iterable.
-        if not isinstance(charset, (str, _lstring.L)):
+        if not isinstance(charset, (str, _lstring.L, Pattern)):
             # Try to treat as iterable and join into a string
             try:
                 iter(charset)
@@ -571,7 +397,7 @@ class L(_lstring.L):
         """
         # Prefer passing str directly to the C extension.
         # For non-str, non-L inputs, attempt to treat as an iterable.
-        if not isinstance(charset, (str, _lstring.L)):
+        if not isinstance(charset, (str, _lstring.L, Pattern)):
             # Try to treat as iterable and join into a string
             try:
                 iter(charset)
@@ -583,558 +409,10 @@ class L(_lstring.L):
         # Call the C++ implementation
         return super().rfindcs(charset, start, end, invert)
     
-    def replace(self, old, new, count=-1):
-        """
-        Replace occurrences of substring old with new.
-        
-        Uses sequential find() to locate occurrences and constructs a generator
-        of string segments that is passed to join().
-        
-        Args:
-            old: Substring to replace (str or L instance)
-            new: Replacement substring (str or L instance)
-            count: Maximum number of replacements (default: -1 = all)
-        
-        Returns:
-            L: New lazy string with replacements
-        
-        Examples:
-            >>> L('hello world').replace('o', 'X')
-            L('hellX wXrld')
-            >>> L('hello hello').replace('hello', 'goodbye', 1)
-            L('goodbye hello')
-        """
-        # Convert old and new to L instances
-        if isinstance(old, str):
-            old = L(old)
-        elif not isinstance(old, _lstring.L):
-            raise TypeError(f"replace() argument 1 must be str or L, not {type(old).__name__}")
-        
-        if isinstance(new, str):
-            new = L(new)
-        elif not isinstance(new, _lstring.L):
-            raise TypeError(f"replace() argument 2 must be str or L, not {type(new).__name__}")
-        
-        # Special case: empty old substring
-        old_len = len(old)
-        if old_len == 0:
-            raise ValueError("replace() cannot replace empty substring")
-        
-        # Generate segments, finding occurrences on the fly
-        def segments():
-            last_end = 0
-            replacements_done = 0
-            max_replacements = count if count >= 0 else float('inf')
-            
-            while replacements_done < max_replacements:
-                found = self.find(old, last_end)
-                if found == -1:
-                    break
-                
-                # Yield segment before this occurrence plus replacement
-                yield self[last_end:found] + new
-                last_end = found + old_len
-                replacements_done += 1
-            
-            # Yield final segment after last occurrence (if not empty)
-            if last_end < len(self):
-                yield self[last_end:]
-        
-        # Check if any replacements will be made
-        first_occurrence = self.find(old, 0)
-        if first_occurrence == -1:
-            return self
-        
-        # Join segments without separator
-        return L('').join(segments())
-    
-    # ============================================================================
-    # Splitting and Joining
-    # ============================================================================
-    
-    def split(self, sep=None, maxsplit=-1):
-        """
-        Split string by separator.
-        
-        Args:
-            sep: Separator to split by (str or L instance, or None for whitespace)
-            maxsplit: Maximum number of splits (default: -1 = all)
-        
-        Returns:
-            list: List of L instances
-        
-        Examples:
-            >>> L('a,b,c').split(',')
-            [L('a'), L('b'), L('c')]
-            >>> L('a  b  c').split()
-            [L('a'), L('b'), L('c')]
-            >>> L('a,b,c').split(',', 1)
-            [L('a'), L('b,c')]
-        """
-        return list(self.split_iter(sep, maxsplit))
-    
-    def split_iter(self, sep=None, maxsplit=-1):
-        """
-        Split string by separator, returning an iterator.
-        
-        Args:
-            sep: Separator to split by (str or L instance, or None for whitespace)
-            maxsplit: Maximum number of splits (default: -1 = all)
-        
-        Yields:
-            L instances
-        
-        Examples:
-            >>> list(L('a,b,c').split_iter(','))
-            [L('a'), L('b'), L('c')]
-            >>> list(L('a  b  c').split_iter())
-            [L('a'), L('b'), L('c')]
-            >>> list(L('a,b,c').split_iter(',', 1))
-            [L('a'), L('b,c')]
-        """
-        # Split by whitespace if sep is None
-        if sep is None:
-            yield from self._split_whitespace_iter(maxsplit)
-            return
-        
-        # Convert sep to L if it's a string
-        if isinstance(sep, str):
-            sep = L(sep)
-        elif not isinstance(sep, _lstring.L):
-            raise TypeError(f"split() argument must be str or L, not {type(sep).__name__}")
-        
-        # Empty separator is not allowed
-        sep_len = len(sep)
-        if sep_len == 0:
-            raise ValueError("empty separator")
-        
-        # Generate segments by splitting on separator
-        last_end = 0
-        splits_done = 0
-        max_splits = maxsplit if maxsplit >= 0 else float('inf')
-        
-        while splits_done < max_splits:
-            found = self.find(sep, last_end)
-            if found == -1:
-                break
-            
-            # Yield segment before separator (may be empty)
-            yield self[last_end:found]
-            last_end = found + sep_len
-            splits_done += 1
-        
-        # Yield final segment
-        yield self[last_end:]
-    
-    def _split_whitespace_iter(self, maxsplit=-1):
-        """
-        Split string by whitespace, merging consecutive whitespace, returning an iterator.
-        
-        Args:
-            maxsplit: Maximum number of splits (default: -1 = all)
-        
-        Yields:
-            L instances (non-empty)
-        """
-        length = len(self)
-        pos = 0
-        splits_done = 0
-        max_splits = maxsplit if maxsplit >= 0 else float('inf')
-        
-        while pos < length and splits_done < max_splits:
-            # Skip leading whitespace using findcc
-            non_space = self.findcc(CharClass.SPACE, pos, length, invert=True)
-            if non_space == -1:
-                break
-            pos = non_space
-            
-            # Find end of non-whitespace segment using findcc
-            start = pos
-            space = self.findcc(CharClass.SPACE, pos, length)
-            if space == -1:
-                pos = length
-            else:
-                pos = space
-            
-            # Yield segment
-            yield self[start:pos]
-            splits_done += 1
-        
-        # If we hit maxsplit, add the rest as final segment
-        if splits_done >= max_splits and pos < length:
-            # Skip leading whitespace of final segment using findcc
-            non_space = self.findcc(CharClass.SPACE, pos, length, invert=True)
-            if non_space != -1:
-                yield self[non_space:]
-    
-    def rsplit(self, sep=None, maxsplit=-1):
-        """
-        Split string by separator from the right.
-        
-        Args:
-            sep: Separator to split by (str or L instance, or None for whitespace)
-            maxsplit: Maximum number of splits (default: -1 = all)
-        
-        Returns:
-            list: List of L instances
-        
-        Examples:
-            >>> L('a,b,c').rsplit(',')
-            [L('a'), L('b'), L('c')]
-            >>> L('a,b,c').rsplit(',', 1)
-            [L('a,b'), L('c')]
-        """
-        # Reverse result since rsplit_iter yields from right to left
-        return list(reversed(list(self.rsplit_iter(sep, maxsplit))))
-    
-    def rsplit_iter(self, sep=None, maxsplit=-1):
-        """
-        Split string by separator from the right, returning an iterator.
-        
-        Yields segments from right to left.
-        
-        Args:
-            sep: Separator to split by (str or L instance, or None for whitespace)
-            maxsplit: Maximum number of splits (default: -1 = all)
-        
-        Yields:
-            L instances (from right to left)
-        
-        Examples:
-            >>> list(reversed(list(L('a,b,c').rsplit_iter(','))))
-            [L('a'), L('b'), L('c')]
-            >>> list(reversed(list(L('a,b,c').rsplit_iter(',', 1))))
-            [L('a,b'), L('c')]
-        """
-        # Split by whitespace if sep is None
-        if sep is None:
-            yield from self._rsplit_whitespace_iter(maxsplit)
-            return
-        
-        # Convert sep to L if it's a string
-        if isinstance(sep, str):
-            sep = L(sep)
-        elif not isinstance(sep, _lstring.L):
-            raise TypeError(f"rsplit() argument must be str or L, not {type(sep).__name__}")
-        
-        # Empty separator is not allowed
-        sep_len = len(sep)
-        if sep_len == 0:
-            raise ValueError("empty separator")
-        
-        # Generate segments by splitting on separator from right
-        last_start = len(self)
-        splits_done = 0
-        max_splits = maxsplit if maxsplit >= 0 else float('inf')
-        
-        while splits_done < max_splits:
-            found = self.rfind(sep, 0, last_start)
-            if found == -1:
-                break
-            
-            # Yield segment after separator (may be empty)
-            yield self[found + sep_len:last_start]
-            last_start = found
-            splits_done += 1
-        
-        # Yield final segment (leftmost part)
-        yield self[:last_start]
-    
-    def _rsplit_whitespace_iter(self, maxsplit=-1):
-        """
-        Split string by whitespace from the right, merging consecutive whitespace.
-        
-        Yields segments from right to left.
-        
-        Args:
-            maxsplit: Maximum number of splits (default: -1 = all)
-        
-        Yields:
-            L instances (non-empty, from right to left)
-        """
-        length = len(self)
-        pos = length
-        splits_done = 0
-        max_splits = maxsplit if maxsplit >= 0 else float('inf')
-        
-        while pos > 0 and splits_done < max_splits:
-            # Skip trailing whitespace using rfindcc
-            non_space = self.rfindcc(CharClass.SPACE, 0, pos, invert=True)
-            if non_space == -1:
-                break
-            pos = non_space + 1  # rfindcc returns index, we need position after it
-            
-            # Find start of non-whitespace segment using rfindcc
-            end = pos
-            space = self.rfindcc(CharClass.SPACE, 0, pos)
-            if space == -1:
-                pos = 0
-            else:
-                pos = space + 1  # Position after the space
-            
-            # Yield segment
-            yield self[pos:end]
-            splits_done += 1
-            
-            # Move position to before the whitespace we just found
-            if space != -1:
-                pos = space
-        
-        # If we hit maxsplit, add the rest as final segment (everything remaining)
-        if splits_done >= max_splits and pos > 0:
-            # Find the last non-space character
-            non_space = self.rfindcc(CharClass.SPACE, 0, pos, invert=True)
-            if non_space != -1:
-                yield self[:non_space + 1]
-    
-    def splitlines(self, keepends=False):
-        """
-        Split string by line boundaries.
-        
-        Line boundaries include: \\n, \\r, \\r\\n, \\v, \\f, \\x1c, \\x1d, \\x1e, \\x85, \\u2028, \\u2029
-        
-        Args:
-            keepends: If True, line breaks are included in the resulting strings (default: False)
-        
-        Returns:
-            list: List of L instances representing lines
-        
-        Examples:
-            >>> L('hello\\nworld\\r\\ntest').splitlines()
-            [L('hello'), L('world'), L('test')]
-            >>> L('hello\\nworld\\n').splitlines(keepends=True)
-            [L('hello\\n'), L('world\\n')]
-            >>> L('line1\\r\\nline2').splitlines()
-            [L('line1'), L('line2')]
-        """
-        return list(self.splitlines_iter(keepends))
-
-    def splitlines_iter(self, keepends=False):
-        """
-        Split string by line boundaries, returning an iterator.
-        
-        Line boundaries include: \\n, \\r, \\r\\n, \\v, \\f, \\x1c, \\x1d, \\x1e, \\x85, \\u2028, \\u2029
-        
-        Args:
-            keepends: If True, line breaks are included in the resulting strings (default: False)
-        
-        Yields:
-            L instances representing lines
-        
-        Examples:
-            >>> list(L('hello\\nworld\\r\\ntest').splitlines_iter())
-            [L('hello'), L('world'), L('test')]
-            >>> list(L('hello\\nworld\\n').splitlines_iter(keepends=True))
-            [L('hello\\n'), L('world\\n')]
-            >>> list(L('line1\\r\\nline2').splitlines_iter())
-            [L('line1'), L('line2')]
-        """
-        # Line break characters according to Python's str.splitlines()
-        # \n (LF), \r (CR), \v (VT), \f (FF), \x1c (FS), \x1d (GS), \x1e (RS)
-        # \x85 (NEL), \u2028 (LS), \u2029 (PS)
-        line_breaks = L('\n\r\v\f\x1c\x1d\x1e\x85\u2028\u2029')
-        
-        if len(self) == 0:
-            return
-        
-        start = 0
-        length = len(self)
-        
-        while start < length:
-            # Find the next line break character using findcs
-            pos = self.findcs(line_breaks, start)
-            
-            if pos == -1:
-                # No more line breaks, add the rest
-                if start < length:
-                    yield self[start:]
-                break
-            
-            # Check if it's \r\n (CRLF) - treat as single line break
-            if pos < length - 1 and self[pos:pos+2] == L('\r\n'):
-                # Found \r\n
-                if keepends:
-                    yield self[start:pos + 2]
-                else:
-                    yield self[start:pos]
-                start = pos + 2
-            else:
-                # Single character line break
-                if keepends:
-                    yield self[start:pos + 1]
-                else:
-                    yield self[start:pos]
-                start = pos + 1
-
-    def partition(self, sep):
-        """
-        Partition string at first occurrence of separator.
-        
-        Returns a 3-tuple: (before, sep, after).
-        If separator is not found, returns (str, L(''), L('')).
-        
-        Args:
-            sep: Separator to partition by (str or L instance)
-        
-        Returns:
-            tuple: (before, sep, after) as L instances
-        
-        Examples:
-            >>> L('hello:world').partition(':')
-            (L('hello'), L(':'), L('world'))
-            >>> L('hello').partition(':')
-            (L('hello'), L(''), L(''))
-            >>> L('a:b:c').partition(':')
-            (L('a'), L(':'), L('b:c'))
-        """
-        # Use split with maxsplit=1 (it will validate and convert sep)
-        parts = self.split(sep, 1)
-        
-        if len(parts) == 1:
-            # Separator not found
-            return (self, L(''), L(''))
-        else:
-            # Separator found - convert sep to L if needed for return value
-            if isinstance(sep, str):
-                sep = L(sep)
-            return (parts[0], sep, parts[1])
-    
-    def rpartition(self, sep):
-        """
-        Partition string at last occurrence of separator.
-        
-        Returns a 3-tuple: (before, sep, after).
-        If separator is not found, returns (L(''), L(''), str).
-        
-        Args:
-            sep: Separator to partition by (str or L instance)
-        
-        Returns:
-            tuple: (before, sep, after) as L instances
-        
-        Examples:
-            >>> L('hello:world').rpartition(':')
-            (L('hello'), L(':'), L('world'))
-            >>> L('hello').rpartition(':')
-            (L(''), L(''), L('hello'))
-            >>> L('a:b:c').rpartition(':')
-            (L('a:b'), L(':'), L('c'))
-        """
-        # Use rsplit with maxsplit=1 (it will validate and convert sep)
-        parts = self.rsplit(sep, 1)
-        
-        if len(parts) == 1:
-            # Separator not found
-            return (L(''), L(''), self)
-        else:
-            # Separator found - convert sep to L if needed for return value
-            if isinstance(sep, str):
-                sep = L(sep)
-            return (parts[0], sep, parts[1])
-    
-    def join(self, iterable):
-        """
-        Join elements of iterable with self as separator.
-        
-        Uses recursive binary splitting to build a balanced tree structure
-        for efficient lazy string operations.
-        
-        Args:
-            iterable: An iterable of str or L instances
-        
-        Returns:
-            L: A lazy string containing the joined elements
-        
-        Raises:
-            TypeError: If any element is not str or L instance
-        
-        Examples:
-            >>> L(', ').join(['a', 'b', 'c'])
-            L('a, b, c')
-            >>> L('').join(['hello', 'world'])
-            L('helloworld')
-        """
-        # Convert iterable to list to allow indexing and length operations
-        if isinstance(iterable, (list, tuple)):
-            items = iterable
-        else:
-            items = list(iterable)
-        
-        # Convert all items to L instances, validating types
-        converted_items = []
-        for i, item in enumerate(items):
-            if isinstance(item, _lstring.L):
-                converted_items.append(item)
-            elif isinstance(item, str):
-                converted_items.append(L(item))
-            else:
-                raise TypeError(
-                    f"sequence item {i}: expected str or L instance, "
-                    f"{type(item).__name__} found"
-                )
-        
-        # Special case: empty separator - just join without separator
-        if len(self) == 0:
-            return self._join_empty(converted_items)
-        else:
-            # Non-empty separator: append separator to all items except last
-            if len(converted_items) == 0:
-                return L('')
-            elif len(converted_items) == 1:
-                return converted_items[0]
-            else:
-                # Create new list where each item (except last) is concatenated with separator
-                items_with_sep = [converted_items[i] + self for i in range(len(converted_items) - 1)] + [converted_items[-1]]
-                return self._join_empty(items_with_sep)
-    
     # ============================================================================
     # Case Manipulation
     # ============================================================================
     
-    def lower(self):
-        """
-        Return a copy with all characters converted to lowercase.
-        
-        Returns:
-            L: Lowercase version of the string
-        
-        Examples:
-            >>> L('HELLO World').lower()
-            L('hello world')
-        """
-        return L(str(self).lower())
-    
-    def upper(self):
-        """
-        Return a copy with all characters converted to uppercase.
-        
-        Returns:
-            L: Uppercase version of the string
-        
-        Examples:
-            >>> L('hello World').upper()
-            L('HELLO WORLD')
-        """
-        return L(str(self).upper())
-    
-    def casefold(self):
-        """
-        Return a casefolded copy for caseless matching.
-        
-        Casefolding is similar to lowercasing but more aggressive,
-        suitable for caseless string matching.
-        
-        Returns:
-            L: Casefolded version of the string
-        
-        Examples:
-            >>> L('ß').casefold()
-            L('ss')
-            >>> L('HELLO').casefold()
-            L('hello')
-        """
-        return L(str(self).casefold())
-    
     def capitalize(self):
         """
         Return a copy with first character capitalized and the rest lowercased.
@@ -1161,19 +439,6 @@ class L(_lstring.L):
         """
         return L(str(self).title())
     
-    def swapcase(self):
-        """
-        Return a copy with uppercase converted to lowercase and vice versa.
-        
-        Returns:
-            L: String with swapped case
-        
-        Examples:
-            >>> L('Hello World').swapcase()
-            L('hELLO wORLD')
-        """
-        return L(str(self).swapcase())
-    
     # ============================================================================
     # Padding and Stripping
     # ============================================================================
@@ -1568,26 +833,6 @@ class L(_lstring.L):
     # Translation and Encoding
     # ============================================================================
     
-    def translate(self, table):
-        """
-        Return a copy with each character mapped through the translation table.
-        
-        Args:
-            table: Translation table (mapping from Unicode ordinals to ordinals, strings, or None)
-        
-        Returns:
-            L: Translated string
-        
-        Examples:
-            >>> table = str.maketrans('aeiou', '12345')
-            >>> L('hello world').translate(table)
-            L('h2ll4 w4rld')
-            >>> table = str.maketran>s('', '', 'aeiou')
-            >>> L('hello world').translate(table)
-            L('hll wrld')
-        """
-        return L(str(self).translate(table))
-    
     @staticmethod
     def maketrans(*args, **kwargs):
         """
@@ -1615,58 +860,92 @@ class L(_lstring.L):
         """
         return str.maketrans(*args, **kwargs)
     
-    def encode(self, encoding='utf-8', errors='strict'):
+    def write_to(self, fileobj, chunk_size=65536):
         """
-        Encode string to bytes using the specified encoding.
+        Write the UTF-8 encoding of the string to a binary file object.
+        
+        The bytes come from iter_chunks(), so the string is never
+        materialized as a whole.
         
         Args:
-            encoding: The encoding to use (default: 'utf-8')
-            errors: Error handling scheme (default: 'strict')
+            fileobj: Object with a write(bytes) method (file, socket.makefile(), BytesIO)
+            chunk_size: Target chunk size passed to iter_chunks()
         
         Returns:
-            bytes: Encoded byte string
+            int: Number of bytes written
         
         Examples:
-            >>> L('hello').encode()
-            b'hello'
-            >>> L('привет').encode('utf-8')
-            b'\\xd0\\xbf\\xd1\\x80\\xd0\\xb8\\xd0\\xb2\\xd0\\xb5\\xd1\\x82'
-        """
-        return str(self).encode(encoding, errors)
-    
-    # ============================================================================
-    # Helper methods (private, used by other methods)
-    # ============================================================================
-    
-    def _join_empty(self, items):
-        """
-        Helper method to join items without separator using recursive binary splitting.
-        
-        Builds a balanced tree by recursively dividing the list in half.
-        
-        Args:
-            items: List of L instances to join
-        
-        Returns:
-            L: Joined lazy string
+            >>> import io
+            >>> out = io.BytesIO()
+            >>> (L('hello ') + L('world')).write_to(out)
+            11
         """
-        if len(items) == 0:
-            return L('')
-        elif len(items) == 1:
-            return items[0]
-        elif len(items) == 2:
-            return items[0] + items[1]
-        else:
-            # Divide list in half and recursively join each half
-            mid = len(items) // 2
-            left = self._join_empty(items[:mid])
-            right = self._join_empty(items[mid:])
-            return left + right
+        write = fileobj.write
+        total = 0
+        for chunk in self.iter_chunks(chunk_size):
+            write(chunk)
+            total += len(chunk)
+        return total
 
 
 # Re-export utility functions from _lstring
 get_optimize_threshold = _lstring.get_optimize_threshold
 set_optimize_threshold = _lstring.set_optimize_threshold
+get_parallel_copy_threshold = _lstring.get_parallel_copy_threshold
+set_parallel_copy_threshold = _lstring.set_parallel_copy_threshold
+get_parallel_copy_threads = _lstring.get_parallel_copy_threads
+set_parallel_copy_threads = _lstring.set_parallel_copy_threads
+get_class_index_threshold = _lstring.get_class_index_threshold
+set_class_index_threshold = _lstring.set_class_index_threshold
+get_compact_min_leaf = _lstring.get_compact_min_leaf
+set_compact_min_leaf = _lstring.set_compact_min_leaf
+get_compact_max_leaf = _lstring.get_compact_max_leaf
+set_compact_max_leaf = _lstring.set_compact_max_leaf
+get_stats_enabled = _lstring.get_stats_enabled
+set_stats_enabled = _lstring.set_stats_enabled
+stats = _lstring.stats
+reset_stats = _lstring.reset_stats
+get_str_cache_limit = _lstring.get_str_cache_limit
+set_str_cache_limit = _lstring.set_str_cache_limit
+clear_str_cache = _lstring.clear_str_cache
+
+# Compiled needle for repeated searches
+Pattern = _lstring.Pattern
+
+
+class Builder(_lstring.Builder):
+    """
+    Incremental construction of an L.
+    
+    Appending to a Builder is amortized O(1): short pieces are copied into
+    chunks of code points, longer ones are referenced without copying, and
+    build() makes one balanced tree over all of them. Use it instead of
+    repeated `s = s + piece`, which builds a new join node per append.
+    
+    Args:
+        type: L subclass of the built value (default L)
+    
+    Examples:
+        >>> b = Builder()
+        >>> b.append('<li>')
+        >>> b.append_slice(L('xitemx'), 1, -1)
+        >>> b.extend(['</li>', '\\n'])
+        >>> b.build()
+        L('<li>item</li>\\n')
+    """
+    __slots__ = ()
+    
+    def __new__(cls, type=L):
+        return super().__new__(cls, type)
 
 
-__all__ = ['L', 'CharClass', 'get_optimize_threshold', 'set_optimize_threshold']
+__all__ = [
+    'L', 'CharClass', 'Pattern', 'Builder', 'get_optimize_threshold', 'set_optimize_threshold',
+    'get_parallel_copy_threshold', 'set_parallel_copy_threshold',
+    'get_parallel_copy_threads', 'set_parallel_copy_threads',
+    'get_class_index_threshold', 'set_class_index_threshold',
+    'get_compact_min_leaf', 'set_compact_min_leaf',
+    'get_compact_max_leaf', 'set_compact_max_leaf',
+    'get_stats_enabled', 'set_stats_enabled', 'stats', 'reset_stats',
+    'get_str_cache_limit', 'set_str_cache_limit', 'clear_str_cache',
+]
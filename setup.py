@@ -12,10 +12,22 @@ ext_modules = [
             'src/lstring_utils.cxx',
             'src/lstring_module.cxx',
             'src/buffer.cxx',
+            'src/lstring_pattern.cxx',
+            'src/simd.cxx',
+            'src/map_buffer.cxx',
+            'src/char_class_table.cxx',
+            'src/lstring_split.cxx',
+            'src/lstring_format.cxx',
+            'src/lstring_encode.cxx',
+            'src/utf8_buffer.cxx',
+            'src/lstring_builder.cxx',
+            'src/substring_index.cxx',
+            'src/str_cache.cxx',
         ],
         include_dirs=['.', './include'],
         depends=[
             'src/join_buffer.hxx',
+            'src/lstring_stats.hxx',
             'src/mul_buffer.hxx',
             'src/slice_buffer.hxx',
             'src/str_buffer.hxx',
@@ -24,6 +36,20 @@ ext_modules = [
             'src/_lstring.hxx',
             'src/lstring_utils.hxx',
             'src/charset.hxx',
+            'src/span.hxx',
+            'src/buffer_cursor.hxx',
+            'src/substring_search.hxx',
+            'src/lstring_pattern.hxx',
+            'src/simd.hxx',
+            'src/map_buffer.hxx',
+            'src/mmap_buffer.hxx',
+            'src/utf8_buffer.hxx',
+            'src/substring_index.hxx',
+            'src/str_cache.hxx',
+            'src/inline_buffer.hxx',
+            'src/poly_hash.hxx',
+            'src/class_index.hxx',
+            'src/char_class_table.hxx',
         ],
         language='c++',
     ),
@@ -49,6 +75,11 @@ class BuildExt(build_ext):
                 # at least C++11 (constexpr, override, make_unique, etc).
                 if '-std=c++17' not in extra_compile_args:
                     extra_compile_args.append('-std=c++17')
+                # std::thread is used by the parallel str() copy.
+                if '-pthread' not in extra_compile_args:
+                    extra_compile_args.append('-pthread')
+                if '-pthread' not in extra_link_args:
+                    extra_link_args.append('-pthread')
                 if sys.platform == 'darwin':
                     if '-stdlib=libc++' not in extra_compile_args:
                         extra_compile_args.append('-stdlib=libc++')
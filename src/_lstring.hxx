@@ -3,14 +3,93 @@
 /** Internal header for the lstring module */
 
 #include <Python.h>
+#include <atomic>
+#include <exception>
+#include <vector>
 #include "lstring/lstring.hxx"
 #include "tptr.hxx"
 
 /* Method table (defined in src/lstring_methods.cxx) */
 extern PyMethodDef LStr_methods[];
 
-/** Process-global optimize threshold declared in the module implementation. */
-extern Py_ssize_t LStr_optimize_threshold;
+/**
+ * Process-global settings defined in the module implementation. They are
+ * atomics because free-threaded builds may read them while another thread
+ * sets them.
+ */
+
+/** Process-global optimize threshold. */
+extern std::atomic<Py_ssize_t> LStr_optimize_threshold;
+
+/**
+ * @brief Process-global settings of the parallel str() materialization.
+ *
+ * Buffers of at least LStr_parallel_copy_threshold code points are copied
+ * by LStr_parallel_copy_threads workers (0: one per hardware thread). A
+ * threshold <= 0 disables the parallel mode.
+ */
+extern std::atomic<Py_ssize_t> LStr_parallel_copy_threshold;
+extern std::atomic<Py_ssize_t> LStr_parallel_copy_threads;
+
+/**
+ * @brief Process-global length from which str-backed buffers keep a
+ *        CharClassIndex for class searches; <= 0 disables the index.
+ */
+extern std::atomic<Py_ssize_t> LStr_class_index_threshold;
+
+/**
+ * @brief Process-global automatic compaction policy of concatenation.
+ *
+ * When LStr_compact_min_leaf > 0, concatenating two leaves shorter than it
+ * (at the seam of the operands) copies them into one leaf of at most
+ * LStr_compact_max_leaf code points instead of adding a join node.
+ */
+extern std::atomic<Py_ssize_t> LStr_compact_min_leaf;
+extern std::atomic<Py_ssize_t> LStr_compact_max_leaf;
+
+/**
+ * @brief Process-global byte limit of the str() materialization cache
+ *        (StrCache); <= 0 disables the cache.
+ */
+extern std::atomic<Py_ssize_t> LStr_str_cache_limit;
+
+/*
+ * Per-object critical sections only exist (and are only needed) in the
+ * free-threaded builds of Python 3.13+; with the GIL they are plain blocks.
+ */
+#ifndef Py_BEGIN_CRITICAL_SECTION
+#define Py_BEGIN_CRITICAL_SECTION(op) {
+#define Py_END_CRITICAL_SECTION() }
+#endif
+
+/** Scans over at least this many code points run with the GIL released. */
+static constexpr Py_ssize_t LSTR_NOGIL_SCAN_LENGTH = 1 << 14;
+
+/**
+ * @brief Run `fn()`, a scan over `length` code points, releasing the GIL
+ *        if the scan is long.
+ *
+ * Buffer trees are immutable once built and the scans read only C++ state
+ * and str storage, so `fn` may run without the GIL as long as it does not
+ * touch the C API and the caller keeps references to everything it reads.
+ * A C++ exception thrown by `fn` is rethrown once the GIL is held again.
+ */
+template <class Fn>
+inline auto scan_without_gil(Py_ssize_t length, Fn&& fn) -> decltype(fn()) {
+    if (length < LSTR_NOGIL_SCAN_LENGTH) return fn();
+
+    decltype(fn()) result{};
+    std::exception_ptr error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        result = fn();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    Py_END_ALLOW_THREADS
+    if (error) std::rethrow_exception(error);
+    return result;
+}
 
 /**
  * @brief Build a balanced JoinBuffer tree for concatenation.
@@ -19,4 +98,36 @@ extern Py_ssize_t LStr_optimize_threshold;
  */
 tptr<LStrObject> concat_balanced(PyTypeObject* type, const tptr<LStrObject>& left, const tptr<LStrObject>& right);
 
+/**
+ * @brief Build a balanced JoinBuffer tree over `pieces`, in order.
+ *
+ * The tree is built bottom-up from MultiJoinBuffer nodes of up to
+ * MultiJoinBuffer::FANOUT children, so n pieces take O(n) work and give a
+ * tree of height about log_FANOUT(n) (plus the height of the tallest piece)
+ * without rotations. A piece may appear several times (e.g. a shared
+ * separator). With automatic compaction enabled (LStr_compact_min_leaf),
+ * runs of short pieces are first copied into chunks. `pieces` must not be
+ * empty; it is consumed. Defined in src/lstring_concat.cxx.
+ */
+tptr<LStrObject> join_balanced(PyTypeObject* type, std::vector<tptr<LStrObject>>& pieces);
+
+/**
+ * @brief Copy `count` leaves into one new str leaf of type `type`.
+ *
+ * Defined in src/lstring_concat.cxx.
+ */
+tptr<LStrObject> make_chunk(PyTypeObject* type, const tptr<LStrObject>* leaves, size_t count);
+
+/**
+ * @brief Rebuild the join tree of `root` with runs of adjacent leaves
+ *        shorter than `min_leaf` copied into chunks of at most `max_leaf`
+ *        code points.
+ *
+ * Longer leaves are shared, and the result is rebuilt balanced by
+ * join_balanced. A root that is not a join is returned as is. Defined in
+ * src/lstring_concat.cxx.
+ */
+tptr<LStrObject> compact_tree(PyTypeObject* type, const tptr<LStrObject>& root,
+                              Py_ssize_t min_leaf, Py_ssize_t max_leaf);
+
 #endif // _LSTRING_XXH_
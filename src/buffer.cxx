@@ -1,8 +1,31 @@
+#include <algorithm>
+#include <new>
+
 #include "lstring/lstring.hxx"
 #include "_lstring.hxx"
 #include "charset.hxx"
+#include "char_class_table.hxx"
+#include "span.hxx"
+#include "buffer_cursor.hxx"
+#include "simd.hxx"
+#include "poly_hash.hxx"
+#include "substring_index.hxx"
+#include "str_cache.hxx"
+
+Buffer::~Buffer() {
+    delete substring_index.load(std::memory_order_acquire);
+    StrCache::release(this);
+}
+
+void* Buffer::operator new(size_t size) {
+    void* ptr = PyObject_Malloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
 
-Buffer::~Buffer() {}
+void Buffer::operator delete(void* ptr) noexcept {
+    PyObject_Free(ptr);
+}
 
 bool Buffer::is_a(int class_id) const {
     return class_id == buffer_class_id;
@@ -12,19 +35,62 @@ bool Buffer::is_str() const {
     return false;
 }
 
+bool Buffer::get_span(Py_ssize_t start, Py_ssize_t end, BufferSpan& span) const {
+    return false;
+}
+
+bool Buffer::visit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const {
+    if (start >= end) return true;
+    BufferSpan span;
+    if (get_span(start, end, span)) return visitor.visit(span);
+
+    uint32_t scratch[SPAN_SCRATCH_SIZE];
+    for (Py_ssize_t pos = start; pos < end; pos += SPAN_SCRATCH_SIZE) {
+        Py_ssize_t count = std::min(SPAN_SCRATCH_SIZE, end - pos);
+        copy(scratch, pos, count);
+        if (!visitor.visit(BufferSpan{PyUnicode_4BYTE_KIND, scratch, count})) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Buffer::rvisit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const {
+    if (start >= end) return true;
+    BufferSpan span;
+    if (get_span(start, end, span)) return visitor.visit(span);
+
+    uint32_t scratch[SPAN_SCRATCH_SIZE];
+    for (Py_ssize_t pos = end; pos > start; pos -= SPAN_SCRATCH_SIZE) {
+        Py_ssize_t count = std::min(SPAN_SCRATCH_SIZE, pos - start);
+        copy(scratch, pos - count, count);
+        if (!visitor.visit(BufferSpan{PyUnicode_4BYTE_KIND, scratch, count})) {
+            return false;
+        }
+    }
+    return true;
+}
+
 Py_ssize_t Buffer::findcs(Py_ssize_t start, Py_ssize_t end, const CharSet& charset, bool invert) const {
     if (start < 0) start = 0;
     Py_ssize_t len = length();
     if (end > len) end = len;
     if (start >= end) return -1;
-    for (Py_ssize_t i = start; i < end; ++i) {
-        uint32_t ch = value(i);
-        bool found = charset.is_in(ch);
-        if (found != invert) {
-            return i;
+    const ByteCharSet* bytes = nullptr;
+    const bool byte_kernel = charset.byte_subset(bytes);
+    return span_find_first(*this, start, end, [&](const BufferSpan& span) -> Py_ssize_t {
+        if (byte_kernel && span.kind == PyUnicode_1BYTE_KIND) {
+            if (!bytes) return invert && span.length > 0 ? 0 : -1;
+            return simd_find_byteset(static_cast<const Py_UCS1*>(span.data), span.length,
+                                     bytes->tables(), invert);
         }
-    }
-    return -1;
+        return with_span_data(span, [&](auto data, Py_ssize_t n) -> Py_ssize_t {
+            for (Py_ssize_t k = 0; k < n; ++k) {
+                if (charset.is_in(data[k]) != invert) return k;
+            }
+            return -1;
+        });
+    });
 }
 
 Py_ssize_t Buffer::rfindcs(Py_ssize_t start, Py_ssize_t end, const CharSet& charset, bool invert) const {
@@ -32,14 +98,21 @@ Py_ssize_t Buffer::rfindcs(Py_ssize_t start, Py_ssize_t end, const CharSet& char
     Py_ssize_t len = length();
     if (end > len) end = len;
     if (start >= end) return -1;
-    for (Py_ssize_t i = end - 1; i >= start; --i) {
-        uint32_t ch = value(i);
-        bool found = charset.is_in(ch);
-        if (found != invert) {
-            return i;
+    const ByteCharSet* bytes = nullptr;
+    const bool byte_kernel = charset.byte_subset(bytes);
+    return span_find_last(*this, start, end, [&](const BufferSpan& span) -> Py_ssize_t {
+        if (byte_kernel && span.kind == PyUnicode_1BYTE_KIND) {
+            if (!bytes) return invert ? span.length - 1 : -1;
+            return simd_rfind_byteset(static_cast<const Py_UCS1*>(span.data), span.length,
+                                      bytes->tables(), invert);
         }
-    }
-    return -1;
+        return with_span_data(span, [&](auto data, Py_ssize_t n) -> Py_ssize_t {
+            for (Py_ssize_t k = n - 1; k >= 0; --k) {
+                if (charset.is_in(data[k]) != invert) return k;
+            }
+            return -1;
+        });
+    });
 }
 
 Py_ssize_t Buffer::findcr(Py_ssize_t start, Py_ssize_t end, uint32_t startcp, uint32_t endcp, bool invert) const {
@@ -49,14 +122,11 @@ Py_ssize_t Buffer::findcr(Py_ssize_t start, Py_ssize_t end, uint32_t startcp, ui
     if (start >= end) return -1;
     if (startcp >= endcp) return -1;
 
-    for (Py_ssize_t i = start; i < end; ++i) {
-        uint32_t ch = value(i);
-        bool in_range = (ch >= startcp && ch < endcp);
-        if (in_range != invert) {
-            return i;
-        }
-    }
-    return -1;
+    return span_find_first(*this, start, end, [&](const BufferSpan& span) {
+        return with_span_data(span, [&](auto data, Py_ssize_t n) {
+            return simd_find_range(data, n, startcp, endcp, invert);
+        });
+    });
 }
 
 Py_ssize_t Buffer::rfindcr(Py_ssize_t start, Py_ssize_t end, uint32_t startcp, uint32_t endcp, bool invert) const {
@@ -66,29 +136,36 @@ Py_ssize_t Buffer::rfindcr(Py_ssize_t start, Py_ssize_t end, uint32_t startcp, u
     if (start >= end) return -1;
     if (startcp >= endcp) return -1;
 
-    for (Py_ssize_t i = end - 1; i >= start; --i) {
-        uint32_t ch = value(i);
-        bool in_range = (ch >= startcp && ch < endcp);
-        if (in_range != invert) {
-            return i;
-        }
-    }
-    return -1;
+    return span_find_last(*this, start, end, [&](const BufferSpan& span) {
+        return with_span_data(span, [&](auto data, Py_ssize_t n) {
+            return simd_rfind_range(data, n, startcp, endcp, invert);
+        });
+    });
 }
 
+/** 1-byte spans at least this long are searched with the vector byte set kernels. */
+static constexpr Py_ssize_t CLASS_BYTESET_LENGTH = 32;
+
 Py_ssize_t Buffer::findcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert) const {
     if (start < 0) start = 0;
     Py_ssize_t len = length();
     if (end > len) end = len;
     if (start >= end) return -1;
 
-    for (Py_ssize_t i = start; i < end; ++i) {
-        bool matches = char_is(value(i), class_mask);
-        if (matches != invert) {
-            return i;
+    const CharClassTable& classes = char_class_table();
+    const ByteSetTables* bytes = nullptr;
+    return span_find_first(*this, start, end, [&](const BufferSpan& span) {
+        if (span.kind == PyUnicode_1BYTE_KIND && span.length >= CLASS_BYTESET_LENGTH) {
+            if (!bytes) bytes = classes.byteset(class_mask, invert);
+            if (bytes) return simd_find_byteset(static_cast<const Py_UCS1*>(span.data), span.length, *bytes, false);
         }
-    }
-    return -1;
+        return with_span_data(span, [&](auto data, Py_ssize_t n) -> Py_ssize_t {
+            for (Py_ssize_t k = 0; k < n; ++k) {
+                if (classes.is(data[k], class_mask) != invert) return k;
+            }
+            return -1;
+        });
+    });
 }
 
 Py_ssize_t Buffer::rfindcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert) const {
@@ -97,13 +174,20 @@ Py_ssize_t Buffer::rfindcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask
     if (end > len) end = len;
     if (start >= end) return -1;
 
-    for (Py_ssize_t i = end - 1; i >= start; --i) {
-        bool matches = char_is(value(i), class_mask);
-        if (matches != invert) {
-            return i;
+    const CharClassTable& classes = char_class_table();
+    const ByteSetTables* bytes = nullptr;
+    return span_find_last(*this, start, end, [&](const BufferSpan& span) {
+        if (span.kind == PyUnicode_1BYTE_KIND && span.length >= CLASS_BYTESET_LENGTH) {
+            if (!bytes) bytes = classes.byteset(class_mask, invert);
+            if (bytes) return simd_rfind_byteset(static_cast<const Py_UCS1*>(span.data), span.length, *bytes, false);
         }
-    }
-    return -1;
+        return with_span_data(span, [&](auto data, Py_ssize_t n) -> Py_ssize_t {
+            for (Py_ssize_t k = n - 1; k >= 0; --k) {
+                if (classes.is(data[k], class_mask) != invert) return k;
+            }
+            return -1;
+        });
+    });
 }
 
 int Buffer::cmp(const Buffer* other) const {
@@ -111,124 +195,169 @@ int Buffer::cmp(const Buffer* other) const {
     Py_ssize_t len2 = other->length();
     Py_ssize_t minlen = (len1 < len2) ? len1 : len2;
 
-    for (Py_ssize_t i = 0; i < minlen; ++i) {
-        uint32_t c1 = value(i);
-        uint32_t c2 = other->value(i);
-        if (c1 < c2) return -1;
-        if (c1 > c2) return 1;
-    }
+    int result = compare_ranges(this, 0, other, 0, minlen);
+    if (result != 0) return result;
     if (len1 < len2) return -1;
     if (len1 > len2) return 1;
     return 0;
 }
 
+Py_uhash_t Buffer::scan_hash(Py_ssize_t start, Py_ssize_t end) const {
+    Py_uhash_t x = 0;
+    for_each_span(*this, start, end, [&](const BufferSpan& span) {
+        with_span_data(span, [&](auto data, Py_ssize_t n) {
+            for (Py_ssize_t k = 0; k < n; ++k) {
+                x = x * HASH_BASE + data[k];
+            }
+        });
+        return true;
+    });
+    return x;
+}
+
+int Buffer::scan_kind(Py_ssize_t start, Py_ssize_t end) const {
+    int kind = PyUnicode_1BYTE_KIND;
+    for_each_span(*this, start, end, [&](const BufferSpan& span) {
+        if (span.kind == PyUnicode_1BYTE_KIND) return true;
+        with_span_data(span, [&](auto data, Py_ssize_t n) {
+            if (span.kind == PyUnicode_4BYTE_KIND &&
+                simd_find_range(data, n, 0x10000, 0x110000, false) != -1) {
+                kind = PyUnicode_4BYTE_KIND;
+            } else if (kind == PyUnicode_1BYTE_KIND &&
+                       simd_find_range(data, n, 0x100, 0x110000, false) != -1) {
+                kind = PyUnicode_2BYTE_KIND;
+            }
+        });
+        return kind != PyUnicode_4BYTE_KIND;
+    });
+    return kind;
+}
+
+int Buffer::range_kind(Py_ssize_t start, Py_ssize_t end) const {
+    if (start >= end) return PyUnicode_1BYTE_KIND;
+    int kind = unicode_kind();
+    if (kind == PyUnicode_1BYTE_KIND || (start == 0 && end == length())) return kind;
+    return scan_kind(start, end);
+}
+
+Py_uhash_t Buffer::compute_hash() const {
+    return scan_hash(0, length());
+}
+
+Py_uhash_t Buffer::range_hash(Py_ssize_t start, Py_ssize_t end) const {
+    if (start == 0 && end == length()) return poly_hash();
+    return scan_hash(start, end);
+}
+
+bool Buffer::check_istitle_range(Py_ssize_t check_len) const {
+    if (check_len == 0) return false;
+    bool previous_is_cased = false;
+    bool has_cased = false;
+
+    bool titled = for_each_span(*this, 0, check_len, [&](const BufferSpan& span) {
+        return with_span_data(span, [&](auto data, Py_ssize_t n) {
+            for (Py_ssize_t k = 0; k < n; ++k) {
+                Py_UCS4 ch = data[k];
+
+                if (Py_UNICODE_ISUPPER(ch) || Py_UNICODE_ISTITLE(ch)) {
+                    if (previous_is_cased) {
+                        return false;
+                    }
+                    previous_is_cased = true;
+                    has_cased = true;
+                } else if (Py_UNICODE_ISLOWER(ch)) {
+                    if (!previous_is_cased) {
+                        return false;
+                    }
+                    previous_is_cased = true;
+                    has_cased = true;
+                } else {
+                    previous_is_cased = false;
+                }
+            }
+            return true;
+        });
+    });
+    return titled && has_cased;
+}
+
 bool Buffer::isspace() const {
     Py_ssize_t len = length();
     if (len == 0) return false;
-    for (Py_ssize_t i = 0; i < len; ++i) {
-        if (!Py_UNICODE_ISSPACE(value(i))) {
-            return false;
-        }
-    }
-    return true;
+    return findcc(0, len, CHAR_SPACE, true) == -1;
 }
 
 bool Buffer::isalpha() const {
     Py_ssize_t len = length();
     if (len == 0) return false;
-    for (Py_ssize_t i = 0; i < len; ++i) {
-        if (!Py_UNICODE_ISALPHA(value(i))) {
-            return false;
-        }
-    }
-    return true;
+    return findcc(0, len, CHAR_ALPHA, true) == -1;
 }
 
 bool Buffer::isdigit() const {
     Py_ssize_t len = length();
     if (len == 0) return false;
-    for (Py_ssize_t i = 0; i < len; ++i) {
-        if (!Py_UNICODE_ISDIGIT(value(i))) {
-            return false;
-        }
-    }
-    return true;
+    return findcc(0, len, CHAR_DIGIT, true) == -1;
 }
 
 bool Buffer::isalnum() const {
     Py_ssize_t len = length();
     if (len == 0) return false;
-    for (Py_ssize_t i = 0; i < len; ++i) {
-        if (!Py_UNICODE_ISALNUM(value(i))) {
-            return false;
-        }
-    }
-    return true;
+    // Py_UNICODE_ISALNUM also accepts decimals and digits.
+    return findcc(0, len, CHAR_ALPHA | CHAR_DECIMAL | CHAR_DIGIT | CHAR_NUMERIC, true) == -1;
 }
 
 bool Buffer::isupper() const {
     Py_ssize_t len = length();
     if (len == 0) return false;
+    const CharClassTable& classes = char_class_table();
     bool has_cased = false;
-    for (Py_ssize_t i = 0; i < len; ++i) {
-        Py_UCS4 ch = value(i);
-        if (Py_UNICODE_ISLOWER(ch)) {
-            return false;
+    Py_ssize_t lower = span_find_if(*this, 0, len, [&](uint32_t ch) {
+        uint32_t c = classes(ch);
+        if (c & CHAR_LOWER) {
+            return true;
         }
-        if (Py_UNICODE_ISUPPER(ch)) {
+        if (c & CHAR_UPPER) {
             has_cased = true;
         }
-    }
-    return has_cased;
+        return false;
+    });
+    return lower == -1 && has_cased;
 }
 
 bool Buffer::islower() const {
     Py_ssize_t len = length();
     if (len == 0) return false;
+    const CharClassTable& classes = char_class_table();
     bool has_cased = false;
-    for (Py_ssize_t i = 0; i < len; ++i) {
-        Py_UCS4 ch = value(i);
-        if (Py_UNICODE_ISUPPER(ch)) {
-            return false;
+    Py_ssize_t upper = span_find_if(*this, 0, len, [&](uint32_t ch) {
+        uint32_t c = classes(ch);
+        if (c & CHAR_UPPER) {
+            return true;
         }
-        if (Py_UNICODE_ISLOWER(ch)) {
+        if (c & CHAR_LOWER) {
             has_cased = true;
         }
-    }
-    return has_cased;
+        return false;
+    });
+    return upper == -1 && has_cased;
 }
 
 bool Buffer::isdecimal() const {
     Py_ssize_t len = length();
     if (len == 0) return false;
-    for (Py_ssize_t i = 0; i < len; ++i) {
-        if (!Py_UNICODE_ISDECIMAL(value(i))) {
-            return false;
-        }
-    }
-    return true;
+    return findcc(0, len, CHAR_DECIMAL, true) == -1;
 }
 
 bool Buffer::isnumeric() const {
     Py_ssize_t len = length();
     if (len == 0) return false;
-    for (Py_ssize_t i = 0; i < len; ++i) {
-        if (!Py_UNICODE_ISNUMERIC(value(i))) {
-            return false;
-        }
-    }
-    return true;
+    return findcc(0, len, CHAR_NUMERIC, true) == -1;
 }
 
 bool Buffer::isprintable() const {
     Py_ssize_t len = length();
     if (len == 0) return true;
-    for (Py_ssize_t i = 0; i < len; ++i) {
-        if (!Py_UNICODE_ISPRINTABLE(value(i))) {
-            return false;
-        }
-    }
-    return true;
+    return findcc(0, len, CHAR_PRINTABLE, true) == -1;
 }
 
 bool Buffer::istitle() const {
@@ -0,0 +1,306 @@
+#ifndef BUFFER_CURSOR_HXX
+#define BUFFER_CURSOR_HXX
+
+#include <Python.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "lstring/lstring.hxx"
+#include "span.hxx"
+#include "join_buffer.hxx"
+#include "mul_buffer.hxx"
+#include "slice_buffer.hxx"
+
+/**
+ * @brief Streaming cursor over a range of a Buffer tree.
+ *
+ * The cursor keeps an explicit descent stack through JoinBuffer,
+ * MultiJoinBuffer, Slice1Buffer and MulBuffer nodes and stays on the raw storage of the
+ * current leaf, moving to the next leaf only when the current span runs
+ * out. Advancing is O(1) amortized per code point regardless of the tree
+ * height. Buffers without contiguous storage are read in chunks through
+ * copy().
+ *
+ * The cursor walks [start, end) left to right, or right to left when
+ * constructed with `reverse` set. It borrows the buffer, which must outlive
+ * the cursor.
+ */
+class BufferCursor {
+public:
+    BufferCursor(const Buffer* buf, Py_ssize_t start, Py_ssize_t end, bool reverse = false)
+        : reverse_(reverse), span_{PyUnicode_1BYTE_KIND, nullptr, 0}, remaining_(0) {
+        stack_.reserve(16);
+        if (start < end) stack_.push_back(Frame{buf, start, end});
+    }
+
+    BufferCursor(const BufferCursor&) = delete;
+    BufferCursor& operator=(const BufferCursor&) = delete;
+
+    /**
+     * @brief Return the unconsumed part of the current span.
+     *
+     * Moves on to the next leaf if the current span is exhausted. For a
+     * reverse cursor the returned span ends at the current position.
+     *
+     * @return false once the whole range has been consumed.
+     */
+    bool current(BufferSpan& out) {
+        if (remaining_ == 0 && !fetch()) return false;
+        Py_ssize_t offset = reverse_ ? 0 : span_.length - remaining_;
+        out = subspan(span_, offset, remaining_);
+        return true;
+    }
+
+    /**
+     * @brief Consume `count` code points of the current span.
+     *
+     * `count` must not exceed the length reported by current().
+     */
+    void advance(Py_ssize_t count) {
+        remaining_ -= count;
+    }
+
+    /**
+     * @brief Whether the cursor sits between leaves, with no span loaded.
+     */
+    bool at_boundary() const {
+        return remaining_ == 0;
+    }
+
+    /**
+     * @brief Node and range the cursor will descend into next.
+     *
+     * Only meaningful at_boundary().
+     *
+     * @return The node, or nullptr once the whole range has been consumed.
+     */
+    const Buffer* next_node(Py_ssize_t& start, Py_ssize_t& end) const {
+        if (stack_.empty()) return nullptr;
+        const Frame& f = stack_.back();
+        start = f.start;
+        end = f.end;
+        return f.node;
+    }
+
+    /**
+     * @brief Consume `count` code points of next_node() without reading them.
+     *
+     * Only valid at_boundary(); `count` must not exceed the node's range.
+     */
+    void skip_node(Py_ssize_t count) {
+        Frame f = stack_.back();
+        stack_.pop_back();
+        if (reverse_) {
+            push(f.node, f.start, f.end - count);
+        } else {
+            push(f.node, f.start + count, f.end);
+        }
+    }
+
+    /**
+     * @brief Descend one level into next_node().
+     *
+     * Only valid at_boundary().
+     *
+     * @return true if the node was split into its children; false if it was
+     *         a leaf, whose span is now current, or nothing was left.
+     */
+    bool descend() {
+        if (stack_.empty()) return false;
+        return !expand();
+    }
+
+    /**
+     * @brief Check whether another code point is available.
+     */
+    bool has_next() {
+        return remaining_ > 0 || fetch();
+    }
+
+    /**
+     * @brief Consume and return the next code point.
+     *
+     * has_next() must have returned true.
+     */
+    uint32_t next() {
+        Py_ssize_t index = reverse_ ? remaining_ - 1 : span_.length - remaining_;
+        --remaining_;
+        switch (span_.kind) {
+            case PyUnicode_1BYTE_KIND:
+                return static_cast<const Py_UCS1*>(span_.data)[index];
+            case PyUnicode_2BYTE_KIND:
+                return static_cast<const Py_UCS2*>(span_.data)[index];
+            default:
+                return static_cast<const Py_UCS4*>(span_.data)[index];
+        }
+    }
+
+private:
+    struct Frame {
+        const Buffer* node;
+        Py_ssize_t start;
+        Py_ssize_t end;
+    };
+
+    void push(const Buffer* node, Py_ssize_t start, Py_ssize_t end) {
+        if (start < end) stack_.push_back(Frame{node, start, end});
+    }
+
+    /**
+     * @brief Descend to the next leaf span; return false at the end of range.
+     */
+    bool fetch() {
+        while (!stack_.empty()) {
+            if (expand()) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Pop the top frame and either load its span or push its children.
+     * @return true if a span was loaded.
+     */
+    bool expand() {
+        Frame f = stack_.back();
+        stack_.pop_back();
+        const Buffer* node = f.node;
+
+        if (node->get_span(f.start, f.end, span_)) {
+            remaining_ = span_.length;
+            return true;
+        }
+
+        if (node->is_a(JoinBuffer::buffer_class_id)) {
+            const JoinBuffer* join = static_cast<const JoinBuffer*>(node);
+            const Buffer* left = reinterpret_cast<LStrObject*>(join->left())->buffer;
+            const Buffer* right = reinterpret_cast<LStrObject*>(join->right())->buffer;
+            Py_ssize_t llen = left->length();
+            Py_ssize_t lend = std::min(f.end, llen);
+            Py_ssize_t rstart = std::max(f.start - llen, (Py_ssize_t)0);
+            // The part visited first goes on top of the stack.
+            if (reverse_) {
+                push(left, f.start, lend);
+                push(right, rstart, f.end - llen);
+            } else {
+                push(right, rstart, f.end - llen);
+                push(left, f.start, lend);
+            }
+            return false;
+        }
+
+        if (node->is_a(MultiJoinBuffer::buffer_class_id)) {
+            const MultiJoinBuffer* join = static_cast<const MultiJoinBuffer*>(node);
+            size_t first = join->child_index(f.start);
+            size_t last = join->child_index(f.end - 1);
+            auto push_child = [&](size_t i) {
+                const Buffer* child = reinterpret_cast<LStrObject*>(join->child(i))->buffer;
+                Py_ssize_t off = join->offset(i);
+                push(child, std::max(f.start - off, (Py_ssize_t)0),
+                     std::min(f.end, join->offset(i + 1)) - off);
+            };
+            // The child visited first goes on top of the stack.
+            if (reverse_) {
+                for (size_t i = first; i <= last; ++i) push_child(i);
+            } else {
+                for (size_t i = last + 1; i-- > first;) push_child(i);
+            }
+            return false;
+        }
+
+        if (node->is_a(Slice1Buffer::buffer_class_id) && !node->is_a(SliceBuffer::buffer_class_id)) {
+            const Slice1Buffer* slice = static_cast<const Slice1Buffer*>(node);
+            const Buffer* base = reinterpret_cast<LStrObject*>(slice->base())->buffer;
+            Py_ssize_t offset = slice->base_start();
+            push(base, f.start + offset, f.end + offset);
+            return false;
+        }
+
+        if (node->is_a(MulBuffer::buffer_class_id)) {
+            const MulBuffer* mul = static_cast<const MulBuffer*>(node);
+            const Buffer* base = reinterpret_cast<LStrObject*>(mul->base())->buffer;
+            Py_ssize_t base_len = base->length();
+            if (base_len <= 0) return false;
+            // Split off one repetition; the rest of the range stays on
+            // the stack below it.
+            if (reverse_) {
+                Py_ssize_t rep = (f.end - 1) / base_len;
+                Py_ssize_t off_end = f.end - rep * base_len;
+                Py_ssize_t count = std::min(off_end, f.end - f.start);
+                push(node, f.start, f.end - count);
+                push(base, off_end - count, off_end);
+            } else {
+                Py_ssize_t rep = f.start / base_len;
+                Py_ssize_t off = f.start - rep * base_len;
+                Py_ssize_t count = std::min(base_len - off, f.end - f.start);
+                push(node, f.start + count, f.end);
+                push(base, off, off + count);
+            }
+            return false;
+        }
+
+        // No contiguous storage: read a chunk into the scratch area.
+        Py_ssize_t count = std::min(SPAN_SCRATCH_SIZE, f.end - f.start);
+        if (reverse_) {
+            node->copy(scratch_, f.end - count, count);
+            push(node, f.start, f.end - count);
+        } else {
+            node->copy(scratch_, f.start, count);
+            push(node, f.start + count, f.end);
+        }
+        span_ = BufferSpan{PyUnicode_4BYTE_KIND, scratch_, count};
+        remaining_ = count;
+        return true;
+    }
+
+    bool reverse_;
+    std::vector<Frame> stack_;
+    BufferSpan span_;
+    Py_ssize_t remaining_;
+    uint32_t scratch_[SPAN_SCRATCH_SIZE];
+};
+
+/**
+ * @brief Compare `count` code points of a (from a_start) and b (from b_start).
+ *
+ * Both ranges are walked in lockstep with cursors, comparing the overlapping
+ * part of the current spans at a time. Between leaves, a subtree that both
+ * sides are about to enter at the same offset is equal on both and skipped
+ * whole; otherwise the side with the longer pending range descends one
+ * level first, so that subtrees shared below it can line up with the other
+ * side. Spans over the same storage are skipped by compare_spans().
+ *
+ * @return -1, 0 or 1 like Buffer::cmp.
+ */
+inline int compare_ranges(const Buffer* a, Py_ssize_t a_start,
+                          const Buffer* b, Py_ssize_t b_start, Py_ssize_t count) {
+    if (a == b && a_start == b_start) return 0;
+    BufferCursor ca(a, a_start, a_start + count);
+    BufferCursor cb(b, b_start, b_start + count);
+    BufferSpan sa, sb;
+    for (;;) {
+        if (ca.at_boundary() && cb.at_boundary()) {
+            Py_ssize_t as, ae, bs, be;
+            const Buffer* na = ca.next_node(as, ae);
+            const Buffer* nb = cb.next_node(bs, be);
+            if (!na || !nb) break;
+            if (na == nb && as == bs) {
+                Py_ssize_t n = std::min(ae, be) - as;
+                ca.skip_node(n);
+                cb.skip_node(n);
+                continue;
+            }
+            BufferCursor& longer = (ae - as >= be - bs) ? ca : cb;
+            if (longer.descend()) continue;
+        }
+        if (!ca.current(sa) || !cb.current(sb)) break;
+        Py_ssize_t n = std::min(sa.length, sb.length);
+        int result = compare_spans(sa, sb, n);
+        if (result != 0) return result;
+        ca.advance(n);
+        cb.advance(n);
+    }
+    return 0;
+}
+
+#endif // BUFFER_CURSOR_HXX
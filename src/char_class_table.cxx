@@ -0,0 +1,65 @@
+/**
+ * @file char_class_table.cxx
+ * @brief Construction of the code point to CharClass lookup table.
+ */
+
+#include <Python.h>
+#include <cstring>
+#include <map>
+#include <new>
+#include <string>
+
+#include "char_class_table.hxx"
+
+CharClassTable::CharClassTable() {
+    for (auto& sets : bytesets_) {
+        for (auto& set : sets) set.store(nullptr, std::memory_order_relaxed);
+    }
+    for (uint32_t ch = 0; ch < 0x100; ++ch) {
+        latin1_[ch] = static_cast<uint8_t>(char_classes(ch));
+    }
+
+    std::map<std::string, uint16_t> known_blocks;
+    std::string block(0x100, '\0');
+    for (uint32_t b = 0; b < 0x100; ++b) {
+        for (uint32_t i = 0; i < 0x100; ++i) {
+            block[i] = static_cast<char>(char_classes((b << 8) | i));
+        }
+        auto inserted = known_blocks.emplace(block, static_cast<uint16_t>(known_blocks.size()));
+        if (inserted.second) {
+            bmp_blocks_.insert(bmp_blocks_.end(), block.begin(), block.end());
+        }
+        bmp_index_[b] = inserted.first->second;
+    }
+}
+
+CharClassTable::~CharClassTable() {
+    for (auto& sets : bytesets_) {
+        for (auto& set : sets) delete set.load(std::memory_order_relaxed);
+    }
+}
+
+const ByteSetTables* CharClassTable::byteset(uint32_t class_mask, bool invert) const {
+    // Only the low byte of a mask names classes.
+    std::atomic<const ByteSetTables*>& slot = bytesets_[invert][class_mask & 0xFF];
+    const ByteSetTables* set = slot.load(std::memory_order_acquire);
+    if (set) return set;
+
+    ByteSetTables* built = new (std::nothrow) ByteSetTables{};
+    if (!built) return nullptr;
+    for (uint32_t ch = 0; ch < 0x100; ++ch) {
+        if (is(ch, class_mask) != invert) built->add(ch);
+    }
+    if (!slot.compare_exchange_strong(set, built, std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+        // Another thread published its set first; use that one.
+        delete built;
+        return set;
+    }
+    return built;
+}
+
+const CharClassTable& char_class_table() {
+    static const CharClassTable table;
+    return table;
+}
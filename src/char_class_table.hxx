@@ -0,0 +1,69 @@
+#ifndef CHAR_CLASS_TABLE_HXX
+#define CHAR_CLASS_TABLE_HXX
+
+#include <Python.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "lstring/lstring.hxx"
+#include "simd.hxx"
+
+/**
+ * @brief Lookup table from code points to their CharClass flags.
+ *
+ * Latin-1 is a flat 256-entry table; the rest of the BMP is a two-level
+ * table of 256-code-point blocks, where identical blocks are stored once.
+ * Code points above the BMP are classified with char_classes().
+ *
+ * The table is built from the Py_UNICODE_IS* predicates when first used, so
+ * it always agrees with the Unicode database of the running interpreter.
+ */
+class CharClassTable {
+public:
+    CharClassTable();
+    ~CharClassTable();
+
+    CharClassTable(const CharClassTable&) = delete;
+    CharClassTable& operator=(const CharClassTable&) = delete;
+
+    /**
+     * @brief CharClass flags of a code point.
+     */
+    uint32_t operator()(uint32_t ch) const {
+        if (ch < 0x100) return latin1_[ch];
+        if (ch < 0x10000) return bmp_blocks_[((uint32_t)bmp_index_[ch >> 8] << 8) | (ch & 0xFF)];
+        return char_classes(ch);
+    }
+
+    /**
+     * @brief Whether a code point has one of the classes of the mask.
+     */
+    bool is(uint32_t ch, uint32_t class_mask) const {
+        return ((*this)(ch) & class_mask) != 0;
+    }
+
+    /**
+     * @brief Byte set of the Latin-1 code points that have one of the
+     *        classes of the mask (or, inverted, none of them), for the
+     *        vector kernels.
+     *
+     * Sets are built on first use and kept for the lifetime of the table.
+     * @return The set, or nullptr if it cannot be allocated.
+     */
+    const ByteSetTables* byteset(uint32_t class_mask, bool invert) const;
+
+private:
+    uint8_t latin1_[0x100];
+    uint16_t bmp_index_[0x100];
+    std::vector<uint8_t> bmp_blocks_;
+    mutable std::atomic<const ByteSetTables*> bytesets_[2][0x100];
+};
+
+/**
+ * @brief The process-wide table, built on first use (thread-safe). Defined
+ *        in src/char_class_table.cxx.
+ */
+const CharClassTable& char_class_table();
+
+#endif // CHAR_CLASS_TABLE_HXX
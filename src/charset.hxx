@@ -9,6 +9,10 @@
 #include <vector>
 
 #include "lstring/lstring.hxx"
+#include "span.hxx"
+#include "simd.hxx"
+
+class ByteCharSet;
 
 class CharSet {
 public:
@@ -18,28 +22,48 @@ public:
     virtual const bool is_in(Py_UCS4 ch) const = 0;
     virtual Py_UCS4 min_char() const = 0;
     virtual Py_UCS4 max_char() const = 0;
+
+    /**
+     * @brief Describe the members below 256 by a ByteCharSet.
+     *
+     * Lets searches over 1-byte data use the vectorized byte set kernels.
+     *
+     * @return true if `out` describes them (nullptr when there are none),
+     *         false if the set cannot describe them this way.
+     */
+    virtual bool byte_subset(const ByteCharSet*& out) const {
+        return false;
+    }
 };
 
 class ByteCharSet final : public CharSet {
 public:
-    ByteCharSet(const Py_UCS1* charset, Py_ssize_t length) : mask_{0, 0, 0, 0} {
+    ByteCharSet(const Py_UCS1* charset, Py_ssize_t length) : tables_{} {
         init_and_fill(charset, length);
     }
 
-    ByteCharSet(const Py_UCS2* charset, Py_ssize_t length) : mask_{0, 0, 0, 0} {
+    ByteCharSet(const Py_UCS2* charset, Py_ssize_t length) : tables_{} {
         init_and_fill(charset, length);
     }
 
-    ByteCharSet(const Py_UCS4* charset, Py_ssize_t length) : mask_{0, 0, 0, 0} {
+    ByteCharSet(const Py_UCS4* charset, Py_ssize_t length) : tables_{} {
         init_and_fill(charset, length);
     }
 
     const bool is_in(Py_UCS4 ch) const override {
-        if (ch > 0xFF) {
-            return false;
-        }
-        const uint32_t u = static_cast<uint32_t>(ch);
-        return (mask_[u >> 6] & (1ULL << (u & 63))) != 0;
+        return tables_.contains(static_cast<uint32_t>(ch));
+    }
+
+    bool byte_subset(const ByteCharSet*& out) const override {
+        out = this;
+        return true;
+    }
+
+    /**
+     * @brief Bitmap and nibble tables for the vectorized kernels.
+     */
+    const ByteSetTables& tables() const {
+        return tables_;
     }
 
     Py_UCS4 min_char() const override {
@@ -59,12 +83,11 @@ private:
             if (ch > 0xFF) {
                 throw std::invalid_argument("ByteCharSet: charset element out of [0, 256) range");
             }
-            const uint32_t u = static_cast<uint32_t>(ch);
-            mask_[u >> 6] |= (1ULL << (u & 63));
+            tables_.add(static_cast<uint32_t>(ch));
         }
     }
 
-    uint64_t mask_[4];
+    ByteSetTables tables_;
 };
 
 class SingleCharSet final : public CharSet {
@@ -93,6 +116,11 @@ public:
     Py_UCS4 max_char() const override {
         return max_char_;
     }
+
+    bool byte_subset(const ByteCharSet*& out) const override {
+        out = nullptr;
+        return min_char_ > 0xFF;
+    }
 private:
     template <class T>
     void init_and_fill(const T* charset, Py_ssize_t length) {
@@ -197,6 +225,15 @@ public:
         }
         return sets_.back()->max_char();
     }
+
+    bool byte_subset(const ByteCharSet*& out) const override {
+        // Only the first range can hold members below 256.
+        if (sets_.empty()) {
+            out = nullptr;
+            return true;
+        }
+        return sets_.front()->byte_subset(out);
+    }
 private:
     template <class GetChar>
     void build_from_indexed(Py_ssize_t length, GetChar get_char) {
@@ -211,7 +248,10 @@ private:
             const Py_UCS4 ch = static_cast<Py_UCS4>(get_char(i));
             chars.push_back(ch);
         }
+        build_from_chars(chars);
+    }
 
+    void build_from_chars(std::vector<Py_UCS4>& chars) {
         std::sort(chars.begin(), chars.end());
 
         const auto high_it = std::upper_bound(chars.begin(), chars.end(), static_cast<Py_UCS4>(0xFF));
@@ -243,7 +283,19 @@ private:
 
     void build_from_buffer(const Buffer& buf) {
         const Py_ssize_t length = buf.length();
-        build_from_indexed(length, [&](Py_ssize_t i) { return buf.value(i); });
+        if (length <= 0) {
+            return;
+        }
+
+        std::vector<Py_UCS4> chars;
+        chars.reserve(static_cast<size_t>(length));
+        for_each_span(buf, 0, length, [&](const BufferSpan& span) {
+            with_span_data(span, [&](auto data, Py_ssize_t n) {
+                chars.insert(chars.end(), data, data + n);
+            });
+            return true;
+        });
+        build_from_chars(chars);
     }
 
     template <class T>
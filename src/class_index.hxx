@@ -0,0 +1,175 @@
+#ifndef CLASS_INDEX_HXX
+#define CLASS_INDEX_HXX
+
+#include <Python.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+#include "lstring/lstring.hxx"
+#include "char_class_table.hxx"
+#include "span.hxx"
+
+/**
+ * @brief Per-block summary of the character classes of a large buffer.
+ *
+ * For every CLASS_BLOCK code points the index records which CharClass flags
+ * occur in the block and which flags every code point of the block has.
+ * A class search can then skip the blocks that cannot contain a match;
+ * blocks are classified the first time a search reaches them, in the same
+ * pass that searches them, so the index costs nothing for the parts of a
+ * buffer that are never searched.
+ *
+ * The buffer must be immutable. Concurrent searches may classify the same
+ * block; they store the same summary.
+ */
+class CharClassIndex {
+public:
+    /** Code points summarized by one entry. */
+    static constexpr Py_ssize_t CLASS_BLOCK = 1024;
+
+    CharClassIndex() : blocks(nullptr) {}
+
+    ~CharClassIndex() {
+        delete[] blocks.load(std::memory_order_relaxed);
+    }
+
+    CharClassIndex(const CharClassIndex&) = delete;
+    CharClassIndex& operator=(const CharClassIndex&) = delete;
+
+    /**
+     * @brief Find the first code point of [start, end) matching the class
+     *        search, scanning only the blocks that may contain it.
+     *
+     * @param buf Indexed buffer.
+     * @param scan `Py_ssize_t scan(s, e)`: the unindexed search of [s, e).
+     * @return Index of the match, or -1.
+     */
+    template <class Scan>
+    Py_ssize_t find(const Buffer& buf, Py_ssize_t start, Py_ssize_t end,
+                    uint32_t class_mask, bool invert, Scan&& scan) const {
+        std::atomic<uint32_t>* index = get_blocks(buf);
+        if (!index) return scan(start, end);
+        for (Py_ssize_t b = start / CLASS_BLOCK; b * CLASS_BLOCK < end; ++b) {
+            Py_ssize_t s = std::max(start, b * CLASS_BLOCK);
+            Py_ssize_t e = std::min(end, (b + 1) * CLASS_BLOCK);
+            uint32_t entry = index[b].load(std::memory_order_relaxed);
+            Py_ssize_t found;
+            if (!(entry & KNOWN)) {
+                found = classify(buf, index, b, s, e, class_mask, invert, false);
+            } else if (may_match(entry, class_mask, invert)) {
+                found = scan(s, e);
+            } else {
+                continue;
+            }
+            if (found != -1) return found;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Find the last matching code point of [start, end); see find().
+     */
+    template <class Scan>
+    Py_ssize_t rfind(const Buffer& buf, Py_ssize_t start, Py_ssize_t end,
+                     uint32_t class_mask, bool invert, Scan&& scan) const {
+        std::atomic<uint32_t>* index = get_blocks(buf);
+        if (!index) return scan(start, end);
+        for (Py_ssize_t b = (end - 1) / CLASS_BLOCK; b >= 0 && (b + 1) * CLASS_BLOCK > start; --b) {
+            Py_ssize_t s = std::max(start, b * CLASS_BLOCK);
+            Py_ssize_t e = std::min(end, (b + 1) * CLASS_BLOCK);
+            uint32_t entry = index[b].load(std::memory_order_relaxed);
+            Py_ssize_t found;
+            if (!(entry & KNOWN)) {
+                found = classify(buf, index, b, s, e, class_mask, invert, true);
+            } else if (may_match(entry, class_mask, invert)) {
+                found = scan(s, e);
+            } else {
+                continue;
+            }
+            if (found != -1) return found;
+        }
+        return -1;
+    }
+
+private:
+    /** Entry bits: present classes, classes of every code point, known. */
+    static constexpr uint32_t COMPLETE_SHIFT = 8;
+    static constexpr uint32_t KNOWN = 1u << 16;
+
+    /**
+     * @brief Whether a block with summary `entry` may contain a code point
+     *        that has one of the classes of the mask (or, inverted, that
+     *        has none of them).
+     */
+    static bool may_match(uint32_t entry, uint32_t class_mask, bool invert) {
+        if (invert) return ((entry >> COMPLETE_SHIFT) & class_mask) == 0;
+        return (entry & class_mask) != 0;
+    }
+
+    /**
+     * @brief Classify block b and, in the same pass, find the first (or,
+     *        if reverse, last) matching code point of [s, e) within it.
+     *
+     * @return Index of the match, or -1.
+     */
+    static Py_ssize_t classify(const Buffer& buf, std::atomic<uint32_t>* index, Py_ssize_t b,
+                               Py_ssize_t s, Py_ssize_t e, uint32_t class_mask, bool invert,
+                               bool reverse) {
+        Py_ssize_t pos = b * CLASS_BLOCK;
+        Py_ssize_t block_end = std::min(buf.length(), pos + CLASS_BLOCK);
+        const CharClassTable& classes_of = char_class_table();
+        uint32_t present = 0;
+        uint32_t complete = 0xFF;
+        Py_ssize_t found = -1;
+        for_each_span(buf, pos, block_end, [&](const BufferSpan& span) {
+            with_span_data(span, [&](auto data, Py_ssize_t n) {
+                // Locals, so that the stores do not alias the 1-byte data.
+                const Py_ssize_t lo = s - pos, hi = e - pos;
+                uint32_t span_present = 0;
+                uint32_t span_complete = 0xFF;
+                Py_ssize_t span_found = -1;
+                uint32_t prev = 0;
+                bool match = false;
+                for (Py_ssize_t k = 0; k < n; ++k) {
+                    // Runs of one character are classified once.
+                    if (k == 0 || data[k] != prev) {
+                        prev = data[k];
+                        uint32_t classes = classes_of(prev);
+                        span_present |= classes;
+                        span_complete &= classes;
+                        match = ((classes & class_mask) != 0) != invert;
+                    }
+                    if (match && k >= lo && k < hi && (reverse || span_found == -1)) span_found = k;
+                }
+                present |= span_present;
+                complete &= span_complete;
+                if (span_found != -1 && (reverse || found == -1)) found = pos + span_found;
+                pos += n;
+            });
+            return true;
+        });
+        index[b].store(KNOWN | present | (complete << COMPLETE_SHIFT), std::memory_order_relaxed);
+        return found;
+    }
+
+    std::atomic<uint32_t>* get_blocks(const Buffer& buf) const {
+        std::atomic<uint32_t>* index = blocks.load(std::memory_order_acquire);
+        if (index) return index;
+        Py_ssize_t count = (buf.length() + CLASS_BLOCK - 1) / CLASS_BLOCK;
+        std::atomic<uint32_t>* built = new (std::nothrow) std::atomic<uint32_t>[count]();
+        if (!built) return nullptr;
+        if (!blocks.compare_exchange_strong(index, built, std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+            // Another thread published its index first; use that one.
+            delete[] built;
+            return index;
+        }
+        return built;
+    }
+
+    mutable std::atomic<std::atomic<uint32_t>*> blocks;
+};
+
+#endif // CLASS_INDEX_HXX
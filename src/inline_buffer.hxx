@@ -0,0 +1,157 @@
+#ifndef INLINE_BUFFER_HXX
+#define INLINE_BUFFER_HXX
+
+#include <Python.h>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <cppy/ptr.h>
+
+#include "lstring/lstring.hxx"
+#include "span.hxx"
+
+/**
+ * @brief InlineBuffer — short string stored inside the buffer node
+ *
+ * Keeps up to CAPACITY_BYTES bytes of code points directly in the node, at
+ * the narrowest width that holds them, so a short collapsed result needs no
+ * Python str until str() is called.
+ */
+class InlineBuffer : public Buffer {
+public:
+    static constexpr int buffer_class_id = 11;
+
+    /** Storage size: 64 1-byte, 32 2-byte or 16 4-byte code points. */
+    static constexpr Py_ssize_t CAPACITY_BYTES = 64;
+
+    bool is_a(int class_id) const override {
+        return class_id == buffer_class_id || Buffer::is_a(class_id);
+    }
+
+    /**
+     * @brief Whether `length` code points of the given kind fit inline.
+     */
+    static bool fits(Py_ssize_t length, int kind) {
+        return length * kind <= CAPACITY_BYTES;
+    }
+
+    /**
+     * @brief Copy the whole content of `src` into a new inline buffer.
+     *
+     * @param src Source buffer.
+     * @param src_kind Exact unicode kind of `src`.
+     * @throws std::length_error if the content does not fit.
+     */
+    InlineBuffer(const Buffer& src, int src_kind) : len(src.length()), kind(src_kind) {
+        if (!fits(len, kind)) {
+            throw std::length_error("InlineBuffer: content too long");
+        }
+        switch (kind) {
+            case PyUnicode_1BYTE_KIND:
+                src.copy(reinterpret_cast<uint8_t*>(data), 0, len);
+                break;
+            case PyUnicode_2BYTE_KIND:
+                src.copy(reinterpret_cast<uint16_t*>(data), 0, len);
+                break;
+            default:
+                src.copy(reinterpret_cast<uint32_t*>(data), 0, len);
+                break;
+        }
+    }
+
+    ~InlineBuffer() override = default;
+
+    Py_ssize_t length() const override {
+        return len;
+    }
+
+    int unicode_kind() const override {
+        return kind;
+    }
+
+    uint32_t value(Py_ssize_t index) const override {
+        if (index < 0 || index >= len) throw std::out_of_range("InlineBuffer: index out of range");
+        return with_span_data(span(), [&](auto d, Py_ssize_t) {
+            return static_cast<uint32_t>(d[index]);
+        });
+    }
+
+    void copy(uint32_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_to(target, start, count);
+    }
+
+    void copy(uint16_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_to(target, start, count);
+    }
+
+    void copy(uint8_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_to(target, start, count);
+    }
+
+    /**
+     * @brief Produce the same repr as a str-backed buffer: L'<text>'.
+     */
+    PyObject* repr() const override {
+        cppy::ptr str(PyUnicode_FromKindAndData(kind, data, len));
+        if (!str) return nullptr;
+        cppy::ptr repr_obj(PyObject_Repr(str.get()));
+        if (!repr_obj) return nullptr;
+        return PyUnicode_FromFormat("L%U", repr_obj.get());
+    }
+
+    /**
+     * @brief Report [start, end) as a single span over the inline storage.
+     */
+    bool get_span(Py_ssize_t start, Py_ssize_t end, BufferSpan& out) const override {
+        out = subspan(span(), start, end - start);
+        return true;
+    }
+
+    Py_ssize_t findc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override {
+        if (start < 0) start = 0;
+        if (end > len) end = len;
+        if (start >= end) return -1;
+        return with_span_data(span(), [&](auto d, Py_ssize_t) -> Py_ssize_t {
+            for (Py_ssize_t k = start; k < end; ++k) {
+                if (d[k] == ch) return k;
+            }
+            return -1;
+        });
+    }
+
+    Py_ssize_t rfindc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override {
+        if (start < 0) start = 0;
+        if (end > len) end = len;
+        if (start >= end) return -1;
+        return with_span_data(span(), [&](auto d, Py_ssize_t) -> Py_ssize_t {
+            for (Py_ssize_t k = end - 1; k >= start; --k) {
+                if (d[k] == ch) return k;
+            }
+            return -1;
+        });
+    }
+
+private:
+    BufferSpan span() const {
+        return BufferSpan{kind, data, len};
+    }
+
+    template <class T>
+    void copy_to(T *target, Py_ssize_t start, Py_ssize_t count) const {
+        if ((int)sizeof(T) == kind) {
+            std::memcpy(target, data + start * kind, count * sizeof(T));
+            return;
+        }
+        with_span_data(span(), [&](auto d, Py_ssize_t) {
+            for (Py_ssize_t i = 0; i < count; ++i) {
+                target[i] = static_cast<T>(d[start + i]);
+            }
+        });
+    }
+
+    Py_ssize_t len;
+    int kind;
+    alignas(uint32_t) char data[CAPACITY_BYTES];
+};
+
+#endif // INLINE_BUFFER_HXX
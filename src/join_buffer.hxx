@@ -2,14 +2,25 @@
 #define JOIN_BUFFER_HXX
 
 #include <Python.h>
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <utility>
+#include <vector>
 
 #include "lstring/lstring.hxx"
+#include "poly_hash.hxx"
 #include "str_buffer.hxx"
 #include "tptr.hxx"
 #include "lstring_utils.hxx"
 #include <cppy/ptr.h>
 
+/**
+ * @brief Height of a join tree node: 1 for leaves, one more than the
+ *        tallest child for JoinBuffer and MultiJoinBuffer nodes.
+ */
+inline Py_ssize_t join_height(const Buffer* buf);
+
 /**
  * @brief JoinBuffer — concatenation of two buffers
  *
@@ -20,8 +31,9 @@ private:
     tptr<LStrObject> left_obj;
     tptr<LStrObject> right_obj;
 
-    mutable Py_ssize_t cached_len;
-    mutable Py_ssize_t cached_height;
+    mutable std::atomic<Py_ssize_t> cached_len;
+    mutable std::atomic<Py_ssize_t> cached_height;
+    mutable std::atomic<int> cached_kind;
 
     static inline bool normalize_range(Py_ssize_t total, Py_ssize_t& start, Py_ssize_t& end) {
         if (total <= 0) return false;
@@ -100,7 +112,7 @@ public:
      * @param right Right operand (borrowed reference)
      */
     JoinBuffer(PyObject *left, PyObject *right)
-        : left_obj(left, true), right_obj(right, true), cached_len(-1), cached_height(-1) {
+        : left_obj(left, true), right_obj(right, true), cached_len(-1), cached_height(-1), cached_kind(-1) {
     }
 
     /**
@@ -116,34 +128,53 @@ public:
      * @return Sum of left->length() and right->length().
      */
     Py_ssize_t length() const override {
-        if (cached_len != -1) return cached_len;
-        cached_len = left_obj->buffer->length() + right_obj->buffer->length();
-        return cached_len;
+        Py_ssize_t len = cached_len.load(std::memory_order_relaxed);
+        if (len != -1) return len;
+        len = left_obj->buffer->length() + right_obj->buffer->length();
+        cached_len.store(len, std::memory_order_relaxed);
+        return len;
     }
 
     Py_ssize_t height() const {
-        if (cached_height != -1) return cached_height;
-
-        auto child_height = [](const Buffer* buf) -> Py_ssize_t {
-            if (buf && buf->is_a(JoinBuffer::buffer_class_id)) {
-                return static_cast<const JoinBuffer*>(buf)->height();
-            }
-            return 1;
-        };
-
-        Py_ssize_t lh = child_height(left_obj->buffer);
-        Py_ssize_t rh = child_height(right_obj->buffer);
-        cached_height = 1 + (lh > rh ? lh : rh);
-        return cached_height;
+        Py_ssize_t height = cached_height.load(std::memory_order_relaxed);
+        if (height != -1) return height;
+
+        Py_ssize_t lh = join_height(left_obj->buffer);
+        Py_ssize_t rh = join_height(right_obj->buffer);
+        height = 1 + (lh > rh ? lh : rh);
+        cached_height.store(height, std::memory_order_relaxed);
+        return height;
     }
 
     /**
      * @brief Unicode storage kind required to represent the concatenation.
      *
-     * Returns the maximum unicode kind required by either side (1/2/4-byte).
+     * Returns the maximum unicode kind required by either side (1/2/4-byte),
+     * cached.
      */
     int unicode_kind() const override {
-        return std::max(left_obj->buffer->unicode_kind(), right_obj->buffer->unicode_kind());
+        int kind = cached_kind.load(std::memory_order_relaxed);
+        if (kind != -1) return kind;
+        kind = left_obj->buffer->unicode_kind();
+        if (kind != PyUnicode_4BYTE_KIND) {
+            kind = std::max(kind, right_obj->buffer->unicode_kind());
+        }
+        cached_kind.store(kind, std::memory_order_relaxed);
+        return kind;
+    }
+
+    /**
+     * @brief Combine the kinds of the parts of the range in each side.
+     */
+    int range_kind(Py_ssize_t start, Py_ssize_t end) const override {
+        if (start >= end) return PyUnicode_1BYTE_KIND;
+        if (start == 0 && end == length()) return unicode_kind();
+        Py_ssize_t llen = left_obj->buffer->length();
+        if (end <= llen) return left_obj->buffer->range_kind(start, end);
+        if (start >= llen) return right_obj->buffer->range_kind(start - llen, end - llen);
+        int kind = left_obj->buffer->range_kind(start, llen);
+        if (kind == PyUnicode_4BYTE_KIND) return kind;
+        return std::max(kind, right_obj->buffer->range_kind(0, end - llen));
     }
 
     /**
@@ -225,6 +256,54 @@ public:
         }
     }
 
+    /**
+     * @brief Visit spans of the left part of the range, then of the right part.
+     */
+    bool visit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override {
+        Py_ssize_t llen = left_obj->buffer->length();
+        if (start < llen) {
+            if (!left_obj->buffer->visit_spans(start, std::min(end, llen), visitor)) return false;
+        }
+        if (end > llen) {
+            return right_obj->buffer->visit_spans(std::max(start - llen, (Py_ssize_t)0), end - llen, visitor);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Visit spans of the right part of the range, then of the left part.
+     */
+    bool rvisit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override {
+        Py_ssize_t llen = left_obj->buffer->length();
+        if (end > llen) {
+            if (!right_obj->buffer->rvisit_spans(std::max(start - llen, (Py_ssize_t)0), end - llen, visitor)) return false;
+        }
+        if (start < llen) {
+            return left_obj->buffer->rvisit_spans(start, std::min(end, llen), visitor);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Combine the cached hashes of both sides: h(l) * 31^len(r) + h(r).
+     */
+    Py_uhash_t compute_hash() const override {
+        const Buffer* right = right_obj->buffer;
+        return hash_concat(left_obj->buffer->poly_hash(), right->poly_hash(), right->length());
+    }
+
+    /**
+     * @brief Hash the parts of the range in each side and combine them.
+     */
+    Py_uhash_t range_hash(Py_ssize_t start, Py_ssize_t end) const override {
+        if (start == 0 && end == length()) return poly_hash();
+        Py_ssize_t llen = left_obj->buffer->length();
+        if (end <= llen) return left_obj->buffer->range_hash(start, end);
+        if (start >= llen) return right_obj->buffer->range_hash(start - llen, end - llen);
+        return hash_concat(left_obj->buffer->range_hash(start, llen),
+                           right_obj->buffer->range_hash(0, end - llen), end - llen);
+    }
+
     /**
      * @brief Produce a Python-level repr for the concatenation.
      *
@@ -402,4 +481,332 @@ public:
     }
 };
 
+/**
+ * @brief MultiJoinBuffer — concatenation of up to FANOUT buffers
+ *
+ * A wide join node for bulk-built ropes: the children are kept in order
+ * with the prefix sums of their lengths, so locating the child of an
+ * index is one binary search over a small array, and a rope of n leaves
+ * is about log_FANOUT(n) levels (and as many Python objects per leaf
+ * fewer) deep instead of log2(n).
+ */
+class MultiJoinBuffer : public Buffer {
+private:
+    std::vector<tptr<LStrObject>> children;
+    // offsets[i] is the start of child i; offsets[count()] is the length.
+    std::vector<Py_ssize_t> offsets;
+    Py_ssize_t node_height;
+
+    mutable std::atomic<int> cached_kind;
+
+    const Buffer* child_buffer(size_t i) const {
+        return children[i]->buffer;
+    }
+
+    static inline bool normalize_range(Py_ssize_t total, Py_ssize_t& start, Py_ssize_t& end) {
+        if (total <= 0) return false;
+        if (start < 0) start = 0;
+        if (end < 0) end = 0;
+        if (start > total) return false;
+        if (end > total) end = total;
+        return start < end;
+    }
+
+    /**
+     * @brief Call fn(child, s, e) on the children parts of [start, end),
+     *        left to right, until it returns a position other than -1.
+     * @return That position, in this buffer's indices, or -1.
+     */
+    template <class Fn>
+    Py_ssize_t find_parts(Py_ssize_t start, Py_ssize_t end, Fn&& fn) const {
+        if (!normalize_range(length(), start, end)) return -1;
+        for (size_t i = child_index(start); i < children.size() && offsets[i] < end; ++i) {
+            Py_ssize_t off = offsets[i];
+            Py_ssize_t pos = fn(child_buffer(i), std::max(start, off) - off,
+                                std::min(end, offsets[i + 1]) - off);
+            if (pos != -1) return pos + off;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Like find_parts, right to left.
+     */
+    template <class Fn>
+    Py_ssize_t rfind_parts(Py_ssize_t start, Py_ssize_t end, Fn&& fn) const {
+        if (!normalize_range(length(), start, end)) return -1;
+        for (size_t i = child_index(end - 1) + 1; i-- > 0 && offsets[i + 1] > start;) {
+            Py_ssize_t off = offsets[i];
+            Py_ssize_t pos = fn(child_buffer(i), std::max(start, off) - off,
+                                std::min(end, offsets[i + 1]) - off);
+            if (pos != -1) return pos + off;
+        }
+        return -1;
+    }
+
+    template <class T>
+    void copy_parts(T *target, Py_ssize_t start, Py_ssize_t count) const {
+        Py_ssize_t end = start + count;
+        for (size_t i = child_index(start); i < children.size() && offsets[i] < end; ++i) {
+            Py_ssize_t s = std::max(start, offsets[i]);
+            Py_ssize_t e = std::min(end, offsets[i + 1]);
+            child_buffer(i)->copy(target + (s - start), s - offsets[i], e - s);
+        }
+    }
+
+    template <class Pred>
+    bool all_children(Pred&& pred) const {
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (!pred(child_buffer(i))) return false;
+        }
+        return true;
+    }
+
+public:
+    static constexpr int buffer_class_id = 12;
+
+    /** Maximum number of children of a node. */
+    static constexpr size_t FANOUT = 32;
+
+    bool is_a(int class_id) const override {
+        return class_id == buffer_class_id || Buffer::is_a(class_id);
+    }
+
+    /**
+     * @brief Construct a wide concatenation of `parts` (2..FANOUT objects
+     *        providing Buffer implementations), in order.
+     */
+    explicit MultiJoinBuffer(std::vector<tptr<LStrObject>> parts)
+        : children(std::move(parts)), node_height(1), cached_kind(-1) {
+        offsets.reserve(children.size() + 1);
+        Py_ssize_t len = 0;
+        for (const tptr<LStrObject>& child : children) {
+            offsets.push_back(len);
+            len += child->buffer->length();
+            node_height = std::max(node_height, 1 + join_height(child->buffer));
+        }
+        offsets.push_back(len);
+    }
+
+    ~MultiJoinBuffer() override = default;
+
+    size_t count() const {
+        return children.size();
+    }
+
+    PyObject* child(size_t i) const {
+        return children[i].ptr().get();
+    }
+
+    /** Start of child i in this buffer. */
+    Py_ssize_t offset(size_t i) const {
+        return offsets[i];
+    }
+
+    /**
+     * @brief Index of the child containing position `index` (0 <= index < length()).
+     */
+    size_t child_index(Py_ssize_t index) const {
+        return (size_t)(std::upper_bound(offsets.begin() + 1, offsets.end() - 1, index) - (offsets.begin() + 1));
+    }
+
+    Py_ssize_t height() const {
+        return node_height;
+    }
+
+    Py_ssize_t length() const override {
+        return offsets.back();
+    }
+
+    /**
+     * @brief Widest kind of the children, cached.
+     */
+    int unicode_kind() const override {
+        int kind = cached_kind.load(std::memory_order_relaxed);
+        if (kind != -1) return kind;
+        kind = PyUnicode_1BYTE_KIND;
+        for (size_t i = 0; i < children.size() && kind != PyUnicode_4BYTE_KIND; ++i) {
+            kind = std::max(kind, child_buffer(i)->unicode_kind());
+        }
+        cached_kind.store(kind, std::memory_order_relaxed);
+        return kind;
+    }
+
+    /**
+     * @brief Combine the kinds of the parts of the range in each child.
+     */
+    int range_kind(Py_ssize_t start, Py_ssize_t end) const override {
+        if (start >= end) return PyUnicode_1BYTE_KIND;
+        if (start == 0 && end == length()) return unicode_kind();
+        int kind = PyUnicode_1BYTE_KIND;
+        find_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) -> Py_ssize_t {
+            kind = std::max(kind, buf->range_kind(s, e));
+            return kind == PyUnicode_4BYTE_KIND ? 0 : -1;
+        });
+        return kind;
+    }
+
+    uint32_t value(Py_ssize_t index) const override {
+        size_t i = child_index(index);
+        return child_buffer(i)->value(index - offsets[i]);
+    }
+
+    void copy(uint32_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_parts(target, start, count);
+    }
+
+    void copy(uint16_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_parts(target, start, count);
+    }
+
+    void copy(uint8_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_parts(target, start, count);
+    }
+
+    bool visit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override {
+        return find_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) -> Py_ssize_t {
+            return buf->visit_spans(s, e, visitor) ? -1 : 0;
+        }) == -1;
+    }
+
+    bool rvisit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override {
+        return rfind_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) -> Py_ssize_t {
+            return buf->rvisit_spans(s, e, visitor) ? -1 : 0;
+        }) == -1;
+    }
+
+    /**
+     * @brief Fold the cached hashes of the children with hash_concat.
+     */
+    Py_uhash_t compute_hash() const override {
+        Py_uhash_t h = 0;
+        for (size_t i = 0; i < children.size(); ++i) {
+            const Buffer* buf = child_buffer(i);
+            h = hash_concat(h, buf->poly_hash(), buf->length());
+        }
+        return h;
+    }
+
+    /**
+     * @brief Hash the parts of the range in each child and combine them.
+     */
+    Py_uhash_t range_hash(Py_ssize_t start, Py_ssize_t end) const override {
+        if (start == 0 && end == length()) return poly_hash();
+        Py_uhash_t h = 0;
+        find_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) -> Py_ssize_t {
+            h = hash_concat(h, buf->range_hash(s, e), e - s);
+            return -1;
+        });
+        return h;
+    }
+
+    /**
+     * @brief Python-level repr of the form "(<repr> + <repr> + ...)".
+     */
+    PyObject* repr() const override {
+        cppy::ptr parts(PyList_New((Py_ssize_t)children.size()));
+        if (!parts) return nullptr;
+        for (size_t i = 0; i < children.size(); ++i) {
+            PyObject* r = child_buffer(i)->repr();
+            if (!r) return nullptr;
+            PyList_SET_ITEM(parts.get(), (Py_ssize_t)i, r);
+        }
+        cppy::ptr sep(PyUnicode_FromString(" + "));
+        if (!sep) return nullptr;
+        cppy::ptr joined(PyUnicode_Join(sep.get(), parts.get()));
+        if (!joined) return nullptr;
+        return PyUnicode_FromFormat("(%U)", joined.get());
+    }
+
+    Py_ssize_t findc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override {
+        return find_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) {
+            return buf->findc(s, e, ch);
+        });
+    }
+
+    Py_ssize_t rfindc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override {
+        return rfind_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) {
+            return buf->rfindc(s, e, ch);
+        });
+    }
+
+    Py_ssize_t findcr(Py_ssize_t start, Py_ssize_t end, uint32_t startcp, uint32_t endcp, bool invert = false) const override {
+        return find_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) {
+            return buf->findcr(s, e, startcp, endcp, invert);
+        });
+    }
+
+    Py_ssize_t rfindcr(Py_ssize_t start, Py_ssize_t end, uint32_t startcp, uint32_t endcp, bool invert = false) const override {
+        return rfind_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) {
+            return buf->rfindcr(s, e, startcp, endcp, invert);
+        });
+    }
+
+    Py_ssize_t findcs(Py_ssize_t start, Py_ssize_t end, const CharSet& charset, bool invert = false) const override {
+        return find_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) {
+            return buf->findcs(s, e, charset, invert);
+        });
+    }
+
+    Py_ssize_t rfindcs(Py_ssize_t start, Py_ssize_t end, const CharSet& charset, bool invert = false) const override {
+        return rfind_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) {
+            return buf->rfindcs(s, e, charset, invert);
+        });
+    }
+
+    Py_ssize_t findcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const override {
+        return find_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) {
+            return buf->findcc(s, e, class_mask, invert);
+        });
+    }
+
+    Py_ssize_t rfindcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const override {
+        return rfind_parts(start, end, [&](const Buffer* buf, Py_ssize_t s, Py_ssize_t e) {
+            return buf->rfindcc(s, e, class_mask, invert);
+        });
+    }
+
+    /**
+     * @brief Context-free classifications hold if they hold for every child;
+     *        isupper, islower and istitle use the base implementation.
+     */
+    bool isspace() const override {
+        return all_children([](const Buffer* b) { return b->isspace(); });
+    }
+
+    bool isalpha() const override {
+        return all_children([](const Buffer* b) { return b->isalpha(); });
+    }
+
+    bool isdigit() const override {
+        return all_children([](const Buffer* b) { return b->isdigit(); });
+    }
+
+    bool isalnum() const override {
+        return all_children([](const Buffer* b) { return b->isalnum(); });
+    }
+
+    bool isdecimal() const override {
+        return all_children([](const Buffer* b) { return b->isdecimal(); });
+    }
+
+    bool isnumeric() const override {
+        return all_children([](const Buffer* b) { return b->isnumeric(); });
+    }
+
+    bool isprintable() const override {
+        return all_children([](const Buffer* b) { return b->isprintable(); });
+    }
+};
+
+inline Py_ssize_t join_height(const Buffer* buf) {
+    if (buf && buf->is_a(JoinBuffer::buffer_class_id)) {
+        return static_cast<const JoinBuffer*>(buf)->height();
+    }
+    if (buf && buf->is_a(MultiJoinBuffer::buffer_class_id)) {
+        return static_cast<const MultiJoinBuffer*>(buf)->height();
+    }
+    return 1;
+}
+
 #endif // JOIN_BUFFER_HXX
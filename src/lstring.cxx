@@ -8,10 +8,13 @@
 
 #include "_lstring.hxx"
 #include "lstring_utils.hxx"
+#include "lstring_stats.hxx"
 #include "lstring/lstring.hxx"
 #include "str_buffer.hxx"
 #include "mul_buffer.hxx"
 #include "slice_buffer.hxx"
+#include "buffer_cursor.hxx"
+#include "str_cache.hxx"
 #include "tptr.hxx"
 
 /* Forward declarations of L type methods. */
@@ -26,6 +29,8 @@ static Py_ssize_t LStr_sq_length(PyObject *self);
 static PyObject* LStr_subscript(PyObject *self_obj, PyObject *key);
 static PyObject* LStr_richcompare(PyObject *a, PyObject *b, int op);
 static PyObject* LStr_iter(PyObject *self);
+// Defined in src/lstring_methods.cxx.
+int LStr_contains(PyObject *self, PyObject *sub);
 static void LStrIter_dealloc(PyObject *it_obj);
 static PyObject* LStrIter_iternext(PyObject *it_obj);
 
@@ -33,8 +38,7 @@ static PyObject* LStrIter_iternext(PyObject *it_obj);
 struct LStrIterObject {
     PyObject_HEAD
     LStrObject *source; /* borrowed but owned reference */
-    Py_ssize_t index;
-    Py_ssize_t length;
+    BufferCursor *cursor; /* streaming position within source->buffer */
 };
 
 /**
@@ -57,6 +61,7 @@ static PyType_Slot LStr_slots[] = {
     {Py_tp_richcompare, (void*)LStr_richcompare},
 
     {Py_sq_length, (void*)LStr_sq_length},
+    {Py_sq_contains, (void*)LStr_contains},
     {Py_mp_subscript, (void*)LStr_subscript},
     {0, nullptr}
 };
@@ -100,14 +105,17 @@ static PyObject* LStr_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
 /**
  * @brief Deallocator for `L` instances.
  *
- * Frees the internal Buffer and releases the object memory.
+ * Frees the internal Buffer, releases the object memory and drops the
+ * instance's reference to its heap type.
  */
 static void LStr_dealloc(LStrObject *self) {
+    PyTypeObject *tp = Py_TYPE(self);
     if (self->buffer) {
         delete self->buffer;
         self->buffer = nullptr;
     }
-    Py_TYPE(self)->tp_free((PyObject*)self);
+    tp->tp_free((PyObject*)self);
+    Py_DECREF(tp);
 }
 
 /**
@@ -192,20 +200,17 @@ static PyObject* LStr_subscript(PyObject *self_obj, PyObject *key) {
         return make_lstr_from_pystr(type, PyUnicode_FromString(""));
     }
 
-    if(start == 0 && end == length && step == 1) {
-        // Full slice returns self
-        return cppy::incref(self_obj);
+    if (step == 1) {
+        // Full slices return self, other slices are views of self
+        return make_lstr_slice((LStrObject*)self_obj, start, end);
     }
 
     tptr<LStrObject> result(type->tp_alloc(type, 0));
     if (!result) return nullptr;
 
     try {
-        if (step == 1) {
-            result->buffer = new Slice1Buffer(self_obj, start, end);
-        } else {
-            result->buffer = new SliceBuffer(self_obj, start, end, step);
-        }
+        result->buffer = new SliceBuffer(self_obj, start, end, step);
+        stats_node(result->buffer);
     } catch (const std::exception &e) {
         PyErr_SetString(PyExc_RuntimeError, e.what());
         return nullptr;
@@ -353,6 +358,7 @@ static PyObject* LStr_mul(PyObject *left, PyObject *right) {
 
     try {
         result->buffer = new MulBuffer(lstr_obj, repeat_count);
+        stats_node(result->buffer);
     } catch (const std::exception &e) {
         PyErr_SetString(PyExc_RuntimeError, e.what());
         return nullptr;
@@ -410,7 +416,15 @@ static PyObject* LStr_richcompare(PyObject *a, PyObject *b, int op) {
         }
     }
 
-    int cmp = ba->cmp(bb);
+    // Cached strs compare with CPython's routine, like two StrBuffers.
+    int cmp;
+    cppy::ptr sa, sb;
+    if ((!ba->is_str() || !bb->is_str()) && (sa = buffer_str_view(ba)) && (sb = buffer_str_view(bb))) {
+        cmp = PyUnicode_Compare(sa.get(), sb.get());
+        if (cmp == -1 && PyErr_Occurred()) return nullptr;
+    } else {
+        cmp = ba->cmp(bb);
+    }
 
     switch (op) {
         case Py_EQ: if (cmp == 0) Py_RETURN_TRUE; else Py_RETURN_FALSE;
@@ -427,13 +441,16 @@ static PyObject* LStr_richcompare(PyObject *a, PyObject *b, int op) {
  * Iterator implementation for `L`.
  *
  * The iterator holds an owned reference to the source `L` object so
- * that the underlying buffer remains valid during iteration. The iterator
- * type is created on-demand via PyType_FromSpec and cached as an attribute
+ * that the underlying buffer remains valid during iteration. Characters
+ * are read through a BufferCursor, so each step is O(1) amortized even on
+ * deep concatenation trees. The iterator type is created on-demand via PyType_FromSpec and cached as an attribute
  * on the `L` heap type object (no global/static variables are used).
  */
 
 static void LStrIter_dealloc(PyObject *it_obj) {
     LStrIterObject *it = (LStrIterObject*)it_obj;
+    delete it->cursor;
+    it->cursor = nullptr;
     if (it->source) {
         cppy::decref(it->source);
         it->source = nullptr;
@@ -442,19 +459,26 @@ static void LStrIter_dealloc(PyObject *it_obj) {
     tp->tp_free(it_obj);
 }
 
-static PyObject* LStrIter_iternext(PyObject *it_obj) {
+static PyObject* LStrIter_next_locked(PyObject *it_obj) {
     LStrIterObject *it = (LStrIterObject*)it_obj;
-    if (!it->source) {
+    if (!it->source || !it->cursor) {
         PyErr_SetString(PyExc_RuntimeError, "invalid L iterator");
         return nullptr;
     }
-    if (it->index >= it->length) {
+    if (!it->cursor->has_next()) {
         PyErr_SetNone(PyExc_StopIteration);
         return nullptr;
     }
-    uint32_t ch = it->source->buffer->value(it->index);
-    it->index += 1;
-    return PyUnicode_FromOrdinal(ch);
+    return PyUnicode_FromOrdinal(it->cursor->next());
+}
+
+static PyObject* LStrIter_iternext(PyObject *it_obj) {
+    // The cursor moves on every step; threads sharing the iterator take turns.
+    PyObject *result;
+    Py_BEGIN_CRITICAL_SECTION(it_obj);
+    result = LStrIter_next_locked(it_obj);
+    Py_END_CRITICAL_SECTION();
+    return result;
 }
 
 PyType_Slot LStrIter_slots[] = {
@@ -496,8 +520,16 @@ static PyObject* LStr_iter(PyObject *self) {
 
     // Iterator holds an owned reference to the source object to keep it alive
     it_obj->source = (LStrObject*)cppy::incref(self);
-    it_obj->index = 0;
-    it_obj->length = it_obj->source->buffer->length();
+    Buffer *buf = it_obj->source->buffer;
+    try {
+        it_obj->cursor = new BufferCursor(buf, 0, buf->length());
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    } catch (...) {
+        PyErr_SetString(PyExc_RuntimeError, "iterator creation failed");
+        return nullptr;
+    }
 
     return it_obj.ptr().release();
 }
@@ -506,7 +538,8 @@ static PyObject* LStr_iter(PyObject *self) {
  * @brief Materialize the `L` as a concrete Python `str`.
  *
  * Delegates to buffer_to_pystr which handles both the StrBuffer shortcut
- * and materialization of lazy buffers.
+ * and materialization of lazy buffers. With the str cache enabled, the
+ * str of a lazy buffer is kept for later calls.
  */
 static PyObject* LStr_str(LStrObject *self) {
     if (!self->buffer) {
@@ -514,5 +547,9 @@ static PyObject* LStr_str(LStrObject *self) {
         return nullptr;
     }
 
-    return buffer_to_pystr(self->buffer);
+    PyObject *result = buffer_to_pystr(self->buffer);
+    if (result && LStr_str_cache_limit.load(std::memory_order_relaxed) > 0 && !self->buffer->is_str()) {
+        StrCache::store(self->buffer, result);
+    }
+    return result;
 }
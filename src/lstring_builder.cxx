@@ -0,0 +1,371 @@
+/**
+ * @file lstring_builder.cxx
+ * @brief Implementation of `_lstring.Builder` - incremental construction of L.
+ *
+ * A Builder collects pieces in a vector instead of building a new join node
+ * per append. Short pieces are copied into a chunk of code points that
+ * becomes one str leaf when it fills up; longer ones are referenced as
+ * they are. build() then makes the balanced tree over all pieces in one
+ * pass, with join_balanced.
+ */
+
+#include <Python.h>
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+#include "lstring/lstring.hxx"
+#include "_lstring.hxx"
+#include "lstring_utils.hxx"
+#include "tptr.hxx"
+#include <cppy/cppy.h>
+
+/** Pieces shorter than this are copied into the current chunk. */
+static constexpr Py_ssize_t BUILDER_SMALL_PIECE = 128;
+
+struct LStrBuilderObject {
+    PyObject_HEAD
+    PyTypeObject *type;                     /* owned: type of the built L */
+    std::vector<tptr<LStrObject>> *pieces;  /* owned: pieces since the last build */
+    std::vector<Py_UCS4> *chunk;            /* owned: code points of short pieces */
+    LStrObject *built;                      /* owned: result of the last build, or null */
+    Py_ssize_t length;
+};
+
+static PyObject* LStrBuilder_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
+static void LStrBuilder_dealloc(LStrBuilderObject *self);
+
+/**
+ * @brief Longest chunk of coalesced pieces; follows the leaf size of
+ *        automatic compaction.
+ */
+static Py_ssize_t builder_chunk_size() {
+    return std::max(LStr_compact_max_leaf.load(std::memory_order_relaxed), BUILDER_SMALL_PIECE);
+}
+
+/**
+ * @brief Turn the pending chunk into a str leaf at the end of the pieces.
+ */
+static bool builder_flush(LStrBuilderObject *self) {
+    std::vector<Py_UCS4>& chunk = *self->chunk;
+    if (chunk.empty()) return true;
+    cppy::ptr text(PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, chunk.data(), (Py_ssize_t)chunk.size()));
+    if (!text) return false;
+    tptr<LStrObject> leaf(make_lstr_from_pystr(self->type, text.get()));
+    if (!leaf) return false;
+    self->pieces->push_back(std::move(leaf));
+    chunk.clear();
+    return true;
+}
+
+/**
+ * @brief Make room for n more code points in the chunk.
+ * @return Where to write them, or nullptr with an exception set.
+ */
+static Py_UCS4* builder_reserve(LStrBuilderObject *self, Py_ssize_t n) {
+    std::vector<Py_UCS4>& chunk = *self->chunk;
+    if ((Py_ssize_t)chunk.size() + n > builder_chunk_size() && !builder_flush(self)) return nullptr;
+    size_t used = chunk.size();
+    chunk.resize(used + (size_t)n);
+    return chunk.data() + used;
+}
+
+/**
+ * @brief Add s[start:end] of a str.
+ */
+static bool builder_add_str(LStrBuilderObject *self, PyObject *s, Py_ssize_t start, Py_ssize_t end) {
+    Py_ssize_t n = end - start;
+    if (n <= 0) return true;
+    if (n < BUILDER_SMALL_PIECE) {
+        Py_UCS4 *out = builder_reserve(self, n);
+        if (!out) return false;
+        const int kind = PyUnicode_KIND(s);
+        const void *data = PyUnicode_DATA(s);
+        for (Py_ssize_t i = 0; i < n; ++i) {
+            out[i] = PyUnicode_READ(kind, data, start + i);
+        }
+    } else {
+        if (!builder_flush(self)) return false;
+        tptr<LStrObject> piece(make_lstr_from_pystr(self->type, s));
+        if (!piece) return false;
+        if (n != PyUnicode_GET_LENGTH(s)) {
+            piece = tptr<LStrObject>(make_lstr_slice(piece.get(), start, end));
+            if (!piece) return false;
+        }
+        self->pieces->push_back(std::move(piece));
+    }
+    self->length += n;
+    return true;
+}
+
+/**
+ * @brief Add obj[start:end] of an L.
+ */
+static bool builder_add_lstr(LStrBuilderObject *self, LStrObject *obj, Py_ssize_t start, Py_ssize_t end) {
+    Py_ssize_t n = end - start;
+    if (n <= 0) return true;
+    if (n < BUILDER_SMALL_PIECE) {
+        Py_UCS4 *out = builder_reserve(self, n);
+        if (!out) return false;
+        obj->buffer->copy((uint32_t*)out, start, n);
+    } else {
+        if (!builder_flush(self)) return false;
+        tptr<LStrObject> piece(make_lstr_slice(obj, start, end));
+        if (!piece) return false;
+        self->pieces->push_back(std::move(piece));
+    }
+    self->length += n;
+    return true;
+}
+
+/**
+ * @brief Length of a str or L piece, or -1 with TypeError set.
+ */
+static Py_ssize_t builder_piece_length(LStrBuilderObject *self, PyObject *obj, const char *method) {
+    if (PyUnicode_Check(obj)) return PyUnicode_GET_LENGTH(obj);
+    if (PyObject_TypeCheck(obj, get_base_l_type(self->type))) {
+        LStrObject *lobj = (LStrObject*)obj;
+        if (!lobj->buffer) {
+            PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+            return -1;
+        }
+        return lobj->buffer->length();
+    }
+    PyErr_Format(PyExc_TypeError, "Builder.%s() argument must be str or L, not %.200s",
+                 method, Py_TYPE(obj)->tp_name);
+    return -1;
+}
+
+static bool builder_add(LStrBuilderObject *self, PyObject *obj, Py_ssize_t start, Py_ssize_t end) {
+    if (PyUnicode_Check(obj)) return builder_add_str(self, obj, start, end);
+    return builder_add_lstr(self, (LStrObject*)obj, start, end);
+}
+
+static bool builder_valid(LStrBuilderObject *self) {
+    if (!self->pieces || !self->chunk || !self->type) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid Builder object");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Builder(type=None): empty builder of `type` instances (default L).
+ */
+static PyObject* LStrBuilder_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"type", nullptr};
+    PyObject *result_type = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O:Builder", kwlist, &result_type)) {
+        return nullptr;
+    }
+    cppy::ptr lstr_type(get_string_lstr_type());
+    if (!lstr_type) return nullptr;
+    if (result_type == Py_None) {
+        result_type = lstr_type.get();
+    } else if (!PyType_Check(result_type) || !PyType_IsSubtype((PyTypeObject*)result_type, (PyTypeObject*)lstr_type.get())) {
+        PyErr_SetString(PyExc_TypeError, "Builder type must be a subclass of L");
+        return nullptr;
+    }
+
+    tptr<LStrBuilderObject> self((LStrBuilderObject*)type->tp_alloc(type, 0));
+    if (!self) return nullptr;
+    try {
+        self->pieces = new std::vector<tptr<LStrObject>>();
+        self->chunk = new std::vector<Py_UCS4>();
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    self->type = (PyTypeObject*)cppy::incref(result_type);
+    self->built = nullptr;
+    self->length = 0;
+    return (PyObject*)self.release();
+}
+
+static void LStrBuilder_dealloc(LStrBuilderObject *self) {
+    delete self->pieces;
+    delete self->chunk;
+    self->pieces = nullptr;
+    self->chunk = nullptr;
+    Py_CLEAR(self->built);
+    Py_CLEAR(self->type);
+    PyTypeObject *tp = Py_TYPE(self);
+    tp->tp_free(self);
+    Py_DECREF(tp);
+}
+
+static PyObject* LStrBuilder_append_locked(LStrBuilderObject *self, PyObject *obj) {
+    if (!builder_valid(self)) return nullptr;
+    Py_ssize_t n = builder_piece_length(self, obj, "append");
+    if (n < 0) return nullptr;
+    try {
+        if (!builder_add(self, obj, 0, n)) return nullptr;
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief append(piece): add a str or L at the end.
+ */
+static PyObject* LStrBuilder_append(LStrBuilderObject *self, PyObject *obj) {
+    PyObject *result;
+    Py_BEGIN_CRITICAL_SECTION(self);
+    result = LStrBuilder_append_locked(self, obj);
+    Py_END_CRITICAL_SECTION();
+    return result;
+}
+
+static PyObject* LStrBuilder_extend_locked(LStrBuilderObject *self, PyObject *iterable) {
+    if (!builder_valid(self)) return nullptr;
+    cppy::ptr seq(PySequence_Fast(iterable, "Builder.extend() argument must be iterable"));
+    if (!seq) return nullptr;
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(seq.get());
+    PyObject **items = PySequence_Fast_ITEMS(seq.get());
+    try {
+        for (Py_ssize_t i = 0; i < count; ++i) {
+            Py_ssize_t n = builder_piece_length(self, items[i], "extend");
+            if (n < 0) return nullptr;
+            if (!builder_add(self, items[i], 0, n)) return nullptr;
+        }
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief extend(iterable): append every str or L of an iterable.
+ */
+static PyObject* LStrBuilder_extend(LStrBuilderObject *self, PyObject *iterable) {
+    PyObject *result;
+    Py_BEGIN_CRITICAL_SECTION(self);
+    result = LStrBuilder_extend_locked(self, iterable);
+    Py_END_CRITICAL_SECTION();
+    return result;
+}
+
+/**
+ * @brief Read an optional slice bound: None or an index.
+ */
+static bool builder_slice_index(PyObject *obj, Py_ssize_t *out) {
+    if (!obj || obj == Py_None) return true;
+    Py_ssize_t value = PyNumber_AsSsize_t(obj, PyExc_OverflowError);
+    if (value == -1 && PyErr_Occurred()) return false;
+    *out = value;
+    return true;
+}
+
+static PyObject* LStrBuilder_append_slice_locked(LStrBuilderObject *self, PyObject *obj,
+                                                 PyObject *start_obj, PyObject *end_obj) {
+    if (!builder_valid(self)) return nullptr;
+    Py_ssize_t n = builder_piece_length(self, obj, "append_slice");
+    if (n < 0) return nullptr;
+    Py_ssize_t start = 0, end = n;
+    if (!builder_slice_index(start_obj, &start) || !builder_slice_index(end_obj, &end)) return nullptr;
+    PySlice_AdjustIndices(n, &start, &end, 1);
+    try {
+        if (!builder_add(self, obj, start, end)) return nullptr;
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief append_slice(piece, start=None, end=None): append piece[start:end]
+ *        without building the slice first.
+ */
+static PyObject* LStrBuilder_append_slice(LStrBuilderObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"piece", (char*)"start", (char*)"end", nullptr};
+    PyObject *obj, *start_obj = nullptr, *end_obj = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|OO:append_slice", kwlist, &obj, &start_obj, &end_obj)) {
+        return nullptr;
+    }
+    PyObject *result;
+    Py_BEGIN_CRITICAL_SECTION(self);
+    result = LStrBuilder_append_slice_locked(self, obj, start_obj, end_obj);
+    Py_END_CRITICAL_SECTION();
+    return result;
+}
+
+static PyObject* LStrBuilder_build_locked(LStrBuilderObject *self) {
+    if (!builder_valid(self)) return nullptr;
+    try {
+        if (!builder_flush(self)) return nullptr;
+        tptr<LStrObject> result;
+        std::vector<tptr<LStrObject>>& pieces = *self->pieces;
+        if (!pieces.empty()) {
+            result = join_balanced(self->type, pieces);
+            if (!result) return nullptr;
+            pieces.clear();
+            if (self->built) {
+                result = concat_balanced(self->type, tptr<LStrObject>(self->built, true), result);
+                if (!result) return nullptr;
+            }
+        } else if (self->built) {
+            result = tptr<LStrObject>(self->built, true);
+        } else {
+            cppy::ptr empty(PyUnicode_New(0, 0));
+            if (!empty) return nullptr;
+            result = tptr<LStrObject>(make_lstr_from_pystr(self->type, empty.get()));
+            if (!result) return nullptr;
+        }
+        // Later appends continue from the result.
+        Py_XSETREF(self->built, (LStrObject*)cppy::incref((PyObject*)result.get()));
+        return result.ptr().release();
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * @brief build(): the L of everything appended so far.
+ */
+static PyObject* LStrBuilder_build(LStrBuilderObject *self, PyObject *Py_UNUSED(ignored)) {
+    PyObject *result;
+    Py_BEGIN_CRITICAL_SECTION(self);
+    result = LStrBuilder_build_locked(self);
+    Py_END_CRITICAL_SECTION();
+    return result;
+}
+
+static Py_ssize_t LStrBuilder_length(LStrBuilderObject *self) {
+    return self->length;
+}
+
+static PyMethodDef LStrBuilder_methods[] = {
+    {"append", (PyCFunction)LStrBuilder_append, METH_O, "Append a str or L"},
+    {"extend", (PyCFunction)LStrBuilder_extend, METH_O, "Append every str or L of an iterable"},
+    {"append_slice", (PyCFunction)LStrBuilder_append_slice, METH_VARARGS | METH_KEYWORDS,
+     "Append piece[start:end] of a str or L: append_slice(piece, start=None, end=None)"},
+    {"build", (PyCFunction)LStrBuilder_build, METH_NOARGS,
+     "Return the L of everything appended so far; later appends continue from it"},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static PyType_Slot LStrBuilder_slots[] = {
+    {Py_tp_new, (void*)LStrBuilder_new},
+    {Py_tp_dealloc, (void*)LStrBuilder_dealloc},
+    {Py_tp_methods, (void*)LStrBuilder_methods},
+    {Py_sq_length, (void*)LStrBuilder_length},
+    {Py_tp_doc, (void*)"Builder(type=None)\n--\n\n"
+        "Incremental construction of an L. Appends are amortized O(1): short "
+        "pieces are copied into chunks, longer ones are referenced, and "
+        "build() makes one balanced tree over all of them. `type` is the L "
+        "subclass of the result."},
+    {0, nullptr}
+};
+
+PyType_Spec LStrBuilder_spec = {
+    "_lstring.Builder",
+    sizeof(LStrBuilderObject),
+    0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    LStrBuilder_slots
+};
@@ -1,7 +1,10 @@
 #include <Python.h>
+#include <algorithm>
 
 #include "_lstring.hxx"
 #include "join_buffer.hxx"
+#include "lstring_utils.hxx"
+#include "lstring_stats.hxx"
 
 static inline bool is_join_buffer(const LStrObject* obj) {
     return obj && obj->buffer && obj->buffer->is_a(JoinBuffer::buffer_class_id);
@@ -11,10 +14,17 @@ static inline const JoinBuffer* as_join_buffer(const LStrObject* obj) {
     return static_cast<const JoinBuffer*>(obj->buffer);
 }
 
+static inline bool is_multi_join(const LStrObject* obj) {
+    return obj && obj->buffer && obj->buffer->is_a(MultiJoinBuffer::buffer_class_id);
+}
+
+static inline const MultiJoinBuffer* as_multi_join(const LStrObject* obj) {
+    return static_cast<const MultiJoinBuffer*>(obj->buffer);
+}
+
 static inline Py_ssize_t lstr_height(const LStrObject* obj) {
     if (!obj || !obj->buffer) return 1;
-    if (is_join_buffer(obj)) return as_join_buffer(obj)->height();
-    return 1;
+    return join_height(obj->buffer);
 }
 
 static tptr<LStrObject> make_join_lstr(PyTypeObject* type, PyObject* left, PyObject* right) {
@@ -23,6 +33,8 @@ static tptr<LStrObject> make_join_lstr(PyTypeObject* type, PyObject* left, PyObj
 
     try {
         result->buffer = new JoinBuffer(left, right);
+        stats_node(result->buffer);
+        stats_max(LStr_stats.max_height, (uint64_t)join_height(result->buffer));
     } catch (const std::exception &e) {
         PyErr_SetString(PyExc_RuntimeError, e.what());
         return {};
@@ -34,7 +46,56 @@ static tptr<LStrObject> make_join_lstr(PyTypeObject* type, PyObject* left, PyObj
     return result;
 }
 
+/**
+ * @brief Join `parts` (not empty) in one node: the part itself, a binary
+ *        JoinBuffer for two parts, otherwise a MultiJoinBuffer.
+ */
+static tptr<LStrObject> make_multi_join_lstr(PyTypeObject* type, std::vector<tptr<LStrObject>> parts) {
+    if (parts.size() == 1) return parts[0];
+    if (parts.size() == 2) return make_join_lstr(type, parts[0].ptr().get(), parts[1].ptr().get());
+
+    tptr<LStrObject> result((LStrObject*)type->tp_alloc(type, 0));
+    if (!result) return {};
+
+    try {
+        result->buffer = new MultiJoinBuffer(std::move(parts));
+        stats_node(result->buffer);
+        stats_max(LStr_stats.max_height, (uint64_t)join_height(result->buffer));
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return {};
+    } catch (...) {
+        PyErr_SetString(PyExc_RuntimeError, "MultiJoinBuffer allocation failed");
+        return {};
+    }
+
+    return result;
+}
+
+/**
+ * @brief Copy of the MultiJoinBuffer node with `part` at its last (or, if
+ *        not `last`, first) child: replacing that child if `replace`,
+ *        otherwise added after (before) it.
+ */
+static tptr<LStrObject> multi_join_with_edge(PyTypeObject* type, const tptr<LStrObject>& node,
+                                             bool last, const tptr<LStrObject>& part, bool replace) {
+    const MultiJoinBuffer* m = as_multi_join(node.get());
+    std::vector<tptr<LStrObject>> parts;
+    parts.reserve(m->count() + 1);
+    if (!last && !replace) parts.push_back(part);
+    for (size_t i = 0; i < m->count(); ++i) {
+        parts.push_back(tptr<LStrObject>(m->child(i), true));
+    }
+    if (replace) {
+        parts[last ? parts.size() - 1 : 0] = part;
+    } else if (last) {
+        parts.push_back(part);
+    }
+    return make_multi_join_lstr(type, std::move(parts));
+}
+
 static tptr<LStrObject> rotate_left(PyTypeObject* type, const tptr<LStrObject>& x) {
+    stats_add(LStr_stats.concat_rotations);
     // x = Join(a, y), y = Join(b, c)  =>  Join(Join(a,b), c)
     const JoinBuffer* jx = as_join_buffer(x.get());
     tptr<LStrObject> a(jx->left(), true);
@@ -49,6 +110,7 @@ static tptr<LStrObject> rotate_left(PyTypeObject* type, const tptr<LStrObject>&
 }
 
 static tptr<LStrObject> rotate_right(PyTypeObject* type, const tptr<LStrObject>& y) {
+    stats_add(LStr_stats.concat_rotations);
     // y = Join(x, c), x = Join(a, b)  =>  Join(a, Join(b,c))
     const JoinBuffer* jy = as_join_buffer(y.get());
     tptr<LStrObject> x(jy->left(), true);
@@ -70,40 +132,37 @@ static tptr<LStrObject> rebalance_join(PyTypeObject* type, const tptr<LStrObject
     Py_ssize_t hl = lstr_height(left.get());
     Py_ssize_t hr = lstr_height(right.get());
 
+    // Only binary joins rotate; a wide node on the heavy side stays as is.
     Py_ssize_t balance = hl - hr;
-    if (balance > 1) {
+    if (balance > 1 && is_join_buffer(left.get())) {
         // Left heavy
-        if (is_join_buffer(left.get())) {
-            const JoinBuffer* jl = as_join_buffer(left.get());
-            tptr<LStrObject> ll(jl->left(), true);
-            tptr<LStrObject> lr(jl->right(), true);
-            if (lstr_height(lr.get()) > lstr_height(ll.get())) {
-                // LR case: rotate left on left child
-                tptr<LStrObject> new_left = rotate_left(type, left);
-                if (!new_left) return {};
-                tptr<LStrObject> tmp = make_join_lstr(type, new_left.ptr().get(), right.ptr().get());
-                if (!tmp) return {};
-                return rotate_right(type, tmp);
-            }
+        const JoinBuffer* jl = as_join_buffer(left.get());
+        tptr<LStrObject> ll(jl->left(), true);
+        tptr<LStrObject> lr(jl->right(), true);
+        if (lstr_height(lr.get()) > lstr_height(ll.get()) && is_join_buffer(lr.get())) {
+            // LR case: rotate left on left child
+            tptr<LStrObject> new_left = rotate_left(type, left);
+            if (!new_left) return {};
+            tptr<LStrObject> tmp = make_join_lstr(type, new_left.ptr().get(), right.ptr().get());
+            if (!tmp) return {};
+            return rotate_right(type, tmp);
         }
         // LL case
         return rotate_right(type, node);
     }
 
-    if (balance < -1) {
+    if (balance < -1 && is_join_buffer(right.get())) {
         // Right heavy
-        if (is_join_buffer(right.get())) {
-            const JoinBuffer* jr = as_join_buffer(right.get());
-            tptr<LStrObject> rl(jr->left(), true);
-            tptr<LStrObject> rr(jr->right(), true);
-            if (lstr_height(rl.get()) > lstr_height(rr.get())) {
-                // RL case: rotate right on right child
-                tptr<LStrObject> new_right = rotate_right(type, right);
-                if (!new_right) return {};
-                tptr<LStrObject> tmp = make_join_lstr(type, left.ptr().get(), new_right.ptr().get());
-                if (!tmp) return {};
-                return rotate_left(type, tmp);
-            }
+        const JoinBuffer* jr = as_join_buffer(right.get());
+        tptr<LStrObject> rl(jr->left(), true);
+        tptr<LStrObject> rr(jr->right(), true);
+        if (lstr_height(rl.get()) > lstr_height(rr.get()) && is_join_buffer(rl.get())) {
+            // RL case: rotate right on right child
+            tptr<LStrObject> new_right = rotate_right(type, right);
+            if (!new_right) return {};
+            tptr<LStrObject> tmp = make_join_lstr(type, left.ptr().get(), new_right.ptr().get());
+            if (!tmp) return {};
+            return rotate_left(type, tmp);
         }
         // RR case
         return rotate_left(type, node);
@@ -112,10 +171,158 @@ static tptr<LStrObject> rebalance_join(PyTypeObject* type, const tptr<LStrObject
     return node;
 }
 
+tptr<LStrObject> make_chunk(PyTypeObject* type, const tptr<LStrObject>* leaves, size_t count) {
+    Py_ssize_t len = 0;
+    int kind = PyUnicode_1BYTE_KIND;
+    for (size_t i = 0; i < count; ++i) {
+        len += leaves[i]->buffer->length();
+        kind = std::max(kind, leaves[i]->buffer->unicode_kind());
+    }
+    Py_UCS4 maxchar = kind == PyUnicode_1BYTE_KIND ? 0xFF
+                    : kind == PyUnicode_2BYTE_KIND ? 0xFFFF : 0x10FFFF;
+    cppy::ptr text(PyUnicode_New(len, maxchar));
+    if (!text) return {};
+
+    auto fill = [&](auto* target) {
+        for (size_t i = 0; i < count; ++i) {
+            const Buffer* buf = leaves[i]->buffer;
+            Py_ssize_t n = buf->length();
+            buf->copy(target, 0, n);
+            target += n;
+        }
+    };
+    try {
+        void* data = PyUnicode_DATA(text.get());
+        if (kind == PyUnicode_1BYTE_KIND) fill(static_cast<uint8_t*>(data));
+        else if (kind == PyUnicode_2BYTE_KIND) fill(static_cast<uint16_t*>(data));
+        else fill(static_cast<uint32_t*>(data));
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return {};
+    }
+    return tptr<LStrObject>(make_lstr_from_pystr(type, text.get()));
+}
+
+/**
+ * @brief Whether obj is a leaf short enough for automatic compaction.
+ */
+static inline bool is_small_leaf(const LStrObject* obj, Py_ssize_t min_leaf) {
+    return !is_join_buffer(obj) && !is_multi_join(obj) && obj->buffer->length() < min_leaf;
+}
+
+/**
+ * @brief Edge leaf of a join tree: the rightmost one if `rightmost`,
+ *        otherwise the leftmost one.
+ */
+static const LStrObject* edge_leaf(const LStrObject* obj, bool rightmost) {
+    for (;;) {
+        if (is_join_buffer(obj)) {
+            const JoinBuffer* j = as_join_buffer(obj);
+            obj = (const LStrObject*)(rightmost ? j->right() : j->left());
+        } else if (is_multi_join(obj)) {
+            const MultiJoinBuffer* m = as_multi_join(obj);
+            obj = (const LStrObject*)m->child(rightmost ? m->count() - 1 : 0);
+        } else {
+            return obj;
+        }
+    }
+}
+
+/**
+ * @brief Automatic compaction step of concat_balanced.
+ *
+ * If the leaves meeting at the seam of left + right are both shorter than
+ * LStr_compact_min_leaf and together fit in LStr_compact_max_leaf, they are
+ * replaced by one copied leaf. Only the spine leading to the seam is
+ * rebuilt; its height does not grow, so one rebalancing step per level
+ * keeps the tree balanced.
+ *
+ * @return The concatenation, or a null tptr without an exception set if
+ *         the seam is not compacted.
+ */
+static tptr<LStrObject> concat_compacted(PyTypeObject* type, const tptr<LStrObject>& left,
+                                         const tptr<LStrObject>& right,
+                                         Py_ssize_t min_leaf, Py_ssize_t max_leaf) {
+    const LStrObject* l = edge_leaf(left.get(), true);
+    const LStrObject* r = edge_leaf(right.get(), false);
+    if (!is_small_leaf(l, min_leaf) || !is_small_leaf(r, min_leaf)) return {};
+    if (l->buffer->length() + r->buffer->length() > max_leaf) return {};
+
+    if (is_join_buffer(left.get())) {
+        // Merge right into the right spine of left.
+        const JoinBuffer* jl = as_join_buffer(left.get());
+        tptr<LStrObject> a(jl->left(), true);
+        tptr<LStrObject> b(jl->right(), true);
+        tptr<LStrObject> new_b = concat_compacted(type, b, right, min_leaf, max_leaf);
+        if (!new_b) return {};
+        tptr<LStrObject> node = make_join_lstr(type, a.ptr().get(), new_b.ptr().get());
+        if (!node) return {};
+        return rebalance_join(type, node);
+    }
+    if (is_multi_join(left.get())) {
+        const MultiJoinBuffer* m = as_multi_join(left.get());
+        tptr<LStrObject> last(m->child(m->count() - 1), true);
+        tptr<LStrObject> new_last = concat_compacted(type, last, right, min_leaf, max_leaf);
+        if (!new_last) return {};
+        return multi_join_with_edge(type, left, true, new_last, true);
+    }
+    if (is_join_buffer(right.get())) {
+        // Merge left into the left spine of right.
+        const JoinBuffer* jr = as_join_buffer(right.get());
+        tptr<LStrObject> b(jr->left(), true);
+        tptr<LStrObject> c(jr->right(), true);
+        tptr<LStrObject> new_b = concat_compacted(type, left, b, min_leaf, max_leaf);
+        if (!new_b) return {};
+        tptr<LStrObject> node = make_join_lstr(type, new_b.ptr().get(), c.ptr().get());
+        if (!node) return {};
+        return rebalance_join(type, node);
+    }
+    if (is_multi_join(right.get())) {
+        const MultiJoinBuffer* m = as_multi_join(right.get());
+        tptr<LStrObject> first(m->child(0), true);
+        tptr<LStrObject> new_first = concat_compacted(type, left, first, min_leaf, max_leaf);
+        if (!new_first) return {};
+        return multi_join_with_edge(type, right, false, new_first, true);
+    }
+    tptr<LStrObject> leaves[2] = {left, right};
+    return make_chunk(type, leaves, 2);
+}
+
 tptr<LStrObject> concat_balanced(PyTypeObject* type, const tptr<LStrObject>& left, const tptr<LStrObject>& right) {
+    Py_ssize_t min_leaf = LStr_compact_min_leaf.load(std::memory_order_relaxed);
+    if (min_leaf > 0) {
+        tptr<LStrObject> merged = concat_compacted(type, left, right, min_leaf,
+                                                   LStr_compact_max_leaf.load(std::memory_order_relaxed));
+        if (merged || PyErr_Occurred()) return merged;
+    }
+
     Py_ssize_t hl = lstr_height(left.get());
     Py_ssize_t hr = lstr_height(right.get());
 
+    if (hl > hr && is_multi_join(left.get())) {
+        // Add right as a last child of the wide node, or merge it into
+        // the last child once the node is full.
+        const MultiJoinBuffer* m = as_multi_join(left.get());
+        if (m->count() < MultiJoinBuffer::FANOUT) {
+            return multi_join_with_edge(type, left, true, right, false);
+        }
+        tptr<LStrObject> last(m->child(m->count() - 1), true);
+        tptr<LStrObject> new_last = concat_balanced(type, last, right);
+        if (!new_last) return {};
+        return multi_join_with_edge(type, left, true, new_last, true);
+    }
+
+    if (hr > hl && is_multi_join(right.get())) {
+        const MultiJoinBuffer* m = as_multi_join(right.get());
+        if (m->count() < MultiJoinBuffer::FANOUT) {
+            return multi_join_with_edge(type, right, false, left, false);
+        }
+        tptr<LStrObject> first(m->child(0), true);
+        tptr<LStrObject> new_first = concat_balanced(type, left, first);
+        if (!new_first) return {};
+        return multi_join_with_edge(type, right, false, new_first, true);
+    }
+
     if (hl > hr + 1) {
         // Left tree is taller; descend on its right spine.
         const JoinBuffer* jl = as_join_buffer(left.get());
@@ -144,3 +351,109 @@ tptr<LStrObject> concat_balanced(PyTypeObject* type, const tptr<LStrObject>& lef
     if (!node) return {};
     return rebalance_join(type, node);
 }
+
+/**
+ * @brief Append `leaves` to `out` with every run of adjacent leaves shorter
+ *        than `min_leaf` copied into chunks of at most `max_leaf` code
+ *        points; empty leaves are dropped.
+ * @return false with an exception set on failure.
+ */
+static bool compact_runs(PyTypeObject* type, const std::vector<tptr<LStrObject>>& leaves,
+                         Py_ssize_t min_leaf, Py_ssize_t max_leaf,
+                         std::vector<tptr<LStrObject>>& out) {
+    size_t n = leaves.size();
+    for (size_t i = 0; i < n;) {
+        Py_ssize_t len = leaves[i]->buffer->length();
+        if (len >= min_leaf) {
+            out.push_back(leaves[i++]);
+            continue;
+        }
+        // Run of small leaves that fits in one chunk.
+        size_t j = i;
+        Py_ssize_t total = 0;
+        while (j < n && leaves[j]->buffer->length() < min_leaf &&
+               total + leaves[j]->buffer->length() <= max_leaf) {
+            total += leaves[j++]->buffer->length();
+        }
+        if (total > 0) {
+            if (j - i == 1) {
+                out.push_back(leaves[i]);
+            } else {
+                tptr<LStrObject> chunk = make_chunk(type, &leaves[i], j - i);
+                if (!chunk) return false;
+                out.push_back(chunk);
+            }
+        }
+        i = j;
+    }
+    return true;
+}
+
+static tptr<LStrObject> make_empty_lstr(PyTypeObject* type) {
+    return tptr<LStrObject>(make_lstr_from_pystr(type, cppy::ptr(PyUnicode_FromString("")).get()));
+}
+
+tptr<LStrObject> join_balanced(PyTypeObject* type, std::vector<tptr<LStrObject>>& pieces) {
+    Py_ssize_t min_leaf = LStr_compact_min_leaf.load(std::memory_order_relaxed);
+    if (min_leaf > 0 && pieces.size() > 1) {
+        std::vector<tptr<LStrObject>> compacted;
+        if (!compact_runs(type, pieces, min_leaf,
+                          LStr_compact_max_leaf.load(std::memory_order_relaxed), compacted)) {
+            return {};
+        }
+        if (compacted.empty()) return make_empty_lstr(type);
+        pieces.swap(compacted);
+    }
+
+    // One level at a time, group neighbouring nodes into nodes of at most
+    // FANOUT children, with the group sizes differing by at most one.
+    const size_t fanout = MultiJoinBuffer::FANOUT;
+    while (pieces.size() > 1) {
+        size_t n = pieces.size();
+        size_t groups = (n + fanout - 1) / fanout;
+        std::vector<tptr<LStrObject>> level;
+        level.reserve(groups);
+        for (size_t g = 0; g < groups; ++g) {
+            size_t lo = n * g / groups;
+            size_t hi = n * (g + 1) / groups;
+            tptr<LStrObject> node = make_multi_join_lstr(
+                type, std::vector<tptr<LStrObject>>(pieces.begin() + lo, pieces.begin() + hi));
+            if (!node) return {};
+            level.push_back(node);
+        }
+        pieces.swap(level);
+    }
+    tptr<LStrObject> result = pieces[0];
+    pieces.clear();
+    return result;
+}
+
+tptr<LStrObject> compact_tree(PyTypeObject* type, const tptr<LStrObject>& root,
+                              Py_ssize_t min_leaf, Py_ssize_t max_leaf) {
+    if (!is_join_buffer(root.get()) && !is_multi_join(root.get())) return root;
+
+    // Leaves in order, by an explicit depth-first walk.
+    std::vector<tptr<LStrObject>> leaves;
+    std::vector<const LStrObject*> stack{root.get()};
+    while (!stack.empty()) {
+        const LStrObject* node = stack.back();
+        stack.pop_back();
+        if (is_join_buffer(node)) {
+            const JoinBuffer* j = as_join_buffer(node);
+            stack.push_back((const LStrObject*)j->right());
+            stack.push_back((const LStrObject*)j->left());
+        } else if (is_multi_join(node)) {
+            const MultiJoinBuffer* m = as_multi_join(node);
+            for (size_t i = m->count(); i-- > 0;) {
+                stack.push_back((const LStrObject*)m->child(i));
+            }
+        } else {
+            leaves.push_back(tptr<LStrObject>((PyObject*)node, true));
+        }
+    }
+
+    std::vector<tptr<LStrObject>> pieces;
+    if (!compact_runs(type, leaves, min_leaf, max_leaf, pieces)) return {};
+    if (pieces.empty()) return make_empty_lstr(type);
+    return join_balanced(type, pieces);
+}
@@ -0,0 +1,562 @@
+/**
+ * @file lstring_encode.cxx
+ * @brief UTF-8 encoding of `L` without materializing it as `str`.
+ *
+ * encode(), encode_into() and the chunk iterator write UTF-8 straight from
+ * the leaf spans: ASCII runs of 1-byte leaves are copied with memcpy, other
+ * code points are encoded in place. A rope that contains a lone surrogate
+ * falls back to CPython's codec, which owns the error handlers.
+ */
+
+#include <Python.h>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+#include "lstring/lstring.hxx"
+#include "_lstring.hxx"
+#include "buffer_cursor.hxx"
+#include "lstring_utils.hxx"
+#include "simd.hxx"
+#include "slice_buffer.hxx"
+#include "span.hxx"
+#include "tptr.hxx"
+#include "utf8_buffer.hxx"
+
+namespace {
+
+/**
+ * @brief Largest UTF-8 length of a code point stored with `kind` bytes.
+ */
+inline Py_ssize_t utf8_max_width(int kind) {
+    return kind == PyUnicode_1BYTE_KIND ? 2 : kind == PyUnicode_2BYTE_KIND ? 3 : 4;
+}
+
+inline bool is_surrogate(uint32_t ch) {
+    return ch >= 0xD800 && ch < 0xE000;
+}
+
+/**
+ * @brief UTF-8 length of n code points, or -1 if they contain a surrogate.
+ */
+template <class CharT>
+Py_ssize_t utf8_size_of(const CharT* data, Py_ssize_t n) {
+    Py_ssize_t size = n;
+    if constexpr (sizeof(CharT) == 1) {
+        // Each code point of 0x80 and above takes two bytes.
+        Py_ssize_t k = 0;
+        while (k < n) {
+            Py_ssize_t run = simd_find_range(data + k, n - k, 0x80, 0x100, false);
+            if (run == -1) break;
+            k += run;
+            while (k < n && data[k] >= 0x80) {
+                ++size;
+                ++k;
+            }
+        }
+    } else {
+        for (Py_ssize_t k = 0; k < n; ++k) {
+            uint32_t ch = data[k];
+            if (ch < 0x80) continue;
+            if (ch < 0x800) {
+                size += 1;
+            } else if (ch < 0x10000) {
+                if (is_surrogate(ch)) return -1;
+                size += 2;
+            } else {
+                size += 3;
+            }
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Write n code points as UTF-8 to out.
+ * @return The end of the written bytes, or nullptr if the code points
+ *         contain a surrogate (out is then partially written).
+ */
+template <class CharT>
+char* utf8_encode_to(const CharT* data, Py_ssize_t n, char* out) {
+    Py_ssize_t k = 0;
+    while (k < n) {
+        if constexpr (sizeof(CharT) == 1) {
+            // ASCII runs are copied as is.
+            Py_ssize_t run = simd_find_range(data + k, n - k, 0x80, 0x100, false);
+            if (run == -1) run = n - k;
+            std::memcpy(out, data + k, (size_t)run);
+            out += run;
+            k += run;
+            while (k < n && data[k] >= 0x80) {
+                uint32_t ch = data[k++];
+                *out++ = (char)(0xC0 | (ch >> 6));
+                *out++ = (char)(0x80 | (ch & 0x3F));
+            }
+        } else {
+            uint32_t ch = data[k++];
+            if (ch < 0x80) {
+                *out++ = (char)ch;
+            } else if (ch < 0x800) {
+                *out++ = (char)(0xC0 | (ch >> 6));
+                *out++ = (char)(0x80 | (ch & 0x3F));
+            } else if (ch < 0x10000) {
+                if (is_surrogate(ch)) return nullptr;
+                *out++ = (char)(0xE0 | (ch >> 12));
+                *out++ = (char)(0x80 | ((ch >> 6) & 0x3F));
+                *out++ = (char)(0x80 | (ch & 0x3F));
+            } else {
+                *out++ = (char)(0xF0 | (ch >> 18));
+                *out++ = (char)(0x80 | ((ch >> 12) & 0x3F));
+                *out++ = (char)(0x80 | ((ch >> 6) & 0x3F));
+                *out++ = (char)(0x80 | (ch & 0x3F));
+            }
+        }
+    }
+    return out;
+}
+
+inline Py_ssize_t span_utf8_size(const BufferSpan& span) {
+    return with_span_data(span, [](auto data, Py_ssize_t n) {
+        return utf8_size_of(data, n);
+    });
+}
+
+inline char* span_utf8_encode(const BufferSpan& span, char* out) {
+    return with_span_data(span, [out](auto data, Py_ssize_t n) {
+        return utf8_encode_to(data, n, out);
+    });
+}
+
+/**
+ * @brief Find the UTF-8 bytes behind a Utf8Buffer or a step-1 slice of one.
+ * @return false for every other buffer.
+ */
+bool raw_utf8(const Buffer& buf, const char*& bytes, Py_ssize_t& size) {
+    if (buf.is_a(Utf8Buffer::buffer_class_id)) {
+        bytes = static_cast<const Utf8Buffer&>(buf).bytes(0, buf.length(), size);
+        return true;
+    }
+    if (buf.is_a(Slice1Buffer::buffer_class_id) && !buf.is_a(SliceBuffer::buffer_class_id)) {
+        const Slice1Buffer& slice = static_cast<const Slice1Buffer&>(buf);
+        const Buffer* base = ((LStrObject*)slice.base())->buffer;
+        if (!base->is_a(Utf8Buffer::buffer_class_id)) return false;
+        Py_ssize_t start = slice.base_start();
+        bytes = static_cast<const Utf8Buffer*>(base)->bytes(start, start + buf.length(), size);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief UTF-8 length of the whole buffer, or -1 if it contains a surrogate.
+ */
+Py_ssize_t buffer_utf8_size(const Buffer& buf) {
+    const char* raw;
+    Py_ssize_t raw_size;
+    if (raw_utf8(buf, raw, raw_size)) return raw_size;
+    Py_ssize_t size = 0;
+    bool ok = for_each_span(buf, 0, buf.length(), [&](const BufferSpan& span) {
+        Py_ssize_t n = span_utf8_size(span);
+        if (n < 0) return false;
+        size += n;
+        return true;
+    });
+    return ok ? size : -1;
+}
+
+/**
+ * @brief Write the buffer as UTF-8 to out, which must have room for
+ *        buffer_utf8_bound() bytes.
+ * @return The end of the written bytes, or nullptr if the buffer contains
+ *         a surrogate.
+ */
+char* buffer_utf8_encode(const Buffer& buf, char* out) {
+    const char* raw;
+    Py_ssize_t raw_size;
+    if (raw_utf8(buf, raw, raw_size)) {
+        // Validated UTF-8 is its own encoding.
+        std::memcpy(out, raw, (size_t)raw_size);
+        return out + raw_size;
+    }
+    for_each_span(buf, 0, buf.length(), [&](const BufferSpan& span) {
+        out = span_utf8_encode(span, out);
+        return out != nullptr;
+    });
+    return out;
+}
+
+/**
+ * @brief Upper bound of the UTF-8 length of the buffer, or -1 on overflow.
+ */
+Py_ssize_t buffer_utf8_bound(const Buffer& buf) {
+    const char* raw;
+    Py_ssize_t raw_size;
+    if (raw_utf8(buf, raw, raw_size)) return raw_size;
+    Py_ssize_t width = utf8_max_width(buf.unicode_kind());
+    Py_ssize_t length = buf.length();
+    if (length > PY_SSIZE_T_MAX / width) return -1;
+    return length * width;
+}
+
+/**
+ * @brief Encode the buffer with CPython's UTF-8 codec and error handler.
+ */
+PyObject* fallback_utf8(const Buffer& buf, const char* errors) {
+    cppy::ptr text(buffer_to_pystr(&buf));
+    if (!text) return nullptr;
+    return PyUnicode_AsEncodedString(text.get(), "utf-8", errors);
+}
+
+/**
+ * @brief Releases a Py_buffer on scope exit.
+ */
+class BufferView {
+public:
+    BufferView() : acquired_(false) {}
+
+    ~BufferView() {
+        if (acquired_) PyBuffer_Release(&view_);
+    }
+
+    BufferView(const BufferView&) = delete;
+    BufferView& operator=(const BufferView&) = delete;
+
+    bool acquire(PyObject* obj, int flags) {
+        acquired_ = PyObject_GetBuffer(obj, &view_, flags) == 0;
+        return acquired_;
+    }
+
+    char* data() const {
+        return static_cast<char*>(view_.buf);
+    }
+
+    Py_ssize_t size() const {
+        return view_.len;
+    }
+
+private:
+    Py_buffer view_;
+    bool acquired_;
+};
+
+} // namespace
+
+/* Iterator over encoded chunks */
+
+/**
+ * Iterator produced by `iter_chunks`.
+ *
+ * Walks the leaves of the source with a BufferCursor and yields their
+ * UTF-8 bytes. Leaves shorter than the chunk size are gathered into one
+ * chunk; longer ones are encoded on their own, split into pieces of at most
+ * `chunk_size` code points. The iterator type is created on demand and
+ * cached on the `L` type object, like the split iterator.
+ */
+struct LStrChunkIterObject {
+    PyObject_HEAD
+    LStrObject *source;       /* owned reference */
+    BufferCursor *cursor;     /* owned */
+    PyObject *errors;         /* owned str */
+    Py_ssize_t chunk_size;
+    std::vector<char> *pending; /* owned scratch of gathered leaves */
+};
+
+static void LStrChunkIter_dealloc(PyObject *it_obj) {
+    LStrChunkIterObject *it = (LStrChunkIterObject*)it_obj;
+    delete it->cursor;
+    it->cursor = nullptr;
+    delete it->pending;
+    it->pending = nullptr;
+    Py_CLEAR(it->errors);
+    if (it->source) {
+        cppy::decref((PyObject*)it->source);
+        it->source = nullptr;
+    }
+    PyTypeObject *tp = Py_TYPE(it_obj);
+    tp->tp_free(it_obj);
+}
+
+/**
+ * @brief Append the UTF-8 of span to out, through the codec if it holds a
+ *        surrogate.
+ */
+static bool append_span_utf8(std::vector<char>& out, const BufferSpan& span, const char* errors) {
+    size_t used = out.size();
+    out.resize(used + (size_t)(span.length * utf8_max_width(span.kind)));
+    char* end = span_utf8_encode(span, out.data() + used);
+    if (end) {
+        out.resize((size_t)(end - out.data()));
+        return true;
+    }
+    out.resize(used);
+    cppy::ptr text(PyUnicode_FromKindAndData(span.kind, span.data, span.length));
+    if (!text) return false;
+    cppy::ptr bytes(PyUnicode_AsEncodedString(text.get(), "utf-8", errors));
+    if (!bytes) return false;
+    const char* data = PyBytes_AS_STRING(bytes.get());
+    out.insert(out.end(), data, data + PyBytes_GET_SIZE(bytes.get()));
+    return true;
+}
+
+static PyObject* LStrChunkIter_next_locked(PyObject *it_obj) {
+    LStrChunkIterObject *it = (LStrChunkIterObject*)it_obj;
+    if (!it->source || !it->cursor || !it->pending) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L chunk iterator");
+        return nullptr;
+    }
+    const char *errors = PyUnicode_AsUTF8(it->errors);
+    if (!errors) return nullptr;
+    try {
+        std::vector<char>& out = *it->pending;
+        out.clear();
+        BufferSpan span;
+        Py_ssize_t taken = 0;
+        while (taken < it->chunk_size && it->cursor->current(span)) {
+            Py_ssize_t count = std::min(span.length, it->chunk_size - taken);
+            BufferSpan piece = subspan(span, 0, count);
+            if (taken == 0 && count * 2 >= it->chunk_size) {
+                // A long leaf goes straight into its own bytes object.
+                Py_ssize_t size = span_utf8_size(piece);
+                if (size >= 0) {
+                    cppy::ptr bytes(PyBytes_FromStringAndSize(nullptr, size));
+                    if (!bytes) return nullptr;
+                    span_utf8_encode(piece, PyBytes_AS_STRING(bytes.get()));
+                    it->cursor->advance(count);
+                    return bytes.release();
+                }
+            }
+            if (!append_span_utf8(out, piece, errors)) return nullptr;
+            it->cursor->advance(count);
+            taken += count;
+        }
+        if (taken == 0) {
+            PyErr_SetNone(PyExc_StopIteration);
+            return nullptr;
+        }
+        return PyBytes_FromStringAndSize(out.data(), (Py_ssize_t)out.size());
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+static PyObject* LStrChunkIter_iternext(PyObject *it_obj) {
+    // The cursor moves on every step; threads sharing the iterator take
+    // turns.
+    PyObject *result;
+    Py_BEGIN_CRITICAL_SECTION(it_obj);
+    result = LStrChunkIter_next_locked(it_obj);
+    Py_END_CRITICAL_SECTION();
+    return result;
+}
+
+PyType_Slot LStrChunkIter_slots[] = {
+    {Py_tp_dealloc, (void*)LStrChunkIter_dealloc},
+    {Py_tp_iternext, (void*)LStrChunkIter_iternext},
+    {Py_tp_iter, (void*)PyObject_SelfIter},
+    {Py_tp_doc, (void*)"Iterator over the UTF-8 encoded chunks of an L."},
+    {0, nullptr}
+};
+
+PyType_Spec LStrChunkIter_spec = {
+    "_lstring._lstr_chunk_iterator",
+    sizeof(LStrChunkIterObject),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    LStrChunkIter_slots
+};
+
+/* Methods */
+
+/**
+ * @brief encode(self, encoding='utf-8', errors='strict')
+ *
+ * UTF-8 is written straight from the leaves into the result bytes; other
+ * encodings, and ropes holding a lone surrogate, go through str.encode.
+ */
+PyObject* LStr_encode(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"encoding", (char*)"errors", nullptr};
+    const char *encoding = "utf-8";
+    const char *errors = "strict";
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ss:encode", kwlist, &encoding, &errors)) {
+        return nullptr;
+    }
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return nullptr;
+    }
+    try {
+        const Buffer &buf = *self->buffer;
+        if (!is_utf8_name(encoding)) {
+            cppy::ptr text(buffer_to_pystr(&buf));
+            if (!text) return nullptr;
+            return PyUnicode_AsEncodedString(text.get(), encoding, errors);
+        }
+        if (buf.is_str()) {
+            // A str leaf: CPython's encoder knows whether it is ASCII.
+            return fallback_utf8(buf, errors);
+        }
+        // One pass into a bytes object of the largest possible size, which
+        // is then shrunk; the untouched tail of a large allocation is
+        // never backed by memory.
+        Py_ssize_t bound = buffer_utf8_bound(buf);
+        if (bound < 0) return PyErr_NoMemory();
+        PyObject *bytes = PyBytes_FromStringAndSize(nullptr, bound);
+        if (!bytes) return nullptr;
+        char *end = buffer_utf8_encode(buf, PyBytes_AS_STRING(bytes));
+        if (!end) {
+            Py_DECREF(bytes);
+            return fallback_utf8(buf, errors);
+        }
+        if (_PyBytes_Resize(&bytes, end - PyBytes_AS_STRING(bytes)) < 0) return nullptr;
+        return bytes;
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * @brief encode_into(self, buffer, offset=0, errors='strict')
+ *
+ * Write the UTF-8 encoding of self into a writable contiguous buffer
+ * (bytearray, memoryview, mmap...) at `offset` and return the number of
+ * bytes written. Raises ValueError if it does not fit; the bytes after
+ * `offset` are unspecified when an error is raised.
+ */
+PyObject* LStr_encode_into(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"buffer", (char*)"offset", (char*)"errors", nullptr};
+    PyObject *target;
+    Py_ssize_t offset = 0;
+    const char *errors = "strict";
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|ns:encode_into", kwlist, &target, &offset, &errors)) {
+        return nullptr;
+    }
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return nullptr;
+    }
+    BufferView view;
+    if (!view.acquire(target, PyBUF_WRITABLE)) return nullptr;
+    if (offset < 0 || offset > view.size()) {
+        PyErr_SetString(PyExc_ValueError, "offset out of range");
+        return nullptr;
+    }
+    try {
+        const Buffer &buf = *self->buffer;
+        Py_ssize_t bound = buffer_utf8_bound(buf);
+        if (bound >= 0 && bound <= view.size() - offset) {
+            // Room for any encoding: one pass, unless there is a surrogate.
+            char *end = buffer_utf8_encode(buf, view.data() + offset);
+            if (end) return PyLong_FromSsize_t(end - (view.data() + offset));
+        }
+        Py_ssize_t size = buffer_utf8_size(buf);
+        cppy::ptr fallback;
+        if (size < 0) {
+            fallback = cppy::ptr(fallback_utf8(buf, errors));
+            if (!fallback) return nullptr;
+            size = PyBytes_GET_SIZE(fallback.get());
+        }
+        if (size > view.size() - offset) {
+            PyErr_Format(PyExc_ValueError, "buffer too small: %zd bytes needed at offset %zd, %zd available",
+                         size, offset, view.size() - offset);
+            return nullptr;
+        }
+        if (fallback) {
+            std::memcpy(view.data() + offset, PyBytes_AS_STRING(fallback.get()), (size_t)size);
+        } else {
+            buffer_utf8_encode(buf, view.data() + offset);
+        }
+        return PyLong_FromSsize_t(size);
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * @brief utf8_length(self, errors='strict')
+ *
+ * Return the length of self.encode('utf-8', errors) without encoding it
+ * (unless self holds a lone surrogate).
+ */
+PyObject* LStr_utf8_length(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"errors", nullptr};
+    const char *errors = "strict";
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|s:utf8_length", kwlist, &errors)) {
+        return nullptr;
+    }
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return nullptr;
+    }
+    try {
+        Py_ssize_t size = buffer_utf8_size(*self->buffer);
+        if (size < 0) {
+            cppy::ptr bytes(fallback_utf8(*self->buffer, errors));
+            if (!bytes) return nullptr;
+            size = PyBytes_GET_SIZE(bytes.get());
+        }
+        return PyLong_FromSsize_t(size);
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * @brief iter_chunks(self, chunk_size=65536, errors='strict')
+ *
+ * Return an iterator over the UTF-8 encoding of self as bytes chunks,
+ * following the leaves; their concatenation equals self.encode().
+ */
+PyObject* LStr_iter_chunks(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"chunk_size", (char*)"errors", nullptr};
+    Py_ssize_t chunk_size = 65536;
+    PyObject *errors = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|nU:iter_chunks", kwlist, &chunk_size, &errors)) {
+        return nullptr;
+    }
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return nullptr;
+    }
+    if (chunk_size < 1) {
+        PyErr_SetString(PyExc_ValueError, "chunk_size must be at least 1");
+        return nullptr;
+    }
+    cppy::ptr errors_ref(errors ? cppy::incref(errors) : PyUnicode_FromString("strict"));
+    if (!errors_ref) return nullptr;
+
+    PyTypeObject *lstr_type = get_base_l_type(Py_TYPE(self));
+
+    // Try to get cached iterator type from the L type object
+    tptr<PyTypeObject> it_type(PyObject_GetAttrString((PyObject*)lstr_type, "_chunk_iterator_type"));
+    if (!it_type) {
+        PyErr_Clear();
+
+        it_type = tptr<PyTypeObject>(PyType_FromSpec(&LStrChunkIter_spec));
+        if (!it_type) return nullptr;
+
+        // Cache iterator type on the L heap type object for reuse.
+        if (PyObject_SetAttrString((PyObject*)lstr_type, "_chunk_iterator_type", it_type.ptr().get()) < 0) {
+            return nullptr;
+        }
+    }
+
+    tptr<LStrChunkIterObject> it_obj(PyObject_CallObject(it_type.ptr().get(), nullptr));
+    if (!it_obj) return nullptr;
+
+    try {
+        it_obj->source = (LStrObject*)cppy::incref((PyObject*)self);
+        it_obj->errors = errors_ref.release();
+        it_obj->chunk_size = chunk_size;
+        it_obj->pending = new std::vector<char>();
+        it_obj->cursor = new BufferCursor(self->buffer, 0, self->buffer->length());
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    return it_obj.ptr().release();
+}
@@ -0,0 +1,1175 @@
+/**
+ * @file lstring_format.cxx
+ * @brief Placeholder parsers and compiled format templates for `L`.
+ *
+ * The printf, str.format and f-string machinery of lstring/format.py parses
+ * a format L once into a FormatTemplate: the literal text as slice views of
+ * the format (or, for escapes, of the escaped character) and the
+ * placeholders with their specs. Rendering a template formats only the
+ * placeholders and assembles the result in a single call, so nothing is
+ * parsed again when the same format is used with other arguments.
+ */
+
+#include <Python.h>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+#include <cppy/ptr.h>
+
+#include "lstring/lstring.hxx"
+#include "_lstring.hxx"
+#include "lstring_utils.hxx"
+#include "span.hxx"
+#include "tptr.hxx"
+
+namespace {
+
+/**
+ * @brief Check if character is a printf flag character (#, 0, space, +, -)
+ */
+inline bool is_printf_flag_char(uint32_t ch) {
+    switch (ch) {
+        case '#': case '0': case ' ': case '+': case '-':
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Check if character is a printf length modifier (h, l, L)
+ */
+inline bool is_printf_length_char(uint32_t ch) {
+    switch (ch) {
+        case 'h': case 'l': case 'L':
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Check if character is a printf type specifier
+ */
+inline bool is_printf_type_char(uint32_t ch) {
+    switch (ch) {
+        case 'd': case 'i': case 'o': case 'u':
+        case 'x': case 'X': case 'e': case 'E':
+        case 'f': case 'F': case 'g': case 'G':
+        case 'c': case 'r': case 's': case 'a':
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief A parsed printf placeholder.
+ *
+ * end: position after the placeholder (-1 if invalid); escape: %%;
+ * star_count: number of * in width/precision (positional only);
+ * name_end: position after the ) of the name (named only, else -1).
+ */
+struct PrintfToken {
+    Py_ssize_t end;
+    bool escape;
+    int star_count;
+    Py_ssize_t name_end;
+};
+
+/**
+ * @brief Parse the flags, width, precision, length and type of a printf
+ *        placeholder from pos; `stars` allows * for width and precision.
+ * @return Position after the type, or -1 if there is no valid type.
+ */
+Py_ssize_t scan_printf_conversion(const Buffer* buf, Py_ssize_t pos, Py_ssize_t length,
+                                  bool stars, int& star_count) {
+    // Parse flags: #, 0, -, space, +
+    while (pos < length && is_printf_flag_char(buf->value(pos))) {
+        pos++;
+    }
+
+    // Parse width: number or *
+    if (stars && pos < length && buf->value(pos) == '*') {
+        star_count++;
+        pos++;
+    } else {
+        while (pos < length && buf->value(pos) >= '0' && buf->value(pos) <= '9') {
+            pos++;
+        }
+    }
+
+    // Parse precision: .number or .*
+    if (pos < length && buf->value(pos) == '.') {
+        pos++;
+        if (stars && pos < length && buf->value(pos) == '*') {
+            star_count++;
+            pos++;
+        } else {
+            while (pos < length && buf->value(pos) >= '0' && buf->value(pos) <= '9') {
+                pos++;
+            }
+        }
+    }
+
+    // Parse length: h, l, L
+    if (pos < length && is_printf_length_char(buf->value(pos))) {
+        pos++;
+    }
+
+    // Parse type: d, i, o, u, x, X, e, E, f, F, g, G, c, r, s, a
+    if (pos < length && is_printf_type_char(buf->value(pos))) {
+        return pos + 1;
+    }
+    return -1;
+}
+
+/**
+ * @brief Parse a positional printf placeholder; buf[start_pos] is '%'.
+ */
+PrintfToken scan_printf_positional(const Buffer* buf, Py_ssize_t start_pos, Py_ssize_t length) {
+    Py_ssize_t pos = start_pos + 1;
+    if (pos >= length) return PrintfToken{-1, false, 0, -1};
+
+    // Check for %% escape
+    if (buf->value(pos) == '%') return PrintfToken{pos + 1, true, 0, -1};
+
+    int star_count = 0;
+    Py_ssize_t end = scan_printf_conversion(buf, pos, length, true, star_count);
+    if (end == -1) return PrintfToken{-1, false, 0, -1};
+    return PrintfToken{end, false, star_count, -1};
+}
+
+/**
+ * @brief Parse a named printf placeholder; buf[start_pos] is '%'.
+ */
+PrintfToken scan_printf_named(const Buffer* buf, Py_ssize_t start_pos, Py_ssize_t length) {
+    const PrintfToken invalid{-1, false, 0, -1};
+    Py_ssize_t pos = start_pos + 1;
+    if (pos >= length) return invalid;
+
+    // Check for %% escape
+    if (buf->value(pos) == '%') return PrintfToken{pos + 1, true, 0, -1};
+
+    // Named placeholder: %(name); anything else is invalid here.
+    if (buf->value(pos) != '(') return invalid;
+    pos++;
+    // Find closing )
+    while (pos < length && buf->value(pos) != ')') {
+        pos++;
+    }
+    if (pos >= length) return invalid;  // Unclosed (
+    pos++;  // Skip )
+    Py_ssize_t name_end = pos;
+
+    // No * for named placeholders
+    int star_count = 0;
+    Py_ssize_t end = scan_printf_conversion(buf, pos, length, false, star_count);
+    if (end == -1) return invalid;
+    return PrintfToken{end, false, 0, name_end};
+}
+
+/** Token types of the brace parsers. */
+enum BraceTokenType {
+    BRACE_INVALID = 0,
+    BRACE_LITERAL_OPEN = 1,
+    BRACE_LITERAL_CLOSE = 2,
+    BRACE_PLACEHOLDER = 3,
+};
+
+/**
+ * @brief A parsed brace token.
+ *
+ * end: position after the token (-1 if invalid/unmatched); type: a
+ * BraceTokenType; content_end: position of the closing } of a placeholder;
+ * expr_end: end of the expression of an f-string placeholder (else -1).
+ */
+struct BraceToken {
+    Py_ssize_t end;
+    int type;
+    Py_ssize_t content_end;
+    Py_ssize_t expr_end;
+};
+
+/**
+ * @brief Parse a str.format token; buf[start_pos] is '{' or '}'.
+ */
+BraceToken scan_format_placeholder(const Buffer* buf, Py_ssize_t start_pos, Py_ssize_t length) {
+    uint32_t ch = buf->value(start_pos);
+
+    if (ch == '{') {
+        // Check for {{ escape
+        if (start_pos + 1 < length && buf->value(start_pos + 1) == '{') {
+            return BraceToken{start_pos + 2, BRACE_LITERAL_OPEN, -1, -1};
+        }
+
+        // Find matching } with nesting support
+        Py_ssize_t pos = start_pos + 1;
+        int depth = 1;
+        while (pos < length && depth > 0) {
+            uint32_t c = buf->value(pos);
+            if (c == '{') {
+                depth++;
+            } else if (c == '}') {
+                depth--;
+            }
+            pos++;
+        }
+
+        if (depth == 0) {
+            // Found complete placeholder: {content}
+            return BraceToken{pos, BRACE_PLACEHOLDER, pos - 1, -1};
+        }
+        // Unclosed brace - invalid
+        return BraceToken{-1, BRACE_INVALID, -1, -1};
+    }
+
+    // Check for }} escape
+    if (start_pos + 1 < length && buf->value(start_pos + 1) == '}') {
+        return BraceToken{start_pos + 2, BRACE_LITERAL_CLOSE, -1, -1};
+    }
+    // Unmatched } - invalid (caller should skip it)
+    return BraceToken{start_pos + 1, BRACE_INVALID, -1, -1};
+}
+
+/**
+ * @brief Find the end of a Python expression in an f-string placeholder.
+ *
+ * Tracks nested brackets (), [], {} and quoted strings to find where the
+ * expression ends (at : for format spec, ! for conversion, or } for end).
+ *
+ * @param buf Buffer containing the format string
+ * @param start Starting position (after opening {)
+ * @param length Total buffer length
+ * @return Position where expression ends, or -1 if not found
+ */
+Py_ssize_t find_fstring_expr_end(const Buffer* buf, Py_ssize_t start, Py_ssize_t length) {
+    int paren_depth = 0;
+    int bracket_depth = 0;
+    int brace_depth = 0;
+    bool in_string = false;
+    uint32_t quote_char = 0;
+    bool is_raw = false;
+    bool is_triple = false;
+
+    for (Py_ssize_t i = start; i < length; i++) {
+        uint32_t ch = buf->value(i);
+
+        // Handle string literals
+        if (!in_string) {
+            // Check for raw string prefix
+            if ((ch == 'r' || ch == 'R') && i + 1 < length) {
+                uint32_t next = buf->value(i + 1);
+                if (next == '\'' || next == '"') {
+                    is_raw = true;
+                    i++;
+                    ch = buf->value(i);
+                }
+            }
+
+            // Check for string start
+            if (ch == '\'' || ch == '"') {
+                in_string = true;
+                quote_char = ch;
+                // Check for triple-quoted string
+                if (i + 2 < length && buf->value(i + 1) == ch && buf->value(i + 2) == ch) {
+                    is_triple = true;
+                    i += 2;
+                }
+                continue;
+            }
+        } else {
+            // Inside string - look for end
+            if (is_triple) {
+                // Triple-quoted string ends with three quotes
+                if (ch == quote_char && i + 2 < length &&
+                    buf->value(i + 1) == quote_char && buf->value(i + 2) == quote_char) {
+                    if (!is_raw || i == start || buf->value(i - 1) != '\\') {
+                        in_string = false;
+                        is_triple = false;
+                        is_raw = false;
+                        i += 2;
+                        continue;
+                    }
+                }
+            } else {
+                // Single-quoted string
+                if (ch == quote_char) {
+                    if (!is_raw || i == start || buf->value(i - 1) != '\\') {
+                        in_string = false;
+                        is_raw = false;
+                        continue;
+                    }
+                }
+            }
+            // Skip everything inside strings
+            continue;
+        }
+
+        // Track bracket depth (only outside strings)
+        if (ch == '(') {
+            paren_depth++;
+        } else if (ch == ')') {
+            paren_depth--;
+            if (paren_depth < 0) return -1;  // Unbalanced
+        } else if (ch == '[') {
+            bracket_depth++;
+        } else if (ch == ']') {
+            bracket_depth--;
+            if (bracket_depth < 0) return -1;  // Unbalanced
+        } else if (ch == '{') {
+            brace_depth++;
+        } else if (ch == '}') {
+            // Closing brace at depth 0 ends the placeholder
+            if (brace_depth == 0 && paren_depth == 0 && bracket_depth == 0) {
+                return i;
+            }
+            brace_depth--;
+            if (brace_depth < 0) return -1;  // Unbalanced
+        } else if ((ch == ':' || ch == '!') && paren_depth == 0 && bracket_depth == 0 && brace_depth == 0) {
+            // Format spec or conversion at depth 0
+            return i;
+        }
+    }
+
+    return -1;  // Unclosed expression
+}
+
+/**
+ * @brief Parse an f-string token; buf[start_pos] is '{' or '}'.
+ */
+BraceToken scan_fformat_placeholder(const Buffer* buf, Py_ssize_t start_pos, Py_ssize_t length) {
+    const BraceToken invalid{-1, BRACE_INVALID, -1, -1};
+    uint32_t ch = buf->value(start_pos);
+
+    if (ch == '{') {
+        // Check for {{ escape
+        if (start_pos + 1 < length && buf->value(start_pos + 1) == '{') {
+            return BraceToken{start_pos + 2, BRACE_LITERAL_OPEN, -1, -1};
+        }
+
+        // Find end of expression
+        Py_ssize_t expr_end = find_fstring_expr_end(buf, start_pos + 1, length);
+        if (expr_end == -1) return invalid;  // Unclosed or invalid expression
+
+        // Now find the actual closing }
+        Py_ssize_t pos = expr_end;
+        uint32_t end_ch = buf->value(pos);
+
+        if (end_ch == '!') {
+            // Conversion: !r, !s, !a
+            pos++;
+            if (pos < length) {
+                uint32_t conv = buf->value(pos);
+                if (conv == 'r' || conv == 's' || conv == 'a') {
+                    pos++;
+                } else {
+                    return invalid;  // Invalid conversion
+                }
+            }
+            // After conversion, might have format spec
+            if (pos < length && buf->value(pos) == ':') {
+                // Skip format spec (everything until })
+                while (pos < length && buf->value(pos) != '}') {
+                    pos++;
+                }
+            }
+        } else if (end_ch == ':') {
+            // Format spec - skip until }
+            pos++;
+            while (pos < length && buf->value(pos) != '}') {
+                pos++;
+            }
+        }
+        // end_ch == '}' - just close
+
+        if (pos >= length || buf->value(pos) != '}') {
+            return invalid;  // Missing closing brace
+        }
+
+        // Found complete placeholder: {expr[!conv][:spec]}
+        return BraceToken{pos + 1, BRACE_PLACEHOLDER, pos, expr_end};
+    }
+
+    // Check for }} escape
+    if (start_pos + 1 < length && buf->value(start_pos + 1) == '}') {
+        return BraceToken{start_pos + 2, BRACE_LITERAL_CLOSE, -1, -1};
+    }
+    // Unmatched } - invalid (caller should skip it)
+    return BraceToken{start_pos + 1, BRACE_INVALID, -1, -1};
+}
+
+/**
+ * @brief Validate self and start_pos for the _parse_* methods.
+ * @return The buffer, or nullptr with an exception set.
+ */
+const Buffer* parse_start(LStrObject *self, Py_ssize_t start_pos, uint32_t ch1, uint32_t ch2,
+                          const char *message) {
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return nullptr;
+    }
+    const Buffer *buf = self->buffer;
+    if (start_pos < 0 || start_pos >= buf->length()) {
+        PyErr_SetString(PyExc_ValueError, "start_pos out of range");
+        return nullptr;
+    }
+    uint32_t ch = buf->value(start_pos);
+    if (ch != ch1 && ch != ch2) {
+        PyErr_SetString(PyExc_ValueError, message);
+        return nullptr;
+    }
+    return buf;
+}
+
+/* Format templates */
+
+/**
+ * @brief Formatting styles of a template.
+ */
+enum FormatStyle {
+    STYLE_PRINTF,
+    STYLE_PRINTF_NAMED,
+    STYLE_FORMAT,
+    STYLE_FFORMAT,
+};
+
+/**
+ * @brief One part of a compiled format: a literal piece or a placeholder.
+ */
+struct FormatSegment {
+    enum Kind {
+        LITERAL,        // piece: the literal L
+        PRINTF,         // spec: '%...' str; star_count
+        PRINTF_NAMED,   // spec: '%(name)...' str; key: name L; key_str: name str
+        FIELD_AUTO,     // spec: '{...}' str of an auto-numbered field
+        FIELD_NUMBERED, // spec: '{0...}'
+        FIELD_NAMED,    // spec: '{name...}'
+        EXPRESSION,     // spec: '{' conversion/spec '}' str; key: expression str
+    };
+
+    Kind kind;
+    int star_count = 0;
+    cppy::ptr piece;
+    cppy::ptr spec;
+    cppy::ptr key;
+    cppy::ptr key_str;
+};
+
+/**
+ * @brief A format L parsed into literal pieces and placeholders.
+ */
+class FormatTemplate {
+public:
+    FormatTemplate(LStrObject *source, FormatStyle style)
+        : source_((PyObject*)source, true), style_(style), verbatim_(false), pending_start_(0), pending_end_(0) {}
+
+    FormatStyle style() const {
+        return style_;
+    }
+
+    /**
+     * @brief Whether the format has a printf spec the template cannot
+     *        parse. It is then rendered by str % on the whole format, so
+     *        that CPython formats it or raises its own error.
+     */
+    bool verbatim() const {
+        return verbatim_;
+    }
+
+    /** New reference to str(source). */
+    PyObject* source_str() const {
+        return buffer_to_pystr(source()->buffer);
+    }
+
+    const std::vector<FormatSegment>& segments() const {
+        return segments_;
+    }
+
+    PyTypeObject* result_type() const {
+        return Py_TYPE(source_.get());
+    }
+
+    /**
+     * @brief Parse the source with the same rules as the former Python
+     *        implementations of printf, format and fformat.
+     * @return false with an exception set on failure.
+     */
+    bool compile() {
+        switch (style_) {
+            case STYLE_PRINTF:
+            case STYLE_PRINTF_NAMED:
+                if (!compile_printf()) return false;
+                break;
+            default:
+                if (!compile_braces()) return false;
+                break;
+        }
+        return flush_literal();
+    }
+
+private:
+    LStrObject* source() const {
+        return source_.get();
+    }
+
+    /**
+     * @brief Add source[start:end) to the literal text, merging it with the
+     *        pending literal when they are adjacent in the source.
+     */
+    bool add_literal(Py_ssize_t start, Py_ssize_t end) {
+        if (start >= end) return true;
+        if (pending_start_ < pending_end_ && pending_end_ == start) {
+            pending_end_ = end;
+            return true;
+        }
+        if (!flush_literal()) return false;
+        pending_start_ = start;
+        pending_end_ = end;
+        return true;
+    }
+
+    bool flush_literal() {
+        if (pending_start_ >= pending_end_) return true;
+        FormatSegment seg;
+        seg.kind = FormatSegment::LITERAL;
+        seg.piece = cppy::ptr(make_lstr_slice(source(), pending_start_, pending_end_));
+        if (!seg.piece) return false;
+        segments_.push_back(std::move(seg));
+        pending_start_ = pending_end_ = 0;
+        return true;
+    }
+
+    bool add_segment(FormatSegment&& seg) {
+        if (!flush_literal()) return false;
+        segments_.push_back(std::move(seg));
+        return true;
+    }
+
+    /** New reference to str(source[start:end]). */
+    PyObject* substr(Py_ssize_t start, Py_ssize_t end) const {
+        cppy::ptr piece(make_lstr_slice(source(), start, end));
+        if (!piece) return nullptr;
+        return buffer_to_pystr(((LStrObject*)piece.get())->buffer);
+    }
+
+    bool compile_printf() {
+        const Buffer *buf = source()->buffer;
+        Py_ssize_t length = buf->length();
+        bool named = style_ == STYLE_PRINTF_NAMED;
+        Py_ssize_t last_pos = 0;
+
+        while (last_pos < length) {
+            Py_ssize_t percent_pos = buf->findc(last_pos, length, '%');
+            if (percent_pos == -1) {
+                // No more placeholders - the rest is literal
+                return add_literal(last_pos, length);
+            }
+            if (!add_literal(last_pos, percent_pos)) return false;
+
+            PrintfToken tok = named ? scan_printf_named(buf, percent_pos, length)
+                                    : scan_printf_positional(buf, percent_pos, length);
+            if (tok.end == -1) {
+                // Invalid here (or positional in a named format): whether
+                // str % raises or formats depends on the values.
+                verbatim_ = true;
+                segments_.clear();
+                pending_start_ = pending_end_ = 0;
+                return true;
+            }
+            if (tok.escape) {
+                // %% escape sequence
+                if (!add_literal(percent_pos, percent_pos + 1)) return false;
+                last_pos = tok.end;
+                continue;
+            }
+
+            FormatSegment seg;
+            seg.spec = cppy::ptr(substr(percent_pos, tok.end));
+            if (!seg.spec) return false;
+            if (named) {
+                // Skip %( and )
+                seg.kind = FormatSegment::PRINTF_NAMED;
+                seg.key = cppy::ptr(make_lstr_slice(source(), percent_pos + 2, tok.name_end - 1));
+                if (!seg.key) return false;
+                seg.key_str = cppy::ptr(substr(percent_pos + 2, tok.name_end - 1));
+                if (!seg.key_str) return false;
+            } else {
+                seg.kind = FormatSegment::PRINTF;
+                seg.star_count = tok.star_count;
+            }
+            if (!add_segment(std::move(seg))) return false;
+            last_pos = tok.end;
+        }
+        return true;
+    }
+
+    bool compile_braces() {
+        const Buffer *buf = source()->buffer;
+        Py_ssize_t length = buf->length();
+        bool fformat = style_ == STYLE_FFORMAT;
+        Py_ssize_t pos = 0;
+        Py_ssize_t last_pos = 0;
+
+        while (pos < length) {
+            Py_ssize_t next_pos = span_find_if(*buf, pos, length, [](uint32_t ch) {
+                return ch == '{' || ch == '}';
+            });
+            if (next_pos == -1) {
+                // No more braces - the rest is literal
+                return add_literal(last_pos, length);
+            }
+
+            BraceToken tok = fformat ? scan_fformat_placeholder(buf, next_pos, length)
+                                     : scan_format_placeholder(buf, next_pos, length);
+            if (tok.end == -1) {
+                // Invalid/unclosed - skip this character
+                pos = next_pos + 1;
+                continue;
+            }
+            if (!add_literal(last_pos, next_pos)) return false;
+
+            if (tok.type == BRACE_LITERAL_OPEN || tok.type == BRACE_LITERAL_CLOSE) {
+                // {{ -> {, }} -> }
+                if (!add_literal(next_pos, next_pos + 1)) return false;
+            } else if (tok.type == BRACE_PLACEHOLDER) {
+                FormatSegment seg;
+                if (fformat) {
+                    // Expression, then the conversion and spec applied
+                    // to its value as '{!r:spec}'.
+                    seg.kind = FormatSegment::EXPRESSION;
+                    seg.key = cppy::ptr(substr(next_pos + 1, tok.expr_end));
+                    if (!seg.key) return false;
+                    cppy::ptr suffix(substr(tok.expr_end, tok.content_end));
+                    if (!suffix) return false;
+                    seg.spec = cppy::ptr(PyUnicode_FromFormat("{%U}", suffix.get()));
+                } else {
+                    cppy::ptr content(substr(next_pos + 1, tok.content_end));
+                    if (!content) return false;
+                    Py_ssize_t content_len = PyUnicode_GET_LENGTH(content.get());
+                    Py_UCS4 first = content_len ? PyUnicode_READ_CHAR(content.get(), 0) : 0;
+                    if (content_len == 0 || first == ':' || first == '.' || first == '!' || first == '[') {
+                        // Auto-numbered: {}, {:.2f}, {!r}
+                        seg.kind = FormatSegment::FIELD_AUTO;
+                    } else if (Py_UNICODE_ISDIGIT(first)) {
+                        // Numbered: {0}, {1:.2f}
+                        seg.kind = FormatSegment::FIELD_NUMBERED;
+                    } else {
+                        // Named or attribute/index access: {name}, {obj.attr}, {dict[key]}
+                        seg.kind = FormatSegment::FIELD_NAMED;
+                    }
+                    seg.spec = cppy::ptr(PyUnicode_FromFormat("{%U}", content.get()));
+                }
+                if (!seg.spec) return false;
+                if (!add_segment(std::move(seg))) return false;
+            }
+            // An unmatched } is dropped.
+
+            last_pos = tok.end;
+            pos = tok.end;
+        }
+        return true;
+    }
+
+    tptr<LStrObject> source_;
+    FormatStyle style_;
+    bool verbatim_;
+    std::vector<FormatSegment> segments_;
+    Py_ssize_t pending_start_;
+    Py_ssize_t pending_end_;
+};
+
+struct LStrFormatTemplateObject {
+    PyObject_HEAD
+    FormatTemplate *tmpl;
+};
+
+/**
+ * @brief Collects the pieces of a rendering and joins them like L.join.
+ */
+class PieceList {
+public:
+    explicit PieceList(PyTypeObject *type) : type_(type) {}
+
+    void add_literal(PyObject *piece) {
+        pieces_.push_back(tptr<LStrObject>(piece, true));
+    }
+
+    /** Add a formatted str (new reference, may be null on error). */
+    bool add_formatted(PyObject *formatted) {
+        cppy::ptr text(formatted);
+        if (!text) return false;
+        if (!PyUnicode_Check(text.get())) {
+            PyErr_Format(PyExc_TypeError, "formatted value must be str, not %.100s",
+                         Py_TYPE(text.get())->tp_name);
+            return false;
+        }
+        if (PyUnicode_GET_LENGTH(text.get()) == 0) return true;
+        tptr<LStrObject> leaf(make_lstr_from_pystr(type_, text.get()));
+        if (!leaf) return false;
+        pieces_.push_back(leaf);
+        return true;
+    }
+
+    PyObject* result() {
+        if (pieces_.empty()) {
+            return make_lstr_from_pystr(type_, cppy::ptr(PyUnicode_FromString("")).get());
+        }
+        if (pieces_.size() == 1) {
+            return pieces_[0].ptr().release();
+        }
+        tptr<LStrObject> joined = join_balanced(type_, pieces_);
+        if (!joined) return nullptr;
+
+        // Try to optimize/collapse small results
+        tptr<LStrObject> optimized(lstr_optimize(joined.get()));
+        if (optimized) {
+            return optimized.ptr().release();
+        }
+        return joined.ptr().release();
+    }
+
+private:
+    PyTypeObject *type_;
+    std::vector<tptr<LStrObject>> pieces_;
+};
+
+FormatTemplate* get_template(PyObject *self_obj, FormatStyle style, const char *method) {
+    FormatTemplate *tmpl = ((LStrFormatTemplateObject*)self_obj)->tmpl;
+    if (!tmpl) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid format template");
+        return nullptr;
+    }
+    if (tmpl->style() != style) {
+        PyErr_Format(PyExc_TypeError, "%s() does not apply to this template", method);
+        return nullptr;
+    }
+    return tmpl;
+}
+
+/**
+ * @brief Render a verbatim printf template: str(format) % values, as an L
+ *        of the format's type.
+ */
+PyObject* render_verbatim(const FormatTemplate *tmpl, PyObject *values) {
+    cppy::ptr format_str(tmpl->source_str());
+    if (!format_str) return nullptr;
+    cppy::ptr formatted(PyUnicode_Format(format_str.get(), values));
+    if (!formatted) return nullptr;
+    return make_lstr_from_pystr(tmpl->result_type(), formatted.get());
+}
+
+void LStrFormatTemplate_dealloc(PyObject *self_obj) {
+    LStrFormatTemplateObject *self = (LStrFormatTemplateObject*)self_obj;
+    delete self->tmpl;
+    self->tmpl = nullptr;
+    PyTypeObject *tp = Py_TYPE(self_obj);
+    tp->tp_free(self_obj);
+    Py_DECREF(tp);
+}
+
+/**
+ * @brief printf(values): render a positional printf template.
+ *
+ * Each placeholder takes its values (one more than its * count) from the
+ * `values` tuple in order and is formatted with str %.
+ */
+PyObject* LStrFormatTemplate_printf(PyObject *self_obj, PyObject *values) {
+    FormatTemplate *tmpl = get_template(self_obj, STYLE_PRINTF, "printf");
+    if (!tmpl) return nullptr;
+    if (!PyTuple_Check(values)) {
+        PyErr_SetString(PyExc_TypeError, "printf() argument must be a tuple");
+        return nullptr;
+    }
+    if (tmpl->verbatim()) return render_verbatim(tmpl, values);
+    try {
+        PieceList pieces(tmpl->result_type());
+        Py_ssize_t value_idx = 0;
+        for (const FormatSegment &seg : tmpl->segments()) {
+            if (seg.kind == FormatSegment::LITERAL) {
+                pieces.add_literal(seg.piece.get());
+                continue;
+            }
+            Py_ssize_t n = seg.star_count + 1;
+            cppy::ptr args(PyTuple_GetSlice(values, value_idx, value_idx + n));
+            if (!args) return nullptr;
+            value_idx += n;
+            if (!pieces.add_formatted(PyUnicode_Format(seg.spec.get(), args.get()))) return nullptr;
+        }
+        if (value_idx < PyTuple_GET_SIZE(values)) {
+            PyErr_SetString(PyExc_TypeError, "not all arguments converted during string formatting");
+            return nullptr;
+        }
+        return pieces.result();
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * @brief printf_named(mapping): render a named printf template.
+ *
+ * The values are looked up in `mapping` by the L names of the
+ * placeholders; a verbatim template passes `mapping` to str % as is.
+ */
+PyObject* LStrFormatTemplate_printf_named(PyObject *self_obj, PyObject *mapping) {
+    FormatTemplate *tmpl = get_template(self_obj, STYLE_PRINTF_NAMED, "printf_named");
+    if (!tmpl) return nullptr;
+    if (tmpl->verbatim()) return render_verbatim(tmpl, mapping);
+    try {
+        PieceList pieces(tmpl->result_type());
+        for (const FormatSegment &seg : tmpl->segments()) {
+            if (seg.kind == FormatSegment::LITERAL) {
+                pieces.add_literal(seg.piece.get());
+                continue;
+            }
+            cppy::ptr value(PyObject_GetItem(mapping, seg.key.get()));
+            if (!value) return nullptr;
+            cppy::ptr args(PyDict_New());
+            if (!args) return nullptr;
+            if (PyDict_SetItem(args.get(), seg.key_str.get(), value.get()) < 0) return nullptr;
+            if (!pieces.add_formatted(PyUnicode_Format(seg.spec.get(), args.get()))) return nullptr;
+        }
+        return pieces.result();
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * @brief format(args, kwargs): render a str.format template.
+ *
+ * Without positional arguments every field is formatted with
+ * `field.format_map(kwargs)`; otherwise with `field.format(*args,
+ * **kwargs)`, an auto-numbered field getting the arguments from its own.
+ */
+PyObject* LStrFormatTemplate_format(PyObject *self_obj, PyObject *const *argv, Py_ssize_t argc) {
+    FormatTemplate *tmpl = get_template(self_obj, STYLE_FORMAT, "format");
+    if (!tmpl) return nullptr;
+    if (argc != 2) {
+        PyErr_SetString(PyExc_TypeError, "format() takes exactly 2 arguments (args, kwargs)");
+        return nullptr;
+    }
+    PyObject *args = argv[0];
+    PyObject *kwargs = argv[1];
+    if (!PyTuple_Check(args)) {
+        PyErr_SetString(PyExc_TypeError, "format() args must be a tuple");
+        return nullptr;
+    }
+
+    bool use_map = PyTuple_GET_SIZE(args) == 0;
+    cppy::ptr kw_dict;
+    if (!use_map) {
+        if (PyDict_Check(kwargs)) {
+            kw_dict = cppy::ptr(kwargs, true);
+        } else {
+            kw_dict = cppy::ptr(PyDict_New());
+            if (!kw_dict || PyDict_Merge(kw_dict.get(), kwargs, 1) < 0) return nullptr;
+        }
+    }
+    cppy::ptr format_name(PyUnicode_InternFromString("format"));
+    cppy::ptr format_map_name(PyUnicode_InternFromString("format_map"));
+    if (!format_name || !format_map_name) return nullptr;
+
+    auto do_format = [&](PyObject *spec, PyObject *args_slice) -> PyObject* {
+        if (use_map) {
+            return PyObject_CallMethodOneArg(spec, format_map_name.get(), kwargs);
+        }
+        cppy::ptr method(PyObject_GetAttr(spec, format_name.get()));
+        if (!method) return nullptr;
+        return PyObject_Call(method.get(), args_slice, kw_dict.get());
+    };
+
+    try {
+        PieceList pieces(tmpl->result_type());
+        Py_ssize_t auto_arg_index = 0;
+        bool has_auto = false;
+        bool has_numbered = false;
+        for (const FormatSegment &seg : tmpl->segments()) {
+            PyObject *formatted;
+            switch (seg.kind) {
+                case FormatSegment::LITERAL:
+                    pieces.add_literal(seg.piece.get());
+                    continue;
+                case FormatSegment::FIELD_AUTO: {
+                    has_auto = true;
+                    if (has_numbered) {
+                        PyErr_SetString(PyExc_ValueError, "cannot mix auto and manual numbering");
+                        return nullptr;
+                    }
+                    cppy::ptr rest(PyTuple_GetSlice(args, auto_arg_index, PY_SSIZE_T_MAX));
+                    if (!rest) return nullptr;
+                    formatted = do_format(seg.spec.get(), rest.get());
+                    auto_arg_index++;
+                    break;
+                }
+                case FormatSegment::FIELD_NUMBERED:
+                    has_numbered = true;
+                    if (has_auto) {
+                        PyErr_SetString(PyExc_ValueError, "cannot mix auto and manual numbering");
+                        return nullptr;
+                    }
+                    formatted = do_format(seg.spec.get(), args);
+                    break;
+                default:
+                    formatted = do_format(seg.spec.get(), args);
+                    break;
+            }
+            if (!pieces.add_formatted(formatted)) return nullptr;
+        }
+        return pieces.result();
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * @brief fields(): the (expression, format) str pairs of the placeholders
+ *        of an f-string template, in order.
+ */
+PyObject* LStrFormatTemplate_fields(PyObject *self_obj, PyObject *Py_UNUSED(ignored)) {
+    FormatTemplate *tmpl = get_template(self_obj, STYLE_FFORMAT, "fields");
+    if (!tmpl) return nullptr;
+    cppy::ptr result(PyList_New(0));
+    if (!result) return nullptr;
+    for (const FormatSegment &seg : tmpl->segments()) {
+        if (seg.kind != FormatSegment::EXPRESSION) continue;
+        cppy::ptr pair(PyTuple_Pack(2, seg.key.get(), seg.spec.get()));
+        if (!pair || PyList_Append(result.get(), pair.get()) < 0) return nullptr;
+    }
+    return PyList_AsTuple(result.get());
+}
+
+/**
+ * @brief fill(values): render an f-string template with the formatted str
+ *        values of its fields(), in order.
+ */
+PyObject* LStrFormatTemplate_fill(PyObject *self_obj, PyObject *values) {
+    FormatTemplate *tmpl = get_template(self_obj, STYLE_FFORMAT, "fill");
+    if (!tmpl) return nullptr;
+    cppy::ptr seq(PySequence_Fast(values, "fill() argument must be a sequence"));
+    if (!seq) return nullptr;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq.get());
+    PyObject **items = PySequence_Fast_ITEMS(seq.get());
+    try {
+        PieceList pieces(tmpl->result_type());
+        Py_ssize_t i = 0;
+        for (const FormatSegment &seg : tmpl->segments()) {
+            if (seg.kind == FormatSegment::LITERAL) {
+                pieces.add_literal(seg.piece.get());
+                continue;
+            }
+            if (i >= n) {
+                PyErr_SetString(PyExc_ValueError, "fill() got fewer values than fields");
+                return nullptr;
+            }
+            if (!pieces.add_formatted(cppy::incref(items[i++]))) return nullptr;
+        }
+        if (i != n) {
+            PyErr_SetString(PyExc_ValueError, "fill() got more values than fields");
+            return nullptr;
+        }
+        return pieces.result();
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+PyMethodDef LStrFormatTemplate_methods[] = {
+    {"printf", (PyCFunction)LStrFormatTemplate_printf, METH_O, "Render a positional printf template: printf(values_tuple)"},
+    {"printf_named", (PyCFunction)LStrFormatTemplate_printf_named, METH_O, "Render a named printf template: printf_named(mapping)"},
+    {"format", (PyCFunction)(void(*)(void))LStrFormatTemplate_format, METH_FASTCALL, "Render a str.format template: format(args, kwargs)"},
+    {"fields", (PyCFunction)LStrFormatTemplate_fields, METH_NOARGS, "Return the (expression, format) pairs of an f-string template"},
+    {"fill", (PyCFunction)LStrFormatTemplate_fill, METH_O, "Render an f-string template with formatted field values"},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+PyObject* LStrFormatTemplate_get_verbatim(PyObject *self_obj, void *Py_UNUSED(closure)) {
+    FormatTemplate *tmpl = ((LStrFormatTemplateObject*)self_obj)->tmpl;
+    return PyBool_FromLong(tmpl && tmpl->verbatim());
+}
+
+PyGetSetDef LStrFormatTemplate_getset[] = {
+    {"verbatim", LStrFormatTemplate_get_verbatim, nullptr,
+     "True if a printf spec cannot be parsed: rendering applies str % to the whole format", nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}
+};
+
+PyType_Slot LStrFormatTemplate_slots[] = {
+    {Py_tp_dealloc, (void*)LStrFormatTemplate_dealloc},
+    {Py_tp_methods, (void*)LStrFormatTemplate_methods},
+    {Py_tp_getset, (void*)LStrFormatTemplate_getset},
+    {Py_tp_doc, (void*)"Compiled format L: literal slices and placeholders."},
+    {0, nullptr}
+};
+
+PyType_Spec LStrFormatTemplate_spec = {
+    "_lstring._format_template",
+    sizeof(LStrFormatTemplateObject),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    LStrFormatTemplate_slots
+};
+
+} // namespace
+
+/**
+ * @brief _parse_printf_positional(self, start_pos)
+ *
+ * Parse a positional printf-style placeholder starting at start_pos.
+ * Returns a tuple: (end_pos, is_escape, star_count) where:
+ *   - end_pos: Position after the placeholder (-1 if invalid)
+ *   - is_escape: True if this is %% escape sequence
+ *   - star_count: Number of * wildcards in width/precision
+ */
+PyObject* LStr_parse_printf_positional(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"start_pos", nullptr};
+    Py_ssize_t start_pos;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n:parse_printf_positional", kwlist, &start_pos)) {
+        return nullptr;
+    }
+    const Buffer *buf = parse_start(self, start_pos, '%', '%', "start_pos must point to %");
+    if (!buf) return nullptr;
+
+    PrintfToken tok = scan_printf_positional(buf, start_pos, buf->length());
+    return Py_BuildValue("(nOi)", tok.end, tok.escape ? Py_True : Py_False, tok.star_count);
+}
+
+/**
+ * @brief _parse_printf_named(self, start_pos)
+ *
+ * Parse a named printf-style placeholder starting at start_pos.
+ * Returns a tuple: (end_pos, is_escape, name_end) where:
+ *   - end_pos: Position after the placeholder (-1 if invalid)
+ *   - is_escape: True if this is %% escape sequence
+ *   - name_end: Position after the closing ) of the name (-1 if not named)
+ */
+PyObject* LStr_parse_printf_named(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"start_pos", nullptr};
+    Py_ssize_t start_pos;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n:parse_printf_named", kwlist, &start_pos)) {
+        return nullptr;
+    }
+    const Buffer *buf = parse_start(self, start_pos, '%', '%', "start_pos must point to %");
+    if (!buf) return nullptr;
+
+    PrintfToken tok = scan_printf_named(buf, start_pos, buf->length());
+    return Py_BuildValue("(nOn)", tok.end, tok.escape ? Py_True : Py_False, tok.name_end);
+}
+
+/**
+ * @brief _parse_format_placeholder(self, start_pos)
+ *
+ * Parse a format() style placeholder or escape sequence starting at start_pos.
+ * start_pos must point to { or } character.
+ *
+ * Returns a tuple: (end_pos, token_type, content_end) where:
+ *   - end_pos: Position after the token (-1 if invalid/unmatched)
+ *   - token_type: 0=invalid, 1=literal_open ({{), 2=literal_close (}}), 3=placeholder
+ *   - content_end: For placeholder - position before closing }, otherwise -1
+ */
+PyObject* LStr_parse_format_placeholder(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"start_pos", nullptr};
+    Py_ssize_t start_pos;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n:_parse_format_placeholder", kwlist, &start_pos)) {
+        return nullptr;
+    }
+    const Buffer *buf = parse_start(self, start_pos, '{', '}', "start_pos must point to { or }");
+    if (!buf) return nullptr;
+
+    BraceToken tok = scan_format_placeholder(buf, start_pos, buf->length());
+    return Py_BuildValue("(nin)", tok.end, tok.type, tok.content_end);
+}
+
+/**
+ * @brief _parse_fformat_placeholder(self, start_pos)
+ *
+ * Parse an f-string style placeholder or escape sequence starting at start_pos.
+ * start_pos must point to { or } character.
+ *
+ * Returns a tuple: (end_pos, token_type, content_end, expr_end) where:
+ *   - end_pos: Position after the token (-1 if invalid/unmatched)
+ *   - token_type: 0=invalid, 1=literal {{ (open), 2=literal }} (close), 3=placeholder
+ *   - content_end: For placeholder - position before closing }, otherwise -1
+ *   - expr_end: For placeholder - position where expression ends (before : ! or }), otherwise -1
+ */
+PyObject* LStr_parse_fformat_placeholder(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"start_pos", nullptr};
+    Py_ssize_t start_pos;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n:_parse_fformat_placeholder", kwlist, &start_pos)) {
+        return nullptr;
+    }
+    const Buffer *buf = parse_start(self, start_pos, '{', '}', "start_pos must point to { or }");
+    if (!buf) return nullptr;
+
+    BraceToken tok = scan_fformat_placeholder(buf, start_pos, buf->length());
+    return Py_BuildValue("(ninn)", tok.end, tok.type, tok.content_end, tok.expr_end);
+}
+
+/**
+ * @brief _format_template(self, style)
+ *
+ * Compile self into a format template; `style` is 'printf', 'printf_named',
+ * 'format' or 'fformat'. Used by lstring/format.py, which caches the
+ * templates by format string.
+ */
+PyObject* LStr_format_template(LStrObject *self, PyObject *style_obj) {
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return nullptr;
+    }
+    const char *style_name = PyUnicode_Check(style_obj) ? PyUnicode_AsUTF8(style_obj) : nullptr;
+    if (!style_name) {
+        if (!PyErr_Occurred()) PyErr_SetString(PyExc_TypeError, "_format_template() style must be str");
+        return nullptr;
+    }
+    FormatStyle style;
+    if (strcmp(style_name, "printf") == 0) {
+        style = STYLE_PRINTF;
+    } else if (strcmp(style_name, "printf_named") == 0) {
+        style = STYLE_PRINTF_NAMED;
+    } else if (strcmp(style_name, "format") == 0) {
+        style = STYLE_FORMAT;
+    } else if (strcmp(style_name, "fformat") == 0) {
+        style = STYLE_FFORMAT;
+    } else {
+        PyErr_Format(PyExc_ValueError, "unknown format template style '%s'", style_name);
+        return nullptr;
+    }
+
+    PyTypeObject *lstr_type = get_base_l_type(Py_TYPE(self));
+
+    // Try to get cached template type from the L type object
+    tptr<PyTypeObject> tmpl_type(PyObject_GetAttrString((PyObject*)lstr_type, "_format_template_type"));
+    if (!tmpl_type) {
+        PyErr_Clear();
+
+        tmpl_type = tptr<PyTypeObject>(PyType_FromSpec(&LStrFormatTemplate_spec));
+        if (!tmpl_type) return nullptr;
+
+        // Cache template type on the L heap type object for reuse.
+        if (PyObject_SetAttrString((PyObject*)lstr_type, "_format_template_type", tmpl_type.ptr().get()) < 0) {
+            return nullptr;
+        }
+    }
+
+    tptr<LStrFormatTemplateObject> result(PyObject_CallObject(tmpl_type.ptr().get(), nullptr));
+    if (!result) return nullptr;
+    try {
+        result->tmpl = new FormatTemplate(self, style);
+        if (!result->tmpl->compile()) return nullptr;
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    return result.ptr().release();
+}
@@ -6,23 +6,33 @@
 #include <Python.h>
 #include <cstring>
 #include "lstring_utils.hxx"
+#include "lstring_stats.hxx"
 #include "lstring/lstring.hxx"
 #include "charset.hxx"
 #include "str_buffer.hxx"
+#include "slice_buffer.hxx"
+#include "map_buffer.hxx"
+#include "mmap_buffer.hxx"
+#include "utf8_buffer.hxx"
+#include "buffer_cursor.hxx"
+#include "span.hxx"
+#include "substring_index.hxx"
+#include "substring_search.hxx"
+#include "lstring_pattern.hxx"
 #include "tptr.hxx"
+#include "_lstring.hxx"
 
-static PyTypeObject* get_base_l_type(PyTypeObject *type_self) {
-    PyTypeObject *base_type = type_self;
-    while (base_type->tp_base != nullptr &&
-           strcmp(base_type->tp_name, "_lstring.L") != 0) {
-        base_type = base_type->tp_base;
-    }
-    return base_type;
-}
-
-static int get_charset_source(LStrObject *self, PyObject *charset_obj, cppy::ptr &out_unicode, Buffer* &out_buffer) {
+static int get_charset_source(LStrObject *self, PyObject *charset_obj, cppy::ptr &out_unicode, Buffer* &out_buffer,
+                              LStrPatternObject* &out_pattern) {
     out_unicode = cppy::ptr();
     out_buffer = nullptr;
+    out_pattern = nullptr;
+
+    // A compiled Pattern keeps its charset between calls.
+    if (LStrPattern_Check(charset_obj)) {
+        out_pattern = (LStrPatternObject*)charset_obj;
+        return 0;
+    }
 
     if (PyUnicode_Check(charset_obj)) {
         out_unicode = cppy::ptr(charset_obj, /*incref=*/true);
@@ -50,23 +60,57 @@ static int get_charset_source(LStrObject *self, PyObject *charset_obj, cppy::ptr
         return 0;
     }
 
-    PyErr_SetString(PyExc_TypeError, "charset must be str or L instance");
+    PyErr_SetString(PyExc_TypeError, "charset must be str, L or Pattern instance");
     return -1;
 }
 static PyObject* LStr_find(LStrObject *self, PyObject *args, PyObject *kwds);
 static PyObject* LStr_rfind(LStrObject *self, PyObject *args, PyObject *kwds);
+static PyObject* LStr_count(LStrObject *self, PyObject *args, PyObject *kwds);
+static PyObject* LStr_build_index(LStrObject *self, PyObject *Py_UNUSED(ignored));
+static PyObject* LStr_startswith(LStrObject *self, PyObject *args);
+static PyObject* LStr_endswith(LStrObject *self, PyObject *args);
+static PyObject* LStr_removeprefix(LStrObject *self, PyObject *prefix);
+static PyObject* LStr_removesuffix(LStrObject *self, PyObject *suffix);
+static PyObject* LStr_partition(LStrObject *self, PyObject *sep);
+static PyObject* LStr_rpartition(LStrObject *self, PyObject *sep);
+static PyObject* LStr_find_iter(LStrObject *self, PyObject *args, PyObject *kwds);
+static PyObject* LStr_rfind_iter(LStrObject *self, PyObject *args, PyObject *kwds);
+static PyObject* LStr_replace(LStrObject *self, PyObject *args, PyObject *kwds);
+static PyObject* LStr_join(LStrObject *self, PyObject *iterable);
+static PyObject* LStr_compact(LStrObject *self, PyObject *args, PyObject *kwds);
+static PyObject* LStr_from_buffer(PyObject *cls, PyObject *args, PyObject *kwds);
+static PyObject* LStr_lower(LStrObject *self, PyObject *Py_UNUSED(ignored));
+static PyObject* LStr_upper(LStrObject *self, PyObject *Py_UNUSED(ignored));
+static PyObject* LStr_casefold(LStrObject *self, PyObject *Py_UNUSED(ignored));
+static PyObject* LStr_swapcase(LStrObject *self, PyObject *Py_UNUSED(ignored));
+static PyObject* LStr_translate(LStrObject *self, PyObject *table);
 static PyObject* LStr_findc(LStrObject *self, PyObject *args, PyObject *kwds);
 static PyObject* LStr_rfindc(LStrObject *self, PyObject *args, PyObject *kwds);
+
+// Defined in src/lstring_split.cxx.
+PyObject* LStr_split(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_split_iter(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_rsplit(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_rsplit_iter(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_splitlines(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_splitlines_iter(LStrObject *self, PyObject *args, PyObject *kwds);
 static PyObject* LStr_findcs(LStrObject *self, PyObject *args, PyObject *kwds);
 static PyObject* LStr_rfindcs(LStrObject *self, PyObject *args, PyObject *kwds);
 static PyObject* LStr_findcr(LStrObject *self, PyObject *args, PyObject *kwds);
 static PyObject* LStr_rfindcr(LStrObject *self, PyObject *args, PyObject *kwds);
 static PyObject* LStr_findcc(LStrObject *self, PyObject *args, PyObject *kwds);
 static PyObject* LStr_rfindcc(LStrObject *self, PyObject *args, PyObject *kwds);
-static PyObject* LStr_parse_printf_positional(LStrObject *self, PyObject *args, PyObject *kwds);
-static PyObject* LStr_parse_printf_named(LStrObject *self, PyObject *args, PyObject *kwds);
-static PyObject* LStr_parse_format_placeholder(LStrObject *self, PyObject *args, PyObject *kwds);
-static PyObject* LStr_parse_fformat_placeholder(LStrObject *self, PyObject *args, PyObject *kwds);
+// Defined in src/lstring_format.cxx.
+PyObject* LStr_parse_printf_positional(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_parse_printf_named(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_parse_format_placeholder(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_parse_fformat_placeholder(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_format_template(LStrObject *self, PyObject *style);
+// Defined in src/lstring_encode.cxx.
+PyObject* LStr_encode(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_encode_into(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_utf8_length(LStrObject *self, PyObject *args, PyObject *kwds);
+PyObject* LStr_iter_chunks(LStrObject *self, PyObject *args, PyObject *kwds);
 
 // Character classification methods
 static PyObject* LStr_isspace(LStrObject *self, PyObject *Py_UNUSED(ignored));
@@ -89,6 +133,30 @@ static PyObject* LStr_istitle(LStrObject *self, PyObject *Py_UNUSED(ignored));
 PyMethodDef LStr_methods[] = {
     {"find", (PyCFunction)LStr_find, METH_VARARGS | METH_KEYWORDS, "Find substring like str.find(sub, start=None, end=None)"},
     {"rfind", (PyCFunction)LStr_rfind, METH_VARARGS | METH_KEYWORDS, "Find last occurrence like str.rfind(sub, start=None, end=None)"},
+    {"count", (PyCFunction)LStr_count, METH_VARARGS | METH_KEYWORDS, "Count non-overlapping occurrences like str.count(sub, start=None, end=None)"},
+    {"build_index", (PyCFunction)LStr_build_index, METH_NOARGS, "Attach a substring index that speeds up later find, rfind, count and in"},
+    {"startswith", (PyCFunction)LStr_startswith, METH_VARARGS, "Check a prefix like str.startswith(prefix, start=None, end=None); prefix may be a tuple"},
+    {"endswith", (PyCFunction)LStr_endswith, METH_VARARGS, "Check a suffix like str.endswith(suffix, start=None, end=None); suffix may be a tuple"},
+    {"removeprefix", (PyCFunction)LStr_removeprefix, METH_O, "Return a slice without the given prefix, or self if it does not start with it"},
+    {"removesuffix", (PyCFunction)LStr_removesuffix, METH_O, "Return a slice without the given suffix, or self if it does not end with it"},
+    {"partition", (PyCFunction)LStr_partition, METH_O, "Split at the first occurrence of sep like str.partition(sep) -> (before, sep, after)"},
+    {"rpartition", (PyCFunction)LStr_rpartition, METH_O, "Split at the last occurrence of sep like str.rpartition(sep) -> (before, sep, after)"},
+    {"find_iter", (PyCFunction)LStr_find_iter, METH_VARARGS | METH_KEYWORDS, "Iterate non-overlapping match positions: find_iter(sub, start=None, end=None)"},
+    {"rfind_iter", (PyCFunction)LStr_rfind_iter, METH_VARARGS | METH_KEYWORDS, "Iterate non-overlapping match positions from right: rfind_iter(sub, start=None, end=None)"},
+    {"split", (PyCFunction)LStr_split, METH_VARARGS | METH_KEYWORDS, "Split like str.split(sep=None, maxsplit=-1); sep may be str, L or Pattern"},
+    {"split_iter", (PyCFunction)LStr_split_iter, METH_VARARGS | METH_KEYWORDS, "Iterate the pieces of split(sep=None, maxsplit=-1)"},
+    {"rsplit", (PyCFunction)LStr_rsplit, METH_VARARGS | METH_KEYWORDS, "Split from the right like str.rsplit(sep=None, maxsplit=-1)"},
+    {"rsplit_iter", (PyCFunction)LStr_rsplit_iter, METH_VARARGS | METH_KEYWORDS, "Iterate the pieces of rsplit(sep=None, maxsplit=-1) from right to left"},
+    {"splitlines", (PyCFunction)LStr_splitlines, METH_VARARGS | METH_KEYWORDS, "Split at line boundaries like str.splitlines(keepends=False)"},
+    {"splitlines_iter", (PyCFunction)LStr_splitlines_iter, METH_VARARGS | METH_KEYWORDS, "Iterate the lines of splitlines(keepends=False)"},
+    {"join", (PyCFunction)LStr_join, METH_O, "Join str or L items with self as separator, like str.join(iterable)"},
+    {"compact", (PyCFunction)LStr_compact, METH_VARARGS | METH_KEYWORDS, "Merge runs of short leaves into chunks: compact(min_leaf=256, max_leaf=4096)"},
+    {"replace", (PyCFunction)LStr_replace, METH_VARARGS | METH_KEYWORDS, "Replace non-overlapping occurrences: replace(old, new, count=-1)"},
+    {"lower", (PyCFunction)LStr_lower, METH_NOARGS, "Return a copy with all cased characters converted to lowercase"},
+    {"upper", (PyCFunction)LStr_upper, METH_NOARGS, "Return a copy with all cased characters converted to uppercase"},
+    {"casefold", (PyCFunction)LStr_casefold, METH_NOARGS, "Return a casefolded copy suitable for caseless comparisons"},
+    {"swapcase", (PyCFunction)LStr_swapcase, METH_NOARGS, "Return a copy with uppercase characters converted to lowercase and vice versa"},
+    {"translate", (PyCFunction)LStr_translate, METH_O, "Return a copy with each character mapped through the given translation table"},
     {"findc", (PyCFunction)LStr_findc, METH_VARARGS | METH_KEYWORDS, "Find single code point: findc(ch, start=None, end=None)"},
     {"rfindc", (PyCFunction)LStr_rfindc, METH_VARARGS | METH_KEYWORDS, "Find single code point from right: rfindc(ch, start=None, end=None)"},
     {"findcs", (PyCFunction)LStr_findcs, METH_VARARGS | METH_KEYWORDS, "Find any character from set: findcs(charset, start=None, end=None, invert=False)"},
@@ -101,6 +169,12 @@ PyMethodDef LStr_methods[] = {
     {"_parse_printf_named", (PyCFunction)LStr_parse_printf_named, METH_VARARGS | METH_KEYWORDS, "Parse named printf placeholder: _parse_printf_named(start_pos) -> (end_pos, is_escape, name_end)"},
     {"_parse_format_placeholder", (PyCFunction)LStr_parse_format_placeholder, METH_VARARGS | METH_KEYWORDS, "Parse format placeholder: _parse_format_placeholder(start_pos) -> (end_pos, token_type, content_end)"},
     {"_parse_fformat_placeholder", (PyCFunction)LStr_parse_fformat_placeholder, METH_VARARGS | METH_KEYWORDS, "Parse f-string placeholder: _parse_fformat_placeholder(start_pos) -> (end_pos, token_type, content_end, expr_end)"},
+    {"_format_template", (PyCFunction)LStr_format_template, METH_O, "Compile a format template: _format_template(style) with style 'printf', 'printf_named', 'format' or 'fformat'"},
+    {"encode", (PyCFunction)LStr_encode, METH_VARARGS | METH_KEYWORDS, "Encode to bytes: encode(encoding='utf-8', errors='strict'); UTF-8 is written from the leaves directly"},
+    {"encode_into", (PyCFunction)LStr_encode_into, METH_VARARGS | METH_KEYWORDS, "Write UTF-8 into a writable buffer: encode_into(buffer, offset=0, errors='strict') -> bytes written"},
+    {"utf8_length", (PyCFunction)LStr_utf8_length, METH_VARARGS | METH_KEYWORDS, "Length of the UTF-8 encoding: utf8_length(errors='strict')"},
+    {"iter_chunks", (PyCFunction)LStr_iter_chunks, METH_VARARGS | METH_KEYWORDS, "Iterate UTF-8 bytes chunks following the leaves: iter_chunks(chunk_size=65536, errors='strict')"},
+    {"from_buffer", (PyCFunction)LStr_from_buffer, METH_CLASS | METH_VARARGS | METH_KEYWORDS, "L over the memory of a buffer-protocol object, without copying: from_buffer(obj, width=1, encoding=None)"},
     {"isspace", (PyCFunction)LStr_isspace, METH_NOARGS, "Return True if all characters are whitespace, False otherwise"},
     {"isalpha", (PyCFunction)LStr_isalpha, METH_NOARGS, "Return True if all characters are alphabetic, False otherwise"},
     {"isdigit", (PyCFunction)LStr_isdigit, METH_NOARGS, "Return True if all characters are digits, False otherwise"},
@@ -115,6 +189,174 @@ PyMethodDef LStr_methods[] = {
 };
 
 
+/**
+ * @brief Parse optional start/end arguments (int or None) against self.
+ *
+ * Negative values are offsets from the end (slice semantics); both are
+ * clamped to [0, len], except that a start beyond the end is kept so that
+ * callers can apply their not-found rule.
+ *
+ * @return 0 on success, -1 with a Python exception set on failure.
+ */
+static int parse_range(LStrObject *self, PyObject *start_obj, PyObject *end_obj,
+                       Py_ssize_t &start, Py_ssize_t &end) {
+    Py_ssize_t src_len = (Py_ssize_t)self->buffer->length();
+    // Parse start
+    if (start_obj == Py_None) {
+        start = 0;
+    } else {
+        if (!PyLong_Check(start_obj)) {
+            PyErr_SetString(PyExc_TypeError, "start must be int or None");
+            return -1;
+        }
+        start = PyLong_AsSsize_t(start_obj);
+        if (start == -1 && PyErr_Occurred()) return -1;
+        if (start < 0) start += src_len;
+    }
+
+    // Parse end
+    if (end_obj == Py_None) {
+        end = src_len;
+    } else {
+        if (!PyLong_Check(end_obj)) {
+            PyErr_SetString(PyExc_TypeError, "end must be int or None");
+            return -1;
+        }
+        end = PyLong_AsSsize_t(end_obj);
+        if (end == -1 && PyErr_Occurred()) return -1;
+        if (end < 0) end += src_len;
+    }
+
+    // Clamp start/end per Python semantics
+    if (start < 0) start = 0;
+    if (end < 0) end = 0;
+    if (end > src_len) end = src_len;
+    return 0;
+}
+
+/**
+ * @brief Parse the (sub, start, end) arguments shared by find-like methods.
+ *
+ * Accepts `sub` as a Python str, another L or a compiled Pattern and stores
+ * an owned reference to the needle L in `sub_owner`; `pattern` is set to
+ * the (borrowed) Pattern or nullptr. Negative start/end are interpreted as offsets
+ * from the end (slice semantics); both are clamped to [0, len], except that
+ * a start beyond the end is reported as `start > len` so callers can apply
+ * their not-found rule.
+ *
+ * @return 0 on success, -1 with a Python exception set on failure.
+ */
+static int parse_sub_range(LStrObject *self, PyObject *sub_obj,
+                           PyObject *start_obj, PyObject *end_obj,
+                           tptr<LStrObject> &sub_owner, LStrPatternObject* &pattern,
+                           Py_ssize_t &start, Py_ssize_t &end) {
+    // Validate source buffer
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return -1;
+    }
+
+    // Obtain a Buffer for sub: accept Python str, L or Pattern
+    pattern = nullptr;
+    if (LStrPattern_Check(sub_obj)) {
+        pattern = (LStrPatternObject*)sub_obj;
+        sub_owner = tptr<LStrObject>(pattern->needle, true);
+    } else if (PyUnicode_Check(sub_obj)) {
+        // wrap Python str into a temporary `L` via factory and own it
+        PyTypeObject *type = Py_TYPE(self);
+        sub_owner = tptr<LStrObject>(make_lstr_from_pystr(type, sub_obj));
+        if (!sub_owner) return -1;
+    } else if (PyObject_IsInstance(sub_obj, (PyObject*)get_base_l_type(Py_TYPE(self))) == 1) {
+        LStrObject *lsub = (LStrObject*)sub_obj;
+        if (!lsub->buffer) {
+            PyErr_SetString(PyExc_RuntimeError, "substring L has no buffer");
+            return -1;
+        }
+        sub_owner = tptr<LStrObject>(sub_obj, true);
+    } else {
+        PyErr_SetString(PyExc_TypeError, "sub must be str, L or Pattern");
+        return -1;
+    }
+
+    return parse_range(self, start_obj, end_obj, start, end);
+}
+
+/**
+ * @brief Search [start, end) of src through a substring index, if src
+ *        (or the buffer it is a step-1 slice of) has one that helps.
+ *
+ * Answers find (reverse == false), rfind (reverse == true) or, with
+ * `count`, the number of non-overlapping occurrences.
+ *
+ * @return false if the search must scan instead.
+ */
+static bool indexed_search(const Buffer *src, const Buffer *sub, Py_ssize_t start, Py_ssize_t end,
+                           bool reverse, bool count, Py_ssize_t &result) {
+    Py_ssize_t sub_len = sub->length();
+    if (sub_len < SubstringIndex::GRAM) return false;
+    const Buffer *target;
+    Py_ssize_t offset;
+    const SubstringIndex *index = SubstringIndex::resolve(src, target, offset);
+    if (!index) return false;
+    std::vector<uint32_t> needle((size_t)sub_len);
+    sub->copy(needle.data(), 0, sub_len);
+    if (count) return index->count(*target, needle, start + offset, end + offset, result);
+    if (!index->find(*target, needle, start + offset, end + offset, reverse, result)) return false;
+    if (result >= 0) result -= offset;
+    return true;
+}
+
+/**
+ * @brief First (or, if reverse, last) position of a non-empty sub within
+ *        [start, end) of self, or -1.
+ *
+ * Tries the substring index, then CPython's search when both sides are
+ * plain str leaves or have a cached str, then the substring search engine (the compiled one
+ * of `pattern` if given) with the GIL released for long ranges.
+ *
+ * @return 0 on success, -1 with a Python exception set on failure.
+ */
+static int search_sub(LStrObject *self, LStrObject *sub, LStrPatternObject *pattern,
+                      Py_ssize_t start, Py_ssize_t end, bool reverse, Py_ssize_t &result) {
+    Buffer *src = self->buffer;
+    try {
+        if (indexed_search(src, sub->buffer, start, end, reverse, false, result)) {
+            stats_add(LStr_stats.find_indexed);
+            return 0;
+        }
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return -1;
+    }
+
+    // Fast-path: if both source and substring are string-backed buffers
+    // (or have their str cached), delegate to the built-in Python unicode
+    // find implementation which is optimized in C and understands Python
+    // slice semantics.
+    cppy::ptr src_py(buffer_str_view(src));
+    cppy::ptr sub_py(src_py ? buffer_str_view(sub->buffer) : nullptr);
+    if (src_py && sub_py) {
+        stats_add(LStr_stats.find_str);
+        result = PyUnicode_Find(src_py.get(), sub_py.get(), start, end, reverse ? -1 : 1);
+        return (result == -2 || (result == -1 && PyErr_Occurred())) ? -1 : 0;
+    }
+
+    stats_add(LStr_stats.find_scan);
+    try {
+        if (pattern) {
+            const SubstringSearch *search = reverse ? pattern->reverse : pattern->forward;
+            result = scan_without_gil(end - start, [&] { return search->find(src, start, end); });
+        } else {
+            SubstringSearch search(sub->buffer, reverse);
+            result = scan_without_gil(end - start, [&] { return search.find(src, start, end); });
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return -1;
+    }
+}
+
 /**
  * @brief Find method: search for a substring in the L.
  *
@@ -129,262 +371,1043 @@ static PyObject* LStr_find(LStrObject *self, PyObject *args, PyObject *kwds) {
     PyObject *start_obj = Py_None;
     PyObject *end_obj = Py_None;
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|OO:find", kwlist,
-                                     &sub_obj, &start_obj, &end_obj)) {
-        return nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|OO:find", kwlist,
+                                     &sub_obj, &start_obj, &end_obj)) {
+        return nullptr;
+    }
+
+    tptr<LStrObject> sub_owner;
+    LStrPatternObject *pattern;
+    Py_ssize_t start, end;
+    if (parse_sub_range(self, sub_obj, start_obj, end_obj, sub_owner, pattern, start, end) < 0) {
+        return nullptr;
+    }
+    Py_ssize_t src_len = (Py_ssize_t)self->buffer->length();
+    Py_ssize_t sub_len = (Py_ssize_t)sub_owner->buffer->length();
+
+    if (start > src_len || end < start) {
+        // start beyond end -> not found, even for the empty substring
+        return PyLong_FromLong(-1);
+    }
+
+    // Empty substring is found at start if start<=len, but if start==len
+    // it's allowed (empty at end). If start > len we already returned -1.
+    if (sub_len == 0) {
+        return PyLong_FromSsize_t(start);
+    }
+
+    // If the remaining region is shorter than sub, not found
+    if (end - start < sub_len) {
+        return PyLong_FromLong(-1);
+    }
+
+    Py_ssize_t found;
+    if (search_sub(self, sub_owner.get(), pattern, start, end, false, found) < 0) return nullptr;
+    return PyLong_FromSsize_t(found);
+}
+
+
+/**
+ * @brief rfind(self, sub, start=None, end=None)
+ *
+ * Mirrors semantics of str.rfind: returns highest index where sub is
+ * found in the slice [start:end], or -1 if not found.
+ */
+static PyObject* LStr_rfind(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"sub", (char*)"start", (char*)"end", nullptr};
+    PyObject *sub_obj = nullptr;
+    PyObject *start_obj = Py_None;
+    PyObject *end_obj = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|OO:rfind", kwlist,
+                                     &sub_obj, &start_obj, &end_obj)) {
+        return nullptr;
+    }
+
+    tptr<LStrObject> sub_owner;
+    LStrPatternObject *pattern;
+    Py_ssize_t start, end;
+    if (parse_sub_range(self, sub_obj, start_obj, end_obj, sub_owner, pattern, start, end) < 0) {
+        return nullptr;
+    }
+    Py_ssize_t src_len = (Py_ssize_t)self->buffer->length();
+    Py_ssize_t sub_len = (Py_ssize_t)sub_owner->buffer->length();
+
+    if (start > src_len || end < start) {
+        // start beyond end -> not found, even for the empty substring
+        return PyLong_FromLong(-1);
+    }
+
+    // Empty substring behavior: return end if sub_len == 0 (rfind rules)
+    if (sub_len == 0) {
+        return PyLong_FromSsize_t(end);
+    }
+
+    // If remaining region is shorter than sub, not found
+    if (end - start < sub_len) {
+        return PyLong_FromLong(-1);
+    }
+
+    Py_ssize_t found;
+    if (search_sub(self, sub_owner.get(), pattern, start, end, true, found) < 0) return nullptr;
+    return PyLong_FromSsize_t(found);
+}
+
+
+/**
+ * @brief count(self, sub, start=None, end=None)
+ *
+ * Mirrors str.count: the number of non-overlapping occurrences of sub in
+ * the slice [start:end], found from the left.
+ */
+static PyObject* LStr_count(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"sub", (char*)"start", (char*)"end", nullptr};
+    PyObject *sub_obj = nullptr;
+    PyObject *start_obj = Py_None;
+    PyObject *end_obj = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|OO:count", kwlist,
+                                     &sub_obj, &start_obj, &end_obj)) {
+        return nullptr;
+    }
+
+    tptr<LStrObject> sub_owner;
+    LStrPatternObject *pattern;
+    Py_ssize_t start, end;
+    if (parse_sub_range(self, sub_obj, start_obj, end_obj, sub_owner, pattern, start, end) < 0) {
+        return nullptr;
+    }
+    Buffer *src = self->buffer;
+    Py_ssize_t src_len = (Py_ssize_t)src->length();
+    Py_ssize_t sub_len = (Py_ssize_t)sub_owner->buffer->length();
+
+    if (start > src_len || end < start) {
+        return PyLong_FromLong(0);
+    }
+    // The empty substring matches at every position, both ends included.
+    if (sub_len == 0) {
+        return PyLong_FromSsize_t(end - start + 1);
+    }
+    if (end - start < sub_len) {
+        return PyLong_FromLong(0);
+    }
+
+    try {
+        Py_ssize_t indexed;
+        if (indexed_search(src, sub_owner->buffer, start, end, false, true, indexed)) {
+            return PyLong_FromSsize_t(indexed);
+        }
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+
+    cppy::ptr src_py(buffer_str_view(src));
+    cppy::ptr sub_py(src_py ? buffer_str_view(sub_owner->buffer) : nullptr);
+    if (src_py && sub_py) {
+        Py_ssize_t n = PyUnicode_Count(src_py.get(), sub_py.get(), start, end);
+        if (n == -1 && PyErr_Occurred()) return nullptr;
+        return PyLong_FromSsize_t(n);
+    }
+
+    try {
+        // One scan reports every non-overlapping match.
+        auto count_with = [&](const SubstringSearch &search) {
+            Py_ssize_t n = 0;
+            search.scan(src, start, end, [&](Py_ssize_t) {
+                ++n;
+                return true;
+            });
+            return n;
+        };
+        if (pattern) {
+            return PyLong_FromSsize_t(scan_without_gil(end - start, [&] { return count_with(*pattern->forward); }));
+        }
+        SubstringSearch search(sub_owner->buffer);
+        return PyLong_FromSsize_t(scan_without_gil(end - start, [&] { return count_with(search); }));
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * @brief sub in self: whether self contains the str or L sub.
+ */
+int LStr_contains(PyObject *self_obj, PyObject *sub_obj) {
+    LStrObject *self = (LStrObject*)self_obj;
+    if (!PyUnicode_Check(sub_obj) &&
+        PyObject_IsInstance(sub_obj, (PyObject*)get_base_l_type(Py_TYPE(self))) != 1) {
+        PyErr_Format(PyExc_TypeError, "'in <L>' requires str or L as left operand, not %.200s",
+                     Py_TYPE(sub_obj)->tp_name);
+        return -1;
+    }
+    if (!self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return -1;
+    }
+    tptr<LStrObject> sub;
+    if (PyUnicode_Check(sub_obj)) {
+        sub = tptr<LStrObject>(make_lstr_from_pystr(Py_TYPE(self), sub_obj));
+        if (!sub) return -1;
+    } else {
+        sub = tptr<LStrObject>(sub_obj, true);
+        if (!sub->buffer) {
+            PyErr_SetString(PyExc_RuntimeError, "substring L has no buffer");
+            return -1;
+        }
+    }
+    Py_ssize_t len = (Py_ssize_t)self->buffer->length();
+    Py_ssize_t sub_len = (Py_ssize_t)sub->buffer->length();
+    if (sub_len == 0) return 1;
+    if (sub_len > len) return 0;
+
+    Py_ssize_t found;
+    if (search_sub(self, sub.get(), nullptr, 0, len, false, found) < 0) return -1;
+    return found >= 0;
+}
+
+/**
+ * @brief Whether [at, at + n) of src holds the n code points of the str
+ *        or L `affix`.
+ *
+ * A str is compared against the spans of src in place, without wrapping it
+ * in an L; an L is compared with compare_ranges(), which skips subtrees
+ * shared by both sides.
+ */
+static bool range_equals(const Buffer *src, Py_ssize_t at, PyObject *affix, Py_ssize_t n) {
+    if (PyUnicode_Check(affix)) {
+        const BufferSpan expected{(int)PyUnicode_KIND(affix), PyUnicode_DATA(affix), n};
+        Py_ssize_t offset = 0;
+        return for_each_span(*src, at, at + n, [&](const BufferSpan& span) {
+            if (compare_spans(span, subspan(expected, offset, span.length), span.length) != 0) return false;
+            offset += span.length;
+            return true;
+        });
+    }
+    return compare_ranges(src, at, ((LStrObject*)affix)->buffer, 0, n) == 0;
+}
+
+/**
+ * @brief Whether `affix` (str or L) is a str or L with a buffer.
+ */
+static bool is_affix(LStrObject *self, PyObject *affix) {
+    if (PyUnicode_Check(affix)) return true;
+    return PyObject_IsInstance(affix, (PyObject*)get_base_l_type(Py_TYPE(self))) == 1 &&
+           ((LStrObject*)affix)->buffer != nullptr;
+}
+
+/**
+ * @brief Length of a str or L accepted by is_affix().
+ */
+static Py_ssize_t affix_length(PyObject *affix) {
+    return PyUnicode_Check(affix) ? PyUnicode_GET_LENGTH(affix)
+                                  : (Py_ssize_t)((LStrObject*)affix)->buffer->length();
+}
+
+/**
+ * @brief Whether [start, end) of self starts (or, if suffix, ends) with
+ *        affix, with the rules of str.startswith / str.endswith.
+ */
+static bool tail_match(LStrObject *self, PyObject *affix, Py_ssize_t start, Py_ssize_t end, bool suffix) {
+    Py_ssize_t n = affix_length(affix);
+    if (end - start < n) return false;
+    if (n == 0) return true;
+    return range_equals(self->buffer, suffix ? end - n : start, affix, n);
+}
+
+/**
+ * @brief Common implementation of startswith (suffix == false) and endswith.
+ */
+static PyObject* tail_match_impl(LStrObject *self, PyObject *args, const char *format,
+                                 const char *name, bool suffix) {
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return nullptr;
+    }
+    PyObject *affix_obj;
+    PyObject *start_obj = Py_None;
+    PyObject *end_obj = Py_None;
+    if (!PyArg_ParseTuple(args, format, &affix_obj, &start_obj, &end_obj)) return nullptr;
+    Py_ssize_t start, end;
+    if (parse_range(self, start_obj, end_obj, start, end) < 0) return nullptr;
+
+    try {
+        if (PyTuple_Check(affix_obj)) {
+            for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(affix_obj); ++i) {
+                PyObject *item = PyTuple_GET_ITEM(affix_obj, i);
+                if (!is_affix(self, item)) {
+                    PyErr_Format(PyExc_TypeError, "tuple for %s must only contain str or L, not %.100s",
+                                 name, Py_TYPE(item)->tp_name);
+                    return nullptr;
+                }
+                if (tail_match(self, item, start, end, suffix)) Py_RETURN_TRUE;
+            }
+            Py_RETURN_FALSE;
+        }
+        if (!is_affix(self, affix_obj)) {
+            PyErr_Format(PyExc_TypeError, "%s first arg must be str, L or a tuple of str or L, not %.100s",
+                         name, Py_TYPE(affix_obj)->tp_name);
+            return nullptr;
+        }
+        return PyBool_FromLong(tail_match(self, affix_obj, start, end, suffix));
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * @brief startswith(self, prefix, start=None, end=None)
+ *
+ * Mirrors str.startswith; `prefix` is a str, an L or a tuple of them.
+ * The prefix is compared against the leaf spans of self in place.
+ */
+static PyObject* LStr_startswith(LStrObject *self, PyObject *args) {
+    return tail_match_impl(self, args, "O|OO:startswith", "startswith", false);
+}
+
+/**
+ * @brief endswith(self, suffix, start=None, end=None)
+ *
+ * Mirrors str.endswith; `suffix` is a str, an L or a tuple of them.
+ */
+static PyObject* LStr_endswith(LStrObject *self, PyObject *args) {
+    return tail_match_impl(self, args, "O|OO:endswith", "endswith", true);
+}
+
+/**
+ * @brief Common implementation of removeprefix (suffix == false) and
+ *        removesuffix: a slice view of self without the affix, or self.
+ */
+static PyObject* remove_affix(LStrObject *self, PyObject *affix, const char *name, bool suffix) {
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return nullptr;
+    }
+    if (!is_affix(self, affix)) {
+        PyErr_Format(PyExc_TypeError, "%s() argument must be str or L, not %.100s",
+                     name, Py_TYPE(affix)->tp_name);
+        return nullptr;
+    }
+    Py_ssize_t len = (Py_ssize_t)self->buffer->length();
+    Py_ssize_t n = affix_length(affix);
+    try {
+        if (n > 0 && tail_match(self, affix, 0, len, suffix)) {
+            return suffix ? make_lstr_slice(self, 0, len - n) : make_lstr_slice(self, n, len);
+        }
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    return cppy::incref((PyObject*)self);
+}
+
+/**
+ * @brief removeprefix(self, prefix): self[len(prefix):] if self starts
+ *        with prefix, else self.
+ */
+static PyObject* LStr_removeprefix(LStrObject *self, PyObject *prefix) {
+    return remove_affix(self, prefix, "removeprefix", false);
+}
+
+/**
+ * @brief removesuffix(self, suffix): self[:-len(suffix)] if self ends
+ *        with a non-empty suffix, else self.
+ */
+static PyObject* LStr_removesuffix(LStrObject *self, PyObject *suffix) {
+    return remove_affix(self, suffix, "removesuffix", true);
+}
+
+/**
+ * @brief Common implementation of partition (reverse == false) and
+ *        rpartition.
+ *
+ * `sep` is a str, L or Pattern. The parts are slice views of self; the
+ * middle one is the separator as an L (the needle of a Pattern).
+ */
+static PyObject* partition_impl(LStrObject *self, PyObject *sep_obj, bool reverse) {
+    tptr<LStrObject> sep;
+    LStrPatternObject *pattern;
+    Py_ssize_t start, end;
+    if (parse_sub_range(self, sep_obj, Py_None, Py_None, sep, pattern, start, end) < 0) return nullptr;
+    Py_ssize_t sep_len = (Py_ssize_t)sep->buffer->length();
+    if (sep_len == 0) {
+        PyErr_SetString(PyExc_ValueError, "empty separator");
+        return nullptr;
+    }
+
+    Py_ssize_t found = -1;
+    if (end - start >= sep_len && search_sub(self, sep.get(), pattern, start, end, reverse, found) < 0) {
+        return nullptr;
+    }
+    cppy::ptr before, middle, after;
+    if (found < 0) {
+        // Not found: self is the first part (last for rpartition).
+        before = cppy::ptr(make_lstr_slice(self, 0, reverse ? 0 : end));
+        middle = cppy::ptr(make_lstr_slice(self, end, end));
+        after = cppy::ptr(make_lstr_slice(self, reverse ? 0 : end, end));
+    } else {
+        before = cppy::ptr(make_lstr_slice(self, 0, found));
+        middle = cppy::ptr(cppy::incref((PyObject*)sep.get()));
+        after = cppy::ptr(make_lstr_slice(self, found + sep_len, end));
+    }
+    if (!before || !middle || !after) return nullptr;
+    return PyTuple_Pack(3, before.get(), middle.get(), after.get());
+}
+
+/**
+ * @brief partition(self, sep): (before, sep, after) around the first
+ *        occurrence of sep, or (self, L(''), L('')).
+ */
+static PyObject* LStr_partition(LStrObject *self, PyObject *sep) {
+    return partition_impl(self, sep, false);
+}
+
+/**
+ * @brief rpartition(self, sep): (before, sep, after) around the last
+ *        occurrence of sep, or (L(''), L(''), self).
+ */
+static PyObject* LStr_rpartition(LStrObject *self, PyObject *sep) {
+    return partition_impl(self, sep, true);
+}
+
+/**
+ * @brief build_index(self): attach a substring index to self.
+ *
+ * Later find, rfind, count and `in` on self, and on step-1 slices of it,
+ * look up needles of SubstringIndex::GRAM or more code points in the
+ * index instead of scanning. The index takes about 4 bytes per code point
+ * and is freed with self's buffer; building it again is a no-op.
+ */
+static PyObject* LStr_build_index(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return nullptr;
+    }
+    const Buffer *buf = self->buffer;
+    if (SubstringIndex::lookup(buf)) Py_RETURN_NONE;
+    Py_ssize_t len = buf->length();
+    if (len > SubstringIndex::MAX_LENGTH) {
+        PyErr_SetString(PyExc_ValueError, "L is too long for build_index()");
+        return nullptr;
+    }
+    try {
+        std::unique_ptr<SubstringIndex> index = scan_without_gil(len, [&] {
+            return std::unique_ptr<SubstringIndex>(new SubstringIndex(*buf));
+        });
+        SubstringIndex::attach(buf, std::move(index));
+    } catch (const std::bad_alloc &) {
+        PyErr_NoMemory();
+        return nullptr;
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+/* Iterator over substring matches */
+
+/**
+ * Iterator produced by `find_iter` and `rfind_iter`.
+ *
+ * Holds owned references to the source and the substring together with a
+ * SubstringSearch engine built once for the whole iteration, or borrowed
+ * from the Pattern passed as the substring. Each step
+ * resumes the search after the previous match, so the matches are
+ * non-overlapping like those used by str.count/replace/split. The iterator
+ * type is created on demand and cached on the `L` type object, like the
+ * character iterator.
+ */
+struct LStrFindIterObject {
+    PyObject_HEAD
+    LStrObject *source;       /* owned reference */
+    LStrObject *sub;          /* owned reference */
+    PyObject *pattern;        /* owned reference to the Pattern, or nullptr */
+    SubstringSearch *search;  /* engine for sub; owned unless pattern is set */
+    bool reverse;
+    Py_ssize_t start;         /* remaining search range [start, end) */
+    Py_ssize_t end;
+    bool done;
+};
+
+static void LStrFindIter_dealloc(PyObject *it_obj) {
+    LStrFindIterObject *it = (LStrFindIterObject*)it_obj;
+    if (!it->pattern) delete it->search;
+    it->search = nullptr;
+    Py_CLEAR(it->pattern);
+    if (it->sub) {
+        cppy::decref(it->sub);
+        it->sub = nullptr;
+    }
+    if (it->source) {
+        cppy::decref(it->source);
+        it->source = nullptr;
+    }
+    PyTypeObject *tp = Py_TYPE(it_obj);
+    tp->tp_free(it_obj);
+}
+
+static PyObject* LStrFindIter_next_locked(PyObject *it_obj) {
+    LStrFindIterObject *it = (LStrFindIterObject*)it_obj;
+    if (!it->source || !it->search) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L find iterator");
+        return nullptr;
+    }
+    if (it->done || it->start > it->end) {
+        PyErr_SetNone(PyExc_StopIteration);
+        return nullptr;
+    }
+
+    Py_ssize_t sub_len = it->search->length();
+    Py_ssize_t found;
+    if (sub_len == 0) {
+        // An empty substring matches at every position of the range.
+        found = it->reverse ? it->end : it->start;
+    } else {
+        found = it->search->find(it->source->buffer, it->start, it->end);
+        if (found < 0) {
+            it->done = true;
+            PyErr_SetNone(PyExc_StopIteration);
+            return nullptr;
+        }
+    }
+
+    if (it->reverse) {
+        it->end = found - (sub_len == 0 ? 1 : 0);
+    } else {
+        it->start = found + (sub_len == 0 ? 1 : sub_len);
+    }
+    return PyLong_FromSsize_t(found);
+}
+
+static PyObject* LStrFindIter_iternext(PyObject *it_obj) {
+    // The remaining range changes on every step; threads sharing the
+    // iterator take turns.
+    PyObject *result;
+    Py_BEGIN_CRITICAL_SECTION(it_obj);
+    result = LStrFindIter_next_locked(it_obj);
+    Py_END_CRITICAL_SECTION();
+    return result;
+}
+
+PyType_Slot LStrFindIter_slots[] = {
+    {Py_tp_dealloc, (void*)LStrFindIter_dealloc},
+    {Py_tp_iternext, (void*)LStrFindIter_iternext},
+    {Py_tp_iter, (void*)PyObject_SelfIter},
+    {Py_tp_doc, (void*)"Iterator over non-overlapping substring match positions of L."},
+    {0, nullptr}
+};
+
+PyType_Spec LStrFindIter_spec = {
+    "_lstring._lstr_find_iterator",
+    sizeof(LStrFindIterObject),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    LStrFindIter_slots
+};
+
+/**
+ * @brief Common implementation of find_iter/rfind_iter.
+ */
+static PyObject* make_find_iter(LStrObject *self, PyObject *args, PyObject *kwds,
+                                const char *format, bool reverse) {
+    static char *kwlist[] = {(char*)"sub", (char*)"start", (char*)"end", nullptr};
+    PyObject *sub_obj = nullptr;
+    PyObject *start_obj = Py_None;
+    PyObject *end_obj = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, format, kwlist,
+                                     &sub_obj, &start_obj, &end_obj)) {
+        return nullptr;
+    }
+
+    tptr<LStrObject> sub_owner;
+    LStrPatternObject *pattern;
+    Py_ssize_t start, end;
+    if (parse_sub_range(self, sub_obj, start_obj, end_obj, sub_owner, pattern, start, end) < 0) {
+        return nullptr;
+    }
+
+    PyTypeObject *lstr_type = get_base_l_type(Py_TYPE(self));
+
+    // Try to get cached iterator type from the L type object
+    tptr<PyTypeObject> it_type(PyObject_GetAttrString((PyObject*)lstr_type, "_find_iterator_type"));
+    if (!it_type) {
+        PyErr_Clear();
+
+        it_type = tptr<PyTypeObject>(PyType_FromSpec(&LStrFindIter_spec));
+        if (!it_type) return nullptr;
+
+        // Cache iterator type on the L heap type object for reuse.
+        if (PyObject_SetAttrString((PyObject*)lstr_type, "_find_iterator_type", it_type.ptr().get()) < 0) {
+            return nullptr;
+        }
+    }
+
+    tptr<LStrFindIterObject> it_obj(PyObject_CallObject(it_type.ptr().get(), nullptr));
+    if (!it_obj) return nullptr;
+
+    it_obj->source = (LStrObject*)cppy::incref((PyObject*)self);
+    it_obj->sub = (LStrObject*)sub_owner.ptr().release();
+    it_obj->reverse = reverse;
+    it_obj->start = start;
+    it_obj->end = end;
+    it_obj->done = false;
+    if (pattern) {
+        it_obj->pattern = cppy::incref((PyObject*)pattern);
+        it_obj->search = reverse ? pattern->reverse : pattern->forward;
+        return it_obj.ptr().release();
+    }
+    try {
+        it_obj->search = new SubstringSearch(it_obj->sub->buffer, reverse);
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    } catch (...) {
+        PyErr_SetString(PyExc_RuntimeError, "find iterator creation failed");
+        return nullptr;
+    }
+
+    return it_obj.ptr().release();
+}
+
+/**
+ * @brief find_iter(self, sub, start=None, end=None)
+ *
+ * Return an iterator over the start indices of non-overlapping occurrences
+ * of sub in the slice [start:end], left to right. The substring search
+ * engine is built once for the whole iteration.
+ */
+static PyObject* LStr_find_iter(LStrObject *self, PyObject *args, PyObject *kwds) {
+    return make_find_iter(self, args, kwds, "O|OO:find_iter", false);
+}
+
+/**
+ * @brief rfind_iter(self, sub, start=None, end=None)
+ *
+ * Like find_iter, but yields the occurrences right to left; each match is
+ * searched for to the left of the previous one, as rsplit does.
+ */
+static PyObject* LStr_rfind_iter(LStrObject *self, PyObject *args, PyObject *kwds) {
+    return make_find_iter(self, args, kwds, "O|OO:rfind_iter", true);
+}
+
+
+/**
+ * @brief replace(self, old, new, count=-1)
+ *
+ * Mirrors str.replace for a non-empty `old` (str, L or Pattern); `new` is
+ * a str or L. The match positions are collected in one scan with the
+ * substring search engine, then the result is built bottom-up as a
+ * balanced join of slices of self and one shared `new` object, so each
+ * occurrence costs a single slice node. Returns self when nothing is
+ * replaced.
+ */
+static PyObject* LStr_replace(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"old", (char*)"new", (char*)"count", nullptr};
+    PyObject *old_obj = nullptr;
+    PyObject *new_obj = nullptr;
+    Py_ssize_t count = -1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|n:replace", kwlist,
+                                     &old_obj, &new_obj, &count)) {
+        return nullptr;
+    }
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return nullptr;
+    }
+
+    PyTypeObject *type = Py_TYPE(self);
+    PyObject *base_type = (PyObject*)get_base_l_type(type);
+
+    // Obtain the needle: accept Python str, L or Pattern
+    tptr<LStrObject> old_owner;
+    LStrPatternObject *pattern = nullptr;
+    if (LStrPattern_Check(old_obj)) {
+        pattern = (LStrPatternObject*)old_obj;
+        old_owner = tptr<LStrObject>(pattern->needle, true);
+    } else if (PyUnicode_Check(old_obj)) {
+        old_owner = tptr<LStrObject>(make_lstr_from_pystr(type, old_obj));
+        if (!old_owner) return nullptr;
+    } else if (PyObject_IsInstance(old_obj, base_type) == 1) {
+        old_owner = tptr<LStrObject>(old_obj, true);
+    } else {
+        PyErr_Format(PyExc_TypeError, "replace() argument 1 must be str, L or Pattern, not %.200s",
+                     Py_TYPE(old_obj)->tp_name);
+        return nullptr;
+    }
+
+    // The replacement is shared by every occurrence, so wrap a str once.
+    tptr<LStrObject> new_owner;
+    if (PyUnicode_Check(new_obj)) {
+        new_owner = tptr<LStrObject>(make_lstr_from_pystr(type, new_obj));
+        if (!new_owner) return nullptr;
+    } else if (PyObject_IsInstance(new_obj, base_type) == 1) {
+        new_owner = tptr<LStrObject>(new_obj, true);
+    } else {
+        PyErr_Format(PyExc_TypeError, "replace() argument 2 must be str or L, not %.200s",
+                     Py_TYPE(new_obj)->tp_name);
+        return nullptr;
+    }
+
+    if (!old_owner->buffer || !new_owner->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "replace() argument L has no buffer");
+        return nullptr;
+    }
+    Py_ssize_t old_len = (Py_ssize_t)old_owner->buffer->length();
+    if (old_len == 0) {
+        PyErr_SetString(PyExc_ValueError, "replace() cannot replace empty substring");
+        return nullptr;
+    }
+
+    Buffer *src = self->buffer;
+    Py_ssize_t src_len = (Py_ssize_t)src->length();
+    if (count == 0 || src_len < old_len) {
+        return cppy::incref((PyObject*)self);
+    }
+
+    // Collect the match positions in a single pass.
+    std::vector<Py_ssize_t> found;
+    try {
+        auto collect = [&](Py_ssize_t pos) {
+            found.push_back(pos);
+            return count < 0 || (Py_ssize_t)found.size() < count;
+        };
+        if (pattern) {
+            pattern->forward->scan(src, 0, src_len, collect);
+        } else {
+            SubstringSearch search(old_owner->buffer);
+            search.scan(src, 0, src_len, collect);
+        }
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    if (found.empty()) {
+        return cppy::incref((PyObject*)self);
+    }
+
+    std::vector<tptr<LStrObject>> pieces;
+    pieces.reserve(2 * found.size() + 1);
+    bool have_new = new_owner->buffer->length() > 0;
+
+    auto add_slice = [&](Py_ssize_t start, Py_ssize_t end) {
+        if (start >= end) return true;
+        if (start == 0 && end == src_len) {
+            pieces.push_back(tptr<LStrObject>((PyObject*)self, true));
+            return true;
+        }
+        tptr<LStrObject> piece(type->tp_alloc(type, 0));
+        if (!piece) return false;
+        try {
+            piece->buffer = new Slice1Buffer((PyObject*)self, start, end);
+            stats_node(piece->buffer);
+        } catch (const std::exception &e) {
+            PyErr_SetString(PyExc_RuntimeError, e.what());
+            return false;
+        } catch (...) {
+            PyErr_SetString(PyExc_RuntimeError, "slice creation failed");
+            return false;
+        }
+        pieces.push_back(piece);
+        return true;
+    };
+
+    Py_ssize_t last_end = 0;
+    for (Py_ssize_t pos : found) {
+        if (!add_slice(last_end, pos)) return nullptr;
+        if (have_new) pieces.push_back(new_owner);
+        last_end = pos + old_len;
+    }
+    if (!add_slice(last_end, src_len)) return nullptr;
+
+    if (pieces.empty()) {
+        return make_lstr_from_pystr(type, cppy::ptr(PyUnicode_FromString("")).get());
+    }
+
+    tptr<LStrObject> result = join_balanced(type, pieces);
+    if (!result) return nullptr;
+
+    // Try to optimize/collapse small results
+    tptr<LStrObject> optimized(lstr_optimize(result.get()));
+    if (optimized) {
+        return optimized.ptr().release();
     }
 
-    // Validate source buffer
+    return result.ptr().release();
+}
+
+/**
+ * @brief join(self, iterable)
+ *
+ * Mirrors str.join for items that are str or L. str items are wrapped in
+ * leaves directly and the separator (self) is shared by every gap, so the
+ * result is one balanced join tree over the 2n-1 pieces built bottom-up in
+ * O(n). Empty pieces are left out; a single item is returned as is.
+ */
+static PyObject* LStr_join(LStrObject *self, PyObject *iterable) {
     if (!self || !self->buffer) {
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    Buffer *src = self->buffer;
-    Py_ssize_t src_len = (Py_ssize_t)src->length();
+    PyTypeObject *type = Py_TYPE(self);
+    PyObject *base_type = (PyObject*)get_base_l_type(type);
 
-    // Obtain a Buffer for sub: accept Python str or L
-    tptr<LStrObject> sub_owner;
-    if (PyUnicode_Check(sub_obj)) {
-        // wrap Python str into a temporary `L` via factory and own it
-        PyTypeObject *type = Py_TYPE(self);
-        sub_owner = tptr<LStrObject>(make_lstr_from_pystr(type, sub_obj));
-        if (!sub_owner) return nullptr;
-    } else if (PyObject_IsInstance(sub_obj, (PyObject*)get_base_l_type(Py_TYPE(self))) == 1) {
-        LStrObject *lsub = (LStrObject*)sub_obj;
-        if (!lsub->buffer) {
-            PyErr_SetString(PyExc_RuntimeError, "substring L has no buffer");
-            return nullptr;
-        }
-        sub_owner = tptr<LStrObject>(sub_obj, true);
-    } else {
-        PyErr_SetString(PyExc_TypeError, "sub must be str or L");
+    cppy::ptr seq(PySequence_Fast(iterable, "can only join an iterable"));
+    if (!seq) return nullptr;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq.get());
+    PyObject **items = PySequence_Fast_ITEMS(seq.get());
+
+    std::vector<tptr<LStrObject>> converted;
+    try {
+        converted.reserve((size_t)n);
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_MemoryError, e.what());
         return nullptr;
     }
-
-    Py_ssize_t sub_len = (Py_ssize_t)sub_owner->buffer->length();
-
-    // Parse start
-    Py_ssize_t start;
-    if (start_obj == Py_None) {
-        start = 0;
-    } else {
-        if (!PyLong_Check(start_obj)) {
-            PyErr_SetString(PyExc_TypeError, "start/end must be int or None");
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        PyObject *item = items[i];
+        if (PyUnicode_Check(item)) {
+            tptr<LStrObject> leaf(make_lstr_from_pystr(type, item));
+            if (!leaf) return nullptr;
+            converted.push_back(leaf);
+        } else if (PyObject_IsInstance(item, base_type) == 1) {
+            if (!((LStrObject*)item)->buffer) {
+                PyErr_SetString(PyExc_RuntimeError, "join() item L has no buffer");
+                return nullptr;
+            }
+            converted.push_back(tptr<LStrObject>(item, true));
+        } else {
+            PyErr_Format(PyExc_TypeError,
+                         "sequence item %zd: expected str or L instance, %.80s found",
+                         i, Py_TYPE(item)->tp_name);
             return nullptr;
         }
-        start = PyLong_AsSsize_t(start_obj);
-        if (start == -1 && PyErr_Occurred()) return nullptr;
-        if (start < 0) start += src_len;
     }
 
-    // Parse end
-    Py_ssize_t end;
-    if (end_obj == Py_None) {
-        end = src_len;
-    } else {
-        if (!PyLong_Check(end_obj)) {
-            PyErr_SetString(PyExc_TypeError, "start/end must be int or None");
-            return nullptr;
-        }
-        end = PyLong_AsSsize_t(end_obj);
-        if (end == -1 && PyErr_Occurred()) return nullptr;
-        if (end < 0) end += src_len;
+    if (n == 0) {
+        return make_lstr_from_pystr(type, cppy::ptr(PyUnicode_FromString("")).get());
     }
-
-    // Clamp start/end per Python semantics
-    if (start < 0) start = 0;
-    if (end < 0) end = 0;
-    if (start > src_len) {
-        // start beyond end -> not found
-        return PyLong_FromLong(-1);
+    if (n == 1) {
+        return converted[0].ptr().release();
     }
-    if (end > src_len) end = src_len;
 
-    // Empty substring is found at start if start<=len, but if start==len
-    // it's allowed (empty at end). If start > len we already returned -1.
-    if (sub_len == 0) {
-        return PyLong_FromSsize_t(start);
+    tptr<LStrObject> sep((PyObject*)self, true);
+    bool have_sep = self->buffer->length() > 0;
+    std::vector<tptr<LStrObject>> pieces;
+    try {
+        pieces.reserve(have_sep ? 2 * (size_t)n - 1 : (size_t)n);
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_MemoryError, e.what());
+        return nullptr;
+    }
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        if (i > 0 && have_sep) pieces.push_back(sep);
+        if (converted[i]->buffer->length() > 0) pieces.push_back(converted[i]);
     }
+    converted.clear();
 
-    // If the remaining region is shorter than sub, not found
-    if (end - start < sub_len) {
-        return PyLong_FromLong(-1);
+    if (pieces.empty()) {
+        return make_lstr_from_pystr(type, cppy::ptr(PyUnicode_FromString("")).get());
     }
 
-    // Fast-path: if both source and substring are string-backed buffers,
-    // delegate to the built-in Python unicode find implementation which is
-    // optimized in C and understands Python slice semantics.
-    if (src->is_str() && sub_owner->buffer->is_str()) {
-        PyObject *src_py = ((StrBuffer*)src)->get_str();
-        PyObject *sub_py = ((StrBuffer*)sub_owner->buffer)->get_str();
-        Py_ssize_t idx = PyUnicode_Find(src_py, sub_py, start, end, 1); // direction=1 -> find
-        if (idx == -1 && PyErr_Occurred()) return nullptr;
-        return PyLong_FromSsize_t(idx);
-    }
-
-    // Optimized scan: find occurrences of the first code point of `sub`
-    // and only perform the full element-wise comparison at those
-    // candidate positions. This delegates single-codepoint search to
-    // the buffer implementation which may provide faster paths for
-    // joined/repeated/sliced buffers.
-    uint32_t first_cp = sub_owner->buffer->value(0);
-    Py_ssize_t pos = start;
-    Py_ssize_t last = end - sub_len;
-    while (pos <= last) {
-        // find next occurrence of first_cp in [pos, end)
-        Py_ssize_t i = src->findc(pos, end, first_cp);
-        if (i < 0 || i > last) break; // not found or not enough room for full match
-
-        // verify full substring match at position i
-        // We can skip j==0 because findc returned i where
-        // src->value(i) == first_cp == sub_owner->buffer->value(0).
-        bool match = true;
-        for (Py_ssize_t j = 1; j < sub_len; ++j) {
-            uint32_t a = src->value(i + j);
-            uint32_t b = sub_owner->buffer->value(j);
-            if (a != b) { match = false; break; }
-        }
-        if (match) return PyLong_FromSsize_t(i);
+    tptr<LStrObject> result = join_balanced(type, pieces);
+    if (!result) return nullptr;
 
-        // advance to the next possible position after the found cp
-        pos = i + 1;
+    // Try to optimize/collapse small results
+    tptr<LStrObject> optimized(lstr_optimize(result.get()));
+    if (optimized) {
+        return optimized.ptr().release();
     }
 
-    return PyLong_FromLong(-1);
+    return result.ptr().release();
 }
 
-
 /**
- * @brief rfind(self, sub, start=None, end=None)
+ * @brief compact(self, min_leaf=256, max_leaf=4096)
  *
- * Mirrors semantics of str.rfind: returns highest index where sub is
- * found in the slice [start:end], or -1 if not found.
+ * Return an equal L whose join tree has every run of adjacent leaves
+ * shorter than `min_leaf` copied into contiguous chunks of at most
+ * `max_leaf` code points, rebuilt balanced. Longer leaves are shared.
+ * Returns self when it is not a join.
  */
-static PyObject* LStr_rfind(LStrObject *self, PyObject *args, PyObject *kwds) {
-    static char *kwlist[] = {(char*)"sub", (char*)"start", (char*)"end", nullptr};
-    PyObject *sub_obj = nullptr;
-    PyObject *start_obj = Py_None;
-    PyObject *end_obj = Py_None;
-
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|OO:rfind", kwlist,
-                                     &sub_obj, &start_obj, &end_obj)) {
+static PyObject* LStr_compact(LStrObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"min_leaf", (char*)"max_leaf", nullptr};
+    Py_ssize_t min_leaf = 256;
+    Py_ssize_t max_leaf = 4096;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|nn:compact", kwlist, &min_leaf, &max_leaf)) {
+        return nullptr;
+    }
+    if (min_leaf < 0) {
+        PyErr_SetString(PyExc_ValueError, "compact() min_leaf must be >= 0");
+        return nullptr;
+    }
+    if (max_leaf < min_leaf || max_leaf < 1) {
+        PyErr_SetString(PyExc_ValueError, "compact() max_leaf must be >= min_leaf and >= 1");
         return nullptr;
     }
-
     if (!self || !self->buffer) {
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    Buffer *src = self->buffer;
-    Py_ssize_t src_len = (Py_ssize_t)src->length();
 
-    // Obtain sub buffer (str or L)
-    tptr<LStrObject> sub_owner;
-    if (PyUnicode_Check(sub_obj)) {
-        PyTypeObject *type = Py_TYPE(self);
-        sub_owner = tptr<LStrObject>(make_lstr_from_pystr(type, sub_obj));
-        if (!sub_owner) return nullptr;
-    } else if (PyObject_IsInstance(sub_obj, (PyObject*)get_base_l_type(Py_TYPE(self))) == 1) {
-        LStrObject *lsub = (LStrObject*)sub_obj;
-        if (!lsub->buffer) {
-            PyErr_SetString(PyExc_RuntimeError, "substring L has no buffer");
-            return nullptr;
+    tptr<LStrObject> result = compact_tree(Py_TYPE(self), tptr<LStrObject>((PyObject*)self, true),
+                                           min_leaf, max_leaf);
+    if (!result) return nullptr;
+    return result.ptr().release();
+}
+
+/* Buffer-protocol leaves */
+
+/**
+ * @brief from_buffer(cls, obj, width=1, encoding=None): L over the memory of obj.
+ *
+ * The result references the memory exported by `obj` (an mmap, bytes,
+ * bytearray...) without copying it: as code points of `width` bytes (see
+ * MmapBuffer), or with encoding='utf-8' as UTF-8 decoded on demand (see
+ * Utf8Buffer).
+ */
+static PyObject* LStr_from_buffer(PyObject *cls, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"obj", (char*)"width", (char*)"encoding", nullptr};
+    PyObject *obj;
+    int width = 1;
+    const char *encoding = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|iz:from_buffer", kwlist, &obj, &width, &encoding)) {
+        return nullptr;
+    }
+    const bool utf8 = encoding != nullptr;
+    if (utf8 && !is_utf8_name(encoding)) {
+        PyErr_Format(PyExc_ValueError, "unsupported encoding '%s': only 'utf-8' is decoded lazily", encoding);
+        return nullptr;
+    }
+    if (utf8 && width != 1) {
+        PyErr_SetString(PyExc_ValueError, "width must be 1 for UTF-8 data");
+        return nullptr;
+    }
+    PyTypeObject *type = (PyTypeObject*)cls;
+    tptr<LStrObject> result(type->tp_alloc(type, 0));
+    if (!result) return nullptr;
+    try {
+        if (utf8) {
+            result->buffer = Utf8Buffer::create(obj);
+        } else {
+            result->buffer = MmapBuffer::create(obj, width);
         }
-        sub_owner = tptr<LStrObject>(sub_obj, true);
-    } else {
-        PyErr_SetString(PyExc_TypeError, "sub must be str or L");
+        stats_node(result->buffer);
+        if (!result->buffer) return nullptr;
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    } catch (...) {
+        PyErr_SetString(PyExc_RuntimeError, "buffer leaf allocation failed");
         return nullptr;
     }
+    return result.ptr().release();
+}
 
-    Py_ssize_t sub_len = (Py_ssize_t)sub_owner->buffer->length();
+/* Character mapping */
 
-    // Parse start
-    Py_ssize_t start;
-    if (start_obj == Py_None) {
-        start = 0;
-    } else {
-        if (!PyLong_Check(start_obj)) {
-            PyErr_SetString(PyExc_TypeError, "start/end must be int or None");
-            return nullptr;
-        }
-        start = PyLong_AsSsize_t(start_obj);
-        if (start == -1 && PyErr_Occurred()) return nullptr;
-        if (start < 0) start += src_len;
+/**
+ * @brief Apply a code point map to self.
+ *
+ * Returns a lazy MapBuffer view unless self contains one of the map's
+ * special (length-changing or context-dependent) code points or `map` is
+ * null; then the str method `method` is applied to the materialized text,
+ * with `arg` as its argument if given.
+ */
+static PyObject* map_lstr(LStrObject *self, const std::shared_ptr<const CodePointMap> &map,
+                          const char *method, PyObject *arg) {
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return nullptr;
     }
+    Buffer *src = self->buffer;
+    Py_ssize_t src_len = (Py_ssize_t)src->length();
+    PyTypeObject *type = Py_TYPE(self);
 
-    // Parse end
-    Py_ssize_t end;
-    if (end_obj == Py_None) {
-        end = src_len;
-    } else {
-        if (!PyLong_Check(end_obj)) {
-            PyErr_SetString(PyExc_TypeError, "start/end must be int or None");
-            return nullptr;
-        }
-        end = PyLong_AsSsize_t(end_obj);
-        if (end == -1 && PyErr_Occurred()) return nullptr;
-        if (end < 0) end += src_len;
+    if (map && (src_len == 0 || map->is_identity())) {
+        return cppy::incref((PyObject*)self);
     }
 
-    // Clamp start/end per Python semantics
-    if (start < 0) start = 0;
-    if (end < 0) end = 0;
-    if (start > src_len) {
-        // start beyond end -> not found
-        return PyLong_FromLong(-1);
+    const CharSet *specials = map ? map->specials() : nullptr;
+    if (!map || (specials && src->findcs(0, src_len, *specials) >= 0)) {
+        cppy::ptr text(buffer_to_pystr(src));
+        if (!text) return nullptr;
+        cppy::ptr mapped(arg ? PyObject_CallMethod(text.get(), method, "O", arg)
+                             : PyObject_CallMethod(text.get(), method, nullptr));
+        if (!mapped) return nullptr;
+        return make_lstr_from_pystr(type, mapped.get());
     }
-    if (end > src_len) end = src_len;
 
-    // Empty substring behavior: return end if sub_len == 0 (rfind rules)
-    if (sub_len == 0) {
-        // For rfind, empty substring is found at min(end, src_len)
-        Py_ssize_t pos = end;
-        if (pos > src_len) pos = src_len;
-        return PyLong_FromSsize_t(pos);
+    tptr<LStrObject> result(type->tp_alloc(type, 0));
+    if (!result) return nullptr;
+    try {
+        result->buffer = new MapBuffer((PyObject*)self, map, method);
+        stats_node(result->buffer);
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    } catch (...) {
+        PyErr_SetString(PyExc_RuntimeError, "MapBuffer allocation failed");
+        return nullptr;
     }
 
-    // If remaining region is shorter than sub, not found
-    if (end - start < sub_len) {
-        return PyLong_FromLong(-1);
+    // Try to optimize/collapse small results
+    tptr<LStrObject> optimized(lstr_optimize(result.get()));
+    if (optimized) {
+        return optimized.ptr().release();
     }
 
-    // Fast-path: if both source and substring are string-backed buffers,
-    // delegate to Python unicode rfind via PyUnicode_Find with direction=-1.
-    if (src->is_str() && sub_owner->buffer->is_str()) {
-        PyObject *src_py = ((StrBuffer*)src)->get_str();
-        PyObject *sub_py = ((StrBuffer*)sub_owner->buffer)->get_str();
-        Py_ssize_t idx = PyUnicode_Find(src_py, sub_py, start, end, -1); // direction=-1 -> rfind
-        if (idx == -1 && PyErr_Occurred()) return nullptr;
-        return PyLong_FromSsize_t(idx);
-    }
-
-    // Scan from the right using rfindc on the LAST code point of `sub`.
-    // When rfindc returns an index `pos` where src->value(pos) == last_cp,
-    // that corresponds to a candidate match last code point.
-    // Verify the substring by comparing the
-    // remaining code points in backward direction.
-    uint32_t last_cp = sub_owner->buffer->value(sub_len - 1);
-    Py_ssize_t pos = end; // rfindc searches in [start, pos)
-    while (pos > start + sub_len - 1) {
-        Py_ssize_t k = src->rfindc(start, pos, last_cp);
-        if (k < 0) break; // no more occurrences
-        if (k < start + sub_len - 1) break; // not enough room for full match
-
-        // verify substring backward; we can skip comparing the last
-        // code point because rfindc already matched it at `k`.
-        bool match = true;
-        for (Py_ssize_t j = 1; j < sub_len; ++j) {
-            uint32_t a = src->value(k - j);
-            uint32_t b = sub_owner->buffer->value(sub_len - j - 1);
-            if (a != b) { match = false; break; }
-        }
-        if (match) return PyLong_FromSsize_t(k - sub_len + 1);
-        pos = k; // continue searching earlier
-    }
+    return result.ptr().release();
+}
+
+static PyObject* map_case(LStrObject *self, CaseMapping mapping, const char *method) {
+    std::shared_ptr<const CodePointMap> map = get_case_map(mapping);
+    if (!map) return nullptr;
+    return map_lstr(self, map, method, nullptr);
+}
 
-    return PyLong_FromLong(-1);
+/**
+ * @brief lower(self): lazily lowercased view, like str.lower().
+ */
+static PyObject* LStr_lower(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
+    return map_case(self, CASE_LOWER, "lower");
+}
+
+/**
+ * @brief upper(self): lazily uppercased view, like str.upper().
+ */
+static PyObject* LStr_upper(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
+    return map_case(self, CASE_UPPER, "upper");
+}
+
+/**
+ * @brief casefold(self): lazily casefolded view, like str.casefold().
+ */
+static PyObject* LStr_casefold(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
+    return map_case(self, CASE_CASEFOLD, "casefold");
+}
+
+/**
+ * @brief swapcase(self): lazily case-swapped view, like str.swapcase().
+ */
+static PyObject* LStr_swapcase(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
+    return map_case(self, CASE_SWAPCASE, "swapcase");
 }
 
+/**
+ * @brief translate(self, table)
+ *
+ * A dict of ordinals to ordinals or one-character strings gives a lazy
+ * view; deletions, longer replacements and other table types are handled
+ * by str.translate on the materialized text.
+ */
+static PyObject* LStr_translate(LStrObject *self, PyObject *table) {
+    return map_lstr(self, make_translate_map(table), "translate", table);
+}
 
 /**
  * findc(self, ch, start=None, end=None)
@@ -407,7 +1430,6 @@ static PyObject* LStr_findc(LStrObject *self, PyObject *args, PyObject *kwds) {
         return nullptr;
     }
     Buffer *buf = self->buffer;
-    Py_ssize_t buf_len = (Py_ssize_t)buf->length();
 
     // parse ch: accept int or 1-char str
     uint32_t ch;
@@ -430,34 +1452,11 @@ static PyObject* LStr_findc(LStrObject *self, PyObject *args, PyObject *kwds) {
         return nullptr;
     }
 
-    // parse start/end similar to find
-    Py_ssize_t start;
-    if (start_obj == Py_None) {
-        start = 0;
-    } else {
-        if (!PyLong_Check(start_obj)) { PyErr_SetString(PyExc_TypeError, "start/end must be int or None"); return nullptr; }
-        start = PyLong_AsSsize_t(start_obj);
-        if (start == -1 && PyErr_Occurred()) return nullptr;
-        if (start < 0) start += buf_len;
-    }
-
-    Py_ssize_t end;
-    if (end_obj == Py_None) {
-        end = buf_len;
-    } else {
-        if (!PyLong_Check(end_obj)) { PyErr_SetString(PyExc_TypeError, "start/end must be int or None"); return nullptr; }
-        end = PyLong_AsSsize_t(end_obj);
-        if (end == -1 && PyErr_Occurred()) return nullptr;
-        if (end < 0) end += buf_len;
-    }
-
-    if (start < 0) start = 0;
-    if (end < 0) end = 0;
-    if (start > buf_len) return PyLong_FromLong(-1);
-    if (end > buf_len) end = buf_len;
+    Py_ssize_t start, end;
+    if (parse_range(self, start_obj, end_obj, start, end) < 0) return nullptr;
     if (start >= end) return PyLong_FromLong(-1);
 
-    Py_ssize_t res = buf->findc(start, end, ch);
+    Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->findc(start, end, ch); });
     return PyLong_FromSsize_t(res);
 }
 
@@ -481,7 +1480,6 @@ static PyObject* LStr_rfindc(LStrObject *self, PyObject *args, PyObject *kwds) {
         return nullptr;
     }
     Buffer *buf = self->buffer;
-    Py_ssize_t buf_len = (Py_ssize_t)buf->length();
 
     uint32_t ch;
     if (PyLong_Check(ch_obj)) {
@@ -494,34 +1492,11 @@ static PyObject* LStr_rfindc(LStrObject *self, PyObject *args, PyObject *kwds) {
         ch = (uint32_t)u;
     } else { PyErr_SetString(PyExc_TypeError, "ch must be int or 1-char str"); return nullptr; }
 
-    // parse start/end
-    Py_ssize_t start;
-    if (start_obj == Py_None) {
-        start = 0;
-    } else {
-        if (!PyLong_Check(start_obj)) { PyErr_SetString(PyExc_TypeError, "start/end must be int or None"); return nullptr; }
-        start = PyLong_AsSsize_t(start_obj);
-        if (start == -1 && PyErr_Occurred()) return nullptr;
-        if (start < 0) start += buf_len;
-    }
-
-    Py_ssize_t end;
-    if (end_obj == Py_None) {
-        end = buf_len;
-    } else {
-        if (!PyLong_Check(end_obj)) { PyErr_SetString(PyExc_TypeError, "start/end must be int or None"); return nullptr; }
-        end = PyLong_AsSsize_t(end_obj);
-        if (end == -1 && PyErr_Occurred()) return nullptr;
-        if (end < 0) end += buf_len;
-    }
-
-    if (start < 0) start = 0;
-    if (end < 0) end = 0;
-    if (start > buf_len) return PyLong_FromLong(-1);
-    if (end > buf_len) end = buf_len;
+    Py_ssize_t start, end;
+    if (parse_range(self, start_obj, end_obj, start, end) < 0) return nullptr;
     if (start >= end) return PyLong_FromLong(-1);
 
-    Py_ssize_t res = buf->rfindc(start, end, ch);
+    Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->rfindc(start, end, ch); });
     return PyLong_FromSsize_t(res);
 }
 
@@ -549,58 +1524,35 @@ static PyObject* LStr_findcs(LStrObject *self, PyObject *args, PyObject *kwds) {
         return nullptr;
     }
     Buffer *buf = self->buffer;
-    Py_ssize_t buf_len = (Py_ssize_t)buf->length();
 
     cppy::ptr charset_u;
     Buffer* charset_buf = nullptr;
-    if (get_charset_source(self, charset_obj, charset_u, charset_buf) < 0) {
+    LStrPatternObject* charset_pattern = nullptr;
+    if (get_charset_source(self, charset_obj, charset_u, charset_buf, charset_pattern) < 0) {
         return nullptr;
     }
 
-    // Parse start/end
-    Py_ssize_t start;
-    if (start_obj == Py_None) {
-        start = 0;
-    } else {
-        if (!PyLong_Check(start_obj)) {
-            PyErr_SetString(PyExc_TypeError, "start must be int or None");
-            return nullptr;
-        }
-        start = PyLong_AsSsize_t(start_obj);
-        if (start == -1 && PyErr_Occurred()) return nullptr;
-        if (start < 0) start += buf_len;
-    }
-
-    Py_ssize_t end;
-    if (end_obj == Py_None) {
-        end = buf_len;
-    } else {
-        if (!PyLong_Check(end_obj)) {
-            PyErr_SetString(PyExc_TypeError, "end must be int or None");
-            return nullptr;
-        }
-        end = PyLong_AsSsize_t(end_obj);
-        if (end == -1 && PyErr_Occurred()) return nullptr;
-        if (end < 0) end += buf_len;
-    }
-
-    if (start < 0) start = 0;
-    if (end < 0) end = 0;
-    if (start > buf_len) return PyLong_FromLong(-1);
-    if (end > buf_len) end = buf_len;
+    Py_ssize_t start, end;
+    if (parse_range(self, start_obj, end_obj, start, end) < 0) return nullptr;
     if (start >= end) return PyLong_FromLong(-1);
 
     try {
+        if (charset_pattern) {
+            const FullCharSet& cs = LStrPattern_charset(charset_pattern);
+            Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->findcs(start, end, cs, invert != 0); });
+            return PyLong_FromSsize_t(res);
+        }
+
         if (charset_buf) {
             const Py_ssize_t charset_len = charset_buf->length();
             if (charset_len <= 0) {
                 FullCharSet empty;
-                Py_ssize_t res = buf->findcs(start, end, empty, invert != 0);
+                Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->findcs(start, end, empty, invert != 0); });
                 return PyLong_FromSsize_t(res);
             }
 
             FullCharSet cs(*charset_buf);
-            Py_ssize_t res = buf->findcs(start, end, cs, invert != 0);
+            Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->findcs(start, end, cs, invert != 0); });
             return PyLong_FromSsize_t(res);
         }
 
@@ -610,7 +1562,7 @@ static PyObject* LStr_findcs(LStrObject *self, PyObject *args, PyObject *kwds) {
         const Py_ssize_t charset_len = PyUnicode_GET_LENGTH(charset_u.get());
         if (charset_len <= 0) {
             FullCharSet empty;
-            Py_ssize_t res = buf->findcs(start, end, empty, invert != 0);
+            Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->findcs(start, end, empty, invert != 0); });
             return PyLong_FromSsize_t(res);
         }
 
@@ -619,13 +1571,13 @@ static PyObject* LStr_findcs(LStrObject *self, PyObject *args, PyObject *kwds) {
         Py_ssize_t res;
         if (kind == PyUnicode_1BYTE_KIND) {
             ByteCharSet cs((const Py_UCS1*)data, charset_len);
-            res = buf->findcs(start, end, cs, invert != 0);
+            res = scan_without_gil(end - start, [&] { return buf->findcs(start, end, cs, invert != 0); });
         } else if (kind == PyUnicode_2BYTE_KIND) {
             FullCharSet cs((const Py_UCS2*)data, charset_len);
-            res = buf->findcs(start, end, cs, invert != 0);
+            res = scan_without_gil(end - start, [&] { return buf->findcs(start, end, cs, invert != 0); });
         } else {
             FullCharSet cs((const Py_UCS4*)data, charset_len);
-            res = buf->findcs(start, end, cs, invert != 0);
+            res = scan_without_gil(end - start, [&] { return buf->findcs(start, end, cs, invert != 0); });
         }
         return PyLong_FromSsize_t(res);
     } catch (const std::exception& e) {
@@ -658,58 +1610,35 @@ static PyObject* LStr_rfindcs(LStrObject *self, PyObject *args, PyObject *kwds)
         return nullptr;
     }
     Buffer *buf = self->buffer;
-    Py_ssize_t buf_len = (Py_ssize_t)buf->length();
 
     cppy::ptr charset_u;
     Buffer* charset_buf = nullptr;
-    if (get_charset_source(self, charset_obj, charset_u, charset_buf) < 0) {
+    LStrPatternObject* charset_pattern = nullptr;
+    if (get_charset_source(self, charset_obj, charset_u, charset_buf, charset_pattern) < 0) {
         return nullptr;
     }
 
-    // Parse start/end
-    Py_ssize_t start;
-    if (start_obj == Py_None) {
-        start = 0;
-    } else {
-        if (!PyLong_Check(start_obj)) {
-            PyErr_SetString(PyExc_TypeError, "start must be int or None");
-            return nullptr;
-        }
-        start = PyLong_AsSsize_t(start_obj);
-        if (start == -1 && PyErr_Occurred()) return nullptr;
-        if (start < 0) start += buf_len;
-    }
-
-    Py_ssize_t end;
-    if (end_obj == Py_None) {
-        end = buf_len;
-    } else {
-        if (!PyLong_Check(end_obj)) {
-            PyErr_SetString(PyExc_TypeError, "end must be int or None");
-            return nullptr;
-        }
-        end = PyLong_AsSsize_t(end_obj);
-        if (end == -1 && PyErr_Occurred()) return nullptr;
-        if (end < 0) end += buf_len;
-    }
-
-    if (start < 0) start = 0;
-    if (end < 0) end = 0;
-    if (start > buf_len) return PyLong_FromLong(-1);
-    if (end > buf_len) end = buf_len;
+    Py_ssize_t start, end;
+    if (parse_range(self, start_obj, end_obj, start, end) < 0) return nullptr;
     if (start >= end) return PyLong_FromLong(-1);
 
     try {
+        if (charset_pattern) {
+            const FullCharSet& cs = LStrPattern_charset(charset_pattern);
+            Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->rfindcs(start, end, cs, invert != 0); });
+            return PyLong_FromSsize_t(res);
+        }
+
         if (charset_buf) {
             const Py_ssize_t charset_len = charset_buf->length();
             if (charset_len <= 0) {
                 FullCharSet empty;
-                Py_ssize_t res = buf->rfindcs(start, end, empty, invert != 0);
+                Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->rfindcs(start, end, empty, invert != 0); });
                 return PyLong_FromSsize_t(res);
             }
 
             FullCharSet cs(*charset_buf);
-            Py_ssize_t res = buf->rfindcs(start, end, cs, invert != 0);
+            Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->rfindcs(start, end, cs, invert != 0); });
             return PyLong_FromSsize_t(res);
         }
 
@@ -719,7 +1648,7 @@ static PyObject* LStr_rfindcs(LStrObject *self, PyObject *args, PyObject *kwds)
         const Py_ssize_t charset_len = PyUnicode_GET_LENGTH(charset_u.get());
         if (charset_len <= 0) {
             FullCharSet empty;
-            Py_ssize_t res = buf->rfindcs(start, end, empty, invert != 0);
+            Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->rfindcs(start, end, empty, invert != 0); });
             return PyLong_FromSsize_t(res);
         }
 
@@ -728,13 +1657,13 @@ static PyObject* LStr_rfindcs(LStrObject *self, PyObject *args, PyObject *kwds)
         Py_ssize_t res;
         if (kind == PyUnicode_1BYTE_KIND) {
             ByteCharSet cs((const Py_UCS1*)data, charset_len);
-            res = buf->rfindcs(start, end, cs, invert != 0);
+            res = scan_without_gil(end - start, [&] { return buf->rfindcs(start, end, cs, invert != 0); });
         } else if (kind == PyUnicode_2BYTE_KIND) {
             FullCharSet cs((const Py_UCS2*)data, charset_len);
-            res = buf->rfindcs(start, end, cs, invert != 0);
+            res = scan_without_gil(end - start, [&] { return buf->rfindcs(start, end, cs, invert != 0); });
         } else {
             FullCharSet cs((const Py_UCS4*)data, charset_len);
-            res = buf->rfindcs(start, end, cs, invert != 0);
+            res = scan_without_gil(end - start, [&] { return buf->rfindcs(start, end, cs, invert != 0); });
         }
         return PyLong_FromSsize_t(res);
     } catch (const std::exception& e) {
@@ -768,7 +1697,6 @@ static PyObject* LStr_findcr(LStrObject *self, PyObject *args, PyObject *kwds) {
         return nullptr;
     }
     Buffer *buf = self->buffer;
-    Py_ssize_t buf_len = (Py_ssize_t)buf->length();
 
     // Parse startcp: accept int or 1-char str
     uint32_t startcp;
@@ -819,40 +1747,11 @@ static PyObject* LStr_findcr(LStrObject *self, PyObject *args, PyObject *kwds) {
         return nullptr;
     }
 
-    // Parse start/end
-    Py_ssize_t start;
-    if (start_obj == Py_None) {
-        start = 0;
-    } else {
-        if (!PyLong_Check(start_obj)) {
-            PyErr_SetString(PyExc_TypeError, "start must be int or None");
-            return nullptr;
-        }
-        start = PyLong_AsSsize_t(start_obj);
-        if (start == -1 && PyErr_Occurred()) return nullptr;
-        if (start < 0) start += buf_len;
-    }
-
-    Py_ssize_t end;
-    if (end_obj == Py_None) {
-        end = buf_len;
-    } else {
-        if (!PyLong_Check(end_obj)) {
-            PyErr_SetString(PyExc_TypeError, "end must be int or None");
-            return nullptr;
-        }
-        end = PyLong_AsSsize_t(end_obj);
-        if (end == -1 && PyErr_Occurred()) return nullptr;
-        if (end < 0) end += buf_len;
-    }
-
-    if (start < 0) start = 0;
-    if (end < 0) end = 0;
-    if (start > buf_len) return PyLong_FromLong(-1);
-    if (end > buf_len) end = buf_len;
+    Py_ssize_t start, end;
+    if (parse_range(self, start_obj, end_obj, start, end) < 0) return nullptr;
     if (start >= end) return PyLong_FromLong(-1);
 
-    Py_ssize_t res = buf->findcr(start, end, startcp, endcp, invert != 0);
+    Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->findcr(start, end, startcp, endcp, invert != 0); });
     return PyLong_FromSsize_t(res);
 }
 
@@ -881,7 +1780,6 @@ static PyObject* LStr_rfindcr(LStrObject *self, PyObject *args, PyObject *kwds)
         return nullptr;
     }
     Buffer *buf = self->buffer;
-    Py_ssize_t buf_len = (Py_ssize_t)buf->length();
 
     // Parse startcp: accept int or 1-char str
     uint32_t startcp;
@@ -932,40 +1830,11 @@ static PyObject* LStr_rfindcr(LStrObject *self, PyObject *args, PyObject *kwds)
         return nullptr;
     }
 
-    // Parse start/end
-    Py_ssize_t start;
-    if (start_obj == Py_None) {
-        start = 0;
-    } else {
-        if (!PyLong_Check(start_obj)) {
-            PyErr_SetString(PyExc_TypeError, "start must be int or None");
-            return nullptr;
-        }
-        start = PyLong_AsSsize_t(start_obj);
-        if (start == -1 && PyErr_Occurred()) return nullptr;
-        if (start < 0) start += buf_len;
-    }
-
-    Py_ssize_t end;
-    if (end_obj == Py_None) {
-        end = buf_len;
-    } else {
-        if (!PyLong_Check(end_obj)) {
-            PyErr_SetString(PyExc_TypeError, "end must be int or None");
-            return nullptr;
-        }
-        end = PyLong_AsSsize_t(end_obj);
-        if (end == -1 && PyErr_Occurred()) return nullptr;
-        if (end < 0) end += buf_len;
-    }
-
-    if (start < 0) start = 0;
-    if (end < 0) end = 0;
-    if (start > buf_len) return PyLong_FromLong(-1);
-    if (end > buf_len) end = buf_len;
+    Py_ssize_t start, end;
+    if (parse_range(self, start_obj, end_obj, start, end) < 0) return nullptr;
     if (start >= end) return PyLong_FromLong(-1);
 
-    Py_ssize_t res = buf->rfindcr(start, end, startcp, endcp, invert != 0);
+    Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->rfindcr(start, end, startcp, endcp, invert != 0); });
     return PyLong_FromSsize_t(res);
 }
 
@@ -978,7 +1847,8 @@ static PyObject* LStr_isspace(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    return PyBool_FromLong(self->buffer->isspace());
+    const Buffer *buf = self->buffer;
+    return PyBool_FromLong(scan_without_gil(buf->length(), [&] { return buf->isspace(); }));
 }
 
 /**
@@ -989,7 +1859,8 @@ static PyObject* LStr_isalpha(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    return PyBool_FromLong(self->buffer->isalpha());
+    const Buffer *buf = self->buffer;
+    return PyBool_FromLong(scan_without_gil(buf->length(), [&] { return buf->isalpha(); }));
 }
 
 /**
@@ -1000,7 +1871,8 @@ static PyObject* LStr_isdigit(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    return PyBool_FromLong(self->buffer->isdigit());
+    const Buffer *buf = self->buffer;
+    return PyBool_FromLong(scan_without_gil(buf->length(), [&] { return buf->isdigit(); }));
 }
 
 /**
@@ -1011,7 +1883,8 @@ static PyObject* LStr_isalnum(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    return PyBool_FromLong(self->buffer->isalnum());
+    const Buffer *buf = self->buffer;
+    return PyBool_FromLong(scan_without_gil(buf->length(), [&] { return buf->isalnum(); }));
 }
 
 /**
@@ -1022,7 +1895,8 @@ static PyObject* LStr_isupper(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    return PyBool_FromLong(self->buffer->isupper());
+    const Buffer *buf = self->buffer;
+    return PyBool_FromLong(scan_without_gil(buf->length(), [&] { return buf->isupper(); }));
 }
 
 /**
@@ -1033,7 +1907,8 @@ static PyObject* LStr_islower(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    return PyBool_FromLong(self->buffer->islower());
+    const Buffer *buf = self->buffer;
+    return PyBool_FromLong(scan_without_gil(buf->length(), [&] { return buf->islower(); }));
 }
 
 /**
@@ -1044,7 +1919,8 @@ static PyObject* LStr_isdecimal(LStrObject *self, PyObject *Py_UNUSED(ignored))
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    return PyBool_FromLong(self->buffer->isdecimal());
+    const Buffer *buf = self->buffer;
+    return PyBool_FromLong(scan_without_gil(buf->length(), [&] { return buf->isdecimal(); }));
 }
 
 /**
@@ -1055,7 +1931,8 @@ static PyObject* LStr_isnumeric(LStrObject *self, PyObject *Py_UNUSED(ignored))
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    return PyBool_FromLong(self->buffer->isnumeric());
+    const Buffer *buf = self->buffer;
+    return PyBool_FromLong(scan_without_gil(buf->length(), [&] { return buf->isnumeric(); }));
 }
 
 /**
@@ -1066,7 +1943,8 @@ static PyObject* LStr_isprintable(LStrObject *self, PyObject *Py_UNUSED(ignored)
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    return PyBool_FromLong(self->buffer->isprintable());
+    const Buffer *buf = self->buffer;
+    return PyBool_FromLong(scan_without_gil(buf->length(), [&] { return buf->isprintable(); }));
 }
 
 /**
@@ -1077,7 +1955,8 @@ static PyObject* LStr_istitle(LStrObject *self, PyObject *Py_UNUSED(ignored)) {
         PyErr_SetString(PyExc_RuntimeError, "invalid L object");
         return nullptr;
     }
-    return PyBool_FromLong(self->buffer->istitle());
+    const Buffer *buf = self->buffer;
+    return PyBool_FromLong(scan_without_gil(buf->length(), [&] { return buf->istitle(); }));
 }
 
 /**
@@ -1102,42 +1981,12 @@ static PyObject* LStr_findcc(LStrObject *self, PyObject *args, PyObject *kwds) {
         return nullptr;
     }
     Buffer *buf = self->buffer;
-    Py_ssize_t buf_len = (Py_ssize_t)buf->length();
-
-    // Parse start/end similar to findc
-    Py_ssize_t start;
-    if (start_obj == Py_None) {
-        start = 0;
-    } else {
-        if (!PyLong_Check(start_obj)) {
-            PyErr_SetString(PyExc_TypeError, "start must be int or None");
-            return nullptr;
-        }
-        start = PyLong_AsSsize_t(start_obj);
-        if (start == -1 && PyErr_Occurred()) return nullptr;
-        if (start < 0) start += buf_len;
-    }
-
-    Py_ssize_t end;
-    if (end_obj == Py_None) {
-        end = buf_len;
-    } else {
-        if (!PyLong_Check(end_obj)) {
-            PyErr_SetString(PyExc_TypeError, "end must be int or None");
-            return nullptr;
-        }
-        end = PyLong_AsSsize_t(end_obj);
-        if (end == -1 && PyErr_Occurred()) return nullptr;
-        if (end < 0) end += buf_len;
-    }
 
-    if (start < 0) start = 0;
-    if (end < 0) end = 0;
-    if (start > buf_len) return PyLong_FromLong(-1);
-    if (end > buf_len) end = buf_len;
+    Py_ssize_t start, end;
+    if (parse_range(self, start_obj, end_obj, start, end) < 0) return nullptr;
     if (start >= end) return PyLong_FromLong(-1);
 
-    Py_ssize_t res = buf->findcc(start, end, (uint32_t)class_mask, invert != 0);
+    Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->findcc(start, end, (uint32_t)class_mask, invert != 0); });
     return PyLong_FromSsize_t(res);
 }
 
@@ -1163,557 +2012,11 @@ static PyObject* LStr_rfindcc(LStrObject *self, PyObject *args, PyObject *kwds)
         return nullptr;
     }
     Buffer *buf = self->buffer;
-    Py_ssize_t buf_len = (Py_ssize_t)buf->length();
-
-    // Parse start/end similar to findc
-    Py_ssize_t start;
-    if (start_obj == Py_None) {
-        start = 0;
-    } else {
-        if (!PyLong_Check(start_obj)) {
-            PyErr_SetString(PyExc_TypeError, "start must be int or None");
-            return nullptr;
-        }
-        start = PyLong_AsSsize_t(start_obj);
-        if (start == -1 && PyErr_Occurred()) return nullptr;
-        if (start < 0) start += buf_len;
-    }
-
-    Py_ssize_t end;
-    if (end_obj == Py_None) {
-        end = buf_len;
-    } else {
-        if (!PyLong_Check(end_obj)) {
-            PyErr_SetString(PyExc_TypeError, "end must be int or None");
-            return nullptr;
-        }
-        end = PyLong_AsSsize_t(end_obj);
-        if (end == -1 && PyErr_Occurred()) return nullptr;
-        if (end < 0) end += buf_len;
-    }
 
-    if (start < 0) start = 0;
-    if (end < 0) end = 0;
-    if (start > buf_len) return PyLong_FromLong(-1);
-    if (end > buf_len) end = buf_len;
+    Py_ssize_t start, end;
+    if (parse_range(self, start_obj, end_obj, start, end) < 0) return nullptr;
     if (start >= end) return PyLong_FromLong(-1);
 
-    Py_ssize_t res = buf->rfindcc(start, end, (uint32_t)class_mask, invert != 0);
+    Py_ssize_t res = scan_without_gil(end - start, [&] { return buf->rfindcc(start, end, (uint32_t)class_mask, invert != 0); });
     return PyLong_FromSsize_t(res);
 }
-
-
-/**
- * @brief Check if character is a printf flag character (#, 0, space, +, -)
- */
-static inline bool _is_printf_flag_char(uint32_t ch) {
-    switch (ch) {
-        case '#': case '0': case ' ': case '+': case '-':
-            return true;
-        default:
-            return false;
-    }
-}
-
-/**
- * @brief Check if character is a printf length modifier (h, l, L)
- */
-static inline bool _is_printf_length_char(uint32_t ch) {
-    switch (ch) {
-        case 'h': case 'l': case 'L':
-            return true;
-        default:
-            return false;
-    }
-}
-
-/**
- * @brief Check if character is a printf type specifier
- */
-static inline bool _is_printf_type_char(uint32_t ch) {
-    switch (ch) {
-        case 'd': case 'i': case 'o': case 'u':
-        case 'x': case 'X': case 'e': case 'E':
-        case 'f': case 'F': case 'g': case 'G':
-        case 'c': case 'r': case 's': case 'a':
-            return true;
-        default:
-            return false;
-    }
-}
-
-/**
- * @brief parse_printf_positional(self, start_pos)
- *
- * Parse a positional printf-style placeholder starting at start_pos.
- * Returns a tuple: (end_pos, is_escape, star_count) where:
- *   - end_pos: Position after the placeholder (-1 if invalid)
- *   - is_escape: True if this is %% escape sequence
- *   - star_count: Number of * wildcards in width/precision
- */
-static PyObject* LStr_parse_printf_positional(LStrObject *self, PyObject *args, PyObject *kwds) {
-    static char *kwlist[] = {(char*)"start_pos", nullptr};
-    Py_ssize_t start_pos;
-
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n:parse_printf_positional", kwlist, &start_pos)) {
-        return nullptr;
-    }
-
-    if (!self || !self->buffer) {
-        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
-        return nullptr;
-    }
-    Buffer *buf = self->buffer;
-    Py_ssize_t length = (Py_ssize_t)buf->length();
-
-    if (start_pos < 0 || start_pos >= length) {
-        PyErr_SetString(PyExc_ValueError, "start_pos out of range");
-        return nullptr;
-    }
-
-    // Must start with %
-    if (buf->value(start_pos) != '%') {
-        PyErr_SetString(PyExc_ValueError, "start_pos must point to %");
-        return nullptr;
-    }
-
-    Py_ssize_t pos = start_pos + 1;
-    
-    if (pos >= length) {
-        return Py_BuildValue("(nOi)", -1, Py_False, 0);
-    }
-    
-    // Check for %% escape
-    if (buf->value(pos) == '%') {
-        return Py_BuildValue("(nOi)", pos + 1, Py_True, 0);
-    }
-    
-    int star_count = 0;
-    
-    // Parse flags: #, 0, -, space, +
-    while (pos < length && _is_printf_flag_char(buf->value(pos))) {
-        pos++;
-    }
-    
-    // Parse width: number or *
-    if (pos < length && buf->value(pos) == '*') {
-        star_count++;
-        pos++;
-    } else {
-        while (pos < length && buf->value(pos) >= '0' && buf->value(pos) <= '9') {
-            pos++;
-        }
-    }
-    
-    // Parse precision: .number or .*
-    if (pos < length && buf->value(pos) == '.') {
-        pos++;
-        if (pos < length && buf->value(pos) == '*') {
-            star_count++;
-            pos++;
-        } else {
-            while (pos < length && buf->value(pos) >= '0' && buf->value(pos) <= '9') {
-                pos++;
-            }
-        }
-    }
-    
-    // Parse length: h, l, L
-    if (pos < length && _is_printf_length_char(buf->value(pos))) {
-        pos++;
-    }
-    
-    // Parse type: d, i, o, u, x, X, e, E, f, F, g, G, c, r, s, a
-    if (pos < length && _is_printf_type_char(buf->value(pos))) {
-        return Py_BuildValue("(nOi)", pos + 1, Py_False, star_count);
-    }
-    
-    // Invalid placeholder
-    return Py_BuildValue("(nOi)", -1, Py_False, 0);
-}
-
-
-/**
- * @brief parse_printf_named(self, start_pos)
- *
- * Parse a named printf-style placeholder starting at start_pos.
- * Returns a tuple: (end_pos, is_escape, name_end) where:
- *   - end_pos: Position after the placeholder (-1 if invalid)
- *   - is_escape: True if this is %% escape sequence
- *   - name_end: Position after the closing ) of the name (-1 if not named)
- */
-static PyObject* LStr_parse_printf_named(LStrObject *self, PyObject *args, PyObject *kwds) {
-    static char *kwlist[] = {(char*)"start_pos", nullptr};
-    Py_ssize_t start_pos;
-
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n:parse_printf_named", kwlist, &start_pos)) {
-        return nullptr;
-    }
-
-    if (!self || !self->buffer) {
-        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
-        return nullptr;
-    }
-    Buffer *buf = self->buffer;
-    Py_ssize_t length = (Py_ssize_t)buf->length();
-
-    if (start_pos < 0 || start_pos >= length) {
-        PyErr_SetString(PyExc_ValueError, "start_pos out of range");
-        return nullptr;
-    }
-
-    // Must start with %
-    if (buf->value(start_pos) != '%') {
-        PyErr_SetString(PyExc_ValueError, "start_pos must point to %");
-        return nullptr;
-    }
-
-    Py_ssize_t pos = start_pos + 1;
-    
-    if (pos >= length) {
-        return Py_BuildValue("(nOn)", -1, Py_False, -1);
-    }
-    
-    // Check for %% escape
-    if (buf->value(pos) == '%') {
-        return Py_BuildValue("(nOn)", pos + 1, Py_True, -1);
-    }
-    
-    // Check for named placeholder: %(name)
-    Py_ssize_t name_end = -1;
-    if (buf->value(pos) == '(') {
-        pos++;
-        // Find closing )
-        while (pos < length && buf->value(pos) != ')') {
-            pos++;
-        }
-        if (pos >= length) {
-            return Py_BuildValue("(nOn)", -1, Py_False, -1);  // Unclosed (
-        }
-        pos++;  // Skip )
-        name_end = pos;
-    }
-    
-    // If not named, it's invalid for named placeholder parser
-    if (name_end == -1) {
-        return Py_BuildValue("(nOn)", -1, Py_False, -1);
-    }
-    
-    // Parse flags: #, 0, -, space, +
-    while (pos < length && _is_printf_flag_char(buf->value(pos))) {
-        pos++;
-    }
-    
-    // Parse width: number (no * for named)
-    while (pos < length && buf->value(pos) >= '0' && buf->value(pos) <= '9') {
-        pos++;
-    }
-    
-    // Parse precision: .number (no * for named)
-    if (pos < length && buf->value(pos) == '.') {
-        pos++;
-        while (pos < length && buf->value(pos) >= '0' && buf->value(pos) <= '9') {
-            pos++;
-        }
-    }
-    
-    // Parse length: h, l, L
-    if (pos < length && _is_printf_length_char(buf->value(pos))) {
-        pos++;
-    }
-    
-    // Parse type: d, i, o, u, x, X, e, E, f, F, g, G, c, r, s, a
-    if (pos < length && _is_printf_type_char(buf->value(pos))) {
-        return Py_BuildValue("(nOn)", pos + 1, Py_False, name_end);
-    }
-    
-    // Invalid placeholder
-    return Py_BuildValue("(nOn)", -1, Py_False, -1);
-}
-
-
-/**
- * @brief _parse_format_placeholder(self, start_pos)
- *
- * Parse a format() style placeholder or escape sequence starting at start_pos.
- * start_pos must point to { or } character.
- * 
- * Returns a tuple: (end_pos, token_type, content_end) where:
- *   - end_pos: Position after the token (-1 if invalid/unmatched)
- *   - token_type: 0=invalid, 1=literal_open ({{), 2=literal_close (}}), 3=placeholder
- *   - content_end: For placeholder - position before closing }, otherwise -1
- */
-static PyObject* LStr_parse_format_placeholder(LStrObject *self, PyObject *args, PyObject *kwds) {
-    static char *kwlist[] = {(char*)"start_pos", nullptr};
-    Py_ssize_t start_pos;
-
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n:_parse_format_placeholder", kwlist, &start_pos)) {
-        return nullptr;
-    }
-
-    if (!self || !self->buffer) {
-        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
-        return nullptr;
-    }
-    Buffer *buf = self->buffer;
-    Py_ssize_t length = (Py_ssize_t)buf->length();
-
-    if (start_pos < 0 || start_pos >= length) {
-        PyErr_SetString(PyExc_ValueError, "start_pos out of range");
-        return nullptr;
-    }
-
-    uint32_t ch = buf->value(start_pos);
-    
-    if (ch == '{') {
-        // Check for {{ escape
-        if (start_pos + 1 < length && buf->value(start_pos + 1) == '{') {
-            // Literal { escape sequence
-            return Py_BuildValue("(nii)", start_pos + 2, 1, -1);
-        }
-        
-        // Find matching } with nesting support
-        Py_ssize_t pos = start_pos + 1;
-        int depth = 1;
-        
-        while (pos < length && depth > 0) {
-            uint32_t c = buf->value(pos);
-            if (c == '{') {
-                depth++;
-            } else if (c == '}') {
-                depth--;
-            }
-            pos++;
-        }
-        
-        if (depth == 0) {
-            // Found complete placeholder: {content}
-            // content_end is position before closing }
-            return Py_BuildValue("(nii)", pos, 3, pos - 1);
-        } else {
-            // Unclosed brace - invalid
-            return Py_BuildValue("(nii)", -1, 0, -1);
-        }
-    } else if (ch == '}') {
-        // Check for }} escape
-        if (start_pos + 1 < length && buf->value(start_pos + 1) == '}') {
-            // Literal } escape sequence
-            return Py_BuildValue("(nii)", start_pos + 2, 2, -1);
-        } else {
-            // Unmatched } - invalid (caller should skip it)
-            return Py_BuildValue("(nii)", start_pos + 1, 0, -1);
-        }
-    } else {
-        PyErr_SetString(PyExc_ValueError, "start_pos must point to { or }");
-        return nullptr;
-    }
-}
-
-
-/**
- * @brief Find the end of a Python expression in an f-string placeholder.
- * 
- * Tracks nested brackets (), [], {} and quoted strings to find where the
- * expression ends (at : for format spec, ! for conversion, or } for end).
- * 
- * @param buf Buffer containing the format string
- * @param start Starting position (after opening {)
- * @param length Total buffer length
- * @return Position where expression ends, or -1 if not found
- */
-static Py_ssize_t _find_fstring_expr_end(Buffer* buf, Py_ssize_t start, Py_ssize_t length) {
-    int paren_depth = 0;
-    int bracket_depth = 0;
-    int brace_depth = 0;
-    bool in_string = false;
-    uint32_t quote_char = 0;
-    bool is_raw = false;
-    bool is_triple = false;
-    
-    for (Py_ssize_t i = start; i < length; i++) {
-        uint32_t ch = buf->value(i);
-        
-        // Handle string literals
-        if (!in_string) {
-            // Check for raw string prefix
-            if ((ch == 'r' || ch == 'R') && i + 1 < length) {
-                uint32_t next = buf->value(i + 1);
-                if (next == '\'' || next == '"') {
-                    is_raw = true;
-                    i++;
-                    ch = buf->value(i);
-                }
-            }
-            
-            // Check for string start
-            if (ch == '\'' || ch == '"') {
-                in_string = true;
-                quote_char = ch;
-                // Check for triple-quoted string
-                if (i + 2 < length && buf->value(i + 1) == ch && buf->value(i + 2) == ch) {
-                    is_triple = true;
-                    i += 2;
-                }
-                continue;
-            }
-        } else {
-            // Inside string - look for end
-            if (is_triple) {
-                // Triple-quoted string ends with three quotes
-                if (ch == quote_char && i + 2 < length && 
-                    buf->value(i + 1) == quote_char && buf->value(i + 2) == quote_char) {
-                    if (!is_raw || i == start || buf->value(i - 1) != '\\') {
-                        in_string = false;
-                        is_triple = false;
-                        is_raw = false;
-                        i += 2;
-                        continue;
-                    }
-                }
-            } else {
-                // Single-quoted string
-                if (ch == quote_char) {
-                    if (!is_raw || i == start || buf->value(i - 1) != '\\') {
-                        in_string = false;
-                        is_raw = false;
-                        continue;
-                    }
-                }
-            }
-            // Skip everything inside strings
-            continue;
-        }
-        
-        // Track bracket depth (only outside strings)
-        if (ch == '(') {
-            paren_depth++;
-        } else if (ch == ')') {
-            paren_depth--;
-            if (paren_depth < 0) return -1;  // Unbalanced
-        } else if (ch == '[') {
-            bracket_depth++;
-        } else if (ch == ']') {
-            bracket_depth--;
-            if (bracket_depth < 0) return -1;  // Unbalanced
-        } else if (ch == '{') {
-            brace_depth++;
-        } else if (ch == '}') {
-            // Closing brace at depth 0 ends the placeholder
-            if (brace_depth == 0 && paren_depth == 0 && bracket_depth == 0) {
-                return i;
-            }
-            brace_depth--;
-            if (brace_depth < 0) return -1;  // Unbalanced
-        } else if ((ch == ':' || ch == '!') && paren_depth == 0 && bracket_depth == 0 && brace_depth == 0) {
-            // Format spec or conversion at depth 0
-            return i;
-        }
-    }
-    
-    return -1;  // Unclosed expression
-}
-
-
-/**
- * @brief _parse_fformat_placeholder(self, start_pos)
- *
- * Parse an f-string style placeholder or escape sequence starting at start_pos.
- * start_pos must point to { or } character.
- * 
- * Returns a tuple: (end_pos, token_type, content_end, expr_end) where:
- *   - end_pos: Position after the token (-1 if invalid/unmatched)
- *   - token_type: 0=invalid, 1=literal {{ (open), 2=literal }} (close), 3=placeholder
- *   - content_end: For placeholder - position before closing }, otherwise -1
- *   - expr_end: For placeholder - position where expression ends (before : ! or }), otherwise -1
- */
-static PyObject* LStr_parse_fformat_placeholder(LStrObject *self, PyObject *args, PyObject *kwds) {
-    static char *kwlist[] = {(char*)"start_pos", nullptr};
-    Py_ssize_t start_pos;
-
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n:_parse_fformat_placeholder", kwlist, &start_pos)) {
-        return nullptr;
-    }
-
-    if (!self || !self->buffer) {
-        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
-        return nullptr;
-    }
-    Buffer *buf = self->buffer;
-    Py_ssize_t length = (Py_ssize_t)buf->length();
-
-    if (start_pos < 0 || start_pos >= length) {
-        PyErr_SetString(PyExc_ValueError, "start_pos out of range");
-        return nullptr;
-    }
-
-    uint32_t ch = buf->value(start_pos);
-    
-    if (ch == '{') {
-        // Check for {{ escape
-        if (start_pos + 1 < length && buf->value(start_pos + 1) == '{') {
-            // Literal { escape sequence
-            return Py_BuildValue("(niii)", start_pos + 2, 1, -1, -1);
-        }
-        
-        // Find end of expression
-        Py_ssize_t expr_end = _find_fstring_expr_end(buf, start_pos + 1, length);
-        
-        if (expr_end == -1) {
-            // Unclosed or invalid expression
-            return Py_BuildValue("(niii)", -1, 0, -1, -1);
-        }
-        
-        // Now find the actual closing }
-        Py_ssize_t pos = expr_end;
-        uint32_t end_ch = buf->value(pos);
-        
-        if (end_ch == '!') {
-            // Conversion: !r, !s, !a
-            pos++;
-            if (pos < length) {
-                uint32_t conv = buf->value(pos);
-                if (conv == 'r' || conv == 's' || conv == 'a') {
-                    pos++;
-                } else {
-                    // Invalid conversion
-                    return Py_BuildValue("(niii)", -1, 0, -1, -1);
-                }
-            }
-            // After conversion, might have format spec
-            if (pos < length && buf->value(pos) == ':') {
-                // Skip format spec (everything until })
-                while (pos < length && buf->value(pos) != '}') {
-                    pos++;
-                }
-            }
-        } else if (end_ch == ':') {
-            // Format spec - skip until }
-            pos++;
-            while (pos < length && buf->value(pos) != '}') {
-                pos++;
-            }
-        }
-        // end_ch == '}' - just close
-        
-        if (pos >= length || buf->value(pos) != '}') {
-            // Missing closing brace
-            return Py_BuildValue("(niii)", -1, 0, -1, -1);
-        }
-        
-        // Found complete placeholder: {expr[!conv][:spec]}
-        return Py_BuildValue("(niii)", pos + 1, 3, pos, expr_end);
-        
-    } else if (ch == '}') {
-        // Check for }} escape
-        if (start_pos + 1 < length && buf->value(start_pos + 1) == '}') {
-            // Literal } escape sequence
-            return Py_BuildValue("(niii)", start_pos + 2, 2, -1, -1);
-        } else {
-            // Unmatched } - invalid (caller should skip it)
-            return Py_BuildValue("(niii)", start_pos + 1, 0, -1, -1);
-        }
-    } else {
-        PyErr_SetString(PyExc_ValueError, "start_pos must point to { or }");
-        return nullptr;
-    }
-}
@@ -10,21 +10,31 @@
 #include <cppy/ptr.h>
 
 #include "lstring/lstring.hxx"
+#include "_lstring.hxx"
+#include "lstring_stats.hxx"
+#include "str_cache.hxx"
+#include "utf8_buffer.hxx"
 
 /**
  * @brief Module-local state structure used by the multi-phase init.
  */
 struct lstring_state {
     PyObject *LStrType;
+    PyObject *PatternType;
+    PyObject *BuilderType;
 };
 
 // The LStr_spec is defined in the implementation file for the type.
 extern PyType_Spec LStr_spec;
+// The LStrPattern_spec is defined in src/lstring_pattern.cxx.
+extern PyType_Spec LStrPattern_spec;
+// The LStrBuilder_spec is defined in src/lstring_builder.cxx.
+extern PyType_Spec LStrBuilder_spec;
 
 /**
  * @brief Global process-wide optimize threshold.
  */
-Py_ssize_t LStr_optimize_threshold = 0;
+std::atomic<Py_ssize_t> LStr_optimize_threshold(0);
 
 // Module-level accessors (exposed to Python).
 static PyObject* lstring_get_optimize_threshold(PyObject *self, PyObject *Py_UNUSED(ignored)) {
@@ -46,6 +56,222 @@ static PyObject* lstring_set_optimize_threshold(PyObject *self, PyObject *arg) {
     Py_RETURN_NONE;
 }
 
+/**
+ * @brief Global process-wide parallel materialization settings.
+ */
+std::atomic<Py_ssize_t> LStr_parallel_copy_threshold(0);
+std::atomic<Py_ssize_t> LStr_parallel_copy_threads(0);
+
+static PyObject* lstring_get_parallel_copy_threshold(PyObject *self, PyObject *Py_UNUSED(ignored)) {
+    return PyLong_FromSsize_t(LStr_parallel_copy_threshold);
+}
+
+static PyObject* lstring_set_parallel_copy_threshold(PyObject *self, PyObject *arg) {
+    if (arg == Py_None) {
+        LStr_parallel_copy_threshold = 0;
+        Py_RETURN_NONE;
+    }
+    if (!PyLong_Check(arg)) {
+        PyErr_SetString(PyExc_TypeError, "parallel_copy_threshold must be int or None");
+        return nullptr;
+    }
+    Py_ssize_t v = PyLong_AsSsize_t(arg);
+    if (v == -1 && PyErr_Occurred()) return nullptr;
+    LStr_parallel_copy_threshold = v;
+    Py_RETURN_NONE;
+}
+
+static PyObject* lstring_get_parallel_copy_threads(PyObject *self, PyObject *Py_UNUSED(ignored)) {
+    return PyLong_FromSsize_t(LStr_parallel_copy_threads);
+}
+
+static PyObject* lstring_set_parallel_copy_threads(PyObject *self, PyObject *arg) {
+    if (arg == Py_None) {
+        LStr_parallel_copy_threads = 0;
+        Py_RETURN_NONE;
+    }
+    if (!PyLong_Check(arg)) {
+        PyErr_SetString(PyExc_TypeError, "parallel_copy_threads must be int or None");
+        return nullptr;
+    }
+    Py_ssize_t v = PyLong_AsSsize_t(arg);
+    if (v == -1 && PyErr_Occurred()) return nullptr;
+    if (v < 0) {
+        PyErr_SetString(PyExc_ValueError, "parallel_copy_threads must be >= 0");
+        return nullptr;
+    }
+    LStr_parallel_copy_threads = v;
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief Global process-wide character class index threshold.
+ */
+std::atomic<Py_ssize_t> LStr_class_index_threshold(1 << 20);
+
+static PyObject* lstring_get_class_index_threshold(PyObject *self, PyObject *Py_UNUSED(ignored)) {
+    return PyLong_FromSsize_t(LStr_class_index_threshold);
+}
+
+static PyObject* lstring_set_class_index_threshold(PyObject *self, PyObject *arg) {
+    if (arg == Py_None) {
+        LStr_class_index_threshold = 0;
+        Py_RETURN_NONE;
+    }
+    if (!PyLong_Check(arg)) {
+        PyErr_SetString(PyExc_TypeError, "class_index_threshold must be int or None");
+        return nullptr;
+    }
+    Py_ssize_t v = PyLong_AsSsize_t(arg);
+    if (v == -1 && PyErr_Occurred()) return nullptr;
+    LStr_class_index_threshold = v;
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief Global process-wide automatic compaction policy.
+ */
+std::atomic<Py_ssize_t> LStr_compact_min_leaf(0);
+std::atomic<Py_ssize_t> LStr_compact_max_leaf(4096);
+
+static PyObject* lstring_get_compact_min_leaf(PyObject *self, PyObject *Py_UNUSED(ignored)) {
+    return PyLong_FromSsize_t(LStr_compact_min_leaf);
+}
+
+static PyObject* lstring_set_compact_min_leaf(PyObject *self, PyObject *arg) {
+    if (arg == Py_None) {
+        LStr_compact_min_leaf = 0;
+        Py_RETURN_NONE;
+    }
+    if (!PyLong_Check(arg)) {
+        PyErr_SetString(PyExc_TypeError, "compact_min_leaf must be int or None");
+        return nullptr;
+    }
+    Py_ssize_t v = PyLong_AsSsize_t(arg);
+    if (v == -1 && PyErr_Occurred()) return nullptr;
+    LStr_compact_min_leaf = v;
+    Py_RETURN_NONE;
+}
+
+static PyObject* lstring_get_compact_max_leaf(PyObject *self, PyObject *Py_UNUSED(ignored)) {
+    return PyLong_FromSsize_t(LStr_compact_max_leaf);
+}
+
+static PyObject* lstring_set_compact_max_leaf(PyObject *self, PyObject *arg) {
+    if (!PyLong_Check(arg)) {
+        PyErr_SetString(PyExc_TypeError, "compact_max_leaf must be int");
+        return nullptr;
+    }
+    Py_ssize_t v = PyLong_AsSsize_t(arg);
+    if (v == -1 && PyErr_Occurred()) return nullptr;
+    if (v < 1) {
+        PyErr_SetString(PyExc_ValueError, "compact_max_leaf must be >= 1");
+        return nullptr;
+    }
+    LStr_compact_max_leaf = v;
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief Global process-wide str() cache limit, in bytes (disabled by default).
+ */
+std::atomic<Py_ssize_t> LStr_str_cache_limit(0);
+
+static PyObject* lstring_get_str_cache_limit(PyObject *self, PyObject *Py_UNUSED(ignored)) {
+    return PyLong_FromSsize_t(LStr_str_cache_limit);
+}
+
+static PyObject* lstring_set_str_cache_limit(PyObject *self, PyObject *arg) {
+    Py_ssize_t v = 0;
+    if (arg != Py_None) {
+        if (!PyLong_Check(arg)) {
+            PyErr_SetString(PyExc_TypeError, "str_cache_limit must be int or None");
+            return nullptr;
+        }
+        v = PyLong_AsSsize_t(arg);
+        if (v == -1 && PyErr_Occurred()) return nullptr;
+    }
+    LStr_str_cache_limit = v;
+    StrCache::trim();
+    Py_RETURN_NONE;
+}
+
+static PyObject* lstring_clear_str_cache(PyObject *self, PyObject *Py_UNUSED(ignored)) {
+    StrCache::clear();
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief Global process-wide instrumentation counters (disabled by default).
+ */
+LStrStats LStr_stats;
+
+static_assert(LStrStats::MAX_CLASS_ID == Utf8Buffer::buffer_class_id,
+              "LStrStats::MAX_CLASS_ID must be the highest buffer_class_id");
+
+/** Names of the node classes reported by stats(), by buffer_class_id. */
+static const char* const stats_class_names[LStrStats::MAX_CLASS_ID + 1] = {
+    nullptr, "Buffer", "StrBuffer", "Str8Buffer", "Str16Buffer", "Str32Buffer",
+    "Slice1Buffer", "SliceBuffer", "MulBuffer", "JoinBuffer", "MapBuffer",
+    "InlineBuffer", "MultiJoinBuffer", "MmapBuffer", "Utf8Buffer",
+};
+
+static PyObject* lstring_get_stats_enabled(PyObject *self, PyObject *Py_UNUSED(ignored)) {
+    return PyBool_FromLong(stats_enabled());
+}
+
+static PyObject* lstring_set_stats_enabled(PyObject *self, PyObject *arg) {
+    int flag = PyObject_IsTrue(arg);
+    if (flag < 0) return nullptr;
+    LStr_stats.enabled.store(flag != 0, std::memory_order_relaxed);
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief Add `name: value` to dict; returns false with an exception set on failure.
+ */
+static bool stats_item(PyObject *dict, const char *name, const std::atomic<uint64_t>& value) {
+    cppy::ptr number(PyLong_FromUnsignedLongLong(value.load(std::memory_order_relaxed)));
+    return number && PyDict_SetItemString(dict, name, number.get()) == 0;
+}
+
+static PyObject* lstring_stats(PyObject *self, PyObject *Py_UNUSED(ignored)) {
+    cppy::ptr result(PyDict_New());
+    cppy::ptr nodes(PyDict_New());
+    if (!result || !nodes) return nullptr;
+    if (PyDict_SetItemString(result.get(), "enabled", stats_enabled() ? Py_True : Py_False) < 0) return nullptr;
+    for (int id = 1; id <= LStrStats::MAX_CLASS_ID; ++id) {
+        if (LStr_stats.nodes[id].load(std::memory_order_relaxed) == 0) continue;
+        if (!stats_item(nodes.get(), stats_class_names[id], LStr_stats.nodes[id])) return nullptr;
+    }
+    if (PyDict_SetItemString(result.get(), "nodes", nodes.get()) < 0) return nullptr;
+    if (!stats_item(result.get(), "optimize_collapses", LStr_stats.optimize_collapses) ||
+        !stats_item(result.get(), "materializations", LStr_stats.materializations) ||
+        !stats_item(result.get(), "materialized_bytes", LStr_stats.materialized_bytes) ||
+        !stats_item(result.get(), "find_indexed", LStr_stats.find_indexed) ||
+        !stats_item(result.get(), "find_str", LStr_stats.find_str) ||
+        !stats_item(result.get(), "find_scan", LStr_stats.find_scan) ||
+        !stats_item(result.get(), "str_cache_hits", LStr_stats.str_cache_hits) ||
+        !stats_item(result.get(), "str_cache_evictions", LStr_stats.str_cache_evictions) ||
+        !stats_item(result.get(), "concat_rotations", LStr_stats.concat_rotations) ||
+        !stats_item(result.get(), "max_height", LStr_stats.max_height)) {
+        return nullptr;
+    }
+    return result.release();
+}
+
+static PyObject* lstring_reset_stats(PyObject *self, PyObject *Py_UNUSED(ignored)) {
+    for (auto& counter : LStr_stats.nodes) counter.store(0, std::memory_order_relaxed);
+    for (std::atomic<uint64_t>* counter : {&LStr_stats.optimize_collapses, &LStr_stats.materializations,
+                                           &LStr_stats.materialized_bytes, &LStr_stats.find_indexed,
+                                           &LStr_stats.find_str, &LStr_stats.find_scan,
+                                           &LStr_stats.str_cache_hits, &LStr_stats.str_cache_evictions,
+                                           &LStr_stats.concat_rotations, &LStr_stats.max_height}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+    Py_RETURN_NONE;
+}
+
 /* Per-module state is declared in lstring.hxx; provide the definition
  * for the getter so other translation units can call it.
  */
@@ -57,19 +283,41 @@ inline static lstring_state* get_lstring_state(PyObject *module) {
 static PyMethodDef lstring_module_methods[] = {
     {"get_optimize_threshold", (PyCFunction)lstring_get_optimize_threshold, METH_NOARGS, "Get global C optimize threshold (process-global)"},
     {"set_optimize_threshold", (PyCFunction)lstring_set_optimize_threshold, METH_O, "Set global C optimize threshold (process-global)"},
+    {"get_parallel_copy_threshold", (PyCFunction)lstring_get_parallel_copy_threshold, METH_NOARGS, "Get the length from which str() copies with several threads (process-global)"},
+    {"set_parallel_copy_threshold", (PyCFunction)lstring_set_parallel_copy_threshold, METH_O, "Set the length from which str() copies with several threads (process-global)"},
+    {"get_parallel_copy_threads", (PyCFunction)lstring_get_parallel_copy_threads, METH_NOARGS, "Get the number of threads used by a parallel str() copy (process-global)"},
+    {"set_parallel_copy_threads", (PyCFunction)lstring_set_parallel_copy_threads, METH_O, "Set the number of threads used by a parallel str() copy (process-global)"},
+    {"get_class_index_threshold", (PyCFunction)lstring_get_class_index_threshold, METH_NOARGS, "Get the str length from which class searches use a block index (process-global)"},
+    {"set_class_index_threshold", (PyCFunction)lstring_set_class_index_threshold, METH_O, "Set the str length from which class searches use a block index (process-global)"},
+    {"get_compact_min_leaf", (PyCFunction)lstring_get_compact_min_leaf, METH_NOARGS, "Get the leaf length below which concatenation merges leaves (process-global)"},
+    {"set_compact_min_leaf", (PyCFunction)lstring_set_compact_min_leaf, METH_O, "Set the leaf length below which concatenation merges leaves; 0 or None disables (process-global)"},
+    {"get_compact_max_leaf", (PyCFunction)lstring_get_compact_max_leaf, METH_NOARGS, "Get the longest leaf built by automatic compaction (process-global)"},
+    {"set_compact_max_leaf", (PyCFunction)lstring_set_compact_max_leaf, METH_O, "Set the longest leaf built by automatic compaction (process-global)"},
+    {"get_str_cache_limit", (PyCFunction)lstring_get_str_cache_limit, METH_NOARGS, "Get the byte limit of the str() materialization cache (process-global)"},
+    {"set_str_cache_limit", (PyCFunction)lstring_set_str_cache_limit, METH_O, "Set the byte limit of the str() materialization cache; 0 or None disables (process-global)"},
+    {"clear_str_cache", (PyCFunction)lstring_clear_str_cache, METH_NOARGS, "Drop every entry of the str() materialization cache"},
+    {"get_stats_enabled", (PyCFunction)lstring_get_stats_enabled, METH_NOARGS, "Whether the instrumentation counters of stats() are updated (process-global)"},
+    {"set_stats_enabled", (PyCFunction)lstring_set_stats_enabled, METH_O, "Turn the instrumentation counters of stats() on or off (process-global)"},
+    {"stats", (PyCFunction)lstring_stats, METH_NOARGS, "Return a dict of the instrumentation counters"},
+    {"reset_stats", (PyCFunction)lstring_reset_stats, METH_NOARGS, "Reset the instrumentation counters to zero"},
     {nullptr, nullptr, 0, nullptr}
 };
 
 // GC callbacks
 static int lstring_traverse(PyObject *module, visitproc visit, void *arg) {
     lstring_state *st = get_lstring_state(module);
-    if (st && st->LStrType) return visit(st->LStrType, arg);
+    if (!st) return 0;
+    Py_VISIT(st->LStrType);
+    Py_VISIT(st->PatternType);
+    Py_VISIT(st->BuilderType);
     return 0;
 }
 
 static int lstring_clear(PyObject *module) {
     lstring_state *st = get_lstring_state(module);
     Py_CLEAR(st->LStrType);
+    Py_CLEAR(st->PatternType);
+    Py_CLEAR(st->BuilderType);
     return 0;
 }
 
@@ -89,6 +337,20 @@ static int lstring_mod_exec(PyObject *module) {
         return -1;
     }
 
+    PyObject *pattern_type = PyType_FromSpec(&LStrPattern_spec);
+    if (!pattern_type) return -1;
+    st->PatternType = pattern_type;
+    if (PyModule_AddObjectRef(module, "Pattern", st->PatternType) < 0) {
+        return -1;
+    }
+
+    PyObject *builder_type = PyType_FromSpec(&LStrBuilder_spec);
+    if (!builder_type) return -1;
+    st->BuilderType = builder_type;
+    if (PyModule_AddObjectRef(module, "Builder", st->BuilderType) < 0) {
+        return -1;
+    }
+
     // Add CharClass constants
     if (PyModule_AddIntConstant(module, "CHAR_SPACE", CHAR_SPACE) < 0) return -1;
     if (PyModule_AddIntConstant(module, "CHAR_ALPHA", CHAR_ALPHA) < 0) return -1;
@@ -109,6 +371,11 @@ static int lstring_mod_exec(PyObject *module) {
  */
 static PyModuleDef_Slot lstring_slots[] = {
     {Py_mod_exec,   (void*)lstring_mod_exec},
+#ifdef Py_mod_gil
+    // Buffers are immutable, their caches and the module settings are
+    // atomics and iterators lock themselves, so no GIL is needed.
+    {Py_mod_gil,    Py_MOD_GIL_NOT_USED},
+#endif
     {0, nullptr}
 };
 
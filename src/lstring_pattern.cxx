@@ -0,0 +1,129 @@
+/**
+ * @file lstring_pattern.cxx
+ * @brief Implementation of `_lstring.Pattern` - a compiled search needle.
+ */
+
+#include <Python.h>
+
+#include "_lstring.hxx"
+#include "lstring_pattern.hxx"
+#include "lstring_utils.hxx"
+#include "tptr.hxx"
+#include <cppy/cppy.h>
+
+static PyObject* LStrPattern_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
+static void LStrPattern_dealloc(LStrPatternObject *self);
+static PyObject* LStrPattern_repr(LStrPatternObject *self);
+static Py_ssize_t LStrPattern_length(LStrPatternObject *self);
+static PyObject* LStrPattern_get_needle(LStrPatternObject *self, void *closure);
+
+bool LStrPattern_Check(PyObject *obj) {
+    return Py_TYPE(obj)->tp_dealloc == (destructor)LStrPattern_dealloc;
+}
+
+const FullCharSet& LStrPattern_charset(LStrPatternObject *pattern) {
+    if (!pattern->charset) {
+        pattern->charset = new FullCharSet(*pattern->needle->buffer);
+    }
+    return *pattern->charset;
+}
+
+/**
+ * @brief Pattern(needle): compile a str or L needle.
+ */
+static PyObject* LStrPattern_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {(char*)"needle", nullptr};
+    PyObject *needle_obj = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O:Pattern", kwlist, &needle_obj)) {
+        return nullptr;
+    }
+
+    cppy::ptr lstr_type(get_string_lstr_type());
+    if (!lstr_type) return nullptr;
+
+    tptr<LStrObject> needle;
+    if (PyUnicode_Check(needle_obj)) {
+        needle = tptr<LStrObject>(make_lstr_from_pystr((PyTypeObject*)lstr_type.get(), needle_obj));
+        if (!needle) return nullptr;
+    } else if (PyObject_IsInstance(needle_obj, lstr_type.get()) == 1) {
+        needle = tptr<LStrObject>(needle_obj, true);
+        if (!needle->buffer) {
+            PyErr_SetString(PyExc_RuntimeError, "needle L has no buffer");
+            return nullptr;
+        }
+    } else {
+        PyErr_SetString(PyExc_TypeError, "needle must be str or L");
+        return nullptr;
+    }
+
+    tptr<LStrPatternObject> self((LStrPatternObject*)type->tp_alloc(type, 0));
+    if (!self) return nullptr;
+    try {
+        self->forward = new SubstringSearch(needle->buffer);
+        self->reverse = new SubstringSearch(needle->buffer, /*reverse=*/true);
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    self->needle = needle.release();
+    return (PyObject*)self.release();
+}
+
+static void LStrPattern_dealloc(LStrPatternObject *self) {
+    delete self->forward;
+    delete self->reverse;
+    delete self->charset;
+    self->forward = nullptr;
+    self->reverse = nullptr;
+    self->charset = nullptr;
+    Py_CLEAR(self->needle);
+    PyTypeObject *tp = Py_TYPE(self);
+    tp->tp_free(self);
+    Py_DECREF(tp);
+}
+
+static PyObject* LStrPattern_repr(LStrPatternObject *self) {
+    if (!self->needle) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid Pattern object");
+        return nullptr;
+    }
+    return PyUnicode_FromFormat("Pattern(%R)", (PyObject*)self->needle);
+}
+
+static Py_ssize_t LStrPattern_length(LStrPatternObject *self) {
+    return self->forward ? self->forward->length() : 0;
+}
+
+static PyObject* LStrPattern_get_needle(LStrPatternObject *self, void *closure) {
+    if (!self->needle) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid Pattern object");
+        return nullptr;
+    }
+    return cppy::incref((PyObject*)self->needle);
+}
+
+static PyGetSetDef LStrPattern_getset[] = {
+    {"needle", (getter)LStrPattern_get_needle, nullptr, "The compiled needle as L", nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}
+};
+
+static PyType_Slot LStrPattern_slots[] = {
+    {Py_tp_new, (void*)LStrPattern_new},
+    {Py_tp_dealloc, (void*)LStrPattern_dealloc},
+    {Py_tp_repr, (void*)LStrPattern_repr},
+    {Py_sq_length, (void*)LStrPattern_length},
+    {Py_tp_getset, (void*)LStrPattern_getset},
+    {Py_tp_doc, (void*)"Pattern(needle)\n--\n\n"
+        "Compiled needle for repeated searches. Accepted by find, rfind, "
+        "find_iter, rfind_iter, count, replace, split and rsplit as a "
+        "substring, and by findcs/rfindcs as a character set."},
+    {0, nullptr}
+};
+
+PyType_Spec LStrPattern_spec = {
+    "_lstring.Pattern",
+    sizeof(LStrPatternObject),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    LStrPattern_slots
+};
@@ -0,0 +1,42 @@
+#ifndef LSTRING_PATTERN_HXX
+#define LSTRING_PATTERN_HXX
+
+#include <Python.h>
+
+#include "lstring/lstring.hxx"
+#include "charset.hxx"
+#include "substring_search.hxx"
+
+/**
+ * @brief Compiled needle shared by repeated searches.
+ *
+ * A Pattern keeps an L for the needle together with the search state that
+ * find-like methods would otherwise rebuild on every call: forward and
+ * reverse SubstringSearch engines, and (built on first use) the
+ * FullCharSet of its characters for findcs/rfindcs.
+ */
+struct LStrPatternObject {
+    PyObject_HEAD
+    LStrObject *needle;       /* owned reference */
+    SubstringSearch *forward;
+    SubstringSearch *reverse;
+    FullCharSet *charset;     /* nullptr until first used as a character set */
+};
+
+/** Type spec of `_lstring.Pattern` (defined in src/lstring_pattern.cxx). */
+extern PyType_Spec LStrPattern_spec;
+
+/**
+ * @brief Check whether obj is a Pattern instance.
+ */
+bool LStrPattern_Check(PyObject *obj);
+
+/**
+ * @brief Return the charset of the pattern characters, building it on
+ *        first use.
+ *
+ * May throw std::bad_alloc.
+ */
+const FullCharSet& LStrPattern_charset(LStrPatternObject *pattern);
+
+#endif // LSTRING_PATTERN_HXX
@@ -0,0 +1,563 @@
+/**
+ * @file lstring_split.cxx
+ * @brief Native split, rsplit and splitlines for `L`, and their iterators.
+ *
+ * The pieces are found by a SplitScanner that works directly on the
+ * buffer: separators with the substring search engine, whitespace with the
+ * character class table and line breaks with the byte set kernels, all over
+ * the leaf spans. Every piece is a slice view of the source, created like
+ * `self[start:end]`.
+ */
+
+#include <Python.h>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "lstring/lstring.hxx"
+#include "_lstring.hxx"
+#include "char_class_table.hxx"
+#include "lstring_pattern.hxx"
+#include "lstring_utils.hxx"
+#include "simd.hxx"
+#include "span.hxx"
+#include "substring_search.hxx"
+#include "tptr.hxx"
+
+namespace {
+
+/**
+ * @brief Whether a code point ends a line for str.splitlines.
+ */
+inline bool is_line_break(uint32_t ch) {
+    return (ch >= 0x0A && ch <= 0x0D) || (ch >= 0x1C && ch <= 0x1E) ||
+           ch == 0x85 || ch == 0x2028 || ch == 0x2029;
+}
+
+/**
+ * @brief Byte set of the Latin-1 line breaks, for the vector kernels.
+ */
+const ByteSetTables& line_break_bytes() {
+    static const ByteSetTables set = [] {
+        ByteSetTables s{};
+        for (uint32_t ch = 0; ch < 0x100; ++ch) {
+            if (is_line_break(ch)) s.add(ch);
+        }
+        return s;
+    }();
+    return set;
+}
+
+/**
+ * @brief Incremental splitter over a buffer.
+ *
+ * The remaining part of the source is [start, end); forward modes consume
+ * it from the left, reverse modes from the right. next() reports the
+ * pieces in the order str.split / str.rsplit / str.splitlines produce them
+ * (right to left for the reverse modes). It uses no Python API, so a whole
+ * split can run with the GIL released.
+ */
+struct SplitScanner {
+    enum Mode {
+        SPLIT_SEP,          // split on a substring
+        SPLIT_WHITESPACE,   // split on runs of whitespace
+        SPLIT_LINES,        // split on line boundaries
+    };
+
+    const Buffer* src;
+    const SubstringSearch* search;  // SPLIT_SEP only
+    Mode mode;
+    bool reverse;
+    bool keepends;                  // SPLIT_LINES only
+    Py_ssize_t start;
+    Py_ssize_t end;
+    Py_ssize_t splits_left;         // < 0: unlimited
+    bool done;
+
+    void init(const Buffer* buf, const SubstringSearch* sep_search, Mode split_mode,
+              bool from_right, Py_ssize_t maxsplit, bool keep_ends) {
+        src = buf;
+        search = sep_search;
+        mode = split_mode;
+        reverse = from_right;
+        keepends = keep_ends;
+        start = 0;
+        end = buf->length();
+        splits_left = maxsplit;
+        // Like str.splitlines, an empty source has no lines.
+        done = mode == SPLIT_LINES && end == 0;
+    }
+
+    /**
+     * @brief Report the next piece as [piece_start, piece_end).
+     * @return false once all pieces have been reported.
+     */
+    bool next(Py_ssize_t& piece_start, Py_ssize_t& piece_end) {
+        if (done) return false;
+        switch (mode) {
+            case SPLIT_SEP:
+                return next_sep(piece_start, piece_end);
+            case SPLIT_WHITESPACE:
+                return reverse ? prev_word(piece_start, piece_end) : next_word(piece_start, piece_end);
+            default:
+                return next_line(piece_start, piece_end);
+        }
+    }
+
+private:
+    bool next_sep(Py_ssize_t& piece_start, Py_ssize_t& piece_end) {
+        Py_ssize_t found = splits_left == 0 ? -1 : search->find(src, start, end);
+        if (found < 0) {
+            // The rest of the source is the last piece.
+            piece_start = start;
+            piece_end = end;
+            done = true;
+            return true;
+        }
+        if (splits_left > 0) --splits_left;
+        if (reverse) {
+            piece_start = found + search->length();
+            piece_end = end;
+            end = found;
+        } else {
+            piece_start = start;
+            piece_end = found;
+            start = found + search->length();
+        }
+        return true;
+    }
+
+    bool next_word(Py_ssize_t& piece_start, Py_ssize_t& piece_end) {
+        if (splits_left == 0) {
+            // The rest, without its leading whitespace, is the last piece.
+            done = true;
+            piece_start = src->findcc(start, end, CHAR_SPACE, true);
+            piece_end = end;
+            return piece_start != -1;
+        }
+        const CharClassTable& classes = char_class_table();
+        Py_ssize_t word = -1;
+        Py_ssize_t space = -1;
+        Py_ssize_t pos = start;
+        for_each_span(*src, start, end, [&](const BufferSpan& span) {
+            with_span_data(span, [&](auto data, Py_ssize_t n) {
+                Py_ssize_t k = 0;
+                if (word == -1) {
+                    while (k < n && classes.is(data[k], CHAR_SPACE)) ++k;
+                    if (k == n) return;
+                    word = pos + k;
+                }
+                while (k < n && !classes.is(data[k], CHAR_SPACE)) ++k;
+                if (k < n) space = pos + k;
+            });
+            pos += span.length;
+            return space == -1;
+        });
+        if (word == -1) {
+            done = true;
+            return false;
+        }
+        if (space == -1) space = end;
+        if (splits_left > 0) --splits_left;
+        piece_start = word;
+        piece_end = space;
+        start = space;
+        return true;
+    }
+
+    bool prev_word(Py_ssize_t& piece_start, Py_ssize_t& piece_end) {
+        if (splits_left == 0) {
+            // The rest, without its trailing whitespace, is the last piece.
+            done = true;
+            Py_ssize_t last = src->rfindcc(start, end, CHAR_SPACE, true);
+            piece_start = start;
+            piece_end = last + 1;
+            return last != -1;
+        }
+        const CharClassTable& classes = char_class_table();
+        Py_ssize_t word_end = -1;
+        Py_ssize_t word_start = -1;
+        Py_ssize_t pos = end;
+        for_each_span_reverse(*src, start, end, [&](const BufferSpan& span) {
+            pos -= span.length;
+            with_span_data(span, [&](auto data, Py_ssize_t n) {
+                Py_ssize_t k = n;
+                if (word_end == -1) {
+                    while (k > 0 && classes.is(data[k - 1], CHAR_SPACE)) --k;
+                    if (k == 0) return;
+                    word_end = pos + k;
+                }
+                while (k > 0 && !classes.is(data[k - 1], CHAR_SPACE)) --k;
+                if (k > 0) word_start = pos + k;
+            });
+            return word_start == -1;
+        });
+        if (word_end == -1) {
+            done = true;
+            return false;
+        }
+        if (word_start == -1) word_start = start;
+        if (splits_left > 0) --splits_left;
+        piece_start = word_start;
+        piece_end = word_end;
+        end = word_start;
+        return true;
+    }
+
+    bool next_line(Py_ssize_t& piece_start, Py_ssize_t& piece_end) {
+        if (start >= end) {
+            done = true;
+            return false;
+        }
+        Py_ssize_t found = span_find_first(*src, start, end, [](const BufferSpan& span) -> Py_ssize_t {
+            if (span.kind == PyUnicode_1BYTE_KIND) {
+                return simd_find_byteset(static_cast<const Py_UCS1*>(span.data), span.length,
+                                         line_break_bytes(), false);
+            }
+            return with_span_data(span, [](auto data, Py_ssize_t n) -> Py_ssize_t {
+                for (Py_ssize_t k = 0; k < n; ++k) {
+                    if (is_line_break(data[k])) return k;
+                }
+                return -1;
+            });
+        });
+        piece_start = start;
+        if (found < 0) {
+            piece_end = end;
+            start = end;
+            return true;
+        }
+        Py_ssize_t break_len = 1;
+        if (src->value(found) == '\r' && found + 1 < end && src->value(found + 1) == '\n') {
+            break_len = 2;
+        }
+        piece_end = keepends ? found + break_len : found;
+        start = found + break_len;
+        return true;
+    }
+};
+
+/**
+ * @brief Arguments of a split call resolved to a scanner configuration.
+ *
+ * Owns the separator L, the Pattern it came from (if any) and the search
+ * engine, which is borrowed from the Pattern or built here.
+ */
+struct SplitSource {
+    tptr<LStrObject> sep;
+    cppy::ptr pattern;
+    const SubstringSearch* search = nullptr;
+    SubstringSearch* owned_search = nullptr;
+
+    SplitSource() = default;
+    SplitSource(const SplitSource&) = delete;
+    SplitSource& operator=(const SplitSource&) = delete;
+
+    ~SplitSource() {
+        delete owned_search;
+    }
+
+    /**
+     * @brief Resolve `sep` (None, str, L or Pattern) for a forward or
+     *        reverse split.
+     * @return 0 on success, -1 with a Python exception set.
+     */
+    int parse(LStrObject *self, PyObject *sep_obj, bool reverse, const char *name) {
+        if (sep_obj == Py_None) return 0;
+        if (LStrPattern_Check(sep_obj)) {
+            LStrPatternObject *pat = (LStrPatternObject*)sep_obj;
+            pattern = cppy::ptr(sep_obj, true);
+            sep = tptr<LStrObject>(pat->needle, true);
+            search = reverse ? pat->reverse : pat->forward;
+        } else if (PyUnicode_Check(sep_obj)) {
+            sep = tptr<LStrObject>(make_lstr_from_pystr(Py_TYPE(self), sep_obj));
+            if (!sep) return -1;
+        } else if (PyObject_IsInstance(sep_obj, (PyObject*)get_base_l_type(Py_TYPE(self))) == 1) {
+            sep = tptr<LStrObject>(sep_obj, true);
+        } else {
+            PyErr_Format(PyExc_TypeError, "%s() argument must be str, L or Pattern, not %.100s",
+                         name, Py_TYPE(sep_obj)->tp_name);
+            return -1;
+        }
+        if (!sep->buffer) {
+            PyErr_SetString(PyExc_RuntimeError, "separator L has no buffer");
+            return -1;
+        }
+        if (sep->buffer->length() == 0) {
+            PyErr_SetString(PyExc_ValueError, "empty separator");
+            return -1;
+        }
+        if (!search) {
+            try {
+                owned_search = new SubstringSearch(sep->buffer, reverse);
+            } catch (const std::exception &e) {
+                PyErr_SetString(PyExc_RuntimeError, e.what());
+                return -1;
+            }
+            search = owned_search;
+        }
+        return 0;
+    }
+
+    SplitScanner::Mode mode() const {
+        return search ? SplitScanner::SPLIT_SEP : SplitScanner::SPLIT_WHITESPACE;
+    }
+};
+
+/**
+ * @brief Run a scanner to completion and build the list of pieces.
+ *
+ * The boundaries are collected first (with the GIL released for long
+ * sources), so the list is created at its final size.
+ */
+PyObject* collect_pieces(LStrObject *self, SplitScanner& scanner) {
+    std::vector<std::pair<Py_ssize_t, Py_ssize_t>> bounds;
+    try {
+        scan_without_gil(self->buffer->length(), [&] {
+            Py_ssize_t s, e;
+            while (scanner.next(s, e)) bounds.emplace_back(s, e);
+            return 0;
+        });
+    } catch (const std::bad_alloc&) {
+        return PyErr_NoMemory();
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+
+    Py_ssize_t count = (Py_ssize_t)bounds.size();
+    cppy::ptr list(PyList_New(count));
+    if (!list) return nullptr;
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        // Reverse scans report the pieces right to left.
+        const auto& b = bounds[scanner.reverse ? count - 1 - i : i];
+        PyObject *piece = make_lstr_slice(self, b.first, b.second);
+        if (!piece) return nullptr;
+        PyList_SET_ITEM(list.get(), i, piece);
+    }
+    return list.release();
+}
+
+/**
+ * @brief Parse the (sep, maxsplit) arguments of split/rsplit.
+ */
+bool parse_split_args(PyObject *args, PyObject *kwds, const char *format,
+                      PyObject *&sep_obj, Py_ssize_t &maxsplit) {
+    static char *kwlist[] = {(char*)"sep", (char*)"maxsplit", nullptr};
+    sep_obj = Py_None;
+    maxsplit = -1;
+    return PyArg_ParseTupleAndKeywords(args, kwds, format, kwlist, &sep_obj, &maxsplit) != 0;
+}
+
+bool check_self(LStrObject *self) {
+    if (!self || !self->buffer) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L object");
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+/* Iterator over split pieces */
+
+/**
+ * Iterator produced by `split_iter`, `rsplit_iter` and `splitlines_iter`.
+ *
+ * Holds an owned reference to the source and the separator state, and
+ * resumes its scanner on every step. The iterator type is created on
+ * demand and cached on the `L` type object, like the find iterator.
+ */
+struct LStrSplitIterObject {
+    PyObject_HEAD
+    LStrObject *source;       /* owned reference */
+    SplitSource *sep;         /* owned */
+    SplitScanner scanner;
+};
+
+static void LStrSplitIter_dealloc(PyObject *it_obj) {
+    LStrSplitIterObject *it = (LStrSplitIterObject*)it_obj;
+    delete it->sep;
+    it->sep = nullptr;
+    if (it->source) {
+        cppy::decref(it->source);
+        it->source = nullptr;
+    }
+    PyTypeObject *tp = Py_TYPE(it_obj);
+    tp->tp_free(it_obj);
+}
+
+static PyObject* LStrSplitIter_next_locked(PyObject *it_obj) {
+    LStrSplitIterObject *it = (LStrSplitIterObject*)it_obj;
+    if (!it->source || !it->sep) {
+        PyErr_SetString(PyExc_RuntimeError, "invalid L split iterator");
+        return nullptr;
+    }
+    Py_ssize_t start, end;
+    try {
+        if (!it->scanner.next(start, end)) {
+            PyErr_SetNone(PyExc_StopIteration);
+            return nullptr;
+        }
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    return make_lstr_slice(it->source, start, end);
+}
+
+static PyObject* LStrSplitIter_iternext(PyObject *it_obj) {
+    // The scanner state changes on every step; threads sharing the
+    // iterator take turns.
+    PyObject *result;
+    Py_BEGIN_CRITICAL_SECTION(it_obj);
+    result = LStrSplitIter_next_locked(it_obj);
+    Py_END_CRITICAL_SECTION();
+    return result;
+}
+
+PyType_Slot LStrSplitIter_slots[] = {
+    {Py_tp_dealloc, (void*)LStrSplitIter_dealloc},
+    {Py_tp_iternext, (void*)LStrSplitIter_iternext},
+    {Py_tp_iter, (void*)PyObject_SelfIter},
+    {Py_tp_doc, (void*)"Iterator over the pieces of a split L."},
+    {0, nullptr}
+};
+
+PyType_Spec LStrSplitIter_spec = {
+    "_lstring._lstr_split_iterator",
+    sizeof(LStrSplitIterObject),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    LStrSplitIter_slots
+};
+
+/**
+ * @brief Create a split iterator for self; takes ownership of `sep`.
+ */
+static PyObject* make_split_iter(LStrObject *self, SplitSource *sep, SplitScanner::Mode mode,
+                                 bool reverse, Py_ssize_t maxsplit, bool keepends) {
+    std::unique_ptr<SplitSource> sep_owner(sep);
+    PyTypeObject *lstr_type = get_base_l_type(Py_TYPE(self));
+
+    // Try to get cached iterator type from the L type object
+    tptr<PyTypeObject> it_type(PyObject_GetAttrString((PyObject*)lstr_type, "_split_iterator_type"));
+    if (!it_type) {
+        PyErr_Clear();
+
+        it_type = tptr<PyTypeObject>(PyType_FromSpec(&LStrSplitIter_spec));
+        if (!it_type) return nullptr;
+
+        // Cache iterator type on the L heap type object for reuse.
+        if (PyObject_SetAttrString((PyObject*)lstr_type, "_split_iterator_type", it_type.ptr().get()) < 0) {
+            return nullptr;
+        }
+    }
+
+    tptr<LStrSplitIterObject> it_obj(PyObject_CallObject(it_type.ptr().get(), nullptr));
+    if (!it_obj) return nullptr;
+
+    it_obj->source = (LStrObject*)cppy::incref((PyObject*)self);
+    it_obj->sep = sep_owner.release();
+    it_obj->scanner.init(self->buffer, it_obj->sep->search, mode, reverse, maxsplit, keepends);
+    return it_obj.ptr().release();
+}
+
+/* Methods */
+
+/**
+ * @brief Common implementation of split/rsplit and their iterators.
+ */
+static PyObject* split_impl(LStrObject *self, PyObject *args, PyObject *kwds,
+                            const char *format, const char *name, bool reverse, bool iter) {
+    if (!check_self(self)) return nullptr;
+    PyObject *sep_obj;
+    Py_ssize_t maxsplit;
+    if (!parse_split_args(args, kwds, format, sep_obj, maxsplit)) return nullptr;
+
+    std::unique_ptr<SplitSource> sep(new SplitSource());
+    if (sep->parse(self, sep_obj, reverse, name) < 0) return nullptr;
+    if (iter) {
+        SplitScanner::Mode mode = sep->mode();
+        return make_split_iter(self, sep.release(), mode, reverse, maxsplit, false);
+    }
+    SplitScanner scanner;
+    scanner.init(self->buffer, sep->search, sep->mode(), reverse, maxsplit, false);
+    return collect_pieces(self, scanner);
+}
+
+/**
+ * @brief split(self, sep=None, maxsplit=-1)
+ *
+ * Mirrors str.split: `sep` is a str, L or Pattern, or None to split on
+ * runs of whitespace. Returns a list of L slice views of self.
+ */
+PyObject* LStr_split(LStrObject *self, PyObject *args, PyObject *kwds) {
+    return split_impl(self, args, kwds, "|On:split", "split", false, false);
+}
+
+/**
+ * @brief split_iter(self, sep=None, maxsplit=-1)
+ *
+ * Like split(), but returns an iterator producing the pieces on demand.
+ */
+PyObject* LStr_split_iter(LStrObject *self, PyObject *args, PyObject *kwds) {
+    return split_impl(self, args, kwds, "|On:split_iter", "split", false, true);
+}
+
+/**
+ * @brief rsplit(self, sep=None, maxsplit=-1)
+ *
+ * Mirrors str.rsplit: the splits are made from the right, the pieces are
+ * returned left to right.
+ */
+PyObject* LStr_rsplit(LStrObject *self, PyObject *args, PyObject *kwds) {
+    return split_impl(self, args, kwds, "|On:rsplit", "rsplit", true, false);
+}
+
+/**
+ * @brief rsplit_iter(self, sep=None, maxsplit=-1)
+ *
+ * Like rsplit(), but returns an iterator producing the pieces right to left.
+ */
+PyObject* LStr_rsplit_iter(LStrObject *self, PyObject *args, PyObject *kwds) {
+    return split_impl(self, args, kwds, "|On:rsplit_iter", "rsplit", true, true);
+}
+
+/**
+ * @brief Common implementation of splitlines/splitlines_iter.
+ */
+static PyObject* splitlines_impl(LStrObject *self, PyObject *args, PyObject *kwds,
+                                 const char *format, bool iter) {
+    static char *kwlist[] = {(char*)"keepends", nullptr};
+    if (!check_self(self)) return nullptr;
+    int keepends = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, format, kwlist, &keepends)) return nullptr;
+
+    if (iter) {
+        return make_split_iter(self, new SplitSource(), SplitScanner::SPLIT_LINES, false, -1, keepends != 0);
+    }
+    SplitScanner scanner;
+    scanner.init(self->buffer, nullptr, SplitScanner::SPLIT_LINES, false, -1, keepends != 0);
+    return collect_pieces(self, scanner);
+}
+
+/**
+ * @brief splitlines(self, keepends=False)
+ *
+ * Mirrors str.splitlines, including the treatment of `\r\n` as a single
+ * line boundary.
+ */
+PyObject* LStr_splitlines(LStrObject *self, PyObject *args, PyObject *kwds) {
+    return splitlines_impl(self, args, kwds, "|p:splitlines", false);
+}
+
+/**
+ * @brief splitlines_iter(self, keepends=False)
+ *
+ * Like splitlines(), but returns an iterator producing the lines on demand.
+ */
+PyObject* LStr_splitlines_iter(LStrObject *self, PyObject *args, PyObject *kwds) {
+    return splitlines_impl(self, args, kwds, "|p:splitlines_iter", true);
+}
@@ -0,0 +1,89 @@
+#ifndef LSTRING_STATS_HXX
+#define LSTRING_STATS_HXX
+
+#include <Python.h>
+#include <atomic>
+#include <cstdint>
+
+#include "lstring/lstring.hxx"
+
+/**
+ * @brief Process-global instrumentation counters reported by lstring.stats().
+ *
+ * The counters are always compiled in but only updated while enabled with
+ * lstring.set_stats_enabled(True); disabled, every hook costs one relaxed
+ * load. They are relaxed atomics: totals are exact, but a snapshot taken
+ * while other threads work is not a consistent cut.
+ */
+struct LStrStats {
+    /** Highest buffer_class_id (Utf8Buffer). */
+    static constexpr int MAX_CLASS_ID = 14;
+
+    std::atomic<bool> enabled;
+
+    /** Nodes created, by the buffer_class_id of their most derived class. */
+    std::atomic<uint64_t> nodes[MAX_CLASS_ID + 1];
+
+    /** Results collapsed into compact leaves by lstr_optimize(). */
+    std::atomic<uint64_t> optimize_collapses;
+
+    /** Lazy buffers copied into a new str by buffer_to_pystr(), and the bytes written. */
+    std::atomic<uint64_t> materializations;
+    std::atomic<uint64_t> materialized_bytes;
+
+    /** Substring searches of find, rfind and partition, by the path that answered them. */
+    std::atomic<uint64_t> find_indexed;
+    std::atomic<uint64_t> find_str;
+    std::atomic<uint64_t> find_scan;
+
+    /** str() calls answered by the str cache, and entries it evicted to fit its limit. */
+    std::atomic<uint64_t> str_cache_hits;
+    std::atomic<uint64_t> str_cache_evictions;
+
+    /** Rotations made by concat_balanced() to keep join trees balanced. */
+    std::atomic<uint64_t> concat_rotations;
+
+    /** Height of the tallest join node created. */
+    std::atomic<uint64_t> max_height;
+};
+
+extern LStrStats LStr_stats;
+
+inline bool stats_enabled() {
+    return LStr_stats.enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Add n to counter if the counters are enabled.
+ */
+inline void stats_add(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+    if (stats_enabled()) counter.fetch_add(n, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Raise counter to value if the counters are enabled.
+ */
+inline void stats_max(std::atomic<uint64_t>& counter, uint64_t value) {
+    if (!stats_enabled()) return;
+    uint64_t seen = counter.load(std::memory_order_relaxed);
+    while (seen < value && !counter.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Count a newly created node under its most derived class.
+ *
+ * Derived classes have higher ids than their bases, so the first id that
+ * buf is_a() from the top is its own.
+ */
+inline void stats_node(const Buffer* buf) {
+    if (!stats_enabled() || !buf) return;
+    for (int id = LStrStats::MAX_CLASS_ID; id > 0; --id) {
+        if (buf->is_a(id)) {
+            LStr_stats.nodes[id].fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+#endif // LSTRING_STATS_HXX
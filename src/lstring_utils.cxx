@@ -4,12 +4,22 @@
  */
 
 #include <Python.h>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <vector>
 #include "_lstring.hxx"
 #include "lstring_utils.hxx"
+#include "lstring_stats.hxx"
 #include "tptr.hxx"
 #include <cppy/cppy.h>
 #include "lstring/lstring.hxx"
 #include "str_buffer.hxx"
+#include "inline_buffer.hxx"
+#include "slice_buffer.hxx"
+#include "str_cache.hxx"
 
 /**
  * @brief Build a StrBuffer wrapper for a Python str.
@@ -37,22 +47,49 @@ StrBuffer* make_str_buffer(PyObject *py_str) {
 
 
 /**
- * @brief Try to collapse small lazy buffers into concrete StrBuffers.
+ * @brief Try to collapse small lazy buffers into compact leaves.
  *
  * Uses the process-global `g_optimize_threshold` to decide whether to
- * collapse. If the threshold is inactive (<= 0), this is a no-op.
+ * collapse. If the threshold is inactive (<= 0), this is a no-op. Content
+ * that fits is copied into an InlineBuffer, so no Python str is created;
+ * longer content becomes a StrBuffer.
  */
 LStrObject *lstr_optimize(LStrObject *self) {
     if (!self || !self->buffer) return nullptr;
     if (self->buffer->is_str()) return nullptr;
-    if (LStr_optimize_threshold <= 0) return nullptr;
-    if ((Py_ssize_t)self->buffer->length() >= LStr_optimize_threshold)
+    if (self->buffer->is_a(InlineBuffer::buffer_class_id)) return nullptr;
+    Py_ssize_t threshold = LStr_optimize_threshold;
+    if (threshold <= 0) return nullptr;
+    Py_ssize_t len = (Py_ssize_t)self->buffer->length();
+    if (len >= threshold)
         return nullptr;
+
+    int kind = self->buffer->unicode_kind();
+    if (InlineBuffer::fits(len, kind)) {
+        PyTypeObject *type = Py_TYPE(self);
+        tptr<LStrObject> result((LStrObject*)type->tp_alloc(type, 0));
+        if (!result) {
+            PyErr_Clear();
+            return nullptr;
+        }
+        try {
+            result->buffer = new InlineBuffer(*self->buffer, kind);
+        } catch (...) {
+            // Keep the lazy result if the compact copy cannot be made.
+            return nullptr;
+        }
+        stats_node(result->buffer);
+        stats_add(LStr_stats.optimize_collapses);
+        return (LStrObject *) result.ptr().release();
+    }
+
     cppy::ptr py_str(buffer_to_pystr(self->buffer));
     if (!py_str) return nullptr;
 
     // Then create a StrBuffer from it
-    return (LStrObject *) make_lstr_from_pystr(Py_TYPE(self), py_str.get());
+    LStrObject *collapsed = (LStrObject *) make_lstr_from_pystr(Py_TYPE(self), py_str.get());
+    if (collapsed) stats_add(LStr_stats.optimize_collapses);
+    return collapsed;
 }
 
 
@@ -76,6 +113,7 @@ PyObject* make_lstr_from_pystr(PyTypeObject *type, PyObject *py_str) {
     try {
         self->buffer = make_str_buffer(py_str);
         if (!self->buffer) return nullptr; // make_str_buffer sets PyErr
+        stats_node(self->buffer);
     } catch (const std::exception &e) {
         PyErr_SetString(PyExc_RuntimeError, e.what());
         return nullptr;
@@ -87,6 +125,45 @@ PyObject* make_lstr_from_pystr(PyTypeObject *type, PyObject *py_str) {
     return self.ptr().release();
 }
 
+PyObject* make_lstr_slice(LStrObject *self, Py_ssize_t start, Py_ssize_t end) {
+    PyTypeObject *type = Py_TYPE(self);
+    if (start >= end) {
+        return make_lstr_from_pystr(type, cppy::ptr(PyUnicode_FromString("")).get());
+    }
+    if (start == 0 && end == self->buffer->length()) {
+        return cppy::incref((PyObject*)self);
+    }
+
+    tptr<LStrObject> result((LStrObject*)type->tp_alloc(type, 0));
+    if (!result) return nullptr;
+    try {
+        result->buffer = new Slice1Buffer((PyObject*)self, start, end);
+        stats_node(result->buffer);
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    } catch (...) {
+        PyErr_SetString(PyExc_RuntimeError, "slice creation failed");
+        return nullptr;
+    }
+
+    // Try to optimize/collapse small results
+    tptr<LStrObject> optimized(lstr_optimize(result.get()));
+    if (optimized) {
+        return optimized.ptr().release();
+    }
+    return result.ptr().release();
+}
+
+PyTypeObject* get_base_l_type(PyTypeObject *type_self) {
+    PyTypeObject *base_type = type_self;
+    while (base_type->tp_base != nullptr &&
+           strcmp(base_type->tp_name, "_lstring.L") != 0) {
+        base_type = base_type->tp_base;
+    }
+    return base_type;
+}
+
 // Return a new reference to the lstring.L type (named lstr here).
 PyObject* get_string_lstr_type() {
     cppy::ptr mod( PyImport_ImportModule("_lstring") );
@@ -97,12 +174,80 @@ PyObject* get_string_lstr_type() {
     return LType.release();
 }
 
+/**
+ * @brief Number of workers for a parallel copy of `len` code points, or 1
+ *        if the copy should stay on the calling thread.
+ */
+static Py_ssize_t parallel_copy_workers(Py_ssize_t len) {
+    Py_ssize_t threshold = LStr_parallel_copy_threshold;
+    if (threshold <= 0 || len < threshold) return 1;
+    Py_ssize_t workers = LStr_parallel_copy_threads;
+    if (workers <= 0) workers = (Py_ssize_t)std::thread::hardware_concurrency();
+    // Tiny pieces are not worth a thread each.
+    const Py_ssize_t min_piece = 1 << 16;
+    if (workers > len / min_piece) workers = len / min_piece;
+    return workers > 1 ? workers : 1;
+}
+
+/**
+ * @brief Copy the whole buffer into `target`, possibly with several threads.
+ *
+ * Buffers are immutable and every node knows its length, so disjoint ranges
+ * of the destination can be filled independently: each worker copies one
+ * contiguous range through `copy()`, which descends only into the subtrees
+ * covering that range. Buffer copies use no Python API, so the GIL is
+ * released while the workers run.
+ *
+ * @return false with a Python exception set if a worker failed.
+ */
+template <class T>
+static bool copy_buffer(const Buffer* buf, T* target, Py_ssize_t len) {
+    Py_ssize_t workers = parallel_copy_workers(len);
+    if (workers == 1) {
+        buf->copy(target, 0, len);
+        return true;
+    }
+
+    std::atomic<bool> failed(false);
+    auto copy_range = [&](Py_ssize_t start, Py_ssize_t end) {
+        try {
+            buf->copy(target + start, start, end - start);
+        } catch (...) {
+            failed = true;
+        }
+    };
+
+    Py_ssize_t piece = (len + workers - 1) / workers;
+    Py_BEGIN_ALLOW_THREADS
+    std::vector<std::thread> threads;
+    Py_ssize_t start = 0;
+    try {
+        threads.reserve(workers - 1);
+        for (; start + piece < len; start += piece) {
+            threads.emplace_back(copy_range, start, start + piece);
+        }
+    } catch (...) {
+        // Out of threads: the calling thread copies whatever is left.
+    }
+    copy_range(start, len);
+    for (auto& t : threads) t.join();
+    Py_END_ALLOW_THREADS
+
+    if (failed) {
+        PyErr_SetString(PyExc_RuntimeError, "Buffer copy failed");
+        return false;
+    }
+    return true;
+}
+
 /**
  * @brief Create a new Python str from Buffer contents.
  *
  * Materializes the buffer into a concrete Python unicode object.
  * If the buffer already wraps a Python str (StrBuffer), returns it
- * directly with an owned reference to avoid copying.
+ * directly with an owned reference to avoid copying; so does a buffer
+ * whose str is in the StrCache. Large buffers are copied by several
+ * threads when the parallel copy mode is enabled.
  *
  * @param buf Buffer to convert (borrowed reference)
  * @return New reference to PyObject* (str) or nullptr on error.
@@ -120,30 +265,60 @@ PyObject* buffer_to_pystr(const Buffer* buf) {
         const StrBuffer *sbuf = static_cast<const StrBuffer*>(buf);
         return cppy::incref(sbuf->get_str());
     }
+    if (PyObject *cached = StrCache::lookup(buf)) {
+        stats_add(LStr_stats.str_cache_hits);
+        return cached;
+    }
 
-    uint32_t len = buf->length();
+    Py_ssize_t len = buf->length();
     int kind = buf->unicode_kind();
 
-    PyObject *py_str = nullptr;
+    cppy::ptr py_str;
+    bool ok = false;
     if (kind == PyUnicode_1BYTE_KIND) {
         py_str = PyUnicode_New(len, 0xFF);
         if (!py_str) return nullptr;
-        uint8_t *data = reinterpret_cast<uint8_t*>(PyUnicode_DATA(py_str));
-        buf->copy(data, 0, len);
+        ok = copy_buffer(buf, reinterpret_cast<uint8_t*>(PyUnicode_DATA(py_str.get())), len);
     } else if (kind == PyUnicode_2BYTE_KIND) {
         py_str = PyUnicode_New(len, 0xFFFF);
         if (!py_str) return nullptr;
-        uint16_t *data = reinterpret_cast<uint16_t*>(PyUnicode_DATA(py_str));
-        buf->copy(data, 0, len);
+        ok = copy_buffer(buf, reinterpret_cast<uint16_t*>(PyUnicode_DATA(py_str.get())), len);
     } else if (kind == PyUnicode_4BYTE_KIND) {
         py_str = PyUnicode_New(len, 0x10FFFF);
         if (!py_str) return nullptr;
-        uint32_t *data = reinterpret_cast<uint32_t*>(PyUnicode_DATA(py_str));
-        buf->copy(data, 0, len);
+        ok = copy_buffer(buf, reinterpret_cast<uint32_t*>(PyUnicode_DATA(py_str.get())), len);
     } else {
         PyErr_SetString(PyExc_RuntimeError, "Unsupported buffer kind");
         return nullptr;
     }
+    if (!ok) return nullptr;
+
+    stats_add(LStr_stats.materializations);
+    stats_add(LStr_stats.materialized_bytes, (uint64_t)len * kind);
+    return py_str.release();
+}
+
+/**
+ * @brief New reference to a str holding the content of buf that exists
+ *        without copying: the str of a StrBuffer or the cached str of a
+ *        lazy buffer. Returns nullptr, without an exception, otherwise.
+ */
+PyObject* buffer_str_view(const Buffer* buf) {
+    if (buf->is_str()) return cppy::incref(static_cast<const StrBuffer*>(buf)->get_str());
+    return StrCache::lookup(buf);
+}
 
-    return py_str;
+/**
+ * @brief Whether an encoding name denotes UTF-8 (any case, '-' or '_').
+ */
+bool is_utf8_name(const char* encoding) {
+    char norm[8];
+    size_t n = 0;
+    for (const char* p = encoding; *p; ++p) {
+        if (*p == '-' || *p == '_') continue;
+        if (n == sizeof(norm) - 1) return false;
+        norm[n++] = (char)std::tolower((unsigned char)*p);
+    }
+    norm[n] = '\0';
+    return std::strcmp(norm, "utf8") == 0;
 }
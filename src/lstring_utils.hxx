@@ -10,10 +10,21 @@ class Buffer;
 extern LStrObject *lstr_optimize(LStrObject *self);
 extern StrBuffer* make_str_buffer(PyObject *py_str);
 extern PyObject* make_lstr_from_pystr(PyTypeObject *type, PyObject *py_str);
+// Return self[start:end] (0 <= start, end <= len(self)) as a new reference,
+// with the semantics of a step-1 slice: an empty L, self itself for the
+// full range, otherwise a (possibly collapsed) slice view.
+extern PyObject* make_lstr_slice(LStrObject *self, Py_ssize_t start, Py_ssize_t end);
+// Return the _lstring.L base type of an L subclass (borrowed reference).
+extern PyTypeObject* get_base_l_type(PyTypeObject *type_self);
 // Return a new reference to the lstring.L type object by importing the
 // '_lstring' module and reading its 'L' attribute. Caller owns the result.
 extern PyObject* get_string_lstr_type();
 // Create a new Python str from Buffer contents. Returns new reference or nullptr on error.
 extern PyObject* buffer_to_pystr(const Buffer* buf);
+// Return a new reference to the str of a StrBuffer or the cached str of a
+// lazy buffer, or nullptr (no exception set) if it would have to be copied.
+extern PyObject* buffer_str_view(const Buffer* buf);
+// Whether an encoding name denotes UTF-8 (any case, with or without '-'/'_').
+extern bool is_utf8_name(const char* encoding);
 
 #endif // LSTRING_UTILS_HXX
@@ -0,0 +1,143 @@
+/**
+ * @file map_buffer.cxx
+ * @brief Construction of the code point maps used by MapBuffer.
+ */
+
+#include <Python.h>
+#include <exception>
+
+#include "map_buffer.hxx"
+
+static const char* const case_method_names[CASE_MAPPING_COUNT] = {
+    "lower", "upper", "casefold", "swapcase"
+};
+
+/**
+ * Process-global case tables, built on first use. Tables are published with
+ * atomic shared_ptr operations: threads racing on first use may each build
+ * one, and all but one copy are dropped.
+ */
+static std::shared_ptr<const CodePointMap> case_maps[CASE_MAPPING_COUNT];
+
+/**
+ * @brief Fill one block of a case table by calling the str method on it.
+ *
+ * The whole block is mapped with a single call; only blocks whose result
+ * has a different length are mapped code point by code point to find the
+ * specials.
+ *
+ * @return false with a Python exception set on failure.
+ */
+static bool fill_case_block(CodePointMap& map, const char* method, uint32_t block) {
+    const uint32_t base = block << CodePointMap::BLOCK_SHIFT;
+    const Py_ssize_t size = CodePointMap::BLOCK_SIZE;
+
+    cppy::ptr text(PyUnicode_New(size, base + size - 1));
+    if (!text) return false;
+    int kind = PyUnicode_KIND(text.get());
+    void* data = PyUnicode_DATA(text.get());
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        PyUnicode_WRITE(kind, data, i, base + i);
+    }
+
+    cppy::ptr mapped(PyObject_CallMethod(text.get(), method, nullptr));
+    if (!mapped) return false;
+    if (PyUnicode_GET_LENGTH(mapped.get()) == size) {
+        // Case mappings never shrink, so every code point maps to exactly one.
+        for (Py_ssize_t i = 0; i < size; ++i) {
+            map.set(base + i, PyUnicode_READ_CHAR(mapped.get(), i));
+        }
+        return true;
+    }
+
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        cppy::ptr ch(PyUnicode_FromOrdinal(base + i));
+        if (!ch) return false;
+        cppy::ptr one(PyObject_CallMethod(ch.get(), method, nullptr));
+        if (!one) return false;
+        if (PyUnicode_GET_LENGTH(one.get()) == 1) {
+            map.set(base + i, PyUnicode_READ_CHAR(one.get(), 0));
+        } else {
+            map.add_special(base + i);
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<const CodePointMap> get_case_map(CaseMapping mapping) {
+    std::shared_ptr<const CodePointMap> cached = std::atomic_load(&case_maps[mapping]);
+    if (cached) return cached;
+
+    try {
+        auto map = std::make_shared<CodePointMap>();
+        const char* method = case_method_names[mapping];
+        for (uint32_t block = 0; block < CodePointMap::BLOCK_COUNT; ++block) {
+            if (!fill_case_block(*map, method, block)) return {};
+        }
+        if (mapping == CASE_LOWER || mapping == CASE_SWAPCASE) {
+            // GREEK CAPITAL LETTER SIGMA lowers to the final form at the
+            // end of a word, which depends on its neighbours.
+            map->add_special(0x03A3);
+        }
+        map->finish();
+        std::shared_ptr<const CodePointMap> built(std::move(map));
+        if (!std::atomic_compare_exchange_strong(&case_maps[mapping], &cached, built)) {
+            // Another thread published its table first; use that one.
+            return cached;
+        }
+        return built;
+    } catch (const std::bad_alloc&) {
+        PyErr_NoMemory();
+        return {};
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return {};
+    }
+}
+
+std::shared_ptr<const CodePointMap> make_translate_map(PyObject* table) {
+    // Anything but a plain dict may compute its values on lookup.
+    if (!PyDict_CheckExact(table)) return {};
+
+    try {
+        auto map = std::make_shared<CodePointMap>();
+        PyObject *key, *value;
+        Py_ssize_t pos = 0;
+        while (PyDict_Next(table, &pos, &key, &value)) {
+            // Other key types may still compare equal to an ordinal.
+            if (!PyLong_Check(key)) return {};
+            int overflow = 0;
+            long ch = PyLong_AsLongAndOverflow(key, &overflow);
+            if (ch == -1 && PyErr_Occurred()) {
+                PyErr_Clear();
+                return {};
+            }
+            // Keys outside the code point range never match.
+            if (overflow || ch < 0 || ch >= 0x110000) continue;
+
+            if (value == Py_None) {
+                map->add_special((uint32_t)ch);
+            } else if (PyLong_Check(value)) {
+                long mapped = PyLong_AsLongAndOverflow(value, &overflow);
+                if (overflow || mapped < 0 || mapped >= 0x110000) {
+                    PyErr_Clear();
+                    return {};
+                }
+                map->set((uint32_t)ch, (uint32_t)mapped);
+            } else if (PyUnicode_Check(value)) {
+                if (PyUnicode_GET_LENGTH(value) == 1) {
+                    map->set((uint32_t)ch, PyUnicode_READ_CHAR(value, 0));
+                } else {
+                    map->add_special((uint32_t)ch);
+                }
+            } else {
+                return {};
+            }
+        }
+        map->finish();
+        return map;
+    } catch (const std::exception&) {
+        // Let str.translate do the work (and report any error).
+        return {};
+    }
+}
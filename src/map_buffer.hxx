@@ -0,0 +1,345 @@
+#ifndef MAP_BUFFER_HXX
+#define MAP_BUFFER_HXX
+
+#include <Python.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "lstring/lstring.hxx"
+#include "charset.hxx"
+#include "span.hxx"
+#include "tptr.hxx"
+#include <cppy/ptr.h>
+
+/**
+ * @brief Per-code-point mapping used by MapBuffer.
+ *
+ * The table is split into blocks of 256 code points; blocks without any
+ * change are not stored and map to themselves. Code points whose mapping is
+ * not a single code point (deletions, expansions such as `ß` -> `SS`) or
+ * depends on the context (the final sigma) are recorded as specials: a
+ * MapBuffer is only created over text that contains none of them.
+ */
+class CodePointMap {
+public:
+    static constexpr uint32_t BLOCK_SHIFT = 8;
+    static constexpr uint32_t BLOCK_SIZE = 1u << BLOCK_SHIFT;
+    static constexpr uint32_t BLOCK_COUNT = 0x110000 >> BLOCK_SHIFT;
+
+    CodePointMap() : blocks_(BLOCK_COUNT), bound_{1, 2, 4}, narrows_{false, false, false} {}
+
+    CodePointMap(const CodePointMap&) = delete;
+    CodePointMap& operator=(const CodePointMap&) = delete;
+
+    /**
+     * @brief Map a single code point.
+     */
+    uint32_t operator()(uint32_t ch) const {
+        if (ch >= 0x110000) return ch;
+        const uint32_t* block = blocks_[ch >> BLOCK_SHIFT].get();
+        return block ? block[ch & (BLOCK_SIZE - 1)] : ch;
+    }
+
+    /**
+     * @brief Set the image of one code point (ch < 0x110000).
+     */
+    void set(uint32_t ch, uint32_t mapped) {
+        std::unique_ptr<uint32_t[]>& block = blocks_[ch >> BLOCK_SHIFT];
+        if (!block) {
+            if (mapped == ch) return;
+            block.reset(new uint32_t[BLOCK_SIZE]);
+            uint32_t base = ch & ~(BLOCK_SIZE - 1);
+            for (uint32_t i = 0; i < BLOCK_SIZE; ++i) block[i] = base + i;
+        }
+        block[ch & (BLOCK_SIZE - 1)] = mapped;
+    }
+
+    /**
+     * @brief Record a code point whose mapping MapBuffer cannot represent.
+     */
+    void add_special(uint32_t ch) {
+        set(ch, ch);
+        specials_.push_back(ch);
+    }
+
+    /**
+     * @brief Build the special set and the kind bounds; call once filled.
+     */
+    void finish() {
+        if (!specials_.empty()) {
+            specials_set_.reset(new FullCharSet(specials_.data(), (Py_ssize_t)specials_.size()));
+        }
+        for (uint32_t b = 0; b < BLOCK_COUNT; ++b) {
+            const uint32_t* block = blocks_[b].get();
+            if (!block) continue;
+            for (uint32_t i = 0; i < BLOCK_SIZE; ++i) {
+                int in = kind_index((b << BLOCK_SHIFT) + i);
+                int out = kind_index(block[i]);
+                bound_[in] = std::max(bound_[in], kind_of_index(out));
+                if (out < in) narrows_[in] = true;
+            }
+        }
+        bound_[1] = std::max(bound_[0], bound_[1]);
+        bound_[2] = std::max(bound_[1], bound_[2]);
+    }
+
+    /**
+     * @brief Set of special code points, or nullptr if there are none.
+     */
+    const CharSet* specials() const {
+        return specials_set_.get();
+    }
+
+    /**
+     * @brief Largest kind produced from text of the given kind.
+     */
+    int kind_bound(int kind) const {
+        return bound_[kind_index_of(kind)];
+    }
+
+    /**
+     * @brief Whether some code point of exactly the given kind maps to a
+     * narrower kind.
+     */
+    bool narrows(int kind) const {
+        return narrows_[kind_index_of(kind)];
+    }
+
+    /**
+     * @brief Collect all code points that map to ch.
+     */
+    void preimage(uint32_t ch, std::vector<Py_UCS4>& out) const {
+        if ((*this)(ch) == ch) out.push_back(ch);
+        for (uint32_t b = 0; b < BLOCK_COUNT; ++b) {
+            const uint32_t* block = blocks_[b].get();
+            if (!block) continue;
+            for (uint32_t i = 0; i < BLOCK_SIZE; ++i) {
+                uint32_t cp = (b << BLOCK_SHIFT) + i;
+                if (block[i] == ch && cp != ch) out.push_back(cp);
+            }
+        }
+    }
+
+    /**
+     * @brief Whether the map changes no code point at all.
+     */
+    bool is_identity() const {
+        if (!specials_.empty()) return false;
+        for (uint32_t b = 0; b < BLOCK_COUNT; ++b) {
+            const uint32_t* block = blocks_[b].get();
+            if (!block) continue;
+            for (uint32_t i = 0; i < BLOCK_SIZE; ++i) {
+                if (block[i] != (b << BLOCK_SHIFT) + i) return false;
+            }
+        }
+        return true;
+    }
+
+    /** Storage kind (1, 2 or 4) of a code point. */
+    static int kind_of(uint32_t ch) {
+        return ch < 0x100 ? PyUnicode_1BYTE_KIND : ch < 0x10000 ? PyUnicode_2BYTE_KIND : PyUnicode_4BYTE_KIND;
+    }
+
+private:
+    static int kind_index(uint32_t ch) {
+        return ch < 0x100 ? 0 : ch < 0x10000 ? 1 : 2;
+    }
+
+    static int kind_index_of(int kind) {
+        return kind == PyUnicode_1BYTE_KIND ? 0 : kind == PyUnicode_2BYTE_KIND ? 1 : 2;
+    }
+
+    static int kind_of_index(int index) {
+        return index == 0 ? PyUnicode_1BYTE_KIND : index == 1 ? PyUnicode_2BYTE_KIND : PyUnicode_4BYTE_KIND;
+    }
+
+    std::vector<std::unique_ptr<uint32_t[]>> blocks_;
+    std::vector<Py_UCS4> specials_;
+    std::unique_ptr<FullCharSet> specials_set_;
+    int bound_[3];
+    bool narrows_[3];
+};
+
+/** Case mappings served by MapBuffer. */
+enum CaseMapping {
+    CASE_LOWER,
+    CASE_UPPER,
+    CASE_CASEFOLD,
+    CASE_SWAPCASE,
+    CASE_MAPPING_COUNT
+};
+
+/**
+ * @brief Shared table for a str case method.
+ *
+ * Built on first use from the interpreter's own str methods, so the result
+ * always agrees with `str.lower()` and friends. Defined in
+ * src/map_buffer.cxx.
+ *
+ * @return The table, or nullptr with a Python exception set.
+ */
+std::shared_ptr<const CodePointMap> get_case_map(CaseMapping mapping);
+
+/**
+ * @brief Build a table from a `str.translate` table.
+ *
+ * Only exact dicts with int keys and int, one-character str or None values
+ * are supported; None and multi-character values become specials. Defined
+ * in src/map_buffer.cxx.
+ *
+ * @return The table, or nullptr if the table is not supported (no Python
+ *         exception is set; callers fall back to str.translate).
+ */
+std::shared_ptr<const CodePointMap> make_translate_map(PyObject* table);
+
+/**
+ * @brief MapBuffer — lazily mapped view of another buffer
+ *
+ * Presents every code point of the wrapped L mapped through a CodePointMap
+ * (case mapping or translate table). The length is that of the wrapped
+ * buffer; characters are mapped on demand by value() and copy().
+ */
+class MapBuffer : public Buffer {
+private:
+    tptr<LStrObject> lstr_obj;
+    std::shared_ptr<const CodePointMap> map;
+    const char* name;
+
+    mutable std::atomic<int> cached_kind;
+
+    template <class T>
+    void copy_mapped(T* target, Py_ssize_t start, Py_ssize_t count) const {
+        const CodePointMap& m = *map;
+        for_each_span(*lstr_obj->buffer, start, start + count, [&](const BufferSpan& span) {
+            with_span_data(span, [&](auto data, Py_ssize_t n) {
+                for (Py_ssize_t k = 0; k < n; ++k) {
+                    *target++ = static_cast<T>(m(data[k]));
+                }
+            });
+            return true;
+        });
+    }
+
+public:
+    static constexpr int buffer_class_id = 10;
+
+    bool is_a(int class_id) const override {
+        return class_id == buffer_class_id || Buffer::is_a(class_id);
+    }
+
+    /**
+     * @brief Construct a mapped view of `lstr`.
+     *
+     * @param lstr L object to map (borrowed ref); it must not contain any of
+     *        the map's special code points.
+     * @param m Mapping shared with other buffers.
+     * @param method_name Name of the str method shown by repr (static string).
+     */
+    MapBuffer(PyObject *lstr, std::shared_ptr<const CodePointMap> m, const char* method_name)
+        : lstr_obj((LStrObject*)lstr, true), map(std::move(m)), name(method_name), cached_kind(-1) {}
+
+    ~MapBuffer() override = default;
+
+    /**
+     * @brief The mapped L object (borrowed reference).
+     */
+    PyObject* base() const {
+        return lstr_obj.ptr().get();
+    }
+
+    Py_ssize_t length() const override {
+        return lstr_obj->buffer->length();
+    }
+
+    /**
+     * @brief Minimal Unicode storage kind of the mapped text.
+     *
+     * The map's kind bounds settle most cases without looking at the text;
+     * otherwise the mapped text is scanned once and the result cached.
+     */
+    int unicode_kind() const override {
+        int kind = cached_kind.load(std::memory_order_relaxed);
+        if (kind != -1) return kind;
+
+        const Buffer* base = lstr_obj->buffer;
+        kind = base->unicode_kind();
+        if (map->kind_bound(kind) == kind && !map->narrows(kind)) {
+            cached_kind.store(kind, std::memory_order_relaxed);
+            return kind;
+        }
+
+        const CodePointMap& m = *map;
+        uint32_t max_char = 0;
+        for_each_span(*base, 0, base->length(), [&](const BufferSpan& span) {
+            with_span_data(span, [&](auto data, Py_ssize_t n) {
+                for (Py_ssize_t k = 0; k < n; ++k) {
+                    max_char = std::max(max_char, m(data[k]));
+                }
+            });
+            return max_char < 0x10000;
+        });
+        kind = CodePointMap::kind_of(max_char);
+        cached_kind.store(kind, std::memory_order_relaxed);
+        return kind;
+    }
+
+    uint32_t value(Py_ssize_t index) const override {
+        return (*map)(lstr_obj->buffer->value(index));
+    }
+
+    void copy(uint32_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_mapped(target, start, count);
+    }
+
+    void copy(uint16_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_mapped(target, start, count);
+    }
+
+    void copy(uint8_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_mapped(target, start, count);
+    }
+
+    /**
+     * @brief Produce a Python-level repr of the form "<base_repr>.<method>()".
+     */
+    PyObject* repr() const override {
+        cppy::ptr brepr( lstr_obj->buffer->repr() );
+        if (!brepr) return nullptr;
+        return PyUnicode_FromFormat("%U.%s()", brepr.get(), name);
+    }
+
+    /**
+     * @brief Find a mapped code point by searching the base buffer for its
+     * preimage, so the base buffer's own scans are used.
+     */
+    Py_ssize_t findc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override {
+        return find_preimage(start, end, ch, false);
+    }
+
+    Py_ssize_t rfindc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override {
+        return find_preimage(start, end, ch, true);
+    }
+
+private:
+    Py_ssize_t find_preimage(Py_ssize_t start, Py_ssize_t end, uint32_t ch, bool reverse) const {
+        if (start < 0) start = 0;
+        Py_ssize_t total_len = length();
+        if (end > total_len) end = total_len;
+        if (start >= end) return -1;
+
+        const Buffer* base = lstr_obj->buffer;
+        std::vector<Py_UCS4> chars;
+        map->preimage(ch, chars);
+        if (chars.empty()) return -1;
+        if (chars.size() == 1) {
+            return reverse ? base->rfindc(start, end, chars[0]) : base->findc(start, end, chars[0]);
+        }
+        FullCharSet set(chars.data(), (Py_ssize_t)chars.size());
+        return reverse ? base->rfindcs(start, end, set) : base->findcs(start, end, set);
+    }
+};
+
+#endif // MAP_BUFFER_HXX
@@ -0,0 +1,237 @@
+#ifndef MMAP_BUFFER_HXX
+#define MMAP_BUFFER_HXX
+
+#include <Python.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <cppy/ptr.h>
+
+#include "lstring/lstring.hxx"
+#include "_lstring.hxx"
+#include "class_index.hxx"
+#include "simd.hxx"
+#include "span.hxx"
+
+/**
+ * @brief MmapBuffer — leaf over the memory of a buffer-protocol object
+ *
+ * References the bytes exported by an `mmap`, `bytes`, `bytearray` or any
+ * other object supporting the buffer protocol, read as fixed-width code
+ * points: 1 byte (Latin-1/ASCII), or 2 or 4 bytes in native byte order.
+ * Nothing is copied; reads go straight to the exported memory, so a mapped
+ * file is only paged in where it is accessed.
+ *
+ * The exported memory must not change while the buffer is alive. 4-byte
+ * data is validated when the buffer is created; for 2- and 4-byte data the
+ * exact kind is found by a scan on first use.
+ */
+class MmapBuffer : public Buffer {
+public:
+    static constexpr int buffer_class_id = 13;
+
+    bool is_a(int class_id) const override {
+        return class_id == buffer_class_id || Buffer::is_a(class_id);
+    }
+
+    /**
+     * @brief Export the memory of `obj` as code points of `width` bytes.
+     *
+     * @param obj Object supporting the buffer protocol; held until the
+     *            buffer is destroyed.
+     * @param width Bytes per code point: 1, 2 or 4.
+     * @return nullptr with a Python exception set if `obj` cannot be
+     *         exported or does not hold valid code points of that width.
+     */
+    static MmapBuffer* create(PyObject *obj, int width) {
+        if (width != 1 && width != 2 && width != 4) {
+            PyErr_SetString(PyExc_ValueError, "width must be 1, 2 or 4");
+            return nullptr;
+        }
+        Py_buffer view;
+        if (PyObject_GetBuffer(obj, &view, PyBUF_SIMPLE) < 0) return nullptr;
+        if (view.len % width != 0) {
+            PyBuffer_Release(&view);
+            PyErr_Format(PyExc_ValueError, "buffer size %zd is not a multiple of width %d", view.len, width);
+            return nullptr;
+        }
+        if (reinterpret_cast<uintptr_t>(view.buf) % width != 0) {
+            PyBuffer_Release(&view);
+            PyErr_Format(PyExc_ValueError, "buffer is not aligned to width %d", width);
+            return nullptr;
+        }
+        if (width == PyUnicode_4BYTE_KIND &&
+            simd_find_range(static_cast<const Py_UCS4*>(view.buf), view.len / 4, 0, 0x110000, true) != -1) {
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_ValueError, "buffer holds a value above U+10FFFF");
+            return nullptr;
+        }
+        // Latin-1 data has its exact kind; wider data is scanned on demand.
+        int kind = width == PyUnicode_1BYTE_KIND ? PyUnicode_1BYTE_KIND : -1;
+        try {
+            return new MmapBuffer(obj, view, width, kind);
+        } catch (...) {
+            PyBuffer_Release(&view);
+            throw;
+        }
+    }
+
+    ~MmapBuffer() override {
+        PyBuffer_Release(&view);
+    }
+
+    MmapBuffer(const MmapBuffer&) = delete;
+    MmapBuffer& operator=(const MmapBuffer&) = delete;
+
+    Py_ssize_t length() const override {
+        return len;
+    }
+
+    /**
+     * @brief Exact kind of the content, scanned once for wide data.
+     */
+    int unicode_kind() const override {
+        int kind = cached_kind.load(std::memory_order_relaxed);
+        if (kind != -1) return kind;
+        kind = scan_kind(0, len);
+        cached_kind.store(kind, std::memory_order_relaxed);
+        return kind;
+    }
+
+    uint32_t value(Py_ssize_t index) const override {
+        if (index < 0 || index >= len) throw std::out_of_range("MmapBuffer: index out of range");
+        return with_span_data(span(), [&](auto d, Py_ssize_t) {
+            return static_cast<uint32_t>(d[index]);
+        });
+    }
+
+    void copy(uint32_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_to(target, start, count);
+    }
+
+    void copy(uint16_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_to(target, start, count);
+    }
+
+    void copy(uint8_t *target, Py_ssize_t start, Py_ssize_t count) const override {
+        copy_to(target, start, count);
+    }
+
+    /**
+     * @brief Name the exporter and length instead of dumping the content:
+     *        L<mmap.mmap:4096>.
+     */
+    PyObject* repr() const override {
+        return PyUnicode_FromFormat("L<%s:%zd>", Py_TYPE(owner.get())->tp_name, len);
+    }
+
+    /**
+     * @brief Report [start, end) as a single span over the exported memory.
+     */
+    bool get_span(Py_ssize_t start, Py_ssize_t end, BufferSpan& out) const override {
+        out = subspan(span(), start, end - start);
+        return true;
+    }
+
+    Py_ssize_t findc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override {
+        if (start < 0) start = 0;
+        if (end > len) end = len;
+        if (start >= end || ch > max_value()) return -1;
+        Py_ssize_t pos = with_span_data(subspan(span(), start, end - start), [&](auto d, Py_ssize_t n) {
+            return simd_find_range(d, n, ch, ch + 1, false);
+        });
+        return pos == -1 ? -1 : start + pos;
+    }
+
+    Py_ssize_t rfindc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override {
+        if (start < 0) start = 0;
+        if (end > len) end = len;
+        if (start >= end || ch > max_value()) return -1;
+        Py_ssize_t pos = with_span_data(subspan(span(), start, end - start), [&](auto d, Py_ssize_t n) {
+            return simd_rfind_range(d, n, ch, ch + 1, false);
+        });
+        return pos == -1 ? -1 : start + pos;
+    }
+
+    /**
+     * @brief Class searches over long buffers skip the blocks that the
+     *        class index rules out, as for str leaves.
+     */
+    Py_ssize_t findcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const override {
+        if (start < 0) start = 0;
+        if (end > len) end = len;
+        if (start >= end) return -1;
+        if (!use_class_index()) return Buffer::findcc(start, end, class_mask, invert);
+        return class_index.find(*this, start, end, class_mask, invert, [&](Py_ssize_t s, Py_ssize_t e) {
+            return Buffer::findcc(s, e, class_mask, invert);
+        });
+    }
+
+    Py_ssize_t rfindcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const override {
+        if (start < 0) start = 0;
+        if (end > len) end = len;
+        if (start >= end) return -1;
+        if (!use_class_index()) return Buffer::rfindcc(start, end, class_mask, invert);
+        return class_index.rfind(*this, start, end, class_mask, invert, [&](Py_ssize_t s, Py_ssize_t e) {
+            return Buffer::rfindcc(s, e, class_mask, invert);
+        });
+    }
+
+    /**
+     * @brief The exporting object (borrowed).
+     */
+    PyObject* get_owner() const {
+        return owner.get();
+    }
+
+    /**
+     * @brief Bytes per code point of the exported memory.
+     */
+    int width() const {
+        return storage_kind;
+    }
+
+private:
+    MmapBuffer(PyObject *obj, const Py_buffer& exported, int width, int kind)
+        : owner(obj, true), view(exported), data(static_cast<const char*>(exported.buf)),
+          len(exported.len / width), storage_kind(width), cached_kind(kind) {}
+
+    BufferSpan span() const {
+        return BufferSpan{storage_kind, data, len};
+    }
+
+    uint32_t max_value() const {
+        return storage_kind == PyUnicode_1BYTE_KIND ? 0xFF : storage_kind == PyUnicode_2BYTE_KIND ? 0xFFFF : 0x10FFFF;
+    }
+
+    bool use_class_index() const {
+        Py_ssize_t threshold = LStr_class_index_threshold.load(std::memory_order_relaxed);
+        return threshold > 0 && len >= threshold;
+    }
+
+    template <class T>
+    void copy_to(T *target, Py_ssize_t start, Py_ssize_t count) const {
+        if ((int)sizeof(T) == storage_kind) {
+            std::memcpy(target, data + start * storage_kind, count * sizeof(T));
+            return;
+        }
+        with_span_data(span(), [&](auto d, Py_ssize_t) {
+            for (Py_ssize_t i = 0; i < count; ++i) {
+                target[i] = static_cast<T>(d[start + i]);
+            }
+        });
+    }
+
+    cppy::ptr owner;
+    Py_buffer view;
+    const char *data;
+    Py_ssize_t len;
+    int storage_kind;
+    mutable std::atomic<int> cached_kind;
+
+    /** Character classes per block, used when the buffer is long enough. */
+    CharClassIndex class_index;
+};
+
+#endif // MMAP_BUFFER_HXX
@@ -2,10 +2,13 @@
 #define MUL_BUFFER_HXX
 
 #include <Python.h>
+#include <atomic>
 #include <stdexcept>
+#include <algorithm>
 #include <cstdint>
 
 #include "lstring/lstring.hxx"
+#include "poly_hash.hxx"
 #include "str_buffer.hxx"
 #include "tptr.hxx"
 #include "lstring_utils.hxx"
@@ -21,7 +24,7 @@ private:
     tptr<LStrObject> lstr_obj;
     Py_ssize_t repeat_count;
 
-    mutable Py_ssize_t cached_len;
+    mutable std::atomic<Py_ssize_t> cached_len;
 
 public:
     static constexpr int buffer_class_id = 8;
@@ -103,15 +106,31 @@ public:
      */
     ~MulBuffer() override = default;
 
+    /**
+     * @brief The repeated L object (borrowed reference).
+     */
+    PyObject* base() const {
+        return lstr_obj.ptr().get();
+    }
+
+    /**
+     * @brief Number of repetitions.
+     */
+    Py_ssize_t count() const {
+        return repeat_count;
+    }
+
     /**
      * @brief Total length of the repeated buffer.
      *
      * Returns base_length * repeat_count.
      */
     Py_ssize_t length() const override {
-        if (cached_len != -1) return cached_len;
-        cached_len = lstr_obj->buffer->length() * repeat_count;
-        return cached_len;
+        Py_ssize_t len = cached_len.load(std::memory_order_relaxed);
+        if (len != -1) return len;
+        len = lstr_obj->buffer->length() * repeat_count;
+        cached_len.store(len, std::memory_order_relaxed);
+        return len;
     }
 
     /**
@@ -123,6 +142,22 @@ public:
         return lstr_obj->buffer->unicode_kind();
     }
 
+    /**
+     * @brief A range covering a whole repetition has the base kind; shorter
+     *        ranges are at most two ranges of the base.
+     */
+    int range_kind(Py_ssize_t start, Py_ssize_t end) const override {
+        if (start >= end) return PyUnicode_1BYTE_KIND;
+        const Buffer* base = lstr_obj->buffer;
+        Py_ssize_t base_len = base->length();
+        if (end - start >= base_len) return base->unicode_kind();
+        Py_ssize_t head_start = start % base_len;
+        Py_ssize_t head_end = head_start + (end - start);
+        if (head_end <= base_len) return base->range_kind(head_start, head_end);
+        return std::max(base->range_kind(head_start, base_len),
+                        base->range_kind(0, head_end - base_len));
+    }
+
     /**
      * @brief Return code point at index in the repeated view.
      *
@@ -168,6 +203,71 @@ public:
         }
     }
 
+    /**
+     * @brief Visit spans repetition by repetition.
+     *
+     * Each repetition covered by [start, end) forwards the matching range of
+     * the base buffer.
+     */
+    bool visit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override {
+        Py_ssize_t base_len = lstr_obj->buffer->length();
+        if (base_len <= 0 || start >= end) return true;
+        Py_ssize_t rep = start / base_len;
+        Py_ssize_t off = start - rep * base_len;
+        for (Py_ssize_t pos = start; pos < end; ++rep) {
+            Py_ssize_t count = std::min(base_len - off, end - pos);
+            if (!lstr_obj->buffer->visit_spans(off, off + count, visitor)) return false;
+            pos += count;
+            off = 0;
+        }
+        return true;
+    }
+
+    bool rvisit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override {
+        Py_ssize_t base_len = lstr_obj->buffer->length();
+        if (base_len <= 0 || start >= end) return true;
+        Py_ssize_t rep = (end - 1) / base_len;
+        Py_ssize_t off_end = end - rep * base_len;
+        for (Py_ssize_t pos = end; pos > start; --rep) {
+            Py_ssize_t count = std::min(off_end, pos - start);
+            if (!lstr_obj->buffer->rvisit_spans(off_end - count, off_end, visitor)) return false;
+            pos -= count;
+            off_end = base_len;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Hash of the repetition from the cached base hash in closed form.
+     */
+    Py_uhash_t compute_hash() const override {
+        const Buffer* base = lstr_obj->buffer;
+        return hash_repeat(base->poly_hash(), base->length(), repeat_count);
+    }
+
+    /**
+     * @brief Hash a partial first repetition, the whole repetitions and a
+     *        partial last repetition, and combine them.
+     */
+    Py_uhash_t range_hash(Py_ssize_t start, Py_ssize_t end) const override {
+        if (start == 0 && end == length()) return poly_hash();
+        if (start >= end) return 0;
+        const Buffer* base = lstr_obj->buffer;
+        Py_ssize_t base_len = base->length();
+        Py_ssize_t first = start / base_len;
+        Py_ssize_t last = (end - 1) / base_len;
+        Py_ssize_t head_start = start - first * base_len;
+        Py_ssize_t tail_end = end - last * base_len;
+        if (first == last) return base->range_hash(head_start, tail_end);
+
+        Py_uhash_t h = base->range_hash(head_start, base_len);
+        Py_ssize_t whole = last - first - 1;
+        if (whole > 0) {
+            h = hash_concat(h, hash_repeat(base->poly_hash(), base_len, whole), whole * base_len);
+        }
+        return hash_concat(h, base->range_hash(0, tail_end), tail_end);
+    }
+
     /**
      * @brief Produce a Python-level repr for the repeated buffer.
      *
@@ -0,0 +1,83 @@
+#ifndef POLY_HASH_HXX
+#define POLY_HASH_HXX
+
+#include <Python.h>
+
+/**
+ * @file poly_hash.hxx
+ * @brief Arithmetic for composing the polynomial hash of buffers.
+ *
+ * The hash of code points c[0..n) is `sum(c[i] * 31^(n-1-i))` modulo 2^64
+ * (Buffer::range_hash), so for a concatenation
+ * `h(a + b) = h(a) * 31^len(b) + h(b)`.
+ */
+
+/** Multiplier of the polynomial hash. */
+static constexpr Py_uhash_t HASH_BASE = 31;
+
+/**
+ * @brief Table of HASH_BASE^(2^k), k = 0..63.
+ */
+struct HashPowers {
+    Py_uhash_t p[64];
+
+    constexpr HashPowers() : p() {
+        p[0] = HASH_BASE;
+        for (int k = 1; k < 64; ++k) p[k] = p[k - 1] * p[k - 1];
+    }
+};
+
+inline constexpr HashPowers HASH_POWERS{};
+
+/**
+ * @brief HASH_BASE^n modulo 2^64 (n >= 0), from the precomputed powers.
+ */
+inline Py_uhash_t hash_pow(Py_ssize_t n) {
+    Py_uhash_t r = 1;
+    for (int k = 0; n > 0; ++k, n >>= 1) {
+        if (n & 1) r *= HASH_POWERS.p[k];
+    }
+    return r;
+}
+
+/**
+ * @brief Hash of a concatenation from the hashes of its parts.
+ * @param left Hash of the left part.
+ * @param right Hash of the right part.
+ * @param right_len Length of the right part.
+ */
+inline Py_uhash_t hash_concat(Py_uhash_t left, Py_uhash_t right, Py_ssize_t right_len) {
+    return left * hash_pow(right_len) + right;
+}
+
+/**
+ * @brief Hash of `count` repetitions of a part.
+ *
+ * Evaluates the geometric series `h * (1 + P + ... + P^(count-1))` with
+ * `P = HASH_BASE^len` by binary splitting, since the series cannot be
+ * summed by division modulo 2^64.
+ *
+ * @param h Hash of one repetition.
+ * @param len Length of one repetition.
+ * @param count Number of repetitions (>= 0).
+ */
+inline Py_uhash_t hash_repeat(Py_uhash_t h, Py_ssize_t len, Py_ssize_t count) {
+    const Py_uhash_t step = hash_pow(len);
+    Py_uhash_t sum = 0;     // sum of P^i for i < m
+    Py_uhash_t power = 1;   // P^m
+    int top = 0;
+    while (top < 63 && (count >> (top + 1)) != 0) ++top;
+    for (int bit = top; bit >= 0 && count > 0; --bit) {
+        // m -> 2m
+        sum = sum * (1 + power);
+        power = power * power;
+        if ((count >> bit) & 1) {
+            // m -> m + 1
+            sum = sum * step + 1;
+            power = power * step;
+        }
+    }
+    return h * sum;
+}
+
+#endif // POLY_HASH_HXX
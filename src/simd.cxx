@@ -0,0 +1,362 @@
+/**
+ * @file simd.cxx
+ * @brief SSE2/AVX2 kernels for range and byte-set scans, with runtime dispatch.
+ */
+
+#include "simd.hxx"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LSTRING_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LSTRING_SIMD_AVX2 1
+#define LSTRING_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+inline int lowest_bit(uint32_t m) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, m);
+    return (int)idx;
+#else
+    return __builtin_ctz(m);
+#endif
+}
+
+inline int highest_bit(uint32_t m) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse(&idx, m);
+    return (int)idx;
+#else
+    return 31 - __builtin_clz(m);
+#endif
+}
+
+template <class T, class Test>
+inline Py_ssize_t scalar_first(const T* data, Py_ssize_t from, Py_ssize_t n, bool invert, const Test& test) {
+    for (Py_ssize_t i = from; i < n; ++i) {
+        if (test(data[i]) != invert) return i;
+    }
+    return -1;
+}
+
+template <class T, class Test>
+inline Py_ssize_t scalar_last(const T* data, Py_ssize_t n, bool invert, const Test& test) {
+    for (Py_ssize_t i = n - 1; i >= 0; --i) {
+        if (test(data[i]) != invert) return i;
+    }
+    return -1;
+}
+
+/**
+ * Scalar form of the range test used by every kernel: with w = hi - lo - 1,
+ * `lo <= ch < hi` is `ch - lo <= w` in unsigned arithmetic.
+ */
+struct RangeTest {
+    uint32_t lo;
+    uint32_t w;
+    bool operator()(uint32_t ch) const { return ch - lo <= w; }
+};
+
+struct ByteSetTest {
+    const ByteSetTables* set;
+    bool operator()(uint32_t ch) const { return set->contains(ch); }
+};
+
+/*
+ * Generic drivers. A kernel provides `value_type`, `bytes` (vector width),
+ * `uint32_t match(const value_type*)` returning the movemask of the
+ * per-byte comparison result for one vector, and a scalar `test` for the
+ * tail. Element indices are byte indices divided by sizeof(value_type).
+ * The drivers are stamped out once per target so the kernels inline.
+ */
+#define LSTRING_DEFINE_SCAN_DRIVERS(ATTR, SUFFIX)                                           \
+    template <class Kernel>                                                                 \
+    ATTR Py_ssize_t scan_first_##SUFFIX(const Kernel& k,                                    \
+            const typename Kernel::value_type* data, Py_ssize_t n, bool invert) {           \
+        constexpr Py_ssize_t lanes = Kernel::bytes / sizeof(typename Kernel::value_type);   \
+        const uint32_t full = Kernel::bytes == 32 ? 0xFFFFFFFFu : ((1u << Kernel::bytes) - 1); \
+        Py_ssize_t i = 0;                                                                   \
+        for (; i + lanes <= n; i += lanes) {                                                \
+            uint32_t m = k.match(data + i);                                                 \
+            if (invert) m ^= full;                                                          \
+            if (m) return i + lowest_bit(m) / (int)sizeof(typename Kernel::value_type);     \
+        }                                                                                   \
+        return scalar_first(data, i, n, invert, k.test);                                    \
+    }                                                                                       \
+                                                                                            \
+    template <class Kernel>                                                                 \
+    ATTR Py_ssize_t scan_last_##SUFFIX(const Kernel& k,                                     \
+            const typename Kernel::value_type* data, Py_ssize_t n, bool invert) {           \
+        constexpr Py_ssize_t lanes = Kernel::bytes / sizeof(typename Kernel::value_type);   \
+        const uint32_t full = Kernel::bytes == 32 ? 0xFFFFFFFFu : ((1u << Kernel::bytes) - 1); \
+        Py_ssize_t i = n;                                                                   \
+        while (i >= lanes) {                                                                \
+            i -= lanes;                                                                     \
+            uint32_t m = k.match(data + i);                                                 \
+            if (invert) m ^= full;                                                          \
+            if (m) return i + highest_bit(m) / (int)sizeof(typename Kernel::value_type);    \
+        }                                                                                   \
+        return scalar_last(data, i, invert, k.test);                                        \
+    }
+
+#if LSTRING_SIMD_SSE2
+
+LSTRING_DEFINE_SCAN_DRIVERS(inline, sse2)
+
+struct RangeSse2U8 {
+    using value_type = Py_UCS1;
+    static constexpr int bytes = 16;
+    __m128i lo, w;
+    RangeTest test;
+
+    RangeSse2U8(uint32_t lo_, uint32_t w_)
+        : lo(_mm_set1_epi8((char)lo_)), w(_mm_set1_epi8((char)w_)), test{lo_, w_} {}
+
+    uint32_t match(const value_type* p) const {
+        __m128i t = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)p), lo);
+        __m128i in = _mm_cmpeq_epi8(_mm_subs_epu8(t, w), _mm_setzero_si128());
+        return (uint32_t)_mm_movemask_epi8(in);
+    }
+};
+
+struct RangeSse2U16 {
+    using value_type = Py_UCS2;
+    static constexpr int bytes = 16;
+    __m128i lo, w;
+    RangeTest test;
+
+    RangeSse2U16(uint32_t lo_, uint32_t w_)
+        : lo(_mm_set1_epi16((short)lo_)), w(_mm_set1_epi16((short)w_)), test{lo_, w_} {}
+
+    uint32_t match(const value_type* p) const {
+        __m128i t = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)p), lo);
+        __m128i in = _mm_cmpeq_epi16(_mm_subs_epu16(t, w), _mm_setzero_si128());
+        return (uint32_t)_mm_movemask_epi8(in);
+    }
+};
+
+struct RangeSse2U32 {
+    using value_type = Py_UCS4;
+    static constexpr int bytes = 16;
+    __m128i lo, w, bias;
+    RangeTest test;
+
+    RangeSse2U32(uint32_t lo_, uint32_t w_)
+        : lo(_mm_set1_epi32((int)lo_)), w(_mm_set1_epi32((int)(w_ ^ 0x80000000u))),
+          bias(_mm_set1_epi32((int)0x80000000u)), test{lo_, w_} {}
+
+    uint32_t match(const value_type* p) const {
+        // No unsigned 32-bit compare in SSE2: flip the sign bit instead.
+        __m128i t = _mm_xor_si128(_mm_sub_epi32(_mm_loadu_si128((const __m128i*)p), lo), bias);
+        __m128i out = _mm_cmpgt_epi32(t, w);
+        return ~(uint32_t)_mm_movemask_epi8(out) & 0xFFFFu;
+    }
+};
+
+#endif // LSTRING_SIMD_SSE2
+
+#if LSTRING_SIMD_AVX2
+
+LSTRING_DEFINE_SCAN_DRIVERS(LSTRING_TARGET_AVX2, avx2)
+
+bool cpu_has_avx2() {
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+
+struct RangeAvx2U8 {
+    using value_type = Py_UCS1;
+    static constexpr int bytes = 32;
+    __m256i lo, w;
+    RangeTest test;
+
+    LSTRING_TARGET_AVX2 RangeAvx2U8(uint32_t lo_, uint32_t w_)
+        : lo(_mm256_set1_epi8((char)lo_)), w(_mm256_set1_epi8((char)w_)), test{lo_, w_} {}
+
+    LSTRING_TARGET_AVX2 uint32_t match(const value_type* p) const {
+        __m256i t = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i*)p), lo);
+        __m256i in = _mm256_cmpeq_epi8(_mm256_subs_epu8(t, w), _mm256_setzero_si256());
+        return (uint32_t)_mm256_movemask_epi8(in);
+    }
+};
+
+struct RangeAvx2U16 {
+    using value_type = Py_UCS2;
+    static constexpr int bytes = 32;
+    __m256i lo, w;
+    RangeTest test;
+
+    LSTRING_TARGET_AVX2 RangeAvx2U16(uint32_t lo_, uint32_t w_)
+        : lo(_mm256_set1_epi16((short)lo_)), w(_mm256_set1_epi16((short)w_)), test{lo_, w_} {}
+
+    LSTRING_TARGET_AVX2 uint32_t match(const value_type* p) const {
+        __m256i t = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i*)p), lo);
+        __m256i in = _mm256_cmpeq_epi16(_mm256_subs_epu16(t, w), _mm256_setzero_si256());
+        return (uint32_t)_mm256_movemask_epi8(in);
+    }
+};
+
+struct RangeAvx2U32 {
+    using value_type = Py_UCS4;
+    static constexpr int bytes = 32;
+    __m256i lo, w;
+    RangeTest test;
+
+    LSTRING_TARGET_AVX2 RangeAvx2U32(uint32_t lo_, uint32_t w_)
+        : lo(_mm256_set1_epi32((int)lo_)), w(_mm256_set1_epi32((int)w_)), test{lo_, w_} {}
+
+    LSTRING_TARGET_AVX2 uint32_t match(const value_type* p) const {
+        // t <= w (unsigned) exactly when min(t, w) == t.
+        __m256i t = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)p), lo);
+        __m256i in = _mm256_cmpeq_epi32(_mm256_min_epu32(t, w), t);
+        return (uint32_t)_mm256_movemask_epi8(in);
+    }
+};
+
+/**
+ * Shuffle-based byte set membership: the low nibble selects a row of the
+ * nibble tables, the high nibble selects the bit within the row.
+ */
+struct ByteSetAvx2 {
+    using value_type = Py_UCS1;
+    static constexpr int bytes = 32;
+    __m256i low, high, bits, nibble, seven;
+    ByteSetTest test;
+
+    LSTRING_TARGET_AVX2 explicit ByteSetAvx2(const ByteSetTables& set)
+        : low(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set.low))),
+          high(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set.high))),
+          bits(_mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128)),
+          nibble(_mm256_set1_epi8(0x0F)), seven(_mm256_set1_epi8(7)), test{&set} {}
+
+    LSTRING_TARGET_AVX2 uint32_t match(const value_type* p) const {
+        __m256i x = _mm256_loadu_si256((const __m256i*)p);
+        __m256i lo = _mm256_and_si256(x, nibble);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+        __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(low, lo),
+                                         _mm256_shuffle_epi8(high, lo),
+                                         _mm256_cmpgt_epi8(hi, seven));
+        __m256i bit = _mm256_shuffle_epi8(bits, hi);
+        __m256i hit = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+        return (uint32_t)_mm256_movemask_epi8(hit);
+    }
+};
+
+template <class Kernel, class... Args>
+LSTRING_TARGET_AVX2 Py_ssize_t avx2_first(const typename Kernel::value_type* data, Py_ssize_t n,
+                                          bool invert, const Args&... args) {
+    Kernel k(args...);
+    return scan_first_avx2(k, data, n, invert);
+}
+
+template <class Kernel, class... Args>
+LSTRING_TARGET_AVX2 Py_ssize_t avx2_last(const typename Kernel::value_type* data, Py_ssize_t n,
+                                         bool invert, const Args&... args) {
+    Kernel k(args...);
+    return scan_last_avx2(k, data, n, invert);
+}
+
+#endif // LSTRING_SIMD_AVX2
+
+/** Range bounds clamped to the code points representable by the kind. */
+inline bool clamp_range(uint32_t kind_max, uint32_t lo, uint32_t& hi, uint32_t& w) {
+    if (lo > kind_max) return false;
+    if (hi > kind_max + 1) hi = kind_max + 1;
+    w = hi - lo - 1;
+    return true;
+}
+
+/*
+ * Dispatch shared by the public functions: AVX2 when available and the
+ * input spans at least one vector, SSE2 otherwise, scalar without SIMD.
+ */
+#if LSTRING_SIMD_AVX2
+#define LSTRING_TRY_AVX2(DIR, KERNEL, ...)                                                  \
+    if (n >= KERNEL::bytes / (Py_ssize_t)sizeof(typename KERNEL::value_type) && cpu_has_avx2()) { \
+        return avx2_##DIR<KERNEL>(data, n, invert, __VA_ARGS__);                            \
+    }
+#else
+#define LSTRING_TRY_AVX2(DIR, KERNEL, ...)
+#endif
+
+#if LSTRING_SIMD_SSE2
+#define LSTRING_SCAN(DIR, SSE2_KERNEL, SCALAR_TEST, ...)                                    \
+    return scan_##DIR##_sse2(SSE2_KERNEL(__VA_ARGS__), data, n, invert);
+#else
+#define LSTRING_SCAN(DIR, SSE2_KERNEL, SCALAR_TEST, ...)                                    \
+    return scalar_##DIR##_dispatch(data, n, invert, SCALAR_TEST);
+#endif
+
+template <class T, class Test>
+inline Py_ssize_t scalar_first_dispatch(const T* data, Py_ssize_t n, bool invert, const Test& test) {
+    return scalar_first(data, 0, n, invert, test);
+}
+
+template <class T, class Test>
+inline Py_ssize_t scalar_last_dispatch(const T* data, Py_ssize_t n, bool invert, const Test& test) {
+    return scalar_last(data, n, invert, test);
+}
+
+} // namespace
+
+Py_ssize_t simd_find_range(const Py_UCS1* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert) {
+    uint32_t w;
+    if (!clamp_range(0xFF, lo, hi, w)) return invert && n > 0 ? 0 : -1;
+    LSTRING_TRY_AVX2(first, RangeAvx2U8, lo, w)
+    LSTRING_SCAN(first, RangeSse2U8, (RangeTest{lo, w}), lo, w)
+}
+
+Py_ssize_t simd_find_range(const Py_UCS2* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert) {
+    uint32_t w;
+    if (!clamp_range(0xFFFF, lo, hi, w)) return invert && n > 0 ? 0 : -1;
+    LSTRING_TRY_AVX2(first, RangeAvx2U16, lo, w)
+    LSTRING_SCAN(first, RangeSse2U16, (RangeTest{lo, w}), lo, w)
+}
+
+Py_ssize_t simd_find_range(const Py_UCS4* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert) {
+    uint32_t w = hi - lo - 1;
+    LSTRING_TRY_AVX2(first, RangeAvx2U32, lo, w)
+    LSTRING_SCAN(first, RangeSse2U32, (RangeTest{lo, w}), lo, w)
+}
+
+Py_ssize_t simd_rfind_range(const Py_UCS1* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert) {
+    uint32_t w;
+    if (!clamp_range(0xFF, lo, hi, w)) return invert ? n - 1 : -1;
+    LSTRING_TRY_AVX2(last, RangeAvx2U8, lo, w)
+    LSTRING_SCAN(last, RangeSse2U8, (RangeTest{lo, w}), lo, w)
+}
+
+Py_ssize_t simd_rfind_range(const Py_UCS2* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert) {
+    uint32_t w;
+    if (!clamp_range(0xFFFF, lo, hi, w)) return invert ? n - 1 : -1;
+    LSTRING_TRY_AVX2(last, RangeAvx2U16, lo, w)
+    LSTRING_SCAN(last, RangeSse2U16, (RangeTest{lo, w}), lo, w)
+}
+
+Py_ssize_t simd_rfind_range(const Py_UCS4* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert) {
+    uint32_t w = hi - lo - 1;
+    LSTRING_TRY_AVX2(last, RangeAvx2U32, lo, w)
+    LSTRING_SCAN(last, RangeSse2U32, (RangeTest{lo, w}), lo, w)
+}
+
+Py_ssize_t simd_find_byteset(const Py_UCS1* data, Py_ssize_t n, const ByteSetTables& set, bool invert) {
+    LSTRING_TRY_AVX2(first, ByteSetAvx2, set)
+    return scalar_first(data, 0, n, invert, ByteSetTest{&set});
+}
+
+Py_ssize_t simd_rfind_byteset(const Py_UCS1* data, Py_ssize_t n, const ByteSetTables& set, bool invert) {
+    LSTRING_TRY_AVX2(last, ByteSetAvx2, set)
+    return scalar_last(data, n, invert, ByteSetTest{&set});
+}
@@ -0,0 +1,56 @@
+#ifndef LSTRING_SIMD_HXX
+#define LSTRING_SIMD_HXX
+
+#include <Python.h>
+#include <cstdint>
+
+/**
+ * @file simd.hxx
+ * @brief Vectorized scans over contiguous UCS1/UCS2/UCS4 data.
+ *
+ * On x86 the kernels use SSE2 (part of the x86-64 baseline) and switch to
+ * AVX2 variants when the CPU reports support at runtime. Other platforms
+ * use the scalar loops. All functions return the index of the first (or,
+ * for the `rfind` variants, last) matching element, or -1.
+ */
+
+/**
+ * @brief Lookup tables describing a set of byte values.
+ *
+ * `mask` is a 256-bit membership bitmap. `low`/`high` are the nibble
+ * tables of the shuffle-based lookup: bit `h` of `low[l]` is set if the
+ * byte `h * 16 + l` is a member, and bit `h - 8` of `high[l]` for the upper
+ * half of the byte range.
+ */
+struct ByteSetTables {
+    uint64_t mask[4];
+    uint8_t low[16];
+    uint8_t high[16];
+
+    void add(uint32_t u) {
+        mask[u >> 6] |= (1ULL << (u & 63));
+        if (u < 128) {
+            low[u & 15] |= static_cast<uint8_t>(1u << (u >> 4));
+        } else {
+            high[u & 15] |= static_cast<uint8_t>(1u << ((u >> 4) - 8));
+        }
+    }
+
+    bool contains(uint32_t u) const {
+        return u < 256 && (mask[u >> 6] & (1ULL << (u & 63))) != 0;
+    }
+};
+
+/** Find a code point in (or, if invert, outside) [lo, hi); requires lo < hi. */
+Py_ssize_t simd_find_range(const Py_UCS1* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert);
+Py_ssize_t simd_find_range(const Py_UCS2* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert);
+Py_ssize_t simd_find_range(const Py_UCS4* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert);
+Py_ssize_t simd_rfind_range(const Py_UCS1* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert);
+Py_ssize_t simd_rfind_range(const Py_UCS2* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert);
+Py_ssize_t simd_rfind_range(const Py_UCS4* data, Py_ssize_t n, uint32_t lo, uint32_t hi, bool invert);
+
+/** Find a byte that is (or, if invert, is not) a member of the set. */
+Py_ssize_t simd_find_byteset(const Py_UCS1* data, Py_ssize_t n, const ByteSetTables& set, bool invert);
+Py_ssize_t simd_rfind_byteset(const Py_UCS1* data, Py_ssize_t n, const ByteSetTables& set, bool invert);
+
+#endif // LSTRING_SIMD_HXX
@@ -2,10 +2,12 @@
 #define SLICE_BUFFER_HXX
 
 #include <Python.h>
+#include <atomic>
 #include <stdexcept>
 #include <cstdint>
 
 #include "lstring/lstring.hxx"
+#include "poly_hash.hxx"
 #include "str_buffer.hxx"
 #include "tptr.hxx"
 #include "lstring_utils.hxx"
@@ -22,8 +24,8 @@ protected:
     Py_ssize_t start_index;
     Py_ssize_t end_index;
 
-    mutable Py_ssize_t cached_kind;
-    mutable Py_ssize_t cached_len;
+    mutable std::atomic<int> cached_kind;
+    mutable std::atomic<Py_ssize_t> cached_len;
 
 public:
     static constexpr int buffer_class_id = 6;
@@ -48,56 +50,51 @@ public:
      */
     ~Slice1Buffer() override = default;
 
+    /**
+     * @brief The sliced L object (borrowed reference).
+     */
+    PyObject* base() const {
+        return lstr_obj.ptr().get();
+    }
+
+    /**
+     * @brief Start index of the slice within the base buffer.
+     */
+    Py_ssize_t base_start() const {
+        return start_index;
+    }
+
     /**
      * @brief Length of the continuous slice.
      *
      * Returns max(0, end - start).
      */
     Py_ssize_t length() const override {
-        if (cached_len != -1) return cached_len;
-        cached_len = end_index > start_index ? (end_index - start_index) : 0;
-        return cached_len;
+        Py_ssize_t len = cached_len.load(std::memory_order_relaxed);
+        if (len != -1) return len;
+        len = end_index > start_index ? (end_index - start_index) : 0;
+        cached_len.store(len, std::memory_order_relaxed);
+        return len;
     }
 
     /**
      * @brief Determine the minimal Unicode storage kind required by this slice.
      *
-     * Caches the computed kind in `cached_kind`. If the underlying buffer
-     * suggests a larger kind, this function scans the slice to see whether a
-     * narrower representation suffices (e.g. all code points fit in 1-byte).
+     * Asks the base for the kind of the sliced range, so only the parts of
+     * it not covered by a cached node summary are scanned, and caches the
+     * result in `cached_kind`.
      */
     int unicode_kind() const override {
-        if (cached_kind != -1) return cached_kind;
-
-        int original_kind = lstr_obj->buffer->unicode_kind();
-        if(original_kind == PyUnicode_1BYTE_KIND) {
-            cached_kind = PyUnicode_1BYTE_KIND;
-        } else if(original_kind == PyUnicode_2BYTE_KIND) {
-            // check if all char are in 1-byte range
-            int kind = PyUnicode_1BYTE_KIND;
-            for(Py_ssize_t index=0; index < length(); index++) {
-                if(value(index) >= 0x100) {
-                    kind = PyUnicode_2BYTE_KIND;
-                    break;
-                }
-            }
-            cached_kind = kind;
-        } else if(original_kind == PyUnicode_4BYTE_KIND) {
-            // check if all char are in 1-byte or 2-byte range
-            int kind = PyUnicode_1BYTE_KIND;
-            for(Py_ssize_t index=0; index < length(); index++) {
-                if(value(index) >= 0x10000) {
-                    kind = PyUnicode_4BYTE_KIND;
-                    break;
-                } else if(value(index) >= 0x100) {
-                    if(kind < PyUnicode_2BYTE_KIND) {
-                        kind = PyUnicode_2BYTE_KIND;
-                    }
-                }
-            }
-            cached_kind = kind;
-        }
-        return cached_kind;
+        int kind = cached_kind.load(std::memory_order_relaxed);
+        if (kind != -1) return kind;
+        kind = lstr_obj->buffer->range_kind(start_index, start_index + length());
+        cached_kind.store(kind, std::memory_order_relaxed);
+        return kind;
+    }
+
+    int range_kind(Py_ssize_t start, Py_ssize_t end) const override {
+        if (start == 0 && end == length()) return unicode_kind();
+        return lstr_obj->buffer->range_kind(start_index + start, start_index + end);
     }
 
     /**
@@ -131,6 +128,30 @@ public:
         lstr_obj->buffer->copy(target, start_index + start, count);
     }
 
+    /**
+     * @brief Visit spans of the slice by forwarding the shifted range to the base.
+     */
+    bool visit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override {
+        return lstr_obj->buffer->visit_spans(start_index + start, start_index + end, visitor);
+    }
+
+    bool rvisit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override {
+        return lstr_obj->buffer->rvisit_spans(start_index + start, start_index + end, visitor);
+    }
+
+    /**
+     * @brief Hash of the slice as a range of the base buffer, so a slice of
+     *        a rope reuses the cached hashes of the subtrees it covers.
+     */
+    Py_uhash_t compute_hash() const override {
+        return lstr_obj->buffer->range_hash(start_index, start_index + length());
+    }
+
+    Py_uhash_t range_hash(Py_ssize_t start, Py_ssize_t end) const override {
+        if (start == 0 && end == length()) return poly_hash();
+        return lstr_obj->buffer->range_hash(start_index + start, start_index + end);
+    }
+
     /**
      * @brief Produce a Python-level repr for the slice (e.g. "<inner>[start:end]").
      */
@@ -304,6 +325,45 @@ public:
         }
     }
 
+    /**
+     * @brief Strided slices have no contiguous storage; use the chunked
+     *        Buffer implementation instead of the Slice1Buffer forwarding.
+     */
+    bool visit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override {
+        return Buffer::visit_spans(start, end, visitor);
+    }
+
+    bool rvisit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override {
+        return Buffer::rvisit_spans(start, end, visitor);
+    }
+
+    /**
+     * @brief Strided slices are hashed from their code points.
+     */
+    Py_uhash_t compute_hash() const override {
+        return Buffer::compute_hash();
+    }
+
+    Py_uhash_t range_hash(Py_ssize_t start, Py_ssize_t end) const override {
+        return Buffer::range_hash(start, end);
+    }
+
+    /**
+     * @brief Strided slices scan their code points for the kind, once.
+     */
+    int unicode_kind() const override {
+        int kind = cached_kind.load(std::memory_order_relaxed);
+        if (kind != -1) return kind;
+        kind = lstr_obj->buffer->unicode_kind();
+        if (kind != PyUnicode_1BYTE_KIND) kind = scan_kind(0, length());
+        cached_kind.store(kind, std::memory_order_relaxed);
+        return kind;
+    }
+
+    int range_kind(Py_ssize_t start, Py_ssize_t end) const override {
+        return Buffer::range_kind(start, end);
+    }
+
     /**
      * @brief Produce a Python-level repr for the strided slice ("<inner>[start:end:step]").
      */
@@ -346,6 +406,35 @@ public:
         }
         return -1;
     }
+
+    /*
+     * The Slice1Buffer versions map the range onto the base buffer
+     * contiguously, which is wrong for step != 1. Use the generic
+     * span-based Buffer implementations instead.
+     */
+    Py_ssize_t findcr(Py_ssize_t start, Py_ssize_t end, uint32_t startcp, uint32_t endcp, bool invert) const override {
+        return Buffer::findcr(start, end, startcp, endcp, invert);
+    }
+
+    Py_ssize_t rfindcr(Py_ssize_t start, Py_ssize_t end, uint32_t startcp, uint32_t endcp, bool invert) const override {
+        return Buffer::rfindcr(start, end, startcp, endcp, invert);
+    }
+
+    Py_ssize_t findcs(Py_ssize_t start, Py_ssize_t end, const CharSet& charset, bool invert = false) const override {
+        return Buffer::findcs(start, end, charset, invert);
+    }
+
+    Py_ssize_t rfindcs(Py_ssize_t start, Py_ssize_t end, const CharSet& charset, bool invert = false) const override {
+        return Buffer::rfindcs(start, end, charset, invert);
+    }
+
+    Py_ssize_t findcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const override {
+        return Buffer::findcc(start, end, class_mask, invert);
+    }
+
+    Py_ssize_t rfindcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const override {
+        return Buffer::rfindcc(start, end, class_mask, invert);
+    }
 };
 
 #endif // SLICE_BUFFER_HXX
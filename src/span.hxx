@@ -0,0 +1,185 @@
+#ifndef SPAN_HXX
+#define SPAN_HXX
+
+#include <Python.h>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "lstring/lstring.hxx"
+
+/** Size of the scratch area used when a buffer has no contiguous storage. */
+static constexpr Py_ssize_t SPAN_SCRATCH_SIZE = 256;
+
+/**
+ * @brief SpanVisitor adapter around a callable `bool fn(const BufferSpan&)`.
+ */
+template <class Fn>
+class SpanFnVisitor final : public SpanVisitor {
+public:
+    explicit SpanFnVisitor(Fn& fn) : fn_(fn) {}
+
+    bool visit(const BufferSpan& span) override {
+        return fn_(span);
+    }
+
+private:
+    Fn& fn_;
+};
+
+/**
+ * @brief Visit spans of buf in [start, end) left to right with a callable.
+ * @return false if the callable stopped the traversal.
+ */
+template <class Fn>
+inline bool for_each_span(const Buffer& buf, Py_ssize_t start, Py_ssize_t end, Fn&& fn) {
+    SpanFnVisitor<std::remove_reference_t<Fn>> visitor(fn);
+    return buf.visit_spans(start, end, visitor);
+}
+
+/**
+ * @brief Visit spans of buf in [start, end) right to left with a callable.
+ * @return false if the callable stopped the traversal.
+ */
+template <class Fn>
+inline bool for_each_span_reverse(const Buffer& buf, Py_ssize_t start, Py_ssize_t end, Fn&& fn) {
+    SpanFnVisitor<std::remove_reference_t<Fn>> visitor(fn);
+    return buf.rvisit_spans(start, end, visitor);
+}
+
+/**
+ * @brief Call fn(data, length) with span data cast to its storage type.
+ */
+template <class Fn>
+inline auto with_span_data(const BufferSpan& span, Fn&& fn) {
+    switch (span.kind) {
+        case PyUnicode_1BYTE_KIND:
+            return fn(static_cast<const Py_UCS1*>(span.data), span.length);
+        case PyUnicode_2BYTE_KIND:
+            return fn(static_cast<const Py_UCS2*>(span.data), span.length);
+        default:
+            return fn(static_cast<const Py_UCS4*>(span.data), span.length);
+    }
+}
+
+/**
+ * @brief Return a span covering `count` code points of span from `offset`.
+ */
+inline BufferSpan subspan(const BufferSpan& span, Py_ssize_t offset, Py_ssize_t count) {
+    return BufferSpan{
+        span.kind,
+        static_cast<const char*>(span.data) + offset * span.kind,
+        count
+    };
+}
+
+/**
+ * @brief Compare the first `count` code points of two spans.
+ *
+ * Spans of the same kind are checked with memcmp first (spans over the
+ * same storage are equal without looking at it); the ordered comparison
+ * loop only runs to locate a difference.
+ *
+ * @return -1, 0 or 1 like Buffer::cmp.
+ */
+inline int compare_spans(const BufferSpan& a, const BufferSpan& b, Py_ssize_t count) {
+    if (a.kind == b.kind) {
+        if (a.data == b.data) return 0;
+        if (std::memcmp(a.data, b.data, (size_t)(count * a.kind)) == 0) return 0;
+        if (a.kind == PyUnicode_1BYTE_KIND) {
+            // Bytes compare in code point order.
+            return std::memcmp(a.data, b.data, (size_t)count) < 0 ? -1 : 1;
+        }
+    }
+    return with_span_data(a, [&](auto adata, Py_ssize_t) {
+        return with_span_data(b, [&](auto bdata, Py_ssize_t) {
+            for (Py_ssize_t k = 0; k < count; ++k) {
+                uint32_t c1 = adata[k];
+                uint32_t c2 = bdata[k];
+                if (c1 < c2) return -1;
+                if (c1 > c2) return 1;
+            }
+            return 0;
+        });
+    });
+}
+
+/**
+ * @brief Find the first index in [start, end) reported by a span kernel.
+ *
+ * `kernel(const BufferSpan&)` returns the offset of the first match within
+ * the span, or -1.
+ * @return The index, or -1 if no span has a match.
+ */
+template <class Kernel>
+inline Py_ssize_t span_find_first(const Buffer& buf, Py_ssize_t start, Py_ssize_t end, Kernel&& kernel) {
+    Py_ssize_t pos = start;
+    Py_ssize_t found = -1;
+    for_each_span(buf, start, end, [&](const BufferSpan& span) {
+        Py_ssize_t i = kernel(span);
+        if (i != -1) {
+            found = pos + i;
+            return false;
+        }
+        pos += span.length;
+        return true;
+    });
+    return found;
+}
+
+/**
+ * @brief Find the last index in [start, end) reported by a span kernel.
+ *
+ * `kernel(const BufferSpan&)` returns the offset of the last match within
+ * the span, or -1.
+ * @return The index, or -1 if no span has a match.
+ */
+template <class Kernel>
+inline Py_ssize_t span_find_last(const Buffer& buf, Py_ssize_t start, Py_ssize_t end, Kernel&& kernel) {
+    Py_ssize_t pos = end;
+    Py_ssize_t found = -1;
+    for_each_span_reverse(buf, start, end, [&](const BufferSpan& span) {
+        pos -= span.length;
+        Py_ssize_t i = kernel(span);
+        if (i != -1) {
+            found = pos + i;
+            return false;
+        }
+        return true;
+    });
+    return found;
+}
+
+/**
+ * @brief Find the first index in [start, end) whose code point satisfies pred.
+ * @return The index, or -1 if no code point matches.
+ */
+template <class Pred>
+inline Py_ssize_t span_find_if(const Buffer& buf, Py_ssize_t start, Py_ssize_t end, Pred&& pred) {
+    return span_find_first(buf, start, end, [&](const BufferSpan& span) {
+        return with_span_data(span, [&](auto data, Py_ssize_t n) -> Py_ssize_t {
+            for (Py_ssize_t k = 0; k < n; ++k) {
+                if (pred(static_cast<uint32_t>(data[k]))) return k;
+            }
+            return -1;
+        });
+    });
+}
+
+/**
+ * @brief Find the last index in [start, end) whose code point satisfies pred.
+ * @return The index, or -1 if no code point matches.
+ */
+template <class Pred>
+inline Py_ssize_t span_rfind_if(const Buffer& buf, Py_ssize_t start, Py_ssize_t end, Pred&& pred) {
+    return span_find_last(buf, start, end, [&](const BufferSpan& span) {
+        return with_span_data(span, [&](auto data, Py_ssize_t n) -> Py_ssize_t {
+            for (Py_ssize_t k = n - 1; k >= 0; --k) {
+                if (pred(static_cast<uint32_t>(data[k]))) return k;
+            }
+            return -1;
+        });
+    });
+}
+
+#endif // SPAN_HXX
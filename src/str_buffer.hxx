@@ -2,11 +2,18 @@
 #define STR_BUFFER_HXX
 
 #include <Python.h>
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
+#include <new>
 #include <cppy/ptr.h>
 
 #include "lstring/lstring.hxx"
+#include "_lstring.hxx"
+#include "class_index.hxx"
+#include "span.hxx"
+#include "simd.hxx"
 
 /**
  * @brief StrBuffer base class (backed by a Python str)
@@ -18,6 +25,18 @@ class StrBuffer : public Buffer {
 protected:
     cppy::ptr py_str;
 
+    /** Code points summarized by one entry of the kind index. */
+    static constexpr Py_ssize_t KIND_BLOCK = 2048;
+
+    /**
+     * Kind of each KIND_BLOCK block of the string (0 until scanned), built on
+     * the first range_kind() query spanning several blocks.
+     */
+    mutable std::atomic<std::atomic<uint8_t>*> kind_index;
+
+    /** Character classes per block, used when the string is long enough. */
+    CharClassIndex class_index;
+
 public:
     static constexpr int buffer_class_id = 2;
 
@@ -30,12 +49,14 @@ public:
      * @param str A Python unicode object (PyObject*). The constructor
      *            will take ownership via an owning cppy::ptr wrapper.
      */
-    StrBuffer(PyObject *str) : py_str(str, true) {}
+    StrBuffer(PyObject *str) : py_str(str, true), kind_index(nullptr) {}
 
     /**
-     * @brief Default virtual destructor.
+     * @brief Release the kind index.
      */
-    ~StrBuffer() override = default;
+    ~StrBuffer() override {
+        delete[] kind_index.load(std::memory_order_relaxed);
+    }
 
     /**
      * @brief Return the number of Unicode code points in the buffer.
@@ -115,6 +136,17 @@ public:
         return true;
     }
 
+    /**
+     * @brief Report [start, end) as a single span over the str storage.
+     */
+    bool get_span(Py_ssize_t start, Py_ssize_t end, BufferSpan& span) const override {
+        PyObject *s = py_str.get();
+        const int kind = PyUnicode_KIND(s);
+        const char *data = static_cast<const char*>(PyUnicode_DATA(s));
+        span = BufferSpan{kind, data + start * kind, end - start};
+        return true;
+    }
+
     /**
      * @brief Access the underlying Python str object.
      * @return Borrowed PyObject* pointing to the Python Unicode object.
@@ -126,98 +158,198 @@ public:
     /**
      * @brief Find a single code point in the wrapped Python string.
      *
-     * Uses PyUnicode_FindChar which understands Python slice semantics and
-     * is implemented efficiently in CPython. start/end are used as given.
+     * Scans the str storage directly with the vector range kernel rather
+     * than PyUnicode_FindChar, so the search needs no C API call and may
+     * run without the GIL.
      */
     Py_ssize_t findc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override {
-        PyObject *s = py_str.get();
-        return PyUnicode_FindChar(s, (Py_UCS4)ch, start, end, 1);
+        BufferSpan span;
+        if (!find_span(start, end, ch, span)) return -1;
+        Py_ssize_t pos = with_span_data(span, [&](auto data, Py_ssize_t n) {
+            return simd_find_range(data, n, ch, ch + 1, false);
+        });
+        return pos == -1 ? -1 : start + pos;
     }
 
     /**
      * @brief Find a single code point searching from the right.
      */
     Py_ssize_t rfindc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override {
-        PyObject *s = py_str.get();
-        return PyUnicode_FindChar(s, (Py_UCS4)ch, start, end, -1);
+        BufferSpan span;
+        if (!find_span(start, end, ch, span)) return -1;
+        Py_ssize_t pos = with_span_data(span, [&](auto data, Py_ssize_t n) {
+            return simd_rfind_range(data, n, ch, ch + 1, false);
+        });
+        return pos == -1 ? -1 : start + pos;
     }
 
     /**
-     * @brief Specialized comparison for StrBuffer.
-     *
-     * If the other buffer is also a string (is_str() == true), use
-     * PyUnicode_Compare for efficient Python string comparison.
-     * Otherwise, fall back to the base class implementation.
+     * @brief Kind of a range of a wide string.
      *
-     * @param other Other buffer to compare with.
-     * @return -1 if *this < other, 0 if equal, 1 if *this > other.
+     * Long ranges are answered from the per-block kind index: the blocks
+     * the range covers are scanned at most once over the buffer's lifetime,
+     * and the parts of the range outside whole blocks are scanned directly.
      */
-    int cmp(const Buffer* other) const override {
-        if (other->is_str()) {
-            // Both are Python strings, use PyUnicode_Compare
-            const StrBuffer* other_str = static_cast<const StrBuffer*>(other);
-            return PyUnicode_Compare(get_str(), other_str->get_str());
+    int range_kind(Py_ssize_t start, Py_ssize_t end) const override {
+        if (start >= end) return PyUnicode_1BYTE_KIND;
+        int kind = unicode_kind();
+        if (kind == PyUnicode_1BYTE_KIND || (start == 0 && end == length())) return kind;
+
+        Py_ssize_t first = (start + KIND_BLOCK - 1) / KIND_BLOCK;
+        Py_ssize_t last = end / KIND_BLOCK;
+        std::atomic<uint8_t>* index = last - first >= 2 ? get_kind_index() : nullptr;
+        if (!index) return scan_kind(start, end);
+
+        int result = PyUnicode_1BYTE_KIND;
+        for (Py_ssize_t b = first; b < last && result != kind; ++b) {
+            int block_kind = index[b].load(std::memory_order_relaxed);
+            if (block_kind == 0) {
+                block_kind = scan_kind(b * KIND_BLOCK, std::min(length(), (b + 1) * KIND_BLOCK));
+                index[b].store((uint8_t)block_kind, std::memory_order_relaxed);
+            }
+            result = std::max(result, block_kind);
         }
-        // Fall back to base class implementation
-        return Buffer::cmp(other);
+        if (result != kind) result = std::max(result, scan_kind(start, first * KIND_BLOCK));
+        if (result != kind) result = std::max(result, scan_kind(last * KIND_BLOCK, end));
+        return result;
     }
 
     /**
-     * @brief Character classification methods using Python string methods.
-     *
-     * These override the base Buffer implementations with optimized
-     * Python native string methods.
+     * @brief Class searches over long strings skip the blocks that the
+     *        class index rules out.
+     */
+    Py_ssize_t findcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const override {
+        if (start < 0) start = 0;
+        if (end > length()) end = length();
+        if (start >= end) return -1;
+        if (!use_class_index()) return Buffer::findcc(start, end, class_mask, invert);
+        return class_index.find(*this, start, end, class_mask, invert, [&](Py_ssize_t s, Py_ssize_t e) {
+            return Buffer::findcc(s, e, class_mask, invert);
+        });
+    }
+
+    Py_ssize_t rfindcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const override {
+        if (start < 0) start = 0;
+        if (end > length()) end = length();
+        if (start >= end) return -1;
+        if (!use_class_index()) return Buffer::rfindcc(start, end, class_mask, invert);
+        return class_index.rfind(*this, start, end, class_mask, invert, [&](Py_ssize_t s, Py_ssize_t e) {
+            return Buffer::rfindcc(s, e, class_mask, invert);
+        });
+    }
+
+    /**
+     * @brief Classification of long strings as class searches, so they are
+     *        answered from the class index.
      */
     bool isspace() const override {
-        cppy::ptr result(PyObject_CallMethod(py_str.get(), "isspace", nullptr));
-        return result && PyObject_IsTrue(result.get());
+        return use_class_index() ? all_in_class(CHAR_SPACE) : Buffer::isspace();
     }
 
     bool isalpha() const override {
-        cppy::ptr result(PyObject_CallMethod(py_str.get(), "isalpha", nullptr));
-        return result && PyObject_IsTrue(result.get());
+        return use_class_index() ? all_in_class(CHAR_ALPHA) : Buffer::isalpha();
     }
 
     bool isdigit() const override {
-        cppy::ptr result(PyObject_CallMethod(py_str.get(), "isdigit", nullptr));
-        return result && PyObject_IsTrue(result.get());
+        return use_class_index() ? all_in_class(CHAR_DIGIT) : Buffer::isdigit();
     }
 
     bool isalnum() const override {
-        cppy::ptr result(PyObject_CallMethod(py_str.get(), "isalnum", nullptr));
-        return result && PyObject_IsTrue(result.get());
+        // Py_UNICODE_ISALNUM also accepts decimals and digits.
+        return use_class_index() ? all_in_class(CHAR_ALPHA | CHAR_DECIMAL | CHAR_DIGIT | CHAR_NUMERIC)
+                                 : Buffer::isalnum();
+    }
+
+    bool isdecimal() const override {
+        return use_class_index() ? all_in_class(CHAR_DECIMAL) : Buffer::isdecimal();
+    }
+
+    bool isnumeric() const override {
+        return use_class_index() ? all_in_class(CHAR_NUMERIC) : Buffer::isnumeric();
+    }
+
+    bool isprintable() const override {
+        // Unlike the other tests, the empty string is printable; it is
+        // never long enough for the index.
+        return use_class_index() ? all_in_class(CHAR_PRINTABLE) : Buffer::isprintable();
     }
 
     bool isupper() const override {
-        cppy::ptr result(PyObject_CallMethod(py_str.get(), "isupper", nullptr));
-        return result && PyObject_IsTrue(result.get());
+        if (!use_class_index()) return Buffer::isupper();
+        return findcc(0, length(), CHAR_LOWER) == -1 && findcc(0, length(), CHAR_UPPER) != -1;
     }
 
     bool islower() const override {
-        cppy::ptr result(PyObject_CallMethod(py_str.get(), "islower", nullptr));
-        return result && PyObject_IsTrue(result.get());
+        if (!use_class_index()) return Buffer::islower();
+        return findcc(0, length(), CHAR_UPPER) == -1 && findcc(0, length(), CHAR_LOWER) != -1;
     }
 
-    bool isdecimal() const override {
-        cppy::ptr result(PyObject_CallMethod(py_str.get(), "isdecimal", nullptr));
-        return result && PyObject_IsTrue(result.get());
+    /**
+     * @brief Specialized comparison for StrBuffer.
+     *
+     * If the other buffer is also a string (is_str() == true), use
+     * PyUnicode_Compare for efficient Python string comparison.
+     * Otherwise, fall back to the base class implementation.
+     *
+     * @param other Other buffer to compare with.
+     * @return -1 if *this < other, 0 if equal, 1 if *this > other.
+     */
+    int cmp(const Buffer* other) const override {
+        if (other->is_str()) {
+            // Both are Python strings, use PyUnicode_Compare
+            const StrBuffer* other_str = static_cast<const StrBuffer*>(other);
+            return PyUnicode_Compare(get_str(), other_str->get_str());
+        }
+        // Fall back to base class implementation
+        return Buffer::cmp(other);
     }
 
-    bool isnumeric() const override {
-        cppy::ptr result(PyObject_CallMethod(py_str.get(), "isnumeric", nullptr));
-        return result && PyObject_IsTrue(result.get());
+private:
+    /**
+     * @brief Clamp [start, end) and report it as a span, or return false if
+     *        `ch` cannot occur in it.
+     */
+    bool find_span(Py_ssize_t& start, Py_ssize_t end, uint32_t ch, BufferSpan& span) const {
+        PyObject *s = py_str.get();
+        Py_ssize_t len = PyUnicode_GET_LENGTH(s);
+        if (start < 0) start = 0;
+        if (end > len) end = len;
+        if (start >= end) return false;
+        // Code points wider than the storage cannot be present.
+        if (ch > PyUnicode_MAX_CHAR_VALUE(s)) return false;
+        return get_span(start, end, span);
     }
 
-    bool isprintable() const override {
-        cppy::ptr result(PyObject_CallMethod(py_str.get(), "isprintable", nullptr));
-        return result && PyObject_IsTrue(result.get());
+    bool use_class_index() const {
+        Py_ssize_t threshold = LStr_class_index_threshold.load(std::memory_order_relaxed);
+        return threshold > 0 && length() >= threshold;
     }
 
-    bool istitle() const override {
-        cppy::ptr result(PyObject_CallMethod(py_str.get(), "istitle", nullptr));
-        return result && PyObject_IsTrue(result.get());
+    /** Whether every code point has one of the classes (string not empty). */
+    bool all_in_class(uint32_t class_mask) const {
+        return findcc(0, length(), class_mask, true) == -1;
     }
-};
+
+    /**
+     * @brief The kind index, allocated on first use, or nullptr if it cannot
+     *        be allocated.
+     */
+    std::atomic<uint8_t>* get_kind_index() const {
+        std::atomic<uint8_t>* index = kind_index.load(std::memory_order_acquire);
+        if (index) return index;
+        Py_ssize_t blocks = (length() + KIND_BLOCK - 1) / KIND_BLOCK;
+        std::atomic<uint8_t>* built = new (std::nothrow) std::atomic<uint8_t>[blocks]();
+        if (!built) return nullptr;
+        if (!kind_index.compare_exchange_strong(index, built, std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+            // Another thread published its index first; use that one.
+            delete[] built;
+            return index;
+        }
+        return built;
+    }
+
+public:};
 
 /**
  * @brief Buffer specialized for 1-byte (UCS1) Python Unicode objects.
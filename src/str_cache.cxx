@@ -0,0 +1,133 @@
+/**
+ * @file str_cache.cxx
+ * @brief Process-wide table of the materialized str of lazy buffers.
+ */
+
+#include <Python.h>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "str_cache.hxx"
+#include "_lstring.hxx"
+#include "lstring_stats.hxx"
+
+namespace {
+
+struct Entry {
+    PyObject* str;
+    size_t bytes;
+    std::list<const Buffer*>::iterator recent;
+};
+
+std::mutex cache_mutex;
+std::unordered_map<const Buffer*, Entry>* cache = nullptr;
+std::list<const Buffer*>* recent = nullptr;   // most recently used first
+size_t cache_bytes = 0;
+std::atomic<size_t> cache_size(0);
+
+size_t str_bytes(PyObject* str) {
+    return (size_t)PyUnicode_GET_LENGTH(str) * PyUnicode_KIND(str);
+}
+
+size_t current_limit() {
+    Py_ssize_t limit = LStr_str_cache_limit.load();
+    return limit > 0 ? (size_t)limit : 0;
+}
+
+/**
+ * @brief Release the strs removed from the cache, once cache_mutex is unlocked.
+ */
+void decref_all(const std::vector<PyObject*>& dropped) {
+    for (PyObject* str : dropped) Py_DECREF(str);
+}
+
+} // namespace
+
+void StrCache::erase(const Buffer* buf, std::vector<PyObject*>& dropped) {
+    auto it = cache->find(buf);
+    dropped.push_back(it->second.str);
+    buf->str_cached.store(false, std::memory_order_release);
+    cache_bytes -= it->second.bytes;
+    recent->erase(it->second.recent);
+    cache->erase(it);
+    cache_size.fetch_sub(1, std::memory_order_release);
+}
+
+void StrCache::evict_to(size_t limit, std::vector<PyObject*>& dropped) {
+    while (cache_bytes > limit && !recent->empty()) {
+        erase(recent->back(), dropped);
+        stats_add(LStr_stats.str_cache_evictions);
+    }
+}
+
+PyObject* StrCache::lookup(const Buffer* buf) {
+    if (!buf->str_cached.load(std::memory_order_acquire)) return nullptr;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache->find(buf);
+    if (it == cache->end()) return nullptr;
+    recent->splice(recent->begin(), *recent, it->second.recent);
+    Py_INCREF(it->second.str);
+    return it->second.str;
+}
+
+void StrCache::store(const Buffer* buf, PyObject* str) {
+    const size_t limit = current_limit();
+    const size_t bytes = str_bytes(str);
+    if (bytes > limit) return;
+    std::vector<PyObject*> dropped;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (!cache) {
+            cache = new std::unordered_map<const Buffer*, Entry>();
+            recent = new std::list<const Buffer*>();
+        }
+        auto it = cache->find(buf);
+        if (it != cache->end()) {
+            recent->splice(recent->begin(), *recent, it->second.recent);
+            return;
+        }
+        recent->push_front(buf);
+        Py_INCREF(str);
+        cache->emplace(buf, Entry{str, bytes, recent->begin()});
+        buf->str_cached.store(true, std::memory_order_release);
+        cache_bytes += bytes;
+        cache_size.fetch_add(1, std::memory_order_release);
+        // The new entry is the most recent one and fits, so it stays.
+        evict_to(limit, dropped);
+    }
+    decref_all(dropped);
+}
+
+void StrCache::trim() {
+    if (cache_size.load(std::memory_order_acquire) == 0) return;
+    std::vector<PyObject*> dropped;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        evict_to(current_limit(), dropped);
+    }
+    decref_all(dropped);
+}
+
+void StrCache::clear() {
+    if (cache_size.load(std::memory_order_acquire) == 0) return;
+    std::vector<PyObject*> dropped;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        while (!cache->empty()) erase(cache->begin()->first, dropped);
+    }
+    decref_all(dropped);
+}
+
+void StrCache::release(const Buffer* buf) {
+    if (!buf->str_cached.load(std::memory_order_acquire)) return;
+    std::vector<PyObject*> dropped;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (cache->find(buf) == cache->end()) return;
+        erase(buf, dropped);
+    }
+    decref_all(dropped);
+}
@@ -0,0 +1,69 @@
+#ifndef STR_CACHE_HXX
+#define STR_CACHE_HXX
+
+#include <Python.h>
+#include <vector>
+
+#include "lstring/lstring.hxx"
+
+/**
+ * @brief StrCache — materialized str of lazy buffers, reused by str()
+ *
+ * After lstring.set_str_cache_limit(n), str() of a lazy value keeps the
+ * str it produced, and later calls return that same object instead of
+ * copying the tree again. Searches, counts and comparisons then use
+ * CPython's str routines on the cached copy, as they do for str-backed
+ * values.
+ *
+ * Entries live in a process-wide table keyed by the buffer and hold at
+ * most `n` bytes of character data together; the least recently used ones
+ * are evicted to make room. Buffer::str_cached marks the buffers that have
+ * an entry, so only those take the table's lock. ~Buffer() drops the entry
+ * of a buffer with it, so the cache never outlives its values.
+ * All functions must be called with the GIL held (an attached thread
+ * state on free-threaded builds).
+ */
+class StrCache {
+public:
+    /**
+     * @brief New reference to the cached str of buf, or nullptr (no
+     *        exception set) if there is none.
+     */
+    static PyObject* lookup(const Buffer* buf);
+
+    /**
+     * @brief Cache str as the content of buf if it fits within the limit.
+     */
+    static void store(const Buffer* buf, PyObject* str);
+
+    /**
+     * @brief Evict entries until the cache fits the current limit.
+     */
+    static void trim();
+
+    /**
+     * @brief Drop every entry.
+     */
+    static void clear();
+
+    /**
+     * @brief Drop the entry of a buffer being destroyed; a no-op, without
+     *        locking, if buf has none.
+     */
+    static void release(const Buffer* buf);
+
+private:
+    /**
+     * @brief Remove the entry of buf; its str is appended to dropped.
+     *        The caller holds the cache mutex.
+     */
+    static void erase(const Buffer* buf, std::vector<PyObject*>& dropped);
+
+    /**
+     * @brief Evict least recently used entries until at most limit bytes
+     *        are cached. The caller holds the cache mutex.
+     */
+    static void evict_to(size_t limit, std::vector<PyObject*>& dropped);
+};
+
+#endif // STR_CACHE_HXX
@@ -0,0 +1,253 @@
+/**
+ * @file substring_index.cxx
+ * @brief Construction, queries and attachment of SubstringIndex.
+ */
+
+#include <Python.h>
+#include <algorithm>
+#include <cstring>
+
+#include "substring_index.hxx"
+#include "slice_buffer.hxx"
+#include "span.hxx"
+
+namespace {
+
+/** Bucket table sizes, as powers of two. */
+constexpr int MIN_BUCKET_BITS = 8;
+constexpr int MAX_BUCKET_BITS = 24;
+
+/** Bucket bits sorted within a partition: a 64 KiB counting table. */
+constexpr int LOW_BITS = 14;
+
+/**
+ * The index is used while it has at most one candidate per this many code
+ * points of the searched range; verifying a candidate costs a random
+ * access, a scan step a few sequential byte comparisons.
+ */
+constexpr Py_ssize_t SCAN_RATIO = 64;
+
+/**
+ * @brief Whether buf[at, at + needle.size()) equals needle.
+ */
+bool matches_at(const Buffer& buf, Py_ssize_t at, const std::vector<uint32_t>& needle,
+                std::vector<uint32_t>& scratch) {
+    const Py_ssize_t m = (Py_ssize_t)needle.size();
+    BufferSpan span;
+    if (buf.get_span(at, at + m, span)) {
+        return with_span_data(span, [&](auto data, Py_ssize_t n) {
+            for (Py_ssize_t i = 0; i < n; ++i) {
+                if ((uint32_t)data[i] != needle[i]) return false;
+            }
+            return true;
+        });
+    }
+    scratch.resize((size_t)m);
+    buf.copy(scratch.data(), at, m);
+    return std::memcmp(scratch.data(), needle.data(), (size_t)m * sizeof(uint32_t)) == 0;
+}
+
+/**
+ * @brief Call fn(position, gram) for every GRAM-gram of buf, in order.
+ */
+template <class Fn>
+void for_each_gram(const Buffer& buf, Fn&& fn) {
+    uint32_t window[SubstringIndex::GRAM] = {};
+    Py_ssize_t pos = 0;
+    for_each_span(buf, 0, buf.length(), [&](const BufferSpan& span) {
+        with_span_data(span, [&](auto data, Py_ssize_t n) {
+            for (Py_ssize_t k = 0; k < n; ++k) {
+                for (Py_ssize_t i = 1; i < SubstringIndex::GRAM; ++i) window[i - 1] = window[i];
+                window[SubstringIndex::GRAM - 1] = data[k];
+                if (++pos >= SubstringIndex::GRAM) fn(pos - SubstringIndex::GRAM, window);
+            }
+        });
+        return true;
+    });
+}
+
+} // namespace
+
+SubstringIndex::SubstringIndex(const Buffer& buf) {
+    const Py_ssize_t n = buf.length();
+    const Py_ssize_t grams = std::max<Py_ssize_t>(0, n - GRAM + 1);
+    // About two positions per bucket.
+    bucket_bits = MIN_BUCKET_BITS;
+    while (bucket_bits < MAX_BUCKET_BITS && ((Py_ssize_t)1 << bucket_bits) < grams / 2) ++bucket_bits;
+    const size_t nbuckets = (size_t)1 << bucket_bits;
+
+    // Bucketing every position directly misses the cache on each write once
+    // the tables outgrow it. Positions are first distributed among at most
+    // 2^(MAX_BUCKET_BITS - LOW_BITS) partitions by the high bits of their
+    // bucket, then each partition is sorted by the low bits.
+    const int low_bits = std::min(bucket_bits, LOW_BITS);
+    const uint32_t low_mask = ((uint32_t)1 << low_bits) - 1;
+    const size_t partitions = (size_t)1 << (bucket_bits - low_bits);
+
+    std::vector<uint32_t> part_start(partitions + 1, 0);
+    for_each_gram(buf, [&](Py_ssize_t, const uint32_t* gram) {
+        ++part_start[(bucket(gram) >> low_bits) + 1];
+    });
+    for (size_t p = 0; p < partitions; ++p) {
+        part_start[p + 1] += part_start[p];
+    }
+
+    positions.resize((size_t)grams);
+    std::vector<uint32_t> low((size_t)grams);
+    {
+        std::vector<uint32_t> fill(part_start.begin(), part_start.end() - 1);
+        for_each_gram(buf, [&](Py_ssize_t pos, const uint32_t* gram) {
+            uint32_t b = bucket(gram);
+            uint32_t slot = fill[b >> low_bits]++;
+            positions[slot] = (uint32_t)pos;
+            low[slot] = b & low_mask;
+        });
+    }
+
+    // A stable counting sort of each partition keeps positions ascending
+    // within their bucket.
+    bucket_start.assign(nbuckets + 1, 0);
+    std::vector<uint32_t> local_fill((size_t)low_mask + 1);
+    std::vector<uint32_t> sorted;
+    for (size_t p = 0; p < partitions; ++p) {
+        const uint32_t first = part_start[p], last = part_start[p + 1];
+        std::fill(local_fill.begin(), local_fill.end(), 0);
+        for (uint32_t i = first; i < last; ++i) ++local_fill[low[i]];
+        uint32_t running = first;
+        uint32_t *starts = bucket_start.data() + (p << low_bits);
+        for (uint32_t l = 0; l <= low_mask; ++l) {
+            starts[l] = running;
+            uint32_t size = local_fill[l];
+            local_fill[l] = running - first;
+            running += size;
+        }
+        sorted.resize(last - first);
+        for (uint32_t i = first; i < last; ++i) sorted[local_fill[low[i]]++] = positions[i];
+        std::copy(sorted.begin(), sorted.end(), positions.begin() + first);
+    }
+    bucket_start[nbuckets] = (uint32_t)grams;
+}
+
+uint32_t SubstringIndex::bucket(const uint32_t* gram) const {
+    uint64_t h = 0;
+    for (Py_ssize_t i = 0; i < GRAM; ++i) {
+        h = (h ^ gram[i]) * 0x100000001B3ULL;
+    }
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    return (uint32_t)(h >> (64 - bucket_bits));
+}
+
+bool SubstringIndex::candidates(const std::vector<uint32_t>& needle, Py_ssize_t start, Py_ssize_t end,
+                                const uint32_t*& first, const uint32_t*& last, Py_ssize_t& gram_offset) const {
+    const Py_ssize_t m = (Py_ssize_t)needle.size();
+    if (m < GRAM) return false;
+
+    // The rarest gram of the needle gives the fewest candidates.
+    uint32_t best = 0;
+    uint32_t best_size = UINT32_MAX;
+    for (Py_ssize_t k = 0; k + GRAM <= m; ++k) {
+        uint32_t b = bucket(needle.data() + k);
+        uint32_t size = bucket_start[b + 1] - bucket_start[b];
+        if (size < best_size) {
+            best = b;
+            best_size = size;
+            gram_offset = k;
+        }
+    }
+
+    // A match at s puts the gram at s + gram_offset, for start <= s <= end - m.
+    const uint32_t *bucket_first = positions.data() + bucket_start[best];
+    const uint32_t *bucket_last = positions.data() + bucket_start[best + 1];
+    first = std::lower_bound(bucket_first, bucket_last, (uint32_t)(start + gram_offset));
+    last = std::upper_bound(first, bucket_last, (uint32_t)(end - m + gram_offset));
+    return (last - first) <= (end - start) / SCAN_RATIO + 1;
+}
+
+bool SubstringIndex::find(const Buffer& buf, const std::vector<uint32_t>& needle,
+                          Py_ssize_t start, Py_ssize_t end, bool reverse, Py_ssize_t& result) const {
+    const Py_ssize_t m = (Py_ssize_t)needle.size();
+    if (m < GRAM) return false;
+    if (end - start < m) {
+        result = -1;
+        return true;
+    }
+    const uint32_t *first, *last;
+    Py_ssize_t gram_offset = 0;
+    if (!candidates(needle, start, end, first, last, gram_offset)) return false;
+
+    std::vector<uint32_t> scratch;
+    result = -1;
+    if (!reverse) {
+        for (const uint32_t *p = first; p < last; ++p) {
+            if (matches_at(buf, *p - gram_offset, needle, scratch)) {
+                result = *p - gram_offset;
+                break;
+            }
+        }
+    } else {
+        for (const uint32_t *p = last; p > first; --p) {
+            if (matches_at(buf, p[-1] - gram_offset, needle, scratch)) {
+                result = p[-1] - gram_offset;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+bool SubstringIndex::count(const Buffer& buf, const std::vector<uint32_t>& needle,
+                           Py_ssize_t start, Py_ssize_t end, Py_ssize_t& result) const {
+    const Py_ssize_t m = (Py_ssize_t)needle.size();
+    if (m < GRAM) return false;
+    if (end - start < m) {
+        result = 0;
+        return true;
+    }
+    const uint32_t *first, *last;
+    Py_ssize_t gram_offset = 0;
+    if (!candidates(needle, start, end, first, last, gram_offset)) return false;
+
+    std::vector<uint32_t> scratch;
+    Py_ssize_t found = 0;
+    Py_ssize_t next = start;
+    for (const uint32_t *p = first; p < last; ++p) {
+        Py_ssize_t at = *p - gram_offset;
+        if (at < next || !matches_at(buf, at, needle, scratch)) continue;
+        ++found;
+        next = at + m;
+    }
+    result = found;
+    return true;
+}
+
+const SubstringIndex* SubstringIndex::lookup(const Buffer* buf) {
+    return buf->substring_index.load(std::memory_order_acquire);
+}
+
+const SubstringIndex* SubstringIndex::resolve(const Buffer* buf, const Buffer*& target, Py_ssize_t& offset) {
+    if (const SubstringIndex* own = lookup(buf)) {
+        target = buf;
+        offset = 0;
+        return own;
+    }
+    if (buf->is_a(Slice1Buffer::buffer_class_id) && !buf->is_a(SliceBuffer::buffer_class_id)) {
+        const Slice1Buffer* slice = static_cast<const Slice1Buffer*>(buf);
+        const Buffer* base = ((LStrObject*)slice->base())->buffer;
+        if (const SubstringIndex* shared = lookup(base)) {
+            target = base;
+            offset = slice->base_start();
+            return shared;
+        }
+    }
+    return nullptr;
+}
+
+const SubstringIndex* SubstringIndex::attach(const Buffer* buf, std::unique_ptr<SubstringIndex> index) {
+    const SubstringIndex* expected = nullptr;
+    if (buf->substring_index.compare_exchange_strong(expected, index.get(), std::memory_order_acq_rel)) {
+        return index.release();
+    }
+    // Another thread indexed buf first; ours is dropped.
+    return expected;
+}
@@ -0,0 +1,105 @@
+#ifndef SUBSTRING_INDEX_HXX
+#define SUBSTRING_INDEX_HXX
+
+#include <Python.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "lstring/lstring.hxx"
+
+/**
+ * @brief SubstringIndex — posting index of the GRAM-grams of a buffer
+ *
+ * Built on request by L.build_index() for long-lived values that are
+ * searched many times. Every position of the buffer is filed under a hash
+ * bucket of the GRAM code points starting there; positions are kept in
+ * ascending order within a bucket. A search for a needle of at least GRAM
+ * code points visits only the bucket of the needle's rarest gram and
+ * compares the candidates, so find(), rfind() and count() no longer scan
+ * the whole range. Needles shorter than GRAM, and needles whose rarest
+ * gram is frequent in the searched range, are left to the linear scan,
+ * which is then at least as fast.
+ *
+ * A buffer owns its index through Buffer::substring_index, which is read
+ * without locking; ~Buffer() deletes the index with it. Positions are
+ * 32-bit: 4 bytes per code point plus the bucket table.
+ */
+class SubstringIndex {
+public:
+    /** Code points per indexed gram. */
+    static constexpr Py_ssize_t GRAM = 4;
+
+    /** Longest buffer the 32-bit positions can index. */
+    static constexpr Py_ssize_t MAX_LENGTH = (Py_ssize_t)UINT32_MAX;
+
+    /**
+     * @brief Index the content of buf (length at most MAX_LENGTH).
+     *
+     * Reads buf without Python calls, so it may run with the GIL released.
+     * Throws std::bad_alloc if the index does not fit in memory.
+     */
+    explicit SubstringIndex(const Buffer& buf);
+
+    SubstringIndex(const SubstringIndex&) = delete;
+    SubstringIndex& operator=(const SubstringIndex&) = delete;
+
+    /**
+     * @brief First (or, if reverse, last) occurrence of needle within
+     *        [start, end) of buf, the buffer this index was built for.
+     * @return false if the index would not beat a linear scan; `result`
+     *         is then unchanged.
+     */
+    bool find(const Buffer& buf, const std::vector<uint32_t>& needle,
+              Py_ssize_t start, Py_ssize_t end, bool reverse, Py_ssize_t& result) const;
+
+    /**
+     * @brief Number of non-overlapping occurrences of needle within
+     *        [start, end), counted from the left like str.count().
+     * @return false if the index would not beat a linear scan.
+     */
+    bool count(const Buffer& buf, const std::vector<uint32_t>& needle,
+               Py_ssize_t start, Py_ssize_t end, Py_ssize_t& result) const;
+
+    /**
+     * @brief Bytes used by the index.
+     */
+    size_t memory() const {
+        return positions.capacity() * sizeof(uint32_t) + bucket_start.capacity() * sizeof(uint32_t);
+    }
+
+    /**
+     * @brief The index of buf, or nullptr. The index lives as long as buf.
+     */
+    static const SubstringIndex* lookup(const Buffer* buf);
+
+    /**
+     * @brief The index that answers searches on buf: the index of buf
+     *        itself, or of the buffer that buf is a step-1 slice of. The
+     *        search range is then shifted by `offset` into `target`.
+     */
+    static const SubstringIndex* resolve(const Buffer* buf, const Buffer*& target, Py_ssize_t& offset);
+
+    /**
+     * @brief Attach index to buf, unless buf already has one.
+     * @return The index now attached to buf.
+     */
+    static const SubstringIndex* attach(const Buffer* buf, std::unique_ptr<SubstringIndex> index);
+
+private:
+    /**
+     * @brief Candidates for needle in [start, end): the positions of its
+     *        rarest gram, and the offset of that gram in the needle.
+     * @return false if there are too many candidates to beat a scan.
+     */
+    bool candidates(const std::vector<uint32_t>& needle, Py_ssize_t start, Py_ssize_t end,
+                    const uint32_t*& first, const uint32_t*& last, Py_ssize_t& gram_offset) const;
+
+    uint32_t bucket(const uint32_t* gram) const;
+
+    int bucket_bits;
+    std::vector<uint32_t> bucket_start;   // nbuckets + 1 offsets into positions
+    std::vector<uint32_t> positions;      // gram start positions, grouped by bucket
+};
+
+#endif // SUBSTRING_INDEX_HXX
@@ -0,0 +1,483 @@
+#ifndef SUBSTRING_SEARCH_HXX
+#define SUBSTRING_SEARCH_HXX
+
+#include <Python.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "lstring/lstring.hxx"
+#include "span.hxx"
+#include "buffer_cursor.hxx"
+#include "simd.hxx"
+
+/**
+ * @brief Substring search engine over lazy buffers.
+ *
+ * Candidates are first located by the vectorized single code point search
+ * of each leaf span, for an anchor: the needle code point that is likely
+ * rarest in text. Each candidate is verified in place, or through the
+ * buffer when it straddles a span boundary, so absent needles and needles
+ * with a rare character cost about one findc per span.
+ *
+ * When the anchor turns out to be frequent, the rest of the range is left
+ * to a Crochemore-Perrin critical factorization (two-way algorithm) plus a
+ * Horspool-style skip table on the low byte of the window's last code
+ * point. The text is streamed through a BufferCursor: long leaf spans are
+ * searched in place, short spans are gathered into a small window, and the
+ * last `length() - 1` code points of every span are kept so matches
+ * straddling leaf boundaries are found too. Either way the search is
+ * linear in the length of the text for any needle.
+ *
+ * A reverse engine stores the needle reversed and walks the text right to
+ * left, so the same code serves rfind and rsplit.
+ */
+class SubstringSearch {
+public:
+    SubstringSearch(const Buffer* needle, bool reverse = false)
+        : reverse_(reverse), m_(needle->length()) {
+        needle_.resize(m_);
+        if (m_ > 0) needle->copy(needle_.data(), 0, m_);
+        text_order_ = needle_;
+        if (reverse_) std::reverse(needle_.begin(), needle_.end());
+        prepare();
+    }
+
+    /**
+     * @brief Needle length in code points.
+     */
+    Py_ssize_t length() const {
+        return m_;
+    }
+
+    /**
+     * @brief Find the first match in [start, end), or the last one for a
+     * reverse engine.
+     * @return The match start index, or -1 if there is no match.
+     */
+    Py_ssize_t find(const Buffer* text, Py_ssize_t start, Py_ssize_t end) const {
+        if (end - start < m_) return -1;
+        if (m_ == 0) return reverse_ ? end : start;
+        Py_ssize_t found = -1;
+        scan(text, start, end, [&](Py_ssize_t pos) {
+            found = pos;
+            return false;
+        });
+        return found;
+    }
+
+    /**
+     * @brief Report non-overlapping matches within [start, end).
+     *
+     * Calls `bool fn(Py_ssize_t pos)` with the start index of every match,
+     * left to right (right to left for a reverse engine), until fn returns
+     * false. The needle must not be empty.
+     */
+    template <class Fn>
+    void scan(const Buffer* text, Py_ssize_t start, Py_ssize_t end, Fn&& fn) const {
+        if (m_ == 0 || end - start < m_) return;
+        if (m_ == 1) {
+            scan_char(text, start, end, fn);
+            return;
+        }
+        Py_ssize_t resume = scan_anchored(text, start, end, fn);
+        if (resume < 0) return;
+        if (reverse_) {
+            scan_two_way(text, start, end - resume, fn);
+        } else {
+            scan_two_way(text, start + resume, end, fn);
+        }
+    }
+
+private:
+    /** Verification work allowed per code point scanned before the anchor is given up. */
+    static constexpr Py_ssize_t ANCHOR_WORK_RATIO = 2;
+    /** Work charged for each candidate on top of the code points it compares. */
+    static constexpr Py_ssize_t CANDIDATE_COST = 8;
+
+    /**
+     * @brief Report matches found from the anchor occurrences of each span.
+     *
+     * Every match starts `anchor_` code points (logically) before an anchor
+     * occurrence. Verification work is bounded by ANCHOR_WORK_RATIO per
+     * code point scanned; past that, the anchor is too frequent to pay off.
+     *
+     * @return -1 when the range is done or fn stopped the scan; otherwise
+     *         the logical offset from which the two-way scan must go on.
+     */
+    template <class Fn>
+    Py_ssize_t scan_anchored(const Buffer* text, Py_ssize_t start, Py_ssize_t end, Fn& fn) const {
+        const Py_ssize_t last = end - start - m_;   // highest logical match offset
+        const uint32_t anchor = needle_[anchor_];
+        std::vector<uint32_t> scratch;
+        Py_ssize_t next = 0;   // lowest offset the next match may take
+        Py_ssize_t work = 0;
+        Py_ssize_t pos = 0;    // logical offset of the current span
+        Py_ssize_t resume = -1;
+
+        auto visit = [&](const BufferSpan& span) {
+            const Py_ssize_t n = span.length;
+            bool more = with_span_data(span, [&](auto data, Py_ssize_t) {
+                // Anchors past k_end would start a match after `last`.
+                Py_ssize_t k = std::max(next + anchor_ - pos, (Py_ssize_t)0);
+                const Py_ssize_t k_end = std::min(n, last + anchor_ - pos + 1);
+                while (k < k_end) {
+                    Py_ssize_t hit = find_anchor(data, n, k, k_end, anchor);
+                    if (hit < 0) break;
+                    // The needle part inside this span is checked first; a
+                    // candidate that straddles spans is then read through text.
+                    Py_ssize_t off = hit - anchor_;
+                    Py_ssize_t lo = std::max(-off, (Py_ssize_t)0);
+                    Py_ssize_t hi = std::min(n - off, m_);
+                    Py_ssize_t compared = 0;
+                    bool found = matches_in_span(data, n, off, lo, hi, compared);
+                    if (found && (lo > 0 || hi < m_)) {
+                        Py_ssize_t q = pos + off;
+                        found = matches_at(text, reverse_ ? end - q - m_ : start + q, scratch, compared);
+                    }
+                    work += compared + CANDIDATE_COST;
+                    if (found) {
+                        Py_ssize_t q = pos + off;
+                        next = q + m_;
+                        if (!fn(reverse_ ? end - q - m_ : start + q)) return false;
+                        k = std::max(hit + 1, next + anchor_ - pos);
+                        continue;
+                    }
+                    k = hit + 1;
+                    if (work > ANCHOR_WORK_RATIO * (pos + hit) + 64 * CANDIDATE_COST) {
+                        resume = std::max(next, pos + off + 1);
+                        return false;
+                    }
+                }
+                return k_end == n;
+            });
+            pos += n;
+            return more;
+        };
+        if (reverse_) {
+            for_each_span_reverse(*text, start, end, visit);
+        } else {
+            for_each_span(*text, start, end, visit);
+        }
+        return resume;
+    }
+
+    /**
+     * @brief Logical index of the first anchor within logical [k, k_end) of
+     *        a span of n code points, or -1.
+     */
+    template <class T>
+    Py_ssize_t find_anchor(const T* data, Py_ssize_t n, Py_ssize_t k, Py_ssize_t k_end, uint32_t anchor) const {
+        // Code points wider than the storage cannot be present.
+        if (anchor > std::numeric_limits<T>::max()) return -1;
+        if (!reverse_) {
+            if constexpr (sizeof(T) == 1) {
+                const void* hit = std::memchr(data + k, (int)anchor, (size_t)(k_end - k));
+                return hit ? (const T*)hit - data : -1;
+            }
+            Py_ssize_t r = simd_find_range(data + k, k_end - k, anchor, anchor + 1, false);
+            return r < 0 ? -1 : k + r;
+        }
+        Py_ssize_t r = simd_rfind_range(data + n - k_end, k_end - k, anchor, anchor + 1, false);
+        return r < 0 ? -1 : k_end - 1 - r;
+    }
+
+    /**
+     * @brief Whether needle[lo, hi) occurs at logical offset `off + lo` of
+     *        a span of n code points.
+     */
+    template <class T>
+    bool matches_in_span(const T* data, Py_ssize_t n, Py_ssize_t off, Py_ssize_t lo, Py_ssize_t hi,
+                         Py_ssize_t& compared) const {
+        for (Py_ssize_t i = lo; i < hi; ++i) {
+            uint32_t ch = reverse_ ? data[n - 1 - off - i] : data[off + i];
+            if (ch != needle_[i]) {
+                compared = i - lo + 1;
+                return false;
+            }
+        }
+        compared = hi - lo;
+        return true;
+    }
+
+    /**
+     * @brief Whether text[at, at + length()) equals the needle; for
+     *        candidates that straddle spans.
+     */
+    bool matches_at(const Buffer* text, Py_ssize_t at, std::vector<uint32_t>& scratch,
+                    Py_ssize_t& compared) const {
+        compared = m_;
+        BufferSpan span;
+        if (text->get_span(at, at + m_, span)) {
+            return with_span_data(span, [&](auto data, Py_ssize_t n) {
+                return std::equal(data, data + n, text_order_.begin());
+            });
+        }
+        scratch.resize((size_t)m_);
+        text->copy(scratch.data(), at, m_);
+        return scratch == text_order_;
+    }
+
+    /**
+     * @brief Two-way scan of the whole of [start, end).
+     */
+    template <class Fn>
+    void scan_two_way(const Buffer* text, Py_ssize_t start, Py_ssize_t end, Fn& fn) const {
+        if (end - start < m_) return;
+        const Py_ssize_t keep = m_ - 1;
+        const Py_ssize_t long_span = std::max<Py_ssize_t>(m_, 64);
+        const Py_ssize_t flush = std::max<Py_ssize_t>(4 * m_, 1024);
+
+        // All offsets below are logical: counted from `start` for a forward
+        // engine and from `end` for a reverse one.
+        BufferCursor cursor(text, start, end, reverse_);
+        std::vector<uint32_t> window;  // code points from offset wpos on
+        Py_ssize_t wpos = 0;
+        Py_ssize_t pos = 0;            // offset of the current span
+        Py_ssize_t next = 0;           // lowest offset the next match may take
+
+        auto report = [&](Py_ssize_t q) {
+            next = q + m_;
+            return fn(reverse_ ? end - q - m_ : start + q);
+        };
+
+        // Report window matches that start before `limit`.
+        auto search_window = [&](Py_ssize_t limit) {
+            ForwardText<uint32_t> t{window.data()};
+            Py_ssize_t n = (Py_ssize_t)window.size();
+            Py_ssize_t from = std::max(next - wpos, (Py_ssize_t)0);
+            for (;;) {
+                Py_ssize_t q = search(t, n, from);
+                if (q < 0 || wpos + q >= limit) return true;
+                if (!report(wpos + q)) return false;
+                from = q + m_;
+            }
+        };
+
+        BufferSpan span;
+        while (cursor.current(span)) {
+            Py_ssize_t n = span.length;
+            if (n < long_span) {
+                append(window, span, 0, n);
+                if ((Py_ssize_t)window.size() >= flush) {
+                    if (!search_window(PY_SSIZE_T_MAX)) return;
+                    Py_ssize_t drop = (Py_ssize_t)window.size() - keep;
+                    window.erase(window.begin(), window.begin() + drop);
+                    wpos += drop;
+                }
+            } else {
+                // Matches straddling the boundary into this span.
+                append(window, span, 0, keep);
+                if (!search_window(pos)) return;
+
+                bool go = with_span_data(span, [&](auto data, Py_ssize_t) {
+                    using T = std::remove_cv_t<std::remove_pointer_t<decltype(data)>>;
+                    if (reverse_) {
+                        return search_span(ReverseText<T>{data + n - 1}, n, pos, next, report);
+                    }
+                    return search_span(ForwardText<T>{data}, n, pos, next, report);
+                });
+                if (!go) return;
+
+                window.clear();
+                append(window, span, n - keep, keep);
+                wpos = pos + n - keep;
+            }
+            pos += n;
+            cursor.advance(n);
+        }
+        search_window(PY_SSIZE_T_MAX);
+    }
+
+    template <class T>
+    struct ForwardText {
+        const T* data;
+        uint32_t operator[](Py_ssize_t i) const { return data[i]; }
+    };
+
+    template <class T>
+    struct ReverseText {
+        const T* last;
+        uint32_t operator[](Py_ssize_t i) const { return last[-i]; }
+    };
+
+    /**
+     * @brief Compute the critical factorization and the skip table.
+     */
+    void prepare() {
+        anchor_ = 0;
+        for (Py_ssize_t i = 1; i < m_; ++i) {
+            if (rarity(needle_[i]) > rarity(needle_[anchor_])) anchor_ = i;
+        }
+        for (int i = 0; i < 256; ++i) skip_[i] = m_;
+        for (Py_ssize_t i = 0; i < m_; ++i) {
+            skip_[needle_[i] & 0xFF] = m_ - 1 - i;
+        }
+        if (m_ == 0) {
+            ell_ = -1;
+            per_ = 1;
+            periodic_ = true;
+            return;
+        }
+
+        Py_ssize_t p, q;
+        Py_ssize_t i = maximal_suffix(false, p);
+        Py_ssize_t j = maximal_suffix(true, q);
+        if (i > j) {
+            ell_ = i;
+            per_ = p;
+        } else {
+            ell_ = j;
+            per_ = q;
+        }
+
+        periodic_ = ell_ + 1 + per_ <= m_ &&
+            std::equal(needle_.begin(), needle_.begin() + ell_ + 1, needle_.begin() + per_);
+        if (!periodic_) {
+            per_ = std::max(ell_ + 1, m_ - ell_ - 1) + 1;
+        }
+    }
+
+    /**
+     * @brief Rough rarity of a code point in text, for the anchor choice:
+     *        spaces and common lowercase letters are the most frequent,
+     *        non-ASCII code points the least.
+     */
+    static int rarity(uint32_t ch) {
+        static const char by_frequency[] = "etaoinsrhldcumfpgwybvkxjqz";
+        if (ch == ' ') return 0;
+        if (ch >= 'a' && ch <= 'z') return 1 + (int)(std::strchr(by_frequency, (int)ch) - by_frequency);
+        if (ch >= 'A' && ch <= 'Z') return 30 + (int)(std::strchr(by_frequency, (int)(ch | 0x20)) - by_frequency);
+        if (ch < 128) return 60;
+        return 70;
+    }
+
+    /**
+     * @brief Position before the maximal suffix of the needle and its period.
+     *
+     * Uses the natural code point order, or the reversed one if `tilde`.
+     */
+    Py_ssize_t maximal_suffix(bool tilde, Py_ssize_t& period) const {
+        Py_ssize_t ms = -1, j = 0, k = 1;
+        period = 1;
+        while (j + k < m_) {
+            uint32_t a = needle_[j + k];
+            uint32_t b = needle_[ms + k];
+            if (tilde ? a > b : a < b) {
+                j += k;
+                k = 1;
+                period = j - ms;
+            } else if (a == b) {
+                if (k != period) {
+                    ++k;
+                } else {
+                    j += period;
+                    k = 1;
+                }
+            } else {
+                ms = j;
+                j = ms + 1;
+                k = period = 1;
+            }
+        }
+        return ms;
+    }
+
+    /**
+     * @brief Two-way search in text[from, n).
+     * @return Offset of the first match, or -1.
+     */
+    template <class Text>
+    Py_ssize_t search(const Text& text, Py_ssize_t n, Py_ssize_t from) const {
+        const uint32_t* x = needle_.data();
+        Py_ssize_t j = from;
+        Py_ssize_t memory = -1;
+        while (j <= n - m_) {
+            Py_ssize_t shift = skip_[text[j + m_ - 1] & 0xFF];
+            if (shift) {
+                j += shift;
+                memory = -1;
+                continue;
+            }
+            Py_ssize_t i = std::max(ell_, memory) + 1;
+            while (i < m_ && x[i] == text[i + j]) ++i;
+            if (i < m_) {
+                j += i - ell_;
+                memory = -1;
+                continue;
+            }
+            i = ell_;
+            while (i > memory && x[i] == text[i + j]) --i;
+            if (i <= memory) return j;
+            j += per_;
+            if (periodic_) memory = m_ - per_ - 1;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Report matches inside one span that starts at offset `pos`.
+     * @return false if the callback stopped the scan.
+     */
+    template <class Text, class Report>
+    bool search_span(const Text& text, Py_ssize_t n, Py_ssize_t pos,
+                     const Py_ssize_t& next, Report& report) const {
+        Py_ssize_t from = std::max(next - pos, (Py_ssize_t)0);
+        for (;;) {
+            Py_ssize_t q = search(text, n, from);
+            if (q < 0) return true;
+            if (!report(pos + q)) return false;
+            from = q + m_;
+        }
+    }
+
+    /**
+     * @brief Append `count` code points of span from logical offset `offset`.
+     */
+    void append(std::vector<uint32_t>& window, const BufferSpan& span,
+                Py_ssize_t offset, Py_ssize_t count) const {
+        with_span_data(span, [&](auto data, Py_ssize_t n) {
+            for (Py_ssize_t k = offset; k < offset + count; ++k) {
+                window.push_back(reverse_ ? data[n - 1 - k] : data[k]);
+            }
+        });
+    }
+
+    /**
+     * @brief Single code point needles go straight to findc/rfindc.
+     */
+    template <class Fn>
+    void scan_char(const Buffer* text, Py_ssize_t start, Py_ssize_t end, Fn& fn) const {
+        uint32_t ch = needle_[0];
+        if (reverse_) {
+            Py_ssize_t pos = end;
+            Py_ssize_t i;
+            while ((i = text->rfindc(start, pos, ch)) >= 0) {
+                if (!fn(i)) return;
+                pos = i;
+            }
+        } else {
+            Py_ssize_t pos = start;
+            Py_ssize_t i;
+            while ((i = text->findc(pos, end, ch)) >= 0) {
+                if (!fn(i)) return;
+                pos = i + 1;
+            }
+        }
+    }
+
+    bool reverse_;
+    Py_ssize_t m_;
+    std::vector<uint32_t> needle_;       // logical order: reversed for a reverse engine
+    std::vector<uint32_t> text_order_;   // the needle as it reads in text
+    Py_ssize_t anchor_;                  // logical index of the anchor code point
+    Py_ssize_t ell_;
+    Py_ssize_t per_;
+    bool periodic_;
+    Py_ssize_t skip_[256];
+};
+
+#endif // SUBSTRING_SEARCH_HXX
@@ -0,0 +1,437 @@
+/**
+ * @file utf8_buffer.cxx
+ * @brief Validation, checkpoint index and on-demand decoding of Utf8Buffer.
+ */
+
+#include <Python.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "utf8_buffer.hxx"
+#include "simd.hxx"
+
+namespace {
+
+/** ASCII runs at least this long are visited in place, not decoded. */
+constexpr Py_ssize_t ASCII_RUN = 32;
+
+/** Buffers up to this size are attached whole to a UnicodeDecodeError. */
+constexpr Py_ssize_t ERROR_OBJECT_LIMIT = 1 << 20;
+
+/** Bytes of context around the offending sequence otherwise. */
+constexpr Py_ssize_t ERROR_CONTEXT = 32;
+
+inline bool is_continuation(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+/**
+ * @brief Length of the sequence that starts with lead byte c (valid data).
+ */
+inline int sequence_width(unsigned char c) {
+    return c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+}
+
+/**
+ * @brief Whether the 8 bytes at p are all ASCII.
+ */
+inline bool ascii8(const unsigned char *p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return (word & 0x8080808080808080ULL) == 0;
+}
+
+/**
+ * @brief Step forward over n code points of valid UTF-8.
+ */
+inline const unsigned char* skip_forward(const unsigned char *p, Py_ssize_t n) {
+    while (n > 0) {
+        // n code points take at least n bytes, so the 8-byte read stays inside.
+        if (n >= 8 && ascii8(p)) {
+            p += 8;
+            n -= 8;
+        } else {
+            p += sequence_width(*p);
+            --n;
+        }
+    }
+    return p;
+}
+
+/**
+ * @brief Step back over n code points of valid UTF-8.
+ */
+inline const unsigned char* skip_backward(const unsigned char *p, Py_ssize_t n) {
+    while (n > 0) {
+        if (n >= 8 && ascii8(p - 8)) {
+            p -= 8;
+            n -= 8;
+        } else {
+            do {
+                --p;
+            } while (is_continuation(*p));
+            --n;
+        }
+    }
+    return p;
+}
+
+/**
+ * @brief Decode n code points of valid UTF-8 from p into out.
+ * @return The byte after the last decoded code point.
+ */
+template <class T>
+const unsigned char* decode_to(const unsigned char *p, T *out, Py_ssize_t n) {
+    T *stop = out + n;
+    while (out < stop) {
+        if (stop - out >= 8 && ascii8(p)) {
+            for (int k = 0; k < 8; ++k) out[k] = static_cast<T>(p[k]);
+            out += 8;
+            p += 8;
+            continue;
+        }
+        uint32_t c = *p;
+        if (c < 0x80) {
+            *out++ = static_cast<T>(c);
+            p += 1;
+        } else if (c < 0xE0) {
+            *out++ = static_cast<T>(((c & 0x1F) << 6) | (p[1] & 0x3F));
+            p += 2;
+        } else if (c < 0xF0) {
+            *out++ = static_cast<T>(((c & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F));
+            p += 3;
+        } else {
+            *out++ = static_cast<T>(((c & 0x07) << 18) | ((p[1] & 0x3F) << 12) |
+                                    ((p[2] & 0x3F) << 6) | (p[3] & 0x3F));
+            p += 4;
+        }
+    }
+    return p;
+}
+
+/**
+ * @brief Write the UTF-8 form of ch to out.
+ * @return The number of bytes written.
+ */
+inline int encode_char(uint32_t ch, unsigned char *out) {
+    if (ch < 0x80) {
+        out[0] = (unsigned char)ch;
+        return 1;
+    }
+    if (ch < 0x800) {
+        out[0] = (unsigned char)(0xC0 | (ch >> 6));
+        out[1] = (unsigned char)(0x80 | (ch & 0x3F));
+        return 2;
+    }
+    if (ch < 0x10000) {
+        out[0] = (unsigned char)(0xE0 | (ch >> 12));
+        out[1] = (unsigned char)(0x80 | ((ch >> 6) & 0x3F));
+        out[2] = (unsigned char)(0x80 | (ch & 0x3F));
+        return 3;
+    }
+    out[0] = (unsigned char)(0xF0 | (ch >> 18));
+    out[1] = (unsigned char)(0x80 | ((ch >> 12) & 0x3F));
+    out[2] = (unsigned char)(0x80 | ((ch >> 6) & 0x3F));
+    out[3] = (unsigned char)(0x80 | (ch & 0x3F));
+    return 4;
+}
+
+/**
+ * @brief Set a UnicodeDecodeError for bytes [start, stop) of data.
+ *
+ * Small buffers are attached whole, so the error reads exactly as the one
+ * from bytes.decode(); for large ones only the surrounding bytes are
+ * copied and the reason names the absolute offset.
+ */
+void set_decode_error(const unsigned char *data, Py_ssize_t size,
+                      Py_ssize_t start, Py_ssize_t stop, const char *reason) {
+    Py_ssize_t lo = 0, hi = size;
+    char context_reason[96];
+    if (size > ERROR_OBJECT_LIMIT) {
+        lo = std::max<Py_ssize_t>(0, start - ERROR_CONTEXT);
+        hi = std::min(size, stop + ERROR_CONTEXT);
+        PyOS_snprintf(context_reason, sizeof(context_reason), "%s at byte offset %zd", reason, start);
+        reason = context_reason;
+    }
+    PyObject *exc = PyUnicodeDecodeError_Create("utf-8", reinterpret_cast<const char*>(data) + lo,
+                                                hi - lo, start - lo, stop - lo, reason);
+    if (!exc) return;
+    PyErr_SetObject(PyExc_UnicodeDecodeError, exc);
+    Py_DECREF(exc);
+}
+
+} // namespace
+
+Utf8Buffer* Utf8Buffer::create(PyObject *obj) {
+    Py_buffer exported;
+    if (PyObject_GetBuffer(obj, &exported, PyBUF_SIMPLE) < 0) return nullptr;
+    std::unique_ptr<Utf8Buffer> buf;
+    try {
+        buf.reset(new Utf8Buffer(obj, exported));
+    } catch (...) {
+        PyBuffer_Release(&exported);
+        throw;
+    }
+    if (!buf->scan()) return nullptr;
+    return buf.release();
+}
+
+bool Utf8Buffer::scan() {
+    const unsigned char *p = data;
+    const unsigned char *end = data + nbytes;
+    Py_ssize_t count = 0;
+    Py_ssize_t next_checkpoint = CHECKPOINT;
+    uint32_t max_char = 0;
+
+    checkpoints.reserve((size_t)(nbytes / CHECKPOINT + 2));
+    checkpoints.push_back(0);
+    while (p < end) {
+        if (*p < 0x80) {
+            Py_ssize_t run = simd_find_range(p, end - p, 0x80, 0x100, false);
+            if (run == -1) run = end - p;
+            while (next_checkpoint < count + run) {
+                checkpoints.push_back((p - data) + (next_checkpoint - count));
+                next_checkpoint += CHECKPOINT;
+            }
+            count += run;
+            p += run;
+            continue;
+        }
+
+        // Strict UTF-8: no overlong forms, surrogates or values above
+        // U+10FFFF; the error positions follow CPython's decoder.
+        const Py_ssize_t pos = p - data;
+        const unsigned char c = *p;
+        int need;
+        uint32_t ch;
+        unsigned char lo = 0x80, hi = 0xBF;
+        if (c < 0xC2) {
+            set_decode_error(data, nbytes, pos, pos + 1, "invalid start byte");
+            return false;
+        } else if (c < 0xE0) {
+            need = 1;
+            ch = c & 0x1F;
+        } else if (c < 0xF0) {
+            need = 2;
+            ch = c & 0x0F;
+            if (c == 0xE0) lo = 0xA0;
+            if (c == 0xED) hi = 0x9F;
+        } else if (c < 0xF5) {
+            need = 3;
+            ch = c & 0x07;
+            if (c == 0xF0) lo = 0x90;
+            if (c == 0xF4) hi = 0x8F;
+        } else {
+            set_decode_error(data, nbytes, pos, pos + 1, "invalid start byte");
+            return false;
+        }
+        for (int k = 1; k <= need; ++k) {
+            if (k >= end - p) {
+                set_decode_error(data, nbytes, pos, nbytes, "unexpected end of data");
+                return false;
+            }
+            unsigned char b = p[k];
+            if (b < lo || b > hi) {
+                set_decode_error(data, nbytes, pos, pos + k, "invalid continuation byte");
+                return false;
+            }
+            ch = (ch << 6) | (b & 0x3F);
+            lo = 0x80;
+            hi = 0xBF;
+        }
+        if (count == next_checkpoint) {
+            checkpoints.push_back(pos);
+            next_checkpoint += CHECKPOINT;
+        }
+        max_char = std::max(max_char, ch);
+        ++count;
+        p += need + 1;
+    }
+
+    len = count;
+    kind = max_char < 0x100 ? PyUnicode_1BYTE_KIND : max_char < 0x10000 ? PyUnicode_2BYTE_KIND : PyUnicode_4BYTE_KIND;
+    if (is_ascii()) {
+        // Code point i is byte i; no index is needed.
+        std::vector<Py_ssize_t>().swap(checkpoints);
+    } else {
+        checkpoints.push_back(nbytes);
+        checkpoints.shrink_to_fit();
+    }
+    return true;
+}
+
+Py_ssize_t Utf8Buffer::byte_offset(Py_ssize_t index) const {
+    if (is_ascii()) return index;
+    if (index >= len) return nbytes;
+    Py_ssize_t block = index / CHECKPOINT;
+    Py_ssize_t pos = checkpoints[block];
+    Py_ssize_t n = index - block * CHECKPOINT;
+    Py_ssize_t block_len = std::min(CHECKPOINT, len - block * CHECKPOINT);
+    if (checkpoints[block + 1] - pos == block_len) return pos + n;
+    return skip_forward(data + pos, n) - data;
+}
+
+Py_ssize_t Utf8Buffer::char_index(Py_ssize_t pos) const {
+    if (is_ascii()) return pos;
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end() - 1, pos);
+    Py_ssize_t block = (it - checkpoints.begin()) - 1;
+    Py_ssize_t index = block * CHECKPOINT;
+    const unsigned char *p = data + checkpoints[block];
+    const unsigned char *stop = data + pos;
+    while (p < stop) {
+        if (stop - p >= 8 && ascii8(p)) {
+            p += 8;
+            index += 8;
+        } else {
+            index += !is_continuation(*p);
+            ++p;
+        }
+    }
+    return index;
+}
+
+uint32_t Utf8Buffer::value(Py_ssize_t index) const {
+    if (index < 0 || index >= len) throw std::out_of_range("Utf8Buffer: index out of range");
+    uint32_t ch;
+    decode_to(data + byte_offset(index), &ch, 1);
+    return ch;
+}
+
+template <class T>
+void Utf8Buffer::copy_to(T *target, Py_ssize_t start, Py_ssize_t count) const {
+    if (count <= 0) return;
+    decode_to(data + byte_offset(start), target, count);
+}
+
+void Utf8Buffer::copy(uint32_t *target, Py_ssize_t start, Py_ssize_t count) const {
+    copy_to(target, start, count);
+}
+
+void Utf8Buffer::copy(uint16_t *target, Py_ssize_t start, Py_ssize_t count) const {
+    copy_to(target, start, count);
+}
+
+void Utf8Buffer::copy(uint8_t *target, Py_ssize_t start, Py_ssize_t count) const {
+    if (is_ascii()) {
+        if (count > 0) std::memcpy(target, data + start, (size_t)count);
+        return;
+    }
+    copy_to(target, start, count);
+}
+
+bool Utf8Buffer::get_span(Py_ssize_t start, Py_ssize_t end, BufferSpan& out) const {
+    if (start >= end) {
+        out = BufferSpan{PyUnicode_1BYTE_KIND, data, 0};
+        return true;
+    }
+    Py_ssize_t first = byte_offset(start);
+    if (byte_offset(end) - first != end - start) return false;
+    out = BufferSpan{PyUnicode_1BYTE_KIND, data + first, end - start};
+    return true;
+}
+
+template <class T>
+bool Utf8Buffer::visit_decoded(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor, bool reverse) const {
+    T scratch[SPAN_SCRATCH_SIZE];
+    if (!reverse) {
+        const unsigned char *p = data + byte_offset(start);
+        for (Py_ssize_t pos = start; pos < end;) {
+            // The next `rest` code points take at least `rest` bytes.
+            Py_ssize_t rest = end - pos;
+            Py_ssize_t run = simd_find_range(p, rest, 0x80, 0x100, false);
+            if (run == -1) run = rest;
+            if (run >= ASCII_RUN || run == rest) {
+                if (!visitor.visit(BufferSpan{PyUnicode_1BYTE_KIND, p, run})) return false;
+                p += run;
+                pos += run;
+                continue;
+            }
+            Py_ssize_t n = std::min(SPAN_SCRATCH_SIZE, rest);
+            p = decode_to(p, scratch, n);
+            if (!visitor.visit(BufferSpan{kind, scratch, n})) return false;
+            pos += n;
+        }
+        return true;
+    }
+
+    const unsigned char *q = data + byte_offset(end);
+    for (Py_ssize_t pos = end; pos > start;) {
+        Py_ssize_t rest = pos - start;
+        Py_ssize_t last = simd_rfind_range(q - rest, rest, 0x80, 0x100, false);
+        Py_ssize_t run = last == -1 ? rest : rest - 1 - last;
+        if (run >= ASCII_RUN || run == rest) {
+            if (!visitor.visit(BufferSpan{PyUnicode_1BYTE_KIND, q - run, run})) return false;
+            q -= run;
+            pos -= run;
+            continue;
+        }
+        Py_ssize_t n = std::min(SPAN_SCRATCH_SIZE, rest);
+        q = skip_backward(q, n);
+        decode_to(q, scratch, n);
+        if (!visitor.visit(BufferSpan{kind, scratch, n})) return false;
+        pos -= n;
+    }
+    return true;
+}
+
+bool Utf8Buffer::visit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const {
+    if (start >= end) return true;
+    if (is_ascii()) return visitor.visit(BufferSpan{PyUnicode_1BYTE_KIND, data + start, end - start});
+    switch (kind) {
+        case PyUnicode_1BYTE_KIND: return visit_decoded<Py_UCS1>(start, end, visitor, false);
+        case PyUnicode_2BYTE_KIND: return visit_decoded<Py_UCS2>(start, end, visitor, false);
+        default: return visit_decoded<Py_UCS4>(start, end, visitor, false);
+    }
+}
+
+bool Utf8Buffer::rvisit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const {
+    if (start >= end) return true;
+    if (is_ascii()) return visitor.visit(BufferSpan{PyUnicode_1BYTE_KIND, data + start, end - start});
+    switch (kind) {
+        case PyUnicode_1BYTE_KIND: return visit_decoded<Py_UCS1>(start, end, visitor, true);
+        case PyUnicode_2BYTE_KIND: return visit_decoded<Py_UCS2>(start, end, visitor, true);
+        default: return visit_decoded<Py_UCS4>(start, end, visitor, true);
+    }
+}
+
+Py_ssize_t Utf8Buffer::find_bytes(Py_ssize_t start, Py_ssize_t end, uint32_t ch, bool reverse) const {
+    if (start < 0) start = 0;
+    if (end > len) end = len;
+    if (start >= end || ch > 0x10FFFF || (ch >= 0xD800 && ch < 0xE000)) return -1;
+    unsigned char encoded[4];
+    const int width = encode_char(ch, encoded);
+    const Py_ssize_t first = byte_offset(start);
+    // Lead bytes of a match lie in [first, limit).
+    const Py_ssize_t limit = byte_offset(end) - (width - 1);
+    auto matches = [&](Py_ssize_t at) {
+        return width == 1 || std::memcmp(data + at + 1, encoded + 1, (size_t)(width - 1)) == 0;
+    };
+
+    if (!reverse) {
+        for (Py_ssize_t from = first; from < limit;) {
+            Py_ssize_t hit = simd_find_range(data + from, limit - from, encoded[0], encoded[0] + 1u, false);
+            if (hit == -1) return -1;
+            hit += from;
+            if (matches(hit)) return char_index(hit);
+            from = hit + 1;
+        }
+        return -1;
+    }
+    for (Py_ssize_t stop = limit; stop > first;) {
+        Py_ssize_t hit = simd_rfind_range(data + first, stop - first, encoded[0], encoded[0] + 1u, false);
+        if (hit == -1) return -1;
+        hit += first;
+        if (matches(hit)) return char_index(hit);
+        stop = hit;
+    }
+    return -1;
+}
+
+Py_ssize_t Utf8Buffer::findc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const {
+    return find_bytes(start, end, ch, false);
+}
+
+Py_ssize_t Utf8Buffer::rfindc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const {
+    return find_bytes(start, end, ch, true);
+}
@@ -0,0 +1,207 @@
+#ifndef UTF8_BUFFER_HXX
+#define UTF8_BUFFER_HXX
+
+#include <Python.h>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include <cppy/ptr.h>
+
+#include "lstring/lstring.hxx"
+#include "_lstring.hxx"
+#include "class_index.hxx"
+#include "span.hxx"
+
+/**
+ * @brief Utf8Buffer — leaf over UTF-8 bytes, decoded on demand
+ *
+ * References the bytes exported by an `mmap`, `bytes` or any other
+ * buffer-protocol object and reads them as UTF-8 without building a
+ * decoded copy. The bytes are validated and counted once, when the buffer
+ * is created; the same pass records the byte offset of every
+ * CHECKPOINT-th code point. An access to code point i then starts at the
+ * nearest checkpoint before it and walks at most CHECKPOINT code points,
+ * so value(), copy(), slicing and searches only decode the region they
+ * touch.
+ *
+ * An all-ASCII buffer keeps no checkpoints: its bytes are its code points,
+ * and it reports them as a single 1-byte span. In mixed text, ASCII runs
+ * are still visited in place and only the rest is decoded into scratch.
+ *
+ * The exported memory must not change while the buffer is alive.
+ */
+class Utf8Buffer : public Buffer {
+public:
+    static constexpr int buffer_class_id = 14;
+
+    /** Code points between two checkpoints of the offset index. */
+    static constexpr Py_ssize_t CHECKPOINT = 1024;
+
+    bool is_a(int class_id) const override {
+        return class_id == buffer_class_id || Buffer::is_a(class_id);
+    }
+
+    /**
+     * @brief Export the memory of `obj` and validate it as UTF-8.
+     *
+     * @param obj Object supporting the buffer protocol; held until the
+     *            buffer is destroyed.
+     * @return nullptr with a Python exception set if `obj` cannot be
+     *         exported, or with UnicodeDecodeError if the bytes are not
+     *         strict UTF-8 (surrogates are rejected, as by bytes.decode()).
+     */
+    static Utf8Buffer* create(PyObject *obj);
+
+    ~Utf8Buffer() override {
+        PyBuffer_Release(&view);
+    }
+
+    Utf8Buffer(const Utf8Buffer&) = delete;
+    Utf8Buffer& operator=(const Utf8Buffer&) = delete;
+
+    Py_ssize_t length() const override {
+        return len;
+    }
+
+    /**
+     * @brief Exact kind of the content, found by the validation pass.
+     */
+    int unicode_kind() const override {
+        return kind;
+    }
+
+    uint32_t value(Py_ssize_t index) const override;
+
+    void copy(uint32_t *target, Py_ssize_t start, Py_ssize_t count) const override;
+    void copy(uint16_t *target, Py_ssize_t start, Py_ssize_t count) const override;
+    void copy(uint8_t *target, Py_ssize_t start, Py_ssize_t count) const override;
+
+    /**
+     * @brief Name the exporter, encoding and length: L<mmap.mmap:utf-8:4096>.
+     */
+    PyObject* repr() const override {
+        return PyUnicode_FromFormat("L<%s:utf-8:%zd>", Py_TYPE(owner.get())->tp_name, len);
+    }
+
+    /**
+     * @brief Report [start, end) as a span over the raw bytes when the
+     *        range is pure ASCII; other ranges have no contiguous storage.
+     */
+    bool get_span(Py_ssize_t start, Py_ssize_t end, BufferSpan& out) const override;
+
+    /**
+     * @brief Visit ASCII runs in place and decode the rest into scratch.
+     */
+    bool visit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override;
+    bool rvisit_spans(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor) const override;
+
+    /**
+     * @brief Search the raw bytes for the UTF-8 form of ch.
+     *
+     * UTF-8 is self-synchronizing, so a match of the encoded sequence is
+     * always a whole code point; only the match position is converted back
+     * to a code point index.
+     */
+    Py_ssize_t findc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override;
+    Py_ssize_t rfindc(Py_ssize_t start, Py_ssize_t end, uint32_t ch) const override;
+
+    /**
+     * @brief Class searches over long buffers skip the blocks that the
+     *        class index rules out, as for str leaves.
+     */
+    Py_ssize_t findcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const override {
+        if (start < 0) start = 0;
+        if (end > len) end = len;
+        if (start >= end) return -1;
+        if (!use_class_index()) return Buffer::findcc(start, end, class_mask, invert);
+        return class_index.find(*this, start, end, class_mask, invert, [&](Py_ssize_t s, Py_ssize_t e) {
+            return Buffer::findcc(s, e, class_mask, invert);
+        });
+    }
+
+    Py_ssize_t rfindcc(Py_ssize_t start, Py_ssize_t end, uint32_t class_mask, bool invert = false) const override {
+        if (start < 0) start = 0;
+        if (end > len) end = len;
+        if (start >= end) return -1;
+        if (!use_class_index()) return Buffer::rfindcc(start, end, class_mask, invert);
+        return class_index.rfind(*this, start, end, class_mask, invert, [&](Py_ssize_t s, Py_ssize_t e) {
+            return Buffer::rfindcc(s, e, class_mask, invert);
+        });
+    }
+
+    /**
+     * @brief Byte offset of code point `index` (0 <= index <= length()).
+     */
+    Py_ssize_t byte_offset(Py_ssize_t index) const;
+
+    /**
+     * @brief The UTF-8 bytes of code points [start, end).
+     */
+    const char* bytes(Py_ssize_t start, Py_ssize_t end, Py_ssize_t& size) const {
+        Py_ssize_t first = byte_offset(start);
+        size = byte_offset(end) - first;
+        return reinterpret_cast<const char*>(data) + first;
+    }
+
+    /**
+     * @brief The exporting object (borrowed).
+     */
+    PyObject* get_owner() const {
+        return owner.get();
+    }
+
+    /**
+     * @brief Whether every code point is ASCII.
+     */
+    bool is_ascii() const {
+        return nbytes == len;
+    }
+
+private:
+    Utf8Buffer(PyObject *obj, const Py_buffer& exported)
+        : owner(obj, true), view(exported), data(static_cast<const unsigned char*>(exported.buf)),
+          nbytes(exported.len), len(0), kind(PyUnicode_1BYTE_KIND) {}
+
+    /**
+     * @brief Validate the bytes, count the code points, find the kind and
+     *        record the checkpoints.
+     * @return false with UnicodeDecodeError set on invalid UTF-8.
+     */
+    bool scan();
+
+    /**
+     * @brief Code point index of the character starting at byte `pos`.
+     */
+    Py_ssize_t char_index(Py_ssize_t pos) const;
+
+    template <class T>
+    void copy_to(T *target, Py_ssize_t start, Py_ssize_t count) const;
+
+    template <class T>
+    bool visit_decoded(Py_ssize_t start, Py_ssize_t end, SpanVisitor& visitor, bool reverse) const;
+
+    Py_ssize_t find_bytes(Py_ssize_t start, Py_ssize_t end, uint32_t ch, bool reverse) const;
+
+    bool use_class_index() const {
+        Py_ssize_t threshold = LStr_class_index_threshold.load(std::memory_order_relaxed);
+        return threshold > 0 && len >= threshold;
+    }
+
+    cppy::ptr owner;
+    Py_buffer view;
+    const unsigned char *data;
+    Py_ssize_t nbytes;
+    Py_ssize_t len;
+    int kind;
+
+    /**
+     * Byte offset of code point j * CHECKPOINT, plus nbytes at the end;
+     * empty for all-ASCII buffers.
+     */
+    std::vector<Py_ssize_t> checkpoints;
+
+    /** Character classes per block, used when the buffer is long enough. */
+    CharClassIndex class_index;
+};
+
+#endif // UTF8_BUFFER_HXX
@@ -0,0 +1,120 @@
+"""
+Tests for lstring.Builder: append(), extend(), append_slice() and build().
+"""
+import random
+import sys
+import unittest
+import lstring
+from lstring import L, Builder
+
+
+class TestLStrBuilder(unittest.TestCase):
+
+    def test_append_and_build(self):
+        b = Builder()
+        self.assertEqual(len(b), 0)
+        self.assertEqual(b.build(), L(''))
+        b.append('<p>')
+        b.append(L('hello ') + L('wörld'))
+        b.append('')
+        b.append('</p>')
+        self.assertEqual(len(b), 18)
+        result = b.build()
+        self.assertIsInstance(result, L)
+        self.assertEqual(str(result), '<p>hello wörld</p>')
+
+    def test_random_pieces(self):
+        rnd = random.Random(25)
+        for _ in range(50):
+            b = Builder()
+            text = ''
+            for _ in range(rnd.randint(0, 300)):
+                p = ''.join(rnd.choice('ab é中\U0001F600') for _ in range(rnd.choice([0, 1, 5, 127, 128, 300])))
+                op = rnd.randrange(4)
+                if op == 0:
+                    b.append(p)
+                    text += p
+                elif op == 1:
+                    b.append(L(p) + L('|'))
+                    text += p + '|'
+                elif op == 2:
+                    a = rnd.randint(-len(p) - 2, len(p) + 2)
+                    e = rnd.choice([None, rnd.randint(-len(p) - 2, len(p) + 2)])
+                    b.append_slice(p if rnd.random() < 0.5 else L(p), a, e)
+                    text += p[a:e]
+                else:
+                    pieces = [p, L(p[:3]), p[::-1]]
+                    b.extend(iter(pieces))
+                    text += p + p[:3] + p[::-1]
+            self.assertEqual(len(b), len(text))
+            self.assertEqual(str(b.build()), text)
+
+    def test_build_continues(self):
+        b = Builder()
+        b.append('x' * 1000)
+        first = b.build()
+        self.assertIs(b.build(), first)
+        b.append('yz')
+        second = b.build()
+        self.assertEqual(str(first), 'x' * 1000)
+        self.assertEqual(str(second), 'x' * 1000 + 'yz')
+
+    def test_long_pieces_are_shared(self):
+        big = 'q' * 10000
+        b = Builder()
+        before = sys.getrefcount(big)
+        b.append(big)
+        self.assertGreater(sys.getrefcount(big), before)
+        b.append_slice(big, 10, -10)
+        self.assertEqual(str(b.build()), big + big[10:-10])
+
+    def test_balanced_result(self):
+        b = Builder()
+        parts = []
+        for i in range(100000):
+            piece = '<td>%d</td>' % i if i % 3 else 'x' * 200
+            b.append(piece if i % 3 else L(piece))
+            parts.append(piece)
+        result = b.build()
+        text = ''.join(parts)
+        self.assertEqual(len(result), len(text))
+        self.assertEqual(str(result[123456:123999]), text[123456:123999])
+        self.assertEqual(result.count('</td>'), text.count('</td>'))
+        self.assertEqual(str(result), text)
+
+    def test_subclass_type(self):
+        class MyL(L):
+            pass
+        b = Builder(MyL)
+        b.append('abc' * 100)
+        b.append('d')
+        self.assertIsInstance(b.build(), MyL)
+        self.assertIsInstance(Builder(type=MyL).build(), MyL)
+        with self.assertRaises(TypeError):
+            Builder(str)
+
+    def test_errors(self):
+        b = Builder()
+        with self.assertRaises(TypeError):
+            b.append(b'bytes')
+        with self.assertRaises(TypeError):
+            b.extend(['ok', 3])
+        with self.assertRaises(TypeError):
+            b.extend(5)
+        with self.assertRaises(TypeError):
+            b.append_slice('abc', 'x')
+        self.assertEqual(str(b.build()), 'ok')
+
+    def test_with_compaction(self):
+        orig = lstring.get_compact_min_leaf()
+        lstring.set_compact_min_leaf(64)
+        try:
+            b = Builder()
+            b.extend(['ab', L('c' * 200), 'd'] * 50)
+            self.assertEqual(str(b.build()), ('ab' + 'c' * 200 + 'd') * 50)
+        finally:
+            lstring.set_compact_min_leaf(orig)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -264,5 +264,55 @@ class TestLStrCharacterClassesVsStr(unittest.TestCase):
                 self.assertEqual(L(s).istitle(), s.istitle())
 
 
+
+class TestLStrCharClassTable(unittest.TestCase):
+    """Class searches agree with the str predicates for every code point."""
+
+    PREDICATES = [
+        ('SPACE', str.isspace), ('ALPHA', str.isalpha), ('DIGIT', str.isdigit),
+        ('LOWER', str.islower), ('UPPER', str.isupper), ('DECIMAL', str.isdecimal),
+        ('NUMERIC', str.isnumeric), ('PRINTABLE', str.isprintable),
+    ]
+
+    def matches(self, ls, mask):
+        found = []
+        pos = ls.findcc(mask)
+        while pos != -1:
+            found.append(pos)
+            pos = ls.findcc(mask, pos + 1)
+        return found
+
+    def check_range(self, first, last):
+        text = ''.join(chr(c) for c in range(first, last))
+        ls = L(text)
+        for name, pred in self.PREDICATES:
+            mask = getattr(lstring.CharClass, name)
+            expected = [i for i, ch in enumerate(text) if pred(ch)]
+            self.assertEqual(self.matches(ls, mask), expected, name)
+
+    def test_latin1(self):
+        self.check_range(0, 0x100)
+
+    def test_bmp(self):
+        self.check_range(0x100, 0x10000)
+
+    def test_supplementary_planes(self):
+        self.check_range(0x10000, 0x10800)
+        self.check_range(0x1D400, 0x1D800)
+        self.check_range(0x1F100, 0x1F200)
+
+    def test_latin1_vector_path(self):
+        # Long 1-byte spans are searched with the byte set kernels.
+        text = ''.join(chr(c) for c in range(0x100)) * 3
+        ls = L(text)
+        for name, pred in self.PREDICATES:
+            mask = getattr(lstring.CharClass, name)
+            for invert in (False, True):
+                expected = next((i for i, ch in enumerate(text) if pred(ch) != invert), -1)
+                self.assertEqual(ls.findcc(mask, invert=invert), expected, name)
+                expected = next((i for i in range(len(text) - 1, -1, -1) if pred(text[i]) != invert), -1)
+                self.assertEqual(ls.rfindcc(mask, invert=invert), expected, name)
+
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,99 @@
+"""
+Tests for the character class index of large str-backed buffers.
+
+With a low class index threshold every search below goes through the
+per-block summaries; results must match a plain scan of the same text.
+"""
+import random
+import unittest
+import lstring
+from lstring import L, CharClass
+
+
+class TestLStrClassIndex(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_class_index_threshold()
+        lstring.set_class_index_threshold(1)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_class_index_threshold(cls._orig_thresh)
+
+    def find_ref(self, text, mask, start, end, invert, reverse):
+        ls = L(text)
+        lstring.set_class_index_threshold(0)
+        try:
+            return ls.rfindcc(mask, start, end, invert) if reverse else ls.findcc(mask, start, end, invert)
+        finally:
+            lstring.set_class_index_threshold(1)
+
+    def test_threshold_accessors(self):
+        lstring.set_class_index_threshold(None)
+        self.assertEqual(lstring.get_class_index_threshold(), 0)
+        lstring.set_class_index_threshold(1)
+        self.assertEqual(lstring.get_class_index_threshold(), 1)
+        with self.assertRaises(TypeError):
+            lstring.set_class_index_threshold('1')
+
+    def test_find_non_space_in_whitespace(self):
+        text = ' ' * 10000 + 'x' + ' \t' * 3000 + 'y' + ' ' * 5000
+        ls = L(text)
+        self.assertEqual(ls.findcc(CharClass.SPACE, invert=True), 10000)
+        self.assertEqual(ls.findcc(CharClass.SPACE, 10001, invert=True), text.index('y'))
+        self.assertEqual(ls.rfindcc(CharClass.SPACE, invert=True), text.index('y'))
+        self.assertEqual(ls.rfindcc(CharClass.SPACE, 0, 10000, invert=True), -1)
+        self.assertEqual(ls.findcc(CharClass.ALPHA), 10000)
+        self.assertEqual(ls.findcc(CharClass.DIGIT), -1)
+
+    def test_block_edges(self):
+        block = 1024
+        text = 'a' * (4 * block)
+        for pos in [0, block - 1, block, 2 * block + 1, 4 * block - 1]:
+            t = text[:pos] + '7' + text[pos + 1:]
+            ls = L(t)
+            self.assertEqual(ls.findcc(CharClass.DIGIT), pos)
+            self.assertEqual(ls.rfindcc(CharClass.DIGIT), pos)
+            self.assertEqual(ls.findcc(CharClass.ALPHA, invert=True), pos)
+            self.assertEqual(ls.findcc(CharClass.DIGIT, pos + 1), -1)
+            self.assertEqual(ls.rfindcc(CharClass.DIGIT, 0, pos), -1)
+
+    def test_random_searches(self):
+        rnd = random.Random(99)
+        alphabet = 'aB3 \t.é٠Ⅷあ\U0001F600\x00'
+        masks = [CharClass.SPACE, CharClass.ALPHA, CharClass.DIGIT, CharClass.LOWER,
+                 CharClass.UPPER, CharClass.DECIMAL, CharClass.NUMERIC,
+                 CharClass.PRINTABLE, CharClass.ALNUM, CharClass.SPACE | CharClass.DIGIT]
+        for _ in range(20):
+            # Long runs of one character, as in real data, with rare others.
+            text = ''.join(rnd.choice(alphabet) * rnd.randint(1, 2000) for _ in range(12))
+            for _ in range(10):
+                mask = rnd.choice(masks)
+                a = rnd.randint(0, len(text))
+                b = rnd.randint(a, len(text))
+                for invert in (False, True):
+                    for reverse in (False, True):
+                        ls = L(text)
+                        got = ls.rfindcc(mask, a, b, invert) if reverse else ls.findcc(mask, a, b, invert)
+                        self.assertEqual(got, self.find_ref(text, mask, a, b, invert, reverse))
+
+    def test_classification(self):
+        samples = [' ' * 5000, ' ' * 5000 + 'x', 'a' * 3000 + 'B', 'A' * 4000,
+                   'ABC ' * 2000, 'abc1 ' * 2000, '1' * 3000, '٠' * 3000 + '7',
+                   'Ⅷ' * 2000, 'x' * 4000 + '\n', 'ab1' * 2000, 'a' * 5000 + '!']
+        for text in samples:
+            ls = L(text)
+            for name in ('isspace', 'isalpha', 'isdigit', 'isalnum', 'isdecimal',
+                         'isnumeric', 'isprintable', 'isupper', 'islower'):
+                self.assertEqual(getattr(ls, name)(), getattr(text, name)(), (name, text[:10]))
+
+    def test_slices_use_base_index(self):
+        text = ' ' * 8000 + 'word' + ' ' * 8000
+        ls = L(text)[100:-100]
+        self.assertEqual(ls.findcc(CharClass.SPACE, invert=True), 7900)
+        self.assertEqual(ls.rfindcc(CharClass.SPACE, invert=True), 7903)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,145 @@
+"""
+Tests for leaf compaction: L.compact() and the automatic mode of
+concatenation (set_compact_min_leaf / set_compact_max_leaf).
+"""
+import random
+import unittest
+import lstring
+from lstring import L
+
+
+def _leaves(ls):
+    """Number of str leaves in the repr of a join tree of str leaves."""
+    return repr(ls).count("L'")
+
+
+class TestLStrCompact(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        cls._orig_min = lstring.get_compact_min_leaf()
+        cls._orig_max = lstring.get_compact_max_leaf()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+        lstring.set_compact_min_leaf(cls._orig_min)
+        lstring.set_compact_max_leaf(cls._orig_max)
+
+    def setUp(self):
+        lstring.set_compact_min_leaf(0)
+        lstring.set_compact_max_leaf(4096)
+
+    def _appended(self, pieces):
+        ls = L('')
+        for p in pieces:
+            ls = ls + L(p)
+        return ls
+
+    def test_compact_merges_small_leaves(self):
+        pieces = ['piece%d;' % i for i in range(1000)]
+        ls = self._appended(pieces)
+        self.assertEqual(_leaves(ls), 1000)
+        compacted = ls.compact(min_leaf=64, max_leaf=256)
+        self.assertEqual(str(compacted), ''.join(pieces))
+        self.assertLessEqual(_leaves(compacted), len(''.join(pieces)) // 200 + 1)
+
+    def test_compact_respects_max_leaf(self):
+        ls = self._appended(['abcd'] * 100)
+        compacted = ls.compact(min_leaf=16, max_leaf=40)
+        self.assertEqual(str(compacted), 'abcd' * 100)
+        self.assertEqual(_leaves(compacted), 10)
+
+    def test_compact_shares_long_leaves(self):
+        long_piece = 'x' * 1000
+        ls = L('a') + L('b') + L(long_piece) + L('c') + L('d')
+        compacted = ls.compact(min_leaf=10, max_leaf=100)
+        self.assertEqual(repr(compacted), "(L'ab' + L'%s' + L'cd')" % long_piece)
+
+    def test_compact_non_join_returns_self(self):
+        ls = L('hello')
+        self.assertIs(ls.compact(), ls)
+        sliced = (L('abc') + L('def'))[1:5]
+        self.assertIs(sliced.compact(), sliced)
+
+    def test_compact_mixed_kinds(self):
+        pieces = ['a', 'é', '中', '\U0001F600', 'b'] * 20
+        ls = self._appended(pieces)
+        compacted = ls.compact()
+        self.assertEqual(_leaves(compacted), 1)
+        self.assertEqual(str(compacted), ''.join(pieces))
+        self.assertEqual(str(self._appended(['ab', 'cd']).compact()), 'abcd')
+
+    def test_compact_empty_leaves(self):
+        ls = (L('') + L('')) * 1 + (L('') + L(''))
+        self.assertEqual(str(ls.compact()), '')
+
+    def test_compact_lazy_leaves(self):
+        ls = L('ab') * 3 + L('xyz').upper() + (L('0123') + L('4567'))[2:6]
+        self.assertEqual(str(ls.compact()), 'abababXYZ2345')
+
+    def test_compact_subclass(self):
+        class MyL(L):
+            pass
+        ls = MyL('a') + MyL('b') + MyL('c')
+        compacted = ls.compact()
+        self.assertIsInstance(compacted, MyL)
+        self.assertEqual(str(compacted), 'abc')
+
+    def test_compact_arguments(self):
+        ls = L('a') + L('b')
+        with self.assertRaises(ValueError):
+            ls.compact(min_leaf=-1)
+        with self.assertRaises(ValueError):
+            ls.compact(min_leaf=10, max_leaf=5)
+        with self.assertRaises(TypeError):
+            ls.compact(min_leaf='x')
+
+    def test_auto_compact_appends(self):
+        lstring.set_compact_min_leaf(32)
+        lstring.set_compact_max_leaf(128)
+        pieces = ['w%d ' % i for i in range(2000)]
+        ls = self._appended(pieces)
+        self.assertEqual(str(ls), ''.join(pieces))
+        self.assertLessEqual(_leaves(ls), len(''.join(pieces)) // 32 + 1)
+
+    def test_auto_compact_prepends_and_joins(self):
+        lstring.set_compact_min_leaf(16)
+        ls = L('')
+        for i in range(500):
+            ls = L(str(i)) + ls
+        self.assertEqual(str(ls), ''.join(str(i) for i in reversed(range(500))))
+        self.assertLess(_leaves(ls), 200)
+        items = [str(i) for i in range(1000)]
+        self.assertEqual(str(L(',').join(items)), ','.join(items))
+
+    def test_auto_compact_random(self):
+        lstring.set_compact_min_leaf(8)
+        lstring.set_compact_max_leaf(24)
+        rnd = random.Random(19)
+        for _ in range(100):
+            ls, text = L(''), ''
+            for _ in range(rnd.randint(1, 40)):
+                p = ''.join(rnd.choice('abé\U0001F600') for _ in range(rnd.randint(0, 12)))
+                if rnd.random() < 0.5:
+                    ls, text = ls + L(p), text + p
+                else:
+                    ls, text = L(p) + ls, p + text
+            self.assertEqual(str(ls), text)
+            self.assertEqual(str(ls.compact(min_leaf=4, max_leaf=10)), text)
+
+    def test_auto_compact_settings(self):
+        lstring.set_compact_min_leaf(None)
+        self.assertEqual(lstring.get_compact_min_leaf(), 0)
+        with self.assertRaises(ValueError):
+            lstring.set_compact_max_leaf(0)
+        with self.assertRaises(TypeError):
+            lstring.set_compact_min_leaf('x')
+        ls = L('a') + L('b')
+        self.assertEqual(_leaves(ls), 2)
+
+
+if __name__ == '__main__':
+    unittest.main()
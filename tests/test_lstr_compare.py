@@ -362,6 +362,74 @@ class TestBufferTypeComparisons(unittest.TestCase):
         self.assertTrue(d < a)
 
 
+class TestSharedStructureComparisons(unittest.TestCase):
+    """Ropes sharing leaves and subtrees compare like their str contents."""
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def assertSameOrder(self, x, y):
+        sx, sy = str(x), str(y)
+        self.assertEqual(x == y, sx == sy)
+        self.assertEqual(x < y, sx < sy)
+        self.assertEqual(x > y, sx > sy)
+        self.assertEqual(y < x, sy < sx)
+
+    def build(self, pieces):
+        r = lstring.L('')
+        for p in pieces:
+            r = r + p
+        return r
+
+    def test_reslices_of_same_source(self):
+        for text in ['abcdefghij' * 30, 'αβγδε' * 60, 'a\U0001F600b' * 80]:
+            src = lstring.L(text)
+            n = len(text)
+            pieces = [src[i:i + 17] for i in range(0, n, 17)]
+            joined = self.build(pieces)
+            self.assertSameOrder(joined, src)
+            self.assertSameOrder(joined, src[:-1])
+            self.assertSameOrder(src[1:], joined[1:])
+            self.assertSameOrder(self.build(pieces[::-1]), joined)
+
+    def test_single_edit(self):
+        src = lstring.L('the quick brown fox ' * 50)
+        pieces = [src[i:i + 40] for i in range(0, len(src), 40)]
+        base = self.build(pieces)
+        for pos in (0, 5, len(pieces) // 2, len(pieces) - 1):
+            for repl in ('X', '', 'the quick brown fox '[:40], '\u0100'):
+                edited = list(pieces)
+                edited[pos] = lstring.L(repl)
+                self.assertSameOrder(base, self.build(edited))
+
+    def test_shared_subtrees(self):
+        common = lstring.L('shared ') * 20 + lstring.L('middle')
+        a = lstring.L('x') + common + lstring.L('y')
+        b = lstring.L('x') + common + lstring.L('z')
+        c = (lstring.L('x') + common) + lstring.L('y')
+        self.assertSameOrder(a, b)
+        self.assertSameOrder(a, c)
+        self.assertSameOrder(common, common + lstring.L(''))
+        self.assertSameOrder(common[3:], common[3:-1])
+        self.assertSameOrder(common * 2, common + common)
+
+    def test_mixed_kinds_and_strided(self):
+        a = lstring.L('abc') + lstring.L('\u0100\u0101')
+        b = lstring.L('abc\u0100') + lstring.L('\u0101')
+        self.assertSameOrder(a, b)
+        self.assertSameOrder(a[::-1], b[::-1])
+        self.assertSameOrder(a.upper(), b.upper())
+        self.assertSameOrder(lstring.L('\xff') * 3, lstring.L('\u0100'))
+        self.assertSameOrder(lstring.L('\u0200\u0100'), lstring.L('\u0100\u0200'))
+
+
+
 if __name__ == "__main__":
     unittest.main()
 
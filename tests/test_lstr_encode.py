@@ -0,0 +1,122 @@
+"""
+Tests for native UTF-8 output: encode(), encode_into(), utf8_length(),
+iter_chunks() and write_to() on ropes of every buffer kind.
+"""
+import io
+import random
+import unittest
+import lstring
+from lstring import L
+
+
+def _rope(rnd, alphabet):
+    """Random rope of joins, slices and repeats, and its str value."""
+    ls, text = L(''), ''
+    for _ in range(rnd.randint(0, 12)):
+        p = ''.join(rnd.choice(alphabet) for _ in range(rnd.randint(0, 25)))
+        ls, text = ls + L(p), text + p
+    if rnd.random() < 0.3 and text:
+        ls, text = ls[1:] * 3, text[1:] * 3
+    if rnd.random() < 0.2:
+        ls, text = ls.upper(), text.upper()
+    return ls, text
+
+
+class TestLStrEncode(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def test_random_ropes(self):
+        rnd = random.Random(31)
+        for _ in range(400):
+            ls, text = _rope(rnd, 'ab é\xff中\U0001F600')
+            expected = text.encode('utf-8')
+            self.assertEqual(ls.encode(), expected)
+            self.assertEqual(ls.utf8_length(), len(expected))
+            self.assertEqual(b''.join(ls.iter_chunks(rnd.randint(1, 40))), expected)
+            target = bytearray(len(expected) + 5)
+            self.assertEqual(ls.encode_into(target, 5), len(expected))
+            self.assertEqual(bytes(target[5:]), expected)
+
+    def test_encoding_names(self):
+        ls = L('ab') + L('é')
+        for name in ['utf-8', 'UTF8', 'utf_8', 'U-T-F-8']:
+            self.assertEqual(ls.encode(name), 'abé'.encode('utf-8'))
+        self.assertEqual(ls.encode('latin-1'), 'abé'.encode('latin-1'))
+        self.assertEqual(ls.encode(encoding='utf-16'), 'abé'.encode('utf-16'))
+        with self.assertRaises(UnicodeEncodeError):
+            ls.encode('ascii')
+        self.assertEqual(ls.encode('ascii', 'replace'), b'ab?')
+        with self.assertRaises(LookupError):
+            ls.encode('no-such-codec')
+
+    def test_surrogates(self):
+        ls = L('ab') + L('\ud800') + L('cd')
+        with self.assertRaises(UnicodeEncodeError):
+            ls.encode()
+        with self.assertRaises(UnicodeEncodeError):
+            list(ls.iter_chunks())
+        with self.assertRaises(UnicodeEncodeError):
+            ls.encode_into(bytearray(16))
+        expected = 'ab\ud800cd'.encode('utf-8', 'surrogatepass')
+        self.assertEqual(ls.encode('utf-8', 'surrogatepass'), expected)
+        self.assertEqual(ls.utf8_length('surrogatepass'), len(expected))
+        self.assertEqual(b''.join(ls.iter_chunks(errors='surrogatepass')), expected)
+        target = bytearray(len(expected))
+        self.assertEqual(ls.encode_into(target, errors='surrogatepass'), len(expected))
+        self.assertEqual(bytes(target), expected)
+
+    def test_encode_into_targets(self):
+        ls = L('hello ') + L('мир')
+        expected = 'hello мир'.encode()
+        view = memoryview(bytearray(32))
+        self.assertEqual(ls.encode_into(view[4:]), len(expected))
+        self.assertEqual(bytes(view[4:4 + len(expected)]), expected)
+        with self.assertRaises(ValueError):
+            ls.encode_into(bytearray(len(expected) - 1))
+        with self.assertRaises(ValueError):
+            ls.encode_into(bytearray(32), 40)
+        with self.assertRaises(BufferError):
+            ls.encode_into(b'read-only buffer')
+        self.assertEqual(L('').encode_into(bytearray()), 0)
+
+    def test_chunks_follow_leaves(self):
+        leaf = 'x' * 5000
+        ls = L(leaf) + L('y' * 10) + L('z' * 10) + L(leaf)
+        chunks = list(ls.iter_chunks(4096))
+        self.assertEqual(b''.join(chunks), ls.encode())
+        self.assertTrue(all(len(c) <= 4096 * 2 for c in chunks))
+        self.assertGreater(len(chunks), 2)
+        small = L('').join(['ab'] * 1000)
+        self.assertEqual(len(list(small.iter_chunks(1024))), 2)
+        self.assertEqual(list(L('').iter_chunks()), [])
+        with self.assertRaises(ValueError):
+            ls.iter_chunks(0)
+
+    def test_write_to(self):
+        ls = L(', ').join(['item %d' % i for i in range(1000)]) * 3
+        out = io.BytesIO()
+        self.assertEqual(ls.write_to(out, chunk_size=100), len(ls.encode()))
+        self.assertEqual(out.getvalue(), str(ls).encode())
+
+        class Sink:
+            def __init__(self):
+                self.parts = []
+
+            def write(self, data):
+                self.parts.append(data)
+
+        sink = Sink()
+        (L('a') + L('b')).write_to(sink)
+        self.assertEqual(b''.join(sink.parts), b'ab')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -354,6 +354,13 @@ class TestFFormatEdgeCases(unittest.TestCase):
         result = fformat(L('Value: {x}'), globals(), locals())
         self.assertIsInstance(result, L)
     
+    def test_padded_expression(self):
+        """Test expressions with surrounding whitespace, as f-strings allow."""
+        x = 3
+        self.assertEqual(str(L('{ x }').f({'x': 3}, {})), '3')
+        self.assertEqual(str(fformat(L('<{  x + 1\t}>'), globals(), locals())), '<4>')
+        self.assertEqual(str(fformat(L('{ x !r:>3}'), globals(), locals())), f'{ x !r:>3}')
+
     def test_nested_braces_in_string(self):
         """Test nested braces in string literals."""
         data = {'a': 1}
@@ -1,6 +1,7 @@
 """
 Tests for find() and rfind() methods across all buffer types.
 """
+import random
 import unittest
 import lstring
 
@@ -184,5 +185,98 @@ class TestLStrRFind(unittest.TestCase):
         self._check_three(s3, 'world')
 
 
+class TestLStrFindIter(unittest.TestCase):
+    """Tests for `L.find_iter`/`L.rfind_iter` and the search engine on ropes."""
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    @staticmethod
+    def _rope(s, step):
+        l = lstring.L('')
+        for i in range(0, len(s), step):
+            l = l + lstring.L(s[i:i + step])
+        return l
+
+    @staticmethod
+    def _matches(s, sub, start=0, end=None):
+        out, pos = [], start
+        end = len(s) if end is None else end
+        while True:
+            i = s.find(sub, pos, end)
+            if i < 0:
+                return out
+            out.append(i)
+            pos = i + max(len(sub), 1)
+
+    def test_find_iter_non_overlapping(self):
+        l = lstring.L('aaaaa')
+        self.assertEqual(list(l.find_iter('aa')), [0, 2])
+        self.assertEqual(list(l.rfind_iter('aa')), [3, 1])
+        self.assertEqual(list(l.find_iter('b')), [])
+
+    def test_find_iter_range_and_empty(self):
+        l = lstring.L('abcabc')
+        self.assertEqual(list(l.find_iter('bc', 2)), [4])
+        self.assertEqual(list(l.find_iter('abc', 0, -1)), [0])
+        self.assertEqual(list(l.find_iter('')), list(range(7)))
+        self.assertEqual(list(l.rfind_iter('', 4)), [6, 5, 4])
+
+    def test_find_iter_type_error(self):
+        with self.assertRaises(TypeError):
+            lstring.L('abc').find_iter(1)
+
+    def test_matches_across_leaves(self):
+        s = 'xyabcab' * 20 + 'abcabd'
+        for step in (1, 2, 3, 7, 64, 100):
+            l = self._rope(s, step)
+            for sub in ('abcabd', 'cabx', 'bcab', 'ab', 'yabcabxy', s[5:90]):
+                self.assertEqual(l.find(sub), s.find(sub), (step, sub))
+                self.assertEqual(l.rfind(sub), s.rfind(sub), (step, sub))
+                self.assertEqual(list(l.find_iter(sub)), self._matches(s, sub), (step, sub))
+                self.assertEqual(l.find(sub, 3, 77), s.find(sub, 3, 77), (step, sub))
+                self.assertEqual(l.rfind(sub, 3, 77), s.rfind(sub, 3, 77), (step, sub))
+
+    def test_periodic_needles(self):
+        s = 'a' * 3000 + 'b' + 'a' * 100
+        l = self._rope(s, 1000) * 2
+        s = s * 2
+        for sub in ('a' * 999 + 'b', 'b' + 'a' * 200, 'ab' * 5, 'a' * 50):
+            self.assertEqual(l.find(sub), s.find(sub), sub[:10])
+            self.assertEqual(l.rfind(sub), s.rfind(sub), sub[:10])
+            self.assertEqual(l.count(sub), s.count(sub), sub[:10])
+
+    def test_wide_kinds(self):
+        s = 'aé\U0001F600' * 50 + 'д'
+        l = self._rope(s, 5)
+        for sub in ('\U0001F600a', 'é\U0001F600aé', '\U0001F600д', 'дa'):
+            self.assertEqual(l.find(sub), s.find(sub), sub)
+            self.assertEqual(l.rfind(sub), s.rfind(sub), sub)
+            self.assertEqual(list(l.rfind_iter(sub)), self._matches(s, sub)[::-1], sub)
+
+    def test_anchor_candidates(self):
+        # Rare and frequent anchor characters, candidates straddling leaves,
+        # and anchors frequent enough to hand over to the two-way scan.
+        rnd = random.Random(3)
+        for alphabet in ('ab', 'abcdefgh e', 'aé中 ', 'x\U0001F600 '):
+            s = ''.join(rnd.choice(alphabet) for _ in range(5000))
+            for step in (1, 3, 17, 600):
+                l = self._rope(s, step)
+                for _ in range(10):
+                    at = rnd.randrange(len(s) - 10)
+                    for sub in (s[at:at + rnd.choice((2, 3, 6, 10))], s[at:at + 4] + 'q', 'q' + s[at:at + 3]):
+                        self.assertEqual(l.find(sub), s.find(sub), (step, sub))
+                        self.assertEqual(l.rfind(sub), s.rfind(sub), (step, sub))
+                        self.assertEqual(l.count(sub), s.count(sub), (step, sub))
+                        self.assertEqual(l.find(sub, 7, -7), s.find(sub, 7, -7), (step, sub))
+                        self.assertEqual(l.rfind(sub, 7, -7), s.rfind(sub, 7, -7), (step, sub))
+
+
 if __name__ == '__main__':
     unittest.main()
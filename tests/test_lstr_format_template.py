@@ -0,0 +1,129 @@
+"""
+Tests for compiled format templates: printf, format and fformat parse a
+format L once and render ropes whose literal text is sliced from it.
+"""
+import random
+import unittest
+import lstring
+from lstring import L
+from lstring import format as lformat
+
+
+class TestFormatTemplate(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def test_template_is_cached(self):
+        fmt = L('a=%s b=%d')
+        self.assertIs(lformat._template(fmt, 'printf'), lformat._template(L('a=%s b=%d'), 'printf'))
+        self.assertIsNot(lformat._template(fmt, 'printf'), lformat._template(fmt, 'printf_named'))
+        self.assertEqual(str(fmt % ('x', 1)), 'a=x b=1')
+        self.assertEqual(str(fmt % ('y', 2)), 'a=y b=2')
+
+    def test_cache_is_bounded(self):
+        for i in range(lformat._TEMPLATE_CACHE_SIZE + 10):
+            self.assertEqual(str(L('%d-' + str(i)) % i), '%d-%d' % (i, i))
+        self.assertLessEqual(len(lformat._template_cache), lformat._TEMPLATE_CACHE_SIZE)
+
+    def test_result_is_rope(self):
+        text = 'x' * 1000
+        result = L(text + '%s' + text) % 'mid'
+        self.assertEqual(str(result), text + 'mid' + text)
+        self.assertIn('+', repr(result))
+        self.assertEqual(str(L(text).format()), text)
+
+    def test_escapes(self):
+        self.assertEqual(str(L('100%% %s%%') % 5), '100% 5%')
+        self.assertEqual(str(L('{{{}}} }}{{').format(1)), '{1} }{')
+        self.assertEqual(str(L('{{{x}}}').f({'x': 2}, {})), '{2}')
+        self.assertEqual(str(L('') % ()), '')
+        self.assertEqual(str(L('{}').format('')), '')
+
+    def test_template_methods(self):
+        tmpl = L('{a!r:>6}-{b + 1}')._format_template('fformat')
+        self.assertEqual(tmpl.fields(), (('a', '{!r:>6}'), ('b + 1', '{}')))
+        self.assertEqual(str(tmpl.fill(['  \'q\'', '3'])), "  'q'-3")
+        with self.assertRaises(ValueError):
+            tmpl.fill(['x'])
+        with self.assertRaises(TypeError):
+            tmpl.printf(('x',))
+        with self.assertRaises(ValueError):
+            L('x')._format_template('other')
+
+    def test_numbering_errors(self):
+        with self.assertRaises(ValueError):
+            L('{} {0}').format(1)
+        with self.assertRaises(ValueError):
+            L('{0} {}').format(1)
+        with self.assertRaises(IndexError):
+            L('{} {}').format(1)
+
+    def test_random_formats(self):
+        rnd = random.Random(23)
+        pieces = ['ab', 'é', '中', '\U0001F600', ' ', '%s', '%d', '%5.1f', '%%', '%-4s', '%*d']
+        for _ in range(300):
+            fmt = ''.join(rnd.choice(pieces) for _ in range(rnd.randint(0, 10)))
+            values = []
+            for _ in range(fmt.replace('%%', '').count('%')):
+                values.append(rnd.randint(-50, 50))
+            values += [3] * fmt.count('%*d')
+            try:
+                expected = fmt % tuple(values)
+            except TypeError:
+                continue
+            self.assertEqual(str(L(fmt) % tuple(values)), expected)
+
+        pieces = ['ab', 'é', '\U0001F600', '{}', '{:>3}', '{!r}', '{{', '}}', '{:.1f}']
+        for _ in range(300):
+            fmt = ''.join(rnd.choice(pieces) for _ in range(rnd.randint(0, 10)))
+            args = [rnd.random() * 10 for _ in range(fmt.count('{'))]
+            self.assertEqual(str(L(fmt).format(*args)), fmt.format(*args))
+
+    def test_invalid_printf_specs_raise_like_str(self):
+        cases = [
+            ('%', ()),
+            ('%q', 1),
+            ('%q', ()),
+            ('%5%', ()),
+            ('ab%', ('x',)),
+            ('%s %q', (1, 2)),
+            ('%(a', {'a': 1}),
+            ('%(a)', {'a': 1}),
+            ('%(a)q', {'a': 1}),
+            ('%(a)s %s', {'a': 1}),
+            ('%(a)s', (1,)),
+            ('%s', (1, 2)),
+            ('abc', (1,)),
+        ]
+        for fmt, values in cases:
+            with self.subTest(fmt=fmt, values=values):
+                with self.assertRaises((TypeError, ValueError)) as expected:
+                    fmt % values
+                with self.assertRaises(type(expected.exception)):
+                    L(fmt) % values
+
+    def test_unparsed_printf_formats_like_str(self):
+        # A format the template cannot parse is handed to str % whole.
+        class MyL(L):
+            pass
+        result = MyL('%s %(a)s') % {'a': 1}
+        self.assertIsInstance(result, MyL)
+        self.assertEqual(str(result), '%s %(a)s' % {'a': 1})
+
+    def test_subclass_format(self):
+        class MyL(L):
+            pass
+        result = MyL('%s and %s') % ('a', 'b')
+        self.assertIsInstance(result, MyL)
+        self.assertEqual(str(result), 'a and b')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,96 @@
+"""
+Tests for the compositional hash of lazy buffers.
+
+The hash of a join, repetition or slice is combined from the cached hashes
+of its parts; it must always equal the hash of the same content held in a
+single str-backed L.
+"""
+import random
+import unittest
+import lstring
+from lstring import L
+
+
+class TestLStrCompositionalHash(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def assertHashMatches(self, ls):
+        self.assertEqual(hash(ls), hash(L(str(ls))), repr(ls)[:200])
+
+    def test_join(self):
+        self.assertHashMatches(L('abc') + L('def'))
+        self.assertHashMatches(L('') + L('x'))
+        self.assertHashMatches(L('x') + L(''))
+        self.assertHashMatches((L('ab') + L('γδ')) + (L('\U0001F600') + L('z')))
+
+    def test_repeat(self):
+        for count in (0, 1, 2, 3, 7, 8, 1000, 12345):
+            self.assertHashMatches(L('abc') * count)
+            self.assertHashMatches((L('a') + L('β')) * count)
+        self.assertHashMatches(L('') * 10)
+
+    def test_ranges(self):
+        rope = (L('hello ') + L('wörld') * 5 + L('!\U0001F600')) * 3
+        text = str(rope)
+        n = len(text)
+        for start in range(0, n, 7):
+            for end in range(start, n + 1, 11):
+                self.assertEqual(hash(rope[start:end]), hash(L(text[start:end])))
+
+    def test_hash_cached_before_slicing(self):
+        rope = L('abc') * 100 + L('xyz') * 50
+        hash(rope)
+        self.assertHashMatches(rope[5:-5])
+        self.assertHashMatches(rope[5:-5][3:200])
+
+    def test_strided_and_mapped(self):
+        rope = L('Hello ') * 4 + L('Wörld')
+        self.assertHashMatches(rope[::2])
+        self.assertHashMatches(rope[::-3])
+        self.assertHashMatches(rope.upper())
+        self.assertHashMatches((rope.lower() + rope[1::2]) * 3)
+
+    def test_random_trees(self):
+        rnd = random.Random(1234)
+        alphabet = 'abéЖ\U0001F600'
+
+        def leaf():
+            return L(''.join(rnd.choice(alphabet) for _ in range(rnd.randint(0, 6))))
+
+        for _ in range(200):
+            items = [leaf() for _ in range(4)]
+            for _ in range(12):
+                op = rnd.randrange(5)
+                a = rnd.choice(items)
+                if op == 0:
+                    items.append(a + rnd.choice(items))
+                elif op == 1 and len(a) < 200:
+                    items.append(a * rnd.randint(0, 5))
+                elif op == 2 and len(a) > 0:
+                    i = rnd.randint(0, len(a))
+                    j = rnd.randint(i, len(a))
+                    items.append(a[i:j])
+                elif op == 3:
+                    items.append(a[::rnd.choice([2, -1, 3])])
+                else:
+                    items.append(a.upper())
+            for ls in items:
+                self.assertHashMatches(ls)
+
+    def test_equal_ropes_as_dict_keys(self):
+        a = L('k') * 1000 + L('ey')
+        b = L('k' * 500) + L('k' * 500) + L('e') + L('y')
+        d = {a: 1}
+        self.assertEqual(d[b], 1)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,78 @@
+"""
+Tests for short results collapsed by the optimize threshold into inline
+storage.
+"""
+import unittest
+import lstring
+from lstring import L
+
+
+class TestLStrInlineCollapse(unittest.TestCase):
+    """Collapsed results behave exactly like str-backed L values."""
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(100)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    # Lengths around the inline capacity of each storage width.
+    SAMPLES = [
+        ('a', [1, 63, 64, 65]),
+        ('α', [1, 31, 32, 33]),
+        ('\U0001F600', [1, 15, 16, 17]),
+    ]
+
+    def collapsed(self, text):
+        half = len(text) // 2
+        return L(text[:half]) + L(text[half:] + '#')[:-1]
+
+    def texts(self):
+        for ch, lengths in self.SAMPLES:
+            for n in lengths:
+                yield ''.join(chr(ord(ch) + (i % 3)) for i in range(n))
+
+    def test_content(self):
+        for text in self.texts():
+            ls = self.collapsed(text)
+            self.assertEqual(repr(ls), 'L' + repr(text))
+            self.assertEqual(str(ls), text)
+            self.assertEqual(len(ls), len(text))
+            self.assertEqual(list(ls), list(text))
+            self.assertEqual(ls[len(text) // 2], L(text[len(text) // 2]))
+            self.assertEqual(ls, L(text))
+            self.assertEqual(hash(ls), hash(L(text)))
+
+    def test_search(self):
+        for text in self.texts():
+            ls = self.collapsed(text)
+            last = text[-1]
+            self.assertEqual(ls.findc(last), text.find(last))
+            self.assertEqual(ls.rfindc(text[0]), text.rfind(text[0]))
+            self.assertEqual(ls.findc(last, 1, -1), text.find(last, 1, len(text) - 1))
+            self.assertEqual(ls.findc('#'), -1)
+            self.assertEqual(ls.find(text[1:3]), text.find(text[1:3]))
+            self.assertEqual(ls.findcs(last + '#'), text.find(last))
+
+    def test_further_operations(self):
+        for text in self.texts():
+            ls = self.collapsed(text)
+            self.assertEqual(str(ls + ls), text + text)
+            self.assertEqual(str(ls[1:-1]), text[1:-1])
+            self.assertEqual(str(ls[::-1]), text[::-1])
+            self.assertEqual(str(ls * 3), text * 3)
+            self.assertEqual(ls.isalpha(), text.isalpha())
+
+    def test_compare_with_str_backed(self):
+        a = L('ab') + L('cd')
+        self.assertEqual(a, L('abcd'))
+        self.assertLess(a, L('abce'))
+        self.assertGreater(L('abce'), a)
+        self.assertEqual(a, 'abcd')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -157,6 +157,49 @@ class TestLStringJoin(unittest.TestCase):
         expected = '-'.join(items)
         self.assertEqual(str(result), expected)
 
+    def test_join_random_against_str(self):
+        """Random mixes of str, L and lazy items match str.join"""
+        import random
+        rnd = random.Random(7)
+        for _ in range(200):
+            texts = [''.join(rnd.choice('ab\u00e9\u4e2d') for _ in range(rnd.randint(0, 4)))
+                     for _ in range(rnd.randint(0, 40))]
+            items = [t if rnd.random() < 0.5 else L(t) * 1 + L('') for t in texts]
+            sep = rnd.choice(['', ',', ' :: ', '\U0001F600'])
+            self.assertEqual(str(L(sep).join(items)), sep.join(texts))
+            self.assertEqual(str(L(sep).join(iter(items))), sep.join(texts))
+
+    def test_join_many_fragments(self):
+        """A large join stays shallow enough to index and materialize"""
+        items = [str(i) for i in range(100000)]
+        result = L('|').join(items)
+        expected = '|'.join(items)
+        self.assertEqual(len(result), len(expected))
+        self.assertEqual(str(result[123456:123500]), expected[123456:123500])
+        self.assertEqual(str(result), expected)
+
+    def test_join_single_item_kept(self):
+        """A single L item is returned without a new node"""
+        item = L('abc') + L('def')
+        self.assertIs(L(', ').join([item]), item)
+
+    def test_join_subclass(self):
+        """Items and the result use the separator's L subclass"""
+        class MyL(L):
+            pass
+        result = MyL('-').join(['a', L('b'), 'c'])
+        self.assertIsInstance(result, MyL)
+        self.assertEqual(str(result), 'a-b-c')
+
+    def test_join_rejects_non_iterable(self):
+        """Test that join rejects non-iterable arguments"""
+        with self.assertRaises(TypeError):
+            L(',').join(5)
+        with self.assertRaises(TypeError) as cm:
+            L(',').join(['a', b'b'])
+        self.assertIn('sequence item 1', str(cm.exception))
+        self.assertIn('bytes found', str(cm.exception))
+
 
 if __name__ == '__main__':
     unittest.main()
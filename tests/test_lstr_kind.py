@@ -0,0 +1,95 @@
+"""
+Tests for the unicode kind of lazy buffers.
+
+Joins, repetitions and slices derive their kind from the summaries of their
+parts and leaves index the kind of wide strings per block; str() must always
+produce the canonical (narrowest) representation of the content.
+"""
+import random
+import unittest
+import lstring
+from lstring import L
+
+
+class TestLStrUnicodeKind(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def assertCanonical(self, ls, expected):
+        # Strings of different kinds never compare equal, so this also checks
+        # that the result is not stored wider than needed.
+        self.assertEqual(str(ls), expected)
+
+    def test_slices_of_wide_str(self):
+        text = 'a' * 5000 + 'ā' + 'b' * 5000 + '\U0001F600' + 'c' * 5000
+        ls = L(text)
+        for start, stop in [(0, 5000), (100, 4999), (5000, 5001), (4000, 9000),
+                            (5001, 10001), (4000, 10002), (10002, 15002), (0, 15002)]:
+            self.assertCanonical(ls[start:stop], text[start:stop])
+
+    def test_block_boundaries(self):
+        block = 2048
+        text = ''.join('Ā' if i % block == block - 1 else 'x' for i in range(8 * block))
+        ls = L(text)
+        for start, stop in [(0, block - 1), (block, 2 * block - 1), (block - 1, 4 * block),
+                            (block, 5 * block - 1), (3, 7 * block + 5)]:
+            self.assertCanonical(ls[start:stop], text[start:stop])
+
+    def test_repeated_queries_reuse_index(self):
+        text = 'x' * 20000 + '€' + 'y' * 20000
+        ls = L(text)
+        for _ in range(3):
+            self.assertCanonical(ls[10:19990], text[10:19990])
+            self.assertCanonical(ls[10:20010], text[10:20010])
+
+    def test_joins(self):
+        left = L('abcĀ')
+        right = L('def\U00010000')
+        self.assertCanonical((left + right)[:3], 'abc')
+        self.assertCanonical((left + right)[2:6], 'cĀde')
+        self.assertCanonical((left + L('xyz'))[4:], 'xyz')
+        self.assertCanonical((left + right)[3:], 'Ādef\U00010000')
+
+    def test_repeats(self):
+        ls = L('abĀ') * 5
+        text = 'abĀ' * 5
+        self.assertCanonical(ls[:2], 'ab')
+        self.assertCanonical(ls[3:5], 'ab')
+        self.assertCanonical(ls[4:6], text[4:6])
+        self.assertCanonical(ls[1:4], text[1:4])
+        self.assertCanonical(ls[6:11], text[6:11])
+
+    def test_strided_slices(self):
+        text = 'aĀ' * 100
+        ls = L(text)
+        self.assertCanonical(ls[::2], text[::2])
+        self.assertCanonical(ls[1::2], text[1::2])
+        self.assertCanonical(ls[::-1], text[::-1])
+
+    def test_random_trees(self):
+        rnd = random.Random(1234)
+        alphabet = ['a', 'z', 'é', 'ā', '中', '\U0001F600']
+        for _ in range(200):
+            pieces = []
+            for _ in range(rnd.randint(1, 6)):
+                n = rnd.randint(0, 30)
+                pieces.append(''.join(rnd.choice(alphabet[:rnd.randint(1, 6)]) for _ in range(n)))
+            ls, text = L(''), ''
+            for p in pieces:
+                count = rnd.randint(1, 3)
+                ls, text = ls + L(p) * count, text + p * count
+            for _ in range(5):
+                a = rnd.randint(0, len(text))
+                b = rnd.randint(a, len(text))
+                self.assertCanonical(ls[a:b], text[a:b])
+
+
+if __name__ == '__main__':
+    unittest.main()
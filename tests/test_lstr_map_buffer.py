@@ -0,0 +1,133 @@
+"""
+Tests for lazily mapped views: lower(), upper(), casefold(), swapcase()
+and translate().
+"""
+import unittest
+import lstring
+from lstring import L
+
+
+def rope(*parts):
+    result = L('')
+    for part in parts:
+        result = result + L(part)
+    return result
+
+
+class TestLStrCaseMapping(unittest.TestCase):
+    """Case methods produce a lazy view when no special character occurs."""
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    SAMPLES = [
+        ('Hello ', 'World'),
+        ('µÿ', 'Ÿ-straße'),
+        ('Kelvin K ', 'Ångström Å'),
+        ('ΟΔΟΣ', ' ΑΣ'),
+        ('İstanbul', ' ı'),
+        ('ǅemal ', 'ﬀ'),
+        ('𐐀𐐨', 'Ꭰꭰ ſ'),
+        ('', ''),
+    ]
+
+    def test_matches_str(self):
+        for parts in self.SAMPLES:
+            s = ''.join(parts)
+            for method in ('lower', 'upper', 'casefold', 'swapcase'):
+                result = getattr(rope(*parts), method)()
+                expected = getattr(s, method)()
+                self.assertIsInstance(result, L)
+                self.assertEqual(str(result), expected, (method, s))
+                self.assertEqual(result, L(expected))
+                self.assertEqual(list(result), list(expected))
+
+    def test_lazy_view(self):
+        result = rope('Hello ', 'World').upper()
+        self.assertEqual(repr(result), "(L'Hello ' + L'World').upper()")
+        self.assertEqual(result[1:4], L('ELL'))
+
+    def test_length_changing_falls_back(self):
+        result = rope('stra', 'ße').upper()
+        self.assertEqual(result, L('STRASSE'))
+        self.assertEqual(repr(result), "L'STRASSE'")
+
+    def test_final_sigma_falls_back(self):
+        self.assertEqual(rope('ΟΔΟ', 'Σ').lower(), L('οδος'))
+        self.assertEqual(rope('ΟΔΟ', 'Σ').swapcase(), L('οδος'))
+        self.assertEqual(rope('ΟΔΟ', 'Σ').casefold(), L('οδοσ'))
+
+    def test_kind_changes(self):
+        # 1-byte text that needs 2 bytes once uppercased, and the reverse.
+        self.assertEqual(str(rope('µ', 'ÿ').upper()), 'ΜŸ')
+        self.assertEqual(str(rope('K', 'Å').lower()), 'kå')
+        self.assertEqual(hash(rope('K', 'Å').lower()), hash(L('kå')))
+
+    def test_findc(self):
+        result = rope('Kelvin ', 'K k').lower()
+        self.assertEqual(result.findc('k'), 0)
+        self.assertEqual(result.rfindc('k'), 9)
+        self.assertEqual(result.findc('K'), -1)
+        self.assertEqual(result.findc('k', 1), 7)
+        self.assertEqual(result.find('vin k'), 3)
+
+    def test_subclass_result(self):
+        class MyL(L):
+            pass
+        self.assertIsInstance(MyL('abc').upper(), MyL)
+
+
+class TestLStrTranslateMapping(unittest.TestCase):
+    """translate() maps lazily for one-to-one tables."""
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def test_one_to_one_is_lazy(self):
+        table = str.maketrans('aeiou', '12345')
+        result = rope('hello ', 'world').translate(table)
+        self.assertEqual(result, L('h2ll4 w4rld'))
+        self.assertEqual(repr(result), "(L'hello ' + L'world').translate()")
+
+    def test_ordinal_values(self):
+        table = {ord('a'): 0x1F600, ord('b'): ord('B')}
+        self.assertEqual(str(rope('ab', 'c').translate(table)), '\U0001F600Bc')
+
+    def test_deletion_and_expansion(self):
+        table = {ord('l'): None, ord('o'): 'oo'}
+        self.assertEqual(rope('hello ', 'world').translate(table), L('heoo woord'))
+        # Unused entries do not prevent a lazy view.
+        result = rope('abc').translate({ord('a'): 'A', ord('z'): None})
+        self.assertEqual(result, L('Abc'))
+
+    def test_identity_returns_self(self):
+        ls = rope('abc', 'def')
+        self.assertIs(ls.translate({}), ls)
+
+    def test_other_tables(self):
+        class Table:
+            def __getitem__(self, key):
+                if key == ord('a'):
+                    return 'A'
+                raise LookupError(key)
+        self.assertEqual(rope('abc').translate(Table()), L('Abc'))
+        with self.assertRaises(TypeError):
+            rope('abc').translate({ord('a'): 1.5})
+        with self.assertRaises(ValueError):
+            rope('abc').translate({ord('a'): -1})
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,143 @@
+"""
+Tests for buffer-protocol leaves: L.from_buffer() and L.from_file().
+
+The leaf reads its code points straight from the exported memory; every
+operation must match the same operation on the decoded str.
+"""
+import array
+import os
+import random
+import tempfile
+import unittest
+import lstring
+from lstring import L, CharClass
+
+
+class TestLStrMmapBuffer(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def _temp_file(self, data):
+        fd, path = tempfile.mkstemp()
+        with os.fdopen(fd, 'wb') as f:
+            f.write(data)
+        self.addCleanup(os.remove, path)
+        return path
+
+    def test_from_bytes_latin1(self):
+        data = 'héllo wörld\nsecond line\n'.encode('latin-1')
+        text = data.decode('latin-1')
+        ls = L.from_buffer(data)
+        self.assertEqual(len(ls), len(text))
+        self.assertEqual(str(ls), text)
+        self.assertEqual(ls, L(text))
+        self.assertEqual(hash(ls), hash(L(text)))
+        self.assertEqual(repr(ls), 'L<bytes:%d>' % len(text))
+        self.assertEqual(ls[1], 'é')
+        self.assertEqual(str(ls[2:9]), text[2:9])
+
+    def test_random_operations(self):
+        rnd = random.Random(41)
+        text = ''.join(rnd.choice('ab cd\n\xe9\xff0') for _ in range(5000))
+        ls = L.from_buffer(bytearray(text.encode('latin-1')))
+        for _ in range(200):
+            a = rnd.randint(0, len(text))
+            b = rnd.randint(a, len(text))
+            self.assertEqual(str(ls[a:b]), text[a:b])
+            self.assertEqual(ls.find('cd', a, b), text.find('cd', a, b))
+            self.assertEqual(ls.rfind('\n', a, b), text.rfind('\n', a, b))
+            self.assertEqual(ls.findc('\xff', a, b), text.find('\xff', a, b))
+            self.assertEqual(ls.rfindc('0', a, b), text.rfind('0', a, b))
+        self.assertEqual([str(x) for x in ls.splitlines()], text.splitlines())
+        self.assertEqual([str(x) for x in ls.split()], text.split())
+        self.assertEqual(ls.count('ab'), text.count('ab'))
+        self.assertEqual(str(ls.upper()), text.upper())
+        self.assertEqual(str(ls[::-3]), text[::-3])
+        self.assertEqual(str(L('<') + ls[10:20] + L('>')), '<' + text[10:20] + '>')
+        self.assertEqual(ls.encode(), text.encode())
+
+    def test_class_index(self):
+        orig = lstring.get_class_index_threshold()
+        lstring.set_class_index_threshold(1000)
+        try:
+            text = 'a' * 5000 + '7' + 'b' * 3000
+            ls = L.from_buffer(text.encode('ascii'))
+            self.assertEqual(ls.findcc(CharClass.DIGIT), 5000)
+            self.assertEqual(ls.rfindcc(CharClass.DIGIT), 5000)
+            self.assertFalse(ls.isalpha())
+            self.assertTrue(ls[:5000].isalpha())
+        finally:
+            lstring.set_class_index_threshold(orig)
+
+    def test_wide_widths(self):
+        text = 'héllo wörld Ωmega '
+        ucs2 = L.from_buffer(array.array('H', map(ord, text)), 2)
+        self.assertEqual(str(ucs2), text)
+        self.assertEqual(ucs2, L(text))
+        self.assertEqual(ucs2.find('Ω'), text.find('Ω'))
+        self.assertEqual(ucs2.findc('Ω'), text.find('Ω'))
+        ascii_only = L.from_buffer(array.array('H', map(ord, 'plain')), 2)
+        self.assertEqual(ascii_only, L('plain'))
+        self.assertEqual(str(ascii_only), 'plain')
+        self.assertEqual(str(ascii_only) + 'x', 'plainx')
+
+        wide = 'a\U0001F600b中'
+        ucs4 = L.from_buffer(array.array('I', map(ord, wide)), 4)
+        self.assertEqual(str(ucs4), wide)
+        self.assertEqual(str(ucs4[1:2]), '\U0001F600')
+        self.assertEqual(ucs4[2:], L('b中'))
+
+    def test_invalid_buffers(self):
+        with self.assertRaises(ValueError):
+            L.from_buffer(b'abc', 2)
+        with self.assertRaises(ValueError):
+            L.from_buffer(b'abcd', 3)
+        with self.assertRaises(ValueError):
+            L.from_buffer(memoryview(b'abcde')[1:5], 2)
+        with self.assertRaises(ValueError):
+            L.from_buffer(array.array('I', [65, 0x110000]), 4)
+        with self.assertRaises(TypeError):
+            L.from_buffer('not a buffer')
+
+    def test_exporter_is_pinned(self):
+        data = bytearray(b'abc')
+        ls = L.from_buffer(data)
+        with self.assertRaises(BufferError):
+            data.extend(b'def')
+        self.assertEqual(str(ls), 'abc')
+        del ls
+        data.extend(b'def')
+        self.assertEqual(data, b'abcdef')
+
+    def test_from_file(self):
+        content = ''.join('line %d: status=%s\n' % (i, 'ERROR' if i % 7 == 0 else 'ok') for i in range(2000))
+        path = self._temp_file(content.encode('ascii'))
+        ls = L.from_file(path)
+        self.assertEqual(repr(ls), 'L<mmap.mmap:%d>' % len(content))
+        self.assertEqual(len(ls), len(content))
+        self.assertEqual(ls.count('ERROR'), content.count('ERROR'))
+        first = ls[:ls.findc('\n')]
+        self.assertEqual(str(first), 'line 0: status=ERROR')
+        self.assertEqual(str(ls), content)
+
+    def test_from_file_empty_and_subclass(self):
+        path = self._temp_file(b'')
+        self.assertEqual(L.from_file(path), L(''))
+
+        class MyL(L):
+            pass
+        path = self._temp_file(b'xyz')
+        ls = MyL.from_file(path)
+        self.assertIsInstance(ls, MyL)
+        self.assertEqual(str(ls), 'xyz')
+
+
+if __name__ == '__main__':
+    unittest.main()
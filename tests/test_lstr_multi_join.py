@@ -0,0 +1,145 @@
+"""
+Tests for wide join nodes (MultiJoinBuffer), built by bulk joins.
+
+join(), replace() and compact() build their results from nodes of up to 32
+children; every operation on such a rope must match the same operation on
+the equivalent str, including concatenations that extend a wide node.
+"""
+import random
+import unittest
+import lstring
+from lstring import L
+
+
+def _height(ls):
+    """Nesting depth of the join nodes in repr(ls) (leaves do not nest)."""
+    depth = best = 0
+    in_str = escape = False
+    for ch in repr(ls):
+        if in_str:
+            if escape:
+                escape = False
+            elif ch == '\\':
+                escape = True
+            elif ch == "'":
+                in_str = False
+        elif ch == "'":
+            in_str = True
+        elif ch == '(':
+            depth += 1
+            best = max(best, depth)
+        elif ch == ')':
+            depth -= 1
+    return best
+
+
+class TestLStrMultiJoin(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def test_wide_node_repr(self):
+        ls = L('').join(['a', 'b', 'c', 'd'])
+        self.assertEqual(repr(ls), "(L'a' + L'b' + L'c' + L'd')")
+
+    def test_bulk_join_is_shallow(self):
+        items = ['x%d' % i for i in range(100000)]
+        ls = L('').join(items)
+        self.assertLessEqual(_height(ls), 4)
+        self.assertEqual(str(ls), ''.join(items))
+
+    def test_random_access_and_slices(self):
+        rnd = random.Random(5)
+        items = [''.join(rnd.choice('abé中\U0001F600') for _ in range(rnd.randint(0, 6)))
+                 for _ in range(3000)]
+        text = '-'.join(items)
+        ls = L('-').join(items)
+        self.assertEqual(len(ls), len(text))
+        for _ in range(300):
+            i = rnd.randrange(len(text))
+            self.assertEqual(ls[i], text[i])
+            a = rnd.randint(0, len(text))
+            b = rnd.randint(a, len(text))
+            self.assertEqual(str(ls[a:b]), text[a:b])
+            self.assertEqual(str(ls[a:b:3]), text[a:b:3])
+        self.assertEqual(str(ls[::-1]), text[::-1])
+
+    def test_searches(self):
+        items = ['alpha', 'beta', 'gamma', ' ', '42', 'Δ'] * 50
+        text = ''.join(items)
+        ls = L('').join(items)
+        for sub in ['a', 'ma4', 'Δa', ' 4', 'zz']:
+            self.assertEqual(ls.find(sub), text.find(sub))
+            self.assertEqual(ls.rfind(sub), text.rfind(sub))
+            self.assertEqual(ls.find(sub, 100, 900), text.find(sub, 100, 900))
+            self.assertEqual(ls.rfind(sub, 100, 900), text.rfind(sub, 100, 900))
+            self.assertEqual(ls.count(sub), text.count(sub))
+        self.assertEqual([str(x) for x in ls.split()], text.split())
+        self.assertEqual([str(x) for x in ls.split('Δ')], text.split('Δ'))
+
+    def test_classification(self):
+        self.assertTrue(L('').join(['ab', 'cd', 'ef']).isalpha())
+        self.assertFalse(L('').join(['ab', 'c1', 'ef']).isalpha())
+        self.assertTrue(L('').join(['12', '34', '56']).isdigit())
+        self.assertTrue(L(' ').join(['', '', '', '']).isspace())
+        self.assertTrue(L('').join(['AB', 'CD', 'EF']).isupper())
+
+    def test_hash_and_compare(self):
+        items = ['p%d' % i for i in range(500)]
+        ls = L(',').join(items)
+        text = ','.join(items)
+        self.assertEqual(hash(ls), hash(L(text)))
+        self.assertEqual(hash(ls[7:1234]), hash(L(text[7:1234])))
+        self.assertEqual(ls, L(text))
+        self.assertEqual(ls, L('').join(ls.split(',', 3)[:1] + [L(',')] + [L(text[len(items[0]) + 1:])]))
+        self.assertLess(ls, L(text + 'a'))
+        self.assertGreater(ls, L(text[:-1]))
+
+    def test_kind(self):
+        ls = L('').join(['a', 'b', 'c', 'Ā', '\U0001F600', 'd', 'e'])
+        self.assertEqual(str(ls[:3]), 'abc')
+        self.assertEqual(str(ls[3:5]), 'Ā\U0001F600')
+        self.assertEqual(str(ls[5:]), 'de')
+
+    def test_concat_onto_wide_nodes(self):
+        rnd = random.Random(11)
+        ls = L('').join([str(i) for i in range(40)])
+        text = ''.join(str(i) for i in range(40))
+        for i in range(2000):
+            piece = 'q%d' % i
+            if rnd.random() < 0.5:
+                ls, text = ls + L(piece), text + piece
+            else:
+                ls, text = L(piece) + ls, piece + text
+            if rnd.random() < 0.05:
+                other = L('|').join(['r', 's', 't'])
+                ls, text = ls + other, text + 'r|s|t'
+        self.assertEqual(str(ls), text)
+        self.assertLess(_height(ls), 40)
+        self.assertEqual(hash(ls), hash(L(text)))
+
+    def test_concat_wide_nodes_together(self):
+        a = L('').join(['a%d' % i for i in range(100)])
+        b = L('').join(['b%d' % i for i in range(3)])
+        text_a = ''.join('a%d' % i for i in range(100))
+        text_b = 'b0b1b2'
+        self.assertEqual(str(a + b), text_a + text_b)
+        self.assertEqual(str(b + a), text_b + text_a)
+        self.assertEqual(str((a + b)[150:250]), (text_a + text_b)[150:250])
+
+    def test_replace_and_compact(self):
+        text = 'ab,cd,' * 200
+        ls = L(text)
+        self.assertEqual(str(ls.replace(',', '::')), text.replace(',', '::'))
+        self.assertEqual(str(ls.replace(',', '::').compact(min_leaf=8, max_leaf=64)),
+                         text.replace(',', '::'))
+
+
+if __name__ == '__main__':
+    unittest.main()
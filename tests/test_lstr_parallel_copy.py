@@ -0,0 +1,95 @@
+"""
+Tests for the multi-threaded str() materialization of large buffers.
+"""
+import threading
+import unittest
+import lstring
+from lstring import L
+
+
+class TestLStrParallelCopy(unittest.TestCase):
+    """str() of large lazy values is the same with any number of threads."""
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        cls._orig_copy_thresh = lstring.get_parallel_copy_threshold()
+        cls._orig_copy_threads = lstring.get_parallel_copy_threads()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+        lstring.set_parallel_copy_threshold(cls._orig_copy_thresh)
+        lstring.set_parallel_copy_threads(cls._orig_copy_threads)
+
+    def samples(self):
+        parts = ['abcdefghij' * 3000, 'αβγδε' * 4001, '\U0001F600xyz' * 2999, 'tail']
+        yield ''.join(parts[:1]) * 5, L(parts[0]) * 5
+        for n in range(1, len(parts) + 1):
+            text = ''.join(parts[:n]) * 7
+            rope = L('')
+            for _ in range(7):
+                for p in parts[:n]:
+                    rope += L(p)
+            yield text, rope
+            yield text[12345:-777], rope[12345:-777]
+            yield text[::-3], rope[::-3]
+            yield text.upper(), rope.upper()
+
+    def check_all(self):
+        for text, ls in self.samples():
+            self.assertEqual(str(ls), text)
+
+    def test_settings(self):
+        lstring.set_parallel_copy_threshold(1000)
+        self.assertEqual(lstring.get_parallel_copy_threshold(), 1000)
+        lstring.set_parallel_copy_threshold(None)
+        self.assertEqual(lstring.get_parallel_copy_threshold(), 0)
+        lstring.set_parallel_copy_threads(3)
+        self.assertEqual(lstring.get_parallel_copy_threads(), 3)
+        lstring.set_parallel_copy_threads(None)
+        self.assertEqual(lstring.get_parallel_copy_threads(), 0)
+        with self.assertRaises(TypeError):
+            lstring.set_parallel_copy_threshold('1')
+        with self.assertRaises(ValueError):
+            lstring.set_parallel_copy_threads(-1)
+
+    def test_serial(self):
+        lstring.set_parallel_copy_threshold(0)
+        self.check_all()
+
+    def test_thread_counts(self):
+        lstring.set_parallel_copy_threshold(1)
+        for threads in (0, 1, 2, 3, 7, 64):
+            with self.subTest(threads=threads):
+                lstring.set_parallel_copy_threads(threads)
+                self.check_all()
+
+    def test_below_threshold(self):
+        lstring.set_parallel_copy_threshold(10 ** 9)
+        lstring.set_parallel_copy_threads(4)
+        self.check_all()
+
+    def test_concurrent_callers(self):
+        lstring.set_parallel_copy_threshold(1)
+        lstring.set_parallel_copy_threads(4)
+        text = 'abc' * 100000 + 'ж' * 100000
+        rope = L('abc') * 100000 + L('ж') * 100000
+        errors = []
+
+        def work():
+            for _ in range(5):
+                if str(rope) != text:
+                    errors.append('mismatch')
+
+        workers = [threading.Thread(target=work) for _ in range(4)]
+        for w in workers:
+            w.start()
+        for w in workers:
+            w.join()
+        self.assertEqual(errors, [])
+
+
+if __name__ == '__main__':
+    unittest.main()
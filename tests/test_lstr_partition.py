@@ -3,7 +3,7 @@ Tests for L.partition() and L.rpartition() methods
 """
 
 import unittest
-from lstring import L
+from lstring import L, Pattern
 import lstring
 
 
@@ -185,6 +185,17 @@ class TestPartitionVsRPartition(unittest.TestCase):
         self.assertEqual(part, (L('hello'), L(''), L('')))
         self.assertEqual(rpart, (L(''), L(''), L('hello')))
 
+    def test_partition_pattern_and_lazy_source(self):
+        """Pattern separators and concatenated sources."""
+        s = L('a, b') + L(', c')
+        self.assertEqual(s.partition(Pattern(', ')), (L('a'), L(', '), L('b, c')))
+        self.assertEqual(s.rpartition(Pattern(', ')), (L('a, b'), L(', '), L('c')))
+        self.assertEqual(s.partition('b,'), (L('a, '), L('b,'), L(' c')))
+        before, sep, after = s.partition(':')
+        self.assertIs(before, s)
+        before, sep, after = s.rpartition(':')
+        self.assertIs(after, s)
+
 
 if __name__ == '__main__':
     unittest.main()
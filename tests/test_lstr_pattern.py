@@ -0,0 +1,92 @@
+"""
+Tests for lstring.Pattern - a compiled needle reused across searches.
+"""
+
+import gc
+import sys
+import unittest
+
+import lstring
+from lstring import L, Pattern
+
+
+class TestLStrPattern(unittest.TestCase):
+    """Pattern accepted by the substring and charset search methods"""
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        # disable C-level automatic collapsing/optimization for deterministic behavior
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def test_construct(self):
+        p = Pattern(', ')
+        self.assertEqual(len(p), 2)
+        self.assertEqual(p.needle, L(', '))
+        self.assertEqual(repr(p), "Pattern(L', ')")
+        self.assertEqual(len(Pattern(L('ab') * 3)), 6)
+        with self.assertRaises(TypeError):
+            Pattern(5)
+
+    def test_find_rfind(self):
+        p = Pattern('lo')
+        for l in (L('hello hello'), L('hel') + L('lo hel') + L('lo'), (L('hello ') * 2)[:-1]):
+            s = str(l)
+            self.assertEqual(l.find(p), s.find('lo'))
+            self.assertEqual(l.rfind(p), s.rfind('lo'))
+            self.assertEqual(l.find(p, 4), s.find('lo', 4))
+            self.assertEqual(l.rfind(p, 0, 8), s.rfind('lo', 0, 8))
+            self.assertEqual(l.index(p), s.index('lo'))
+
+    def test_find_iter_and_count(self):
+        p = Pattern('aa')
+        l = L('a') * 7 + L('b') + L('aaa')
+        self.assertEqual(list(l.find_iter(p)), [0, 2, 4, 8])
+        self.assertEqual(list(l.rfind_iter(p)), [9, 5, 3, 1])
+        self.assertEqual(l.count(p), 4)
+        self.assertEqual(l.count(p, 1, 6), 2)
+        self.assertEqual(L('').count(Pattern('')), 1)
+
+    def test_split_replace(self):
+        sep = Pattern(', ')
+        l = L('a, b') + L(', c, ') + L('d')
+        self.assertEqual(l.split(sep), [L('a'), L('b'), L('c'), L('d')])
+        self.assertEqual(l.rsplit(sep, 1), [L('a, b, c'), L('d')])
+        self.assertEqual(l.replace(sep, '|'), L('a|b|c|d'))
+        self.assertEqual(l.replace(sep, L('; '), 2), L('a; b; c, d'))
+
+    def test_findcs(self):
+        p = Pattern(' ,;')
+        l = L('abc') + L('de;f g')
+        self.assertEqual(l.findcs(p), 5)
+        self.assertEqual(l.rfindcs(p), 7)
+        self.assertEqual(l.findcs(p, invert=True), 0)
+        wide = Pattern('дé\U0001F600')
+        l = L('xyz') + L('aé') + L('\U0001F600')
+        self.assertEqual(l.findcs(wide), 4)
+        self.assertEqual(l.rfindcs(wide), 5)
+        self.assertEqual(l.findcs(wide), l.findcs('дé\U0001F600'))
+
+    def test_reuse_on_many_strings(self):
+        p = Pattern('needle')
+        for i in range(50):
+            l = L('x' * i) + L('need') + L('le') + L('y' * (50 - i))
+            self.assertEqual(l.find(p), i)
+            self.assertEqual(l.findcs(p), i)
+
+    def test_iterator_keeps_pattern_alive(self):
+        p = Pattern('ab')
+        before = sys.getrefcount(p)
+        it = L('abab').find_iter(p)
+        self.assertEqual(sys.getrefcount(p), before + 1)
+        del p
+        gc.collect()
+        self.assertEqual(list(it), [0, 2])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -407,5 +407,27 @@ class TestLStrRefCounts(unittest.TestCase):
         self.assertEqual(after_c, before_c)
 
 
+    def test_type_refcount_balanced(self):
+        """Creating and dropping L instances leaves the type refcounts unchanged."""
+        import _lstring
+
+        class SubL(lstring.L):
+            pass
+
+        for cls in (lstring.L, _lstring.L, SubL):
+            before = sys.getrefcount(cls)
+            objs = [cls(dyn("abc"))[0:2] + cls(dyn("de")) for _ in range(100)]
+            del objs
+            gc.collect()
+            self.assertEqual(sys.getrefcount(cls), before, cls)
+
+    def test_instances_have_no_dict(self):
+        """L instances, like str, carry no per-instance attributes."""
+        s = lstring.L(dyn("abc"))
+        self.assertFalse(hasattr(s, "__dict__"))
+        with self.assertRaises(AttributeError):
+            s.extra = 1
+
+
 if __name__ == "__main__":
     unittest.main()
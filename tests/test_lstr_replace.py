@@ -237,5 +237,63 @@ class TestReplaceVsStrReplace(unittest.TestCase):
                                            f"Failed for {repr(s)}.replace({repr(old)}, {repr(new)}, {count})")
 
 
+class TestReplaceRope(unittest.TestCase):
+    """replace() builds its result from slices of the source."""
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def test_many_replacements(self):
+        s = "key=${v}; " * 20000
+        result = L(s).replace("${v}", L("value"))
+        self.assertEqual(str(result), s.replace("${v}", "value"))
+        # The balanced tree keeps further edits cheap and correct.
+        result = result + "tail"
+        self.assertEqual(str(result[-14:]), s.replace("${v}", "value")[-10:] + "tail")
+
+    def test_many_replacements_across_parts(self):
+        parts = ["ab", "cab", "ca", "bc"] * 500
+        ls = L("")
+        for part in parts:
+            ls = ls + L(part)
+        s = "".join(parts)
+        self.assertEqual(str(ls.replace("abc", "-")), s.replace("abc", "-"))
+        self.assertEqual(str(ls.replace("c", "")), s.replace("c", ""))
+
+    def test_no_match_returns_self(self):
+        ls = L("hello") + L(" world")
+        self.assertIs(ls.replace("xyz", "abc"), ls)
+        self.assertIs(ls.replace("o", "0", 0), ls)
+
+    def test_count_keyword(self):
+        self.assertEqual(L("a-b-c").replace("-", "+", count=1), L("a+b-c"))
+
+    def test_pattern_and_l_arguments(self):
+        pattern = lstring.Pattern(L("ab"))
+        self.assertEqual(L("xabyabz").replace(pattern, L("..") * 2), L("x....y....z"))
+
+    def test_everything_replaced_with_empty(self):
+        self.assertEqual(L("abab").replace("ab", ""), L(""))
+
+    def test_subclass_result(self):
+        class MyL(L):
+            pass
+        result = MyL("a,b").replace(",", ";")
+        self.assertIsInstance(result, MyL)
+        self.assertEqual(result, L("a;b"))
+
+    def test_type_error_messages(self):
+        with self.assertRaisesRegex(TypeError, "argument 1 must be str, L or Pattern, not int"):
+            L("hello").replace(1, "x")
+        with self.assertRaisesRegex(TypeError, "argument 2 must be str or L, not NoneType"):
+            L("hello").replace("l", None)
+
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,144 @@
+"""
+Tests for span-based scanning over composite buffers.
+
+Searches, comparisons, hashing and classification walk the buffer as a
+sequence of contiguous spans; these tests check them on rope shapes where
+the spans come from many different leaves.
+"""
+
+import unittest
+
+import lstring
+from lstring import L, CharClass
+
+
+def _rope(parts):
+    """Build a balanced join tree over the given str parts."""
+    return L('').join(L(p) for p in parts)
+
+
+class TestLStrSpans(unittest.TestCase):
+    """Span traversal over JoinBuffer, MulBuffer and slice trees"""
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        # disable C-level automatic collapsing/optimization for deterministic behavior
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def shapes(self):
+        """Yield (lazy, expected str) pairs of various shapes and kinds."""
+        parts = ['ab', ' c', 'Dé', 'гд ', 'x\U0001F600', '  ', 'Zz9']
+        text = ''.join(parts)
+        yield _rope(parts), text
+        yield _rope(parts)[3:-2], text[3:-2]
+        yield _rope(parts) * 3, text * 3
+        yield (_rope(parts) * 3)[5:29], (text * 3)[5:29]
+        yield (L('a bé') * 4)[1::3], ('a bé' * 4)[1::3]
+        yield (L('hello') + L(' ') + L('world'))[::-1], 'hello world'[::-1]
+
+    def test_findcs_on_shapes(self):
+        for l, s in self.shapes():
+            for cs in (' ', 'zé', 'д', '\U0001F600', 'q'):
+                expected = next((i for i, c in enumerate(s) if c in cs), -1)
+                self.assertEqual(l.findcs(cs), expected, (repr(l), cs))
+                expected = next((i for i in range(len(s) - 1, -1, -1) if s[i] in cs), -1)
+                self.assertEqual(l.rfindcs(cs), expected, (repr(l), cs))
+                expected = next((i for i, c in enumerate(s) if c not in cs), -1)
+                self.assertEqual(l.findcs(cs, invert=True), expected, (repr(l), cs))
+
+    def test_findcr_on_shapes(self):
+        for l, s in self.shapes():
+            expected = next((i for i, c in enumerate(s) if ord(c) >= 128), -1)
+            self.assertEqual(l.findcr(0, 128, invert=True), expected, repr(l))
+            expected = next((i for i in range(len(s) - 1, -1, -1) if 'a' <= s[i] < 'z'), -1)
+            self.assertEqual(l.rfindcr('a', 'z'), expected, repr(l))
+
+    def test_findcc_on_shapes(self):
+        for l, s in self.shapes():
+            expected = next((i for i, c in enumerate(s) if c.isspace()), -1)
+            self.assertEqual(l.findcc(CharClass.SPACE), expected, repr(l))
+            expected = next((i for i in range(len(s) - 1, -1, -1) if not s[i].isspace()), -1)
+            self.assertEqual(l.rfindcc(CharClass.SPACE, invert=True), expected, repr(l))
+
+    def test_findcs_range_inside_rope(self):
+        l, s = _rope(['aaaa', 'bbbb', 'cccc']), 'aaaabbbbcccc'
+        for start in range(len(s) + 1):
+            for end in range(start, len(s) + 1):
+                expected = next((i for i in range(start, end) if s[i] == 'b'), -1)
+                self.assertEqual(l.findcs('b', start, end), expected, (start, end))
+
+    def test_strided_slice_searches(self):
+        """Strided slices must not reuse the contiguous base range."""
+        l = L('a b c d e f g h')[1::2]
+        self.assertEqual(str(l), ' ' * 7)
+        self.assertEqual(l.findcs(' ', invert=True), -1)
+        self.assertEqual(l.findcr(97, 120), -1)
+        self.assertEqual(l.findcc(CharClass.ALPHA), -1)
+        self.assertEqual(l.rfindcc(CharClass.SPACE), 6)
+
+        l = L('a b c d e f g h')[::2]
+        self.assertEqual(l.findcs(' '), -1)
+        self.assertEqual(l.rfindcs('h'), 7)
+
+    def test_compare_on_shapes(self):
+        for l, s in self.shapes():
+            flat = L(s)
+            self.assertEqual(l, flat)
+            self.assertEqual(flat, l)
+            if s:
+                self.assertLess(l[:-1], flat)
+                bumped = s[:-1] + chr(ord(s[-1]) + 1)
+                self.assertLess(l, L(bumped))
+                self.assertGreater(_rope([bumped[:3], bumped[3:]]), l)
+
+    def test_hash_on_shapes(self):
+        for l, s in self.shapes():
+            self.assertEqual(hash(l), hash(L(s)), repr(l))
+
+    def test_classification_on_shapes(self):
+        cases = [
+            (_rope(['   ', '\t', '\n  ']), '   \t\n  '),
+            (_rope(['abc', 'éè', 'XYZ']), 'abcéèXYZ'),
+            (_rope(['123', '٣']) * 3, '123٣' * 3),
+            (_rope(['ABC', 'D']) * 2, 'ABCD' * 2),
+            (_rope(['Hello ', 'World']), 'Hello World'),
+            (_rope(['Hello ', 'world']), 'Hello world'),
+        ]
+        for l, s in cases:
+            for name in ('isspace', 'isalpha', 'isdigit', 'isalnum', 'isupper',
+                         'islower', 'isdecimal', 'isnumeric', 'isprintable', 'istitle'):
+                self.assertEqual(getattr(l, name)(), getattr(s, name)(), (repr(l), name))
+
+    def test_iteration_on_shapes(self):
+        for l, s in self.shapes():
+            self.assertEqual(list(l), list(s), repr(l))
+
+    def test_iteration_on_deep_rope(self):
+        l, s = L(''), ''
+        for i in range(300):
+            part = chr(0x61 + i % 26) * (i % 3) + ('é' if i % 7 == 0 else '')
+            l, s = l + L(part), s + part
+        self.assertEqual(''.join(l), s)
+        self.assertEqual(''.join(l[17:-5]), s[17:-5])
+        self.assertEqual(''.join(L('xy') * 1000), 'xy' * 1000)
+
+    def test_find_verification_on_shapes(self):
+        for l, s in self.shapes():
+            for sub in (s[2:6], s[-4:], s[:3] + 'q', s[5:9] * 2):
+                self.assertEqual(l.find(sub), s.find(sub), (repr(l), sub))
+                self.assertEqual(l.rfind(sub), s.rfind(sub), (repr(l), sub))
+                self.assertEqual(l.find(_rope([sub[:1], sub[1:]])), s.find(sub), (repr(l), sub))
+
+    def test_charset_from_rope(self):
+        l = L('hello world')
+        self.assertEqual(l.findcs(_rope(['xw', 'yz'])), 6)
+        self.assertEqual(l.findcs(_rope(['x', 'y']) * 3), -1)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -321,5 +321,82 @@ class TestSplitIterators(unittest.TestCase):
                 )
 
 
+
+class TestSplitAgainstStr(unittest.TestCase):
+    """The native splitter agrees with str on str-backed and lazy sources."""
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def sources(self, text):
+        """The text as a str-backed L and as a join of small pieces."""
+        yield L(text)
+        lazy = L('')
+        for i in range(0, len(text), 3):
+            lazy = lazy + L(text[i:i + 3])
+        yield lazy
+
+    def test_random_split(self):
+        import random
+        rnd = random.Random(7)
+        alphabet = ['a', 'b', ',', ',,', ' ', '\t', '\u3000', '\u00e9', '\U0001F600', '::']
+        for _ in range(300):
+            text = ''.join(rnd.choice(alphabet) for _ in range(rnd.randint(0, 25)))
+            sep = rnd.choice([None, ',', ',,', '::', 'a', ' '])
+            maxsplit = rnd.choice([-1, 0, 1, 2, 5])
+            for ls in self.sources(text):
+                with self.subTest(text=text, sep=sep, maxsplit=maxsplit):
+                    self.assertEqual([str(p) for p in ls.split(sep, maxsplit)],
+                                     text.split(sep, maxsplit))
+                    self.assertEqual([str(p) for p in ls.rsplit(sep, maxsplit)],
+                                     text.rsplit(sep, maxsplit))
+                    self.assertEqual([str(p) for p in ls.split_iter(sep, maxsplit)],
+                                     text.split(sep, maxsplit))
+                    self.assertEqual([str(p) for p in ls.rsplit_iter(sep, maxsplit)],
+                                     text.rsplit(sep, maxsplit)[::-1])
+
+    def test_pattern_separator(self):
+        pat = lstring.Pattern(L('--'))
+        text = 'a--b----c--'
+        self.assertEqual([str(p) for p in L(text).split(pat)], text.split('--'))
+        self.assertEqual([str(p) for p in L(text).rsplit(pat, 1)], text.rsplit('--', 1))
+
+    def test_keyword_arguments(self):
+        self.assertEqual(L('a,b,c').split(sep=',', maxsplit=1), [L('a'), L('b,c')])
+        self.assertEqual(L('a b c').rsplit(maxsplit=1), [L('a b'), L('c')])
+
+    def test_pieces_are_views_of_subclass(self):
+        class MyL(L):
+            pass
+        src = MyL('ab,cd,ef')
+        pieces = src.split(',')
+        self.assertTrue(all(type(p) is MyL for p in pieces))
+        self.assertIs(src.split(';')[0], src)
+
+    def test_iterator_is_lazy(self):
+        it = L('a,b,c').split_iter(',')
+        self.assertIs(iter(it), it)
+        self.assertEqual(next(it), L('a'))
+        self.assertEqual(list(it), [L('b'), L('c')])
+        self.assertEqual(list(it), [])
+
+    def test_error_message(self):
+        with self.assertRaisesRegex(TypeError, 'split\\(\\) argument must be str, L or Pattern, not int'):
+            L('abc').split(1)
+        with self.assertRaises(ValueError):
+            L('abc').rsplit_iter('')
+
+    def test_long_source(self):
+        text = 'word ' * 20000 + 'end'
+        self.assertEqual([str(p) for p in L(text).split()], text.split())
+        self.assertEqual(len(L(text).split(' ')), len(text.split(' ')))
+
+
 if __name__ == '__main__':
     unittest.main()
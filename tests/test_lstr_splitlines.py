@@ -178,6 +178,21 @@ class TestLStrSplitlines(unittest.TestCase):
 class TestSplitlinesIterator(unittest.TestCase):
     """Tests for L.splitlines_iter generator method"""
     
+    def test_splitlines_random_against_str(self):
+        """Lines of str-backed and lazy sources match str.splitlines."""
+        import random
+        rnd = random.Random(3)
+        alphabet = ['a', 'bc', '\n', '\r', '\r\n', '\x85', '\u2028', '\u00e9', '\U0001F600', '\x1c']
+        for _ in range(300):
+            text = ''.join(rnd.choice(alphabet) for _ in range(rnd.randint(0, 20)))
+            lazy = L('')
+            for i in range(0, len(text), 2):
+                lazy = lazy + L(text[i:i + 2])
+            for ls in (L(text), lazy):
+                for keepends in (False, True):
+                    self.assertEqual([str(x) for x in ls.splitlines(keepends)], text.splitlines(keepends))
+                    self.assertEqual([str(x) for x in ls.splitlines_iter(keepends)], text.splitlines(keepends))
+
     def test_splitlines_iter_returns_generator(self):
         """Test that splitlines_iter returns a generator."""
         result = L('hello\nworld\r\ntest').splitlines_iter()
@@ -216,6 +216,35 @@ class TestStartsEndsWithBufferTypes(unittest.TestCase):
         self.assertTrue(s.startswith("abcabc"))
         self.assertTrue(s.endswith("bcabc"))
 
+    def test_str_edge_cases(self):
+        """Empty affixes and out-of-range bounds follow str."""
+        text = "hello"
+        s = L("hel") + L("lo")
+        for affix in ["", "lo", "hello", "hello!"]:
+            for start in [None, -10, -2, 0, 3, 5, 6]:
+                for end in [None, -10, -1, 0, 2, 5, 9]:
+                    self.assertEqual(s.startswith(affix, start, end), text.startswith(affix, start, end))
+                    self.assertEqual(s.endswith(L(affix), start, end), text.endswith(affix, start, end))
+
+
+class TestStartsEndsWithTuple(unittest.TestCase):
+    """Tests for tuples of prefixes and suffixes."""
+
+    def test_tuple(self):
+        s = L("hello") + L(" world")
+        self.assertTrue(s.startswith(("x", L("hel"))))
+        self.assertTrue(s.endswith(("x", "world")))
+        self.assertFalse(s.startswith(("x", "world")))
+        self.assertFalse(s.endswith(()))
+        self.assertTrue(s.startswith(("wor", "x"), 6))
+        self.assertTrue(s.endswith(("lo", "x"), 0, 5))
+
+    def test_tuple_type_error(self):
+        with self.assertRaises(TypeError):
+            L("hello").startswith(("x", 1))
+        with self.assertRaises(TypeError):
+            L("hello").endswith([("lo")])
+
 
 if __name__ == '__main__':
     unittest.main()
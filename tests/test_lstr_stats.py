@@ -0,0 +1,104 @@
+"""
+Tests for the instrumentation counters: lstring.stats(), reset_stats() and
+set_stats_enabled().
+"""
+import unittest
+import lstring
+from lstring import L
+
+
+class TestLStrStats(unittest.TestCase):
+
+    def setUp(self):
+        self._orig_enabled = lstring.get_stats_enabled()
+        self._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+        lstring.set_stats_enabled(True)
+        lstring.reset_stats()
+
+    def tearDown(self):
+        lstring.set_stats_enabled(self._orig_enabled)
+        lstring.set_optimize_threshold(self._orig_thresh)
+        lstring.reset_stats()
+
+    def test_disabled_by_default_toggle(self):
+        lstring.set_stats_enabled(False)
+        self.assertFalse(lstring.get_stats_enabled())
+        L('abc') + L('def')
+        stats = lstring.stats()
+        self.assertFalse(stats['enabled'])
+        self.assertEqual(stats['nodes'], {})
+        lstring.set_stats_enabled(True)
+        self.assertTrue(lstring.stats()['enabled'])
+
+    def test_nodes_by_class(self):
+        a = L('abc')
+        b = L('dĕf')
+        c = L('\U0001F600')
+        joined = a + b + c
+        joined[1:4]
+        joined[::2]
+        a * 3
+        L.from_buffer(b'xyz')
+        L.from_buffer('héllo'.encode('utf-8'), encoding='utf-8')
+        joined.upper()
+        nodes = lstring.stats()['nodes']
+        self.assertEqual(nodes['Str8Buffer'], 1)
+        self.assertEqual(nodes['Str16Buffer'], 1)
+        self.assertEqual(nodes['Str32Buffer'], 1)
+        self.assertEqual(nodes['JoinBuffer'], 2)
+        self.assertEqual(nodes['Slice1Buffer'], 1)
+        self.assertEqual(nodes['SliceBuffer'], 1)
+        self.assertEqual(nodes['MulBuffer'], 1)
+        self.assertEqual(nodes['MmapBuffer'], 1)
+        self.assertEqual(nodes['Utf8Buffer'], 1)
+        self.assertEqual(nodes['MapBuffer'], 1)
+
+    def test_collapses_and_materializations(self):
+        x = L('a' * 50) + L('b' * 50)
+        lstring.set_optimize_threshold(1000)
+        x[10:20]
+        lstring.set_optimize_threshold(0)
+        self.assertEqual(lstring.stats()['optimize_collapses'], 1)
+
+        before = lstring.stats()
+        str(x)
+        str(L('Ā') + L('xy'))
+        stats = lstring.stats()
+        self.assertEqual(stats['materializations'] - before['materializations'], 2)
+        self.assertEqual(stats['materialized_bytes'] - before['materialized_bytes'], 100 + 6)
+
+    def test_find_paths(self):
+        flat = L('hello world')
+        lazy = L('hello ') + L('world')
+        flat.find('wor')
+        lazy.rfind('o w')
+        lazy.partition(' ')
+        big = L('abcdefgh' * 1000 + 'wxyz')
+        big.build_index()
+        big.find('hwxyz')
+        stats = lstring.stats()
+        self.assertEqual(stats['find_str'], 1)
+        self.assertEqual(stats['find_scan'], 2)
+        self.assertEqual(stats['find_indexed'], 1)
+
+    def test_rotations_and_height(self):
+        x = L('')
+        for i in range(256):
+            x = x + L('%03d' % i)
+        stats = lstring.stats()
+        self.assertGreater(stats['concat_rotations'], 0)
+        self.assertGreaterEqual(stats['max_height'], 8)
+        self.assertLessEqual(stats['max_height'], 16)
+
+    def test_reset(self):
+        L('abc') + L('def')
+        lstring.reset_stats()
+        stats = lstring.stats()
+        self.assertEqual(stats['nodes'], {})
+        self.assertEqual(stats['max_height'], 0)
+        self.assertTrue(stats['enabled'])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,117 @@
+"""
+Tests for the str() materialization cache: set_str_cache_limit(),
+clear_str_cache() and the str fast paths of cached values.
+"""
+import sys
+import unittest
+import lstring
+from lstring import L
+
+
+def lazy(text):
+    """A JoinBuffer-backed L equal to text."""
+    half = len(text) // 2
+    return L(text[:half]) + L(text[half:])
+
+
+class TestLStrStrCache(unittest.TestCase):
+
+    def setUp(self):
+        self.orig_limit = lstring.get_str_cache_limit()
+        self.orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+        lstring.set_str_cache_limit(1 << 20)
+
+    def tearDown(self):
+        lstring.set_str_cache_limit(self.orig_limit)
+        lstring.set_optimize_threshold(self.orig_thresh)
+        lstring.set_stats_enabled(False)
+        lstring.reset_stats()
+
+    def test_disabled_by_default(self):
+        self.assertEqual(self.orig_limit, 0)
+        lstring.set_str_cache_limit(None)
+        self.assertEqual(lstring.get_str_cache_limit(), 0)
+        s = lazy('hello world')
+        self.assertIsNot(str(s), str(s))
+        with self.assertRaises(TypeError):
+            lstring.set_str_cache_limit('big')
+
+    def test_str_is_reused(self):
+        for text in ['hello world', 'héllo wörld', 'привет мир', '\U0001F600 smile']:
+            s = lazy(text * 10)[3:-3]
+            first = str(s)
+            self.assertEqual(first, (text * 10)[3:-3])
+            self.assertIs(str(s), first)
+            self.assertIs(str(s), first)
+
+    def test_hits_counted(self):
+        s = lazy('abc' * 100)
+        lstring.set_stats_enabled(True)
+        lstring.reset_stats()
+        str(s)
+        str(s)
+        '%s' % s
+        st = lstring.stats()
+        self.assertEqual(st['materializations'], 1)
+        self.assertEqual(st['str_cache_hits'], 2)
+
+    def test_limit_evicts_least_recent(self):
+        lstring.set_str_cache_limit(250)
+        a, b, c = lazy('a' * 100), lazy('b' * 100), lazy('c' * 100)
+        sa, sb = str(a), str(b)
+        self.assertIs(str(a), sa)        # a is now more recent than b
+        lstring.set_stats_enabled(True)
+        lstring.reset_stats()
+        sc = str(c)
+        self.assertEqual(lstring.stats()['str_cache_evictions'], 1)
+        self.assertIs(str(a), sa)
+        self.assertIs(str(c), sc)
+        self.assertIsNot(str(b), sb)     # cached again, evicting a
+        # A value larger than the whole limit is never cached.
+        big = lazy('d' * 1000)
+        self.assertIsNot(str(big), str(big))
+        self.assertIs(str(c), sc)
+
+    def test_lowering_limit_and_clear(self):
+        s = lazy('x' * 500)
+        first = str(s)
+        lstring.set_str_cache_limit(100)
+        self.assertIsNot(str(s), first)
+        lstring.set_str_cache_limit(1 << 20)
+        first = str(s)
+        lstring.clear_str_cache()
+        self.assertIsNot(str(s), first)
+        self.assertEqual(lstring.get_str_cache_limit(), 1 << 20)
+
+    def test_entry_dies_with_value(self):
+        s = lazy('q' * 300)
+        cached = str(s)
+        held = sys.getrefcount(cached)
+        del s
+        self.assertEqual(sys.getrefcount(cached), held - 1)
+        self.assertEqual(cached, 'q' * 300)
+
+    def test_fast_paths(self):
+        text = 'the quick brown fox jumps over the lazy dog ' * 20
+        s = lazy(text)
+        sub = lazy('lazy dog')
+        str(s)
+        str(sub)
+        lstring.set_stats_enabled(True)
+        lstring.reset_stats()
+        self.assertEqual(s.find(sub), text.find('lazy dog'))
+        self.assertEqual(s.rfind('the', 5, -5), text.rfind('the', 5, -5))
+        self.assertEqual(lstring.stats()['find_str'], 2)
+        self.assertEqual(s.count('o'), text.count('o'))
+        other = lazy(text[:-1] + '!')
+        str(other)
+        self.assertTrue(s < other)
+        self.assertFalse(s == other)
+        self.assertTrue(s == L(text))
+        self.assertTrue(L(text) <= s)
+        self.assertEqual(s.split(' ', 3), text.split(' ', 3))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,102 @@
+"""
+Tests for L.build_index() and the searches it accelerates: find(), rfind(),
+count() and the in operator.
+"""
+import random
+import unittest
+import lstring
+from lstring import L, Pattern
+
+
+def make_text(rnd, n, alphabet='abcd é中\U0001F600'):
+    return ''.join(rnd.choice(alphabet) for _ in range(n))
+
+
+class TestLStrSubstringIndex(unittest.TestCase):
+
+    def check(self, lstr, text, rnd, queries=200):
+        for _ in range(queries):
+            if rnd.random() < 0.7 and text:
+                a = rnd.randrange(len(text))
+                sub = text[a:a + rnd.randint(0, 12)]
+            else:
+                sub = make_text(rnd, rnd.randint(0, 6))
+            start = rnd.choice([None, rnd.randint(-len(text) - 2, len(text) + 2)])
+            end = rnd.choice([None, rnd.randint(-len(text) - 2, len(text) + 2)])
+            self.assertEqual(lstr.find(sub, start, end), text.find(sub, start, end))
+            self.assertEqual(lstr.rfind(sub, start, end), text.rfind(sub, start, end))
+            self.assertEqual(lstr.count(sub, start, end), text.count(sub, start, end))
+            self.assertEqual(sub in lstr, sub in text)
+
+    def test_differential(self):
+        rnd = random.Random(26)
+        for n in [0, 3, 4, 100, 5000]:
+            for alphabet in ['ab', 'abcd é中\U0001F600']:
+                text = make_text(rnd, n, alphabet)
+                lstr = L(text)
+                lstr.build_index()
+                self.check(lstr, text, rnd)
+
+    def test_lazy_and_slices(self):
+        rnd = random.Random(27)
+        parts = [make_text(rnd, rnd.randint(0, 300)) for _ in range(40)]
+        text = ''.join(parts)
+        lstr = L('').join([L(p) for p in parts])
+        lstr.build_index()
+        self.check(lstr, text, rnd)
+        view = lstr[1000:5000]
+        self.check(view, text[1000:5000], rnd)
+
+    def test_utf8_buffer(self):
+        rnd = random.Random(28)
+        text = make_text(rnd, 4000)
+        lstr = L.from_buffer(text.encode('utf-8'), encoding='utf-8')
+        lstr.build_index()
+        lstr.build_index()
+        self.check(lstr, text, rnd)
+
+    def test_frequent_needle(self):
+        text = 'abcd' * 5000 + 'abce'
+        lstr = L(text)
+        lstr.build_index()
+        self.assertEqual(lstr.count('abcd'), 5000)
+        self.assertEqual(lstr.find('abce'), 20000)
+        self.assertEqual(lstr.rfind('dabc'), text.rfind('dabc'))
+        self.assertEqual(lstr.count('abcdabcd'), 2500)
+
+    def test_patterns(self):
+        rnd = random.Random(29)
+        text = make_text(rnd, 3000)
+        lstr = L(text)
+        lstr.build_index()
+        sub = text[1234:1240]
+        self.assertEqual(lstr.count(Pattern(sub)), text.count(sub))
+        self.assertEqual(lstr.find(Pattern(sub)), text.find(sub))
+
+    def test_count_edge_cases(self):
+        lstr = L('hello')
+        self.assertEqual(lstr.count(''), 6)
+        self.assertEqual(lstr.count('', 5), 1)
+        self.assertEqual(lstr.count('', 6), 0)
+        self.assertEqual(lstr.count('', 3, 1), 0)
+        self.assertEqual(lstr.count('l', -3), 2)
+        self.assertEqual(lstr.count(L('ll')), 1)
+        with self.assertRaises(TypeError):
+            lstr.count(3)
+
+    def test_contains(self):
+        lstr = L('hello') + L(' wörld')
+        self.assertIn('ell', lstr)
+        self.assertIn(L('o w'), lstr)
+        self.assertIn('', lstr)
+        self.assertNotIn('xyz', lstr)
+        self.assertNotIn('hello wörld!', lstr)
+        with self.assertRaises(TypeError):
+            3 in lstr
+        lstr.build_index()
+        self.assertIn('lo wö', lstr)
+        self.assertNotIn('lo wo', lstr)
+
+
+if __name__ == '__main__':
+    unittest.main()
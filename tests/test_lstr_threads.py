@@ -0,0 +1,116 @@
+"""
+Tests for scans that release the GIL and for L values shared by threads.
+"""
+import threading
+import unittest
+import lstring
+from lstring import L, CharClass
+
+
+def run_threads(target, count=4):
+    errors = []
+
+    def wrapper():
+        try:
+            target()
+        except Exception as e:  # pragma: no cover - reported below
+            errors.append(e)
+
+    threads = [threading.Thread(target=wrapper) for _ in range(count)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    return errors
+
+
+class TestLStrThreads(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def test_long_scans_in_threads(self):
+        text = 'abc ' * 50000 + 'Zé\U0001F600' + 'xyz' * 30000
+        rope = L('abc ') * 50000 + L('Zé\U0001F600') + L('xyz') * 30000
+        flat = L(text)
+
+        def work():
+            for ls in (rope, flat, rope[1:-1]):
+                s = str(ls)
+                for _ in range(3):
+                    self.assertEqual(ls.findc('Z'), s.find('Z'))
+                    self.assertEqual(ls.rfindc('a'), s.rfind('a'))
+                    self.assertEqual(ls.findcs('Zq'), s.find('Z'))
+                    self.assertEqual(ls.rfindcs(' ', invert=True), len(s.rstrip(' ')) - 1)
+                    self.assertEqual(ls.findcr(0x100, 0x110000), s.find('\U0001F600'))
+                    self.assertEqual(ls.findcc(CharClass.UPPER), s.find('Z'))
+                    self.assertEqual(ls.find('Zé'), s.find('Zé'))
+                    self.assertEqual(ls.rfind(L('c a')), s.rfind('c a'))
+                    self.assertEqual(ls.isalpha(), s.isalpha())
+                    self.assertEqual(ls.isprintable(), s.isprintable())
+
+        self.assertEqual(run_threads(work), [])
+
+    def test_first_use_caches_in_threads(self):
+        # Fresh nodes each round, so every thread races on filling the
+        # cached length, kind and hash.
+        for _ in range(20):
+            base = L('αβγ' * 10000) + L('abc' * 10000)
+            values = [base[5:-5], base * 3, (base + base)[::2], base.upper()]
+            results = []
+
+            def work():
+                results.append([(len(v), hash(v), str(v)) for v in values])
+
+            self.assertEqual(run_threads(work), [])
+            self.assertTrue(all(r == results[0] for r in results))
+
+    def test_shared_iterator(self):
+        text = ''.join(chr(0x41 + i % 26) for i in range(40000))
+        it = iter(L(text[:20000]) + L(text[20000:]))
+        seen = []
+
+        def work():
+            local = []
+            for ch in it:
+                local.append(ch)
+            seen.append(local)
+
+        self.assertEqual(run_threads(work), [])
+        self.assertEqual(sum(len(s) for s in seen), len(text))
+        self.assertEqual(sorted(ch for s in seen for ch in s), sorted(text))
+
+    def test_shared_find_iterator(self):
+        it = (L('ab') * 30000).find_iter('b')
+        seen = []
+
+        def work():
+            seen.extend(list(it))
+
+        self.assertEqual(run_threads(work), [])
+        self.assertEqual(sorted(seen), list(range(1, 60000, 2)))
+
+
+class TestLStrStrFindc(unittest.TestCase):
+    """findc on str-backed values scans the str storage directly."""
+
+    def test_code_points_outside_storage(self):
+        for text in ['abc', 'aβc', 'a\U0001F600c']:
+            ls = L(text)
+            self.assertEqual(ls.findc(0x10FFFF), -1)
+            self.assertEqual(ls.rfindc('\U0010FFFE'), -1)
+            self.assertEqual(ls.findc(0x7FFFFFFF), -1)
+            self.assertEqual(ls.findc('c'), 2)
+            self.assertEqual(ls.rfindc(text[1]), 1)
+            self.assertEqual(ls.findc('a', 1), -1)
+            self.assertEqual(ls.rfindc('c', 0, 2), -1)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,131 @@
+"""
+Tests for UTF-8 leaves: L.from_buffer(obj, encoding='utf-8') and
+L.from_file(path, encoding='utf-8').
+
+The leaf decodes its bytes on demand; every operation must match the same
+operation on the decoded str, on both sides of the checkpoint boundaries.
+"""
+import os
+import random
+import tempfile
+import unittest
+import lstring
+from lstring import L, CharClass
+
+
+def _utf8(text):
+    return L.from_buffer(text.encode('utf-8'), encoding='utf-8')
+
+
+class TestLStrUtf8Buffer(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls._orig_thresh = lstring.get_optimize_threshold()
+        lstring.set_optimize_threshold(0)
+
+    @classmethod
+    def tearDownClass(cls):
+        lstring.set_optimize_threshold(cls._orig_thresh)
+
+    def _temp_file(self, data):
+        fd, path = tempfile.mkstemp()
+        with os.fdopen(fd, 'wb') as f:
+            f.write(data)
+        self.addCleanup(os.remove, path)
+        return path
+
+    def test_basic(self):
+        text = 'héllo wörld — 中文 \U0001F600!\n'
+        ls = _utf8(text)
+        self.assertEqual(len(ls), len(text))
+        self.assertEqual(str(ls), text)
+        self.assertEqual(ls, L(text))
+        self.assertEqual(hash(ls), hash(L(text)))
+        self.assertEqual(repr(ls), 'L<bytes:utf-8:%d>' % len(text))
+        self.assertEqual(ls[1], 'é')
+        self.assertEqual(ls[-3], '\U0001F600')
+        self.assertEqual(str(ls[6:11]), 'wörld')
+        self.assertEqual(ls.encode(), text.encode())
+        self.assertEqual(ls[6:11].encode(), 'wörld'.encode())
+
+    def test_exact_kind(self):
+        for text in ['plain ascii', 'latin é\xff', 'bmp Ω中', 'astral \U0001F600']:
+            s = str(_utf8(text))
+            self.assertEqual(s, text)
+            self.assertEqual(max(map(ord, s)), max(map(ord, text)))
+            self.assertEqual(s + 'x', text + 'x')
+        self.assertEqual(_utf8(''), L(''))
+
+    def test_random_operations(self):
+        rnd = random.Random(24)
+        for alphabet in ['ab \n', 'ab é\xff\n', 'aé中 \U0001F600', 'x' * 40 + 'é']:
+            for n in [1, 1023, 1024, 1025, 4000]:
+                text = ''.join(rnd.choice(alphabet) for _ in range(n))
+                ls = _utf8(text)
+                self.assertEqual(str(ls), text)
+                for _ in range(40):
+                    a = rnd.randint(0, n)
+                    b = rnd.randint(a, n)
+                    self.assertEqual(str(ls[a:b]), text[a:b])
+                    self.assertEqual(ls[a:b].encode(), text[a:b].encode())
+                    ch = rnd.choice(alphabet)
+                    self.assertEqual(ls.findc(ch, a, b), text.find(ch, a, b))
+                    self.assertEqual(ls.rfindc(ch, a, b), text.rfind(ch, a, b))
+                    self.assertEqual(ls.find('a' + ch, a, b), text.find('a' + ch, a, b))
+                    self.assertEqual(ls.rfind(ch + ' ', a, b), text.rfind(ch + ' ', a, b))
+                self.assertEqual(str(ls[::-7]), text[::-7])
+                self.assertEqual([str(x) for x in ls.split()], text.split())
+                self.assertEqual(str(ls.upper()), text.upper())
+                self.assertEqual(ls.count('a'), text.count('a'))
+                self.assertEqual(b''.join(ls.iter_chunks(100)), text.encode())
+
+    def test_class_index(self):
+        orig = lstring.get_class_index_threshold()
+        lstring.set_class_index_threshold(1000)
+        try:
+            text = 'é' * 5000 + '7' + 'b' * 3000
+            ls = _utf8(text)
+            self.assertEqual(ls.findcc(CharClass.DIGIT), 5000)
+            self.assertEqual(ls.rfindcc(CharClass.DIGIT), 5000)
+            self.assertFalse(ls.isalpha())
+            self.assertTrue(ls[:5000].isalpha())
+        finally:
+            lstring.set_class_index_threshold(orig)
+
+    def test_invalid_utf8(self):
+        for data in [b'\xff', b'ab\xc0\x80', b'\xe0\x80', b'a\xe0\xa0', b'a\xed\xa0\x80',
+                     b'\xf4\x90\x80\x80', b'\x80', b'\xe2\x82\x28']:
+            with self.assertRaises(UnicodeDecodeError) as expected:
+                data.decode('utf-8')
+            with self.assertRaises(UnicodeDecodeError) as got:
+                L.from_buffer(data, encoding='utf-8')
+            e, g = expected.exception, got.exception
+            self.assertEqual((g.start, g.end, g.reason), (e.start, e.end, e.reason))
+            self.assertEqual(str(g), str(e))
+
+    def test_arguments(self):
+        for name in ['utf-8', 'UTF8', 'utf_8']:
+            self.assertEqual(L.from_buffer(b'ok', encoding=name), L('ok'))
+        with self.assertRaises(ValueError):
+            L.from_buffer(b'ab', encoding='latin-1')
+        with self.assertRaises(ValueError):
+            L.from_buffer(b'ab', 2, 'utf-8')
+        with self.assertRaises(TypeError):
+            L.from_buffer('not a buffer', encoding='utf-8')
+
+    def test_from_file(self):
+        content = ''.join('ligne %d : état=%s\n' % (i, 'ÉCHEC' if i % 7 == 0 else 'ok') for i in range(3000))
+        path = self._temp_file(content.encode('utf-8'))
+        ls = L.from_file(path, encoding='utf-8')
+        self.assertEqual(repr(ls), 'L<mmap.mmap:utf-8:%d>' % len(content))
+        self.assertEqual(len(ls), len(content))
+        self.assertEqual(ls.count('ÉCHEC'), content.count('ÉCHEC'))
+        lines = ls.splitlines()
+        self.assertEqual(str(lines[2000]), content.splitlines()[2000])
+        self.assertEqual(str(ls), content)
+        self.assertEqual(L.from_file(self._temp_file(b''), encoding='utf-8'), L(''))
+
+
+if __name__ == '__main__':
+    unittest.main()
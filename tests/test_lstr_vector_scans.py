@@ -0,0 +1,71 @@
+"""
+Tests for the vectorized range and byte-set scans behind findcr/findcs.
+
+The kernels process 16 or 32 bytes at a time, so the cases place matches
+around vector boundaries and use all three storage kinds.
+"""
+
+import unittest
+
+from lstring import L
+
+
+def _first(s, pred, start, end, invert):
+    return next((i for i in range(start, end) if pred(s[i]) != invert), -1)
+
+
+def _last(s, pred, start, end, invert):
+    return next((i for i in range(end - 1, start - 1, -1) if pred(s[i]) != invert), -1)
+
+
+class TestLStrVectorScans(unittest.TestCase):
+    """findcr/findcs on long contiguous leaves"""
+
+    LENGTHS = (1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 130)
+    FILLERS = ('x', 'д', '\U0001F600')
+
+    def cases(self):
+        for fill in self.FILLERS:
+            for n in self.LENGTHS:
+                for pos in sorted({0, n // 2, n - 1}):
+                    for mark in (' ', 'é', 'Ā', '\U0001F601'):
+                        s = fill * pos + mark + fill * (n - pos - 1)
+                        yield s
+
+    def test_findcr(self):
+        ranges = ((0, 33), (0xE0, 0x100), (0x100, 0x101), (0x1F601, 0x1F602), (0, 0x110000))
+        for s in self.cases():
+            l = L(s)
+            for lo, hi in ranges:
+                pred = lambda c: lo <= ord(c) < hi
+                for invert in (False, True):
+                    for start, end in ((0, len(s)), (1, len(s) - 1), (3, 40)):
+                        end = min(end, len(s))
+                        self.assertEqual(l.findcr(lo, hi, start, end, invert),
+                                         _first(s, pred, start, end, invert), (s, lo, hi, invert))
+                        self.assertEqual(l.rfindcr(lo, hi, start, end, invert),
+                                         _last(s, pred, start, end, invert), (s, lo, hi, invert))
+
+    def test_findcs(self):
+        charsets = (' ', ' \t\n', 'é\xff', 'xé', 'Ā ', '\U0001F601', '')
+        for s in self.cases():
+            l = L(s)
+            for cs in charsets:
+                pred = lambda c: c in cs
+                for invert in (False, True):
+                    self.assertEqual(l.findcs(cs, invert=invert),
+                                     _first(s, pred, 0, len(s), invert), (s, cs, invert))
+                    self.assertEqual(l.rfindcs(cs, invert=invert),
+                                     _last(s, pred, 0, len(s), invert), (s, cs, invert))
+
+    def test_findcs_all_byte_values(self):
+        s = ''.join(chr(c) for c in range(256)) * 2
+        l = L(s)
+        for c in range(256):
+            self.assertEqual(l.findcs(chr(c)), c)
+            self.assertEqual(l.rfindcs(chr(c)), 256 + c)
+            self.assertEqual(l.findcs(chr(c) + chr(255 - c)), min(c, 255 - c))
+
+
+if __name__ == '__main__':
+    unittest.main()